@@ -24,7 +24,8 @@ struct Grid_Data;
 
 
 // In Kripke/Sweep_Solver.cpp
-int SweepSolver(Grid_Data *grid_data, bool block_jacobi, const std::string& file);
+int SweepSolver(Grid_Data *grid_data, bool block_jacobi, const std::string& file,
+  bool zero_copy);
 void SweepSubdomains (std::vector<int> subdomain_list, Grid_Data *grid_data, bool block_jacobi);
 
 /**
@@ -32,6 +32,7 @@ struct Input_Variables {
 #endif
 
   Nesting_Order nesting;        // Data layout and loop ordering (of Psi)
+  bool zero_copy;               // Pass fields to SENSEI without copying
 };
 
 #endif
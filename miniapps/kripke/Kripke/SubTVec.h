@@ -100,6 +100,18 @@ struct SubTVec {
     return &(*this)(g,d,z);
   }
 
+  /**
+   * Distance between consecutive elements along an external index
+   * (0=groups, 1=directions/moments, 2=zones) in the nesting order.
+   */
+  inline int stride(int ext) const {
+    int s = 1;
+    for(int i = ext_to_int[ext]+1;i < 3;++ i){
+      s *= size_int[i];
+    }
+    return s;
+  }
+
   // These are NOT efficient.. just used to re-stride data for comparisons
   inline double &operator()(int g, int d, int z) {
     int idx[3];
@@ -23,7 +23,138 @@ using namespace conduit;
 static int count = 0;
 static int max_backlog = 0;
 
-void writeData(Grid_Data *grid_data, int timeStep, const std::string& file)
+/**
+  Buffers for the zero copy path, one per zone set. They persist across
+  iterations, the nodes passed to SENSEI point into these and into phi.
+*/
+struct ZeroCopyBuffers {
+  std::vector<double> coords[3];
+  std::vector<double> phi_sum;    // scalar flux summed over the groups
+};
+static std::vector<ZeroCopyBuffers> zero_copy_buffers;
+
+/**
+  Sums the scalar flux (moment 0) over the groups. The inner loop runs
+  over whichever of zones and groups is nested innermost, so that it is
+  unit stride except in the GZD and ZGD nestings where the moments are
+  innermost. The groups are added in the same order for every nesting.
+*/
+static void sumGroups(SubTVec &phi, double * KRESTRICT phi_sum){
+  int num_zones = phi.zones;
+  int num_groups = phi.groups;
+  int zone_stride = phi.stride(2);
+  int group_stride = phi.stride(0);
+  double const * KRESTRICT phi0 = phi.ptr(0,0,0);
+
+  if(zone_stride < group_stride){
+    for(int z = 0;z < num_zones;++ z){
+      phi_sum[z] = 0.0;
+    }
+    for(int g = 0;g < num_groups;++ g){
+      double const * KRESTRICT phi_g = phi0 + g*group_stride;
+      if(zone_stride == 1){
+        for(int z = 0;z < num_zones;++ z){
+          phi_sum[z] += phi_g[z];
+        }
+      }
+      else{
+        for(int z = 0;z < num_zones;++ z){
+          phi_sum[z] += phi_g[z*zone_stride];
+        }
+      }
+    }
+  }
+  else{
+    for(int z = 0;z < num_zones;++ z){
+      double const * KRESTRICT phi_z = phi0 + z*zone_stride;
+      double sum = 0.0;
+      for(int g = 0;g < num_groups;++ g){
+        sum += phi_z[g*group_stride];
+      }
+      phi_sum[z] = sum;
+    }
+  }
+}
+
+/**
+  Describes the mesh and fields of a zone set in a node. With zero_copy the
+  coordinates and the group summed flux are kept in persistent buffers and
+  phi is a strided view of the solver's data, otherwise they are copied
+  into the node. SENSEI uses the coordinates and phi_sum in place. phi is
+  used in place only in the nestings where zones are innermost, in the
+  other four its stride is not 1 and the data adaptor copies it element
+  by element.
+*/
+static void wrapZoneSet(Grid_Data *grid_data, int sdom_idx, bool zero_copy,
+  conduit::Node &data){
+
+  int sdom_id =  grid_data->zs_to_sdomid[sdom_idx];
+  Subdomain &sdom = grid_data->subdomains[sdom_id];
+  SubTVec &phi = *sdom.phi;
+
+  data["coordsets/coords/type"]  = "rectilinear";
+  data["topologies/mesh/type"]      = "rectilinear";
+  data["topologies/mesh/coordset"]  = "coords";
+
+  const char *axes[3] = {"coordsets/coords/values/x",
+    "coordsets/coords/values/y", "coordsets/coords/values/z"};
+
+  for(int dim = 0; dim < 3;++ dim)
+  {
+    conduit::float64 *coords = NULL;
+    if(zero_copy)
+    {
+      std::vector<double> &buf = zero_copy_buffers[sdom_idx].coords[dim];
+      buf.resize(sdom.nzones[dim]+1);
+      coords = &buf[0];
+      data[axes[dim]].set_external(coords, sdom.nzones[dim]+1);
+    }
+    else
+    {
+      data[axes[dim]].set(conduit::DataType::float64(sdom.nzones[dim]+1));
+      coords = data[axes[dim]].value();
+    }
+
+    coords[0] = sdom.zeros[dim];
+    for(int z = 0;z < sdom.nzones[dim]; ++z)
+    {
+      coords[1+z] = coords[z] + sdom.deltas[dim][z];
+    }
+  }
+
+  data["fields/phi/association"] = "element";
+  data["fields/phi/topology"] = "mesh";
+  data["fields/phi/type"] = "scalar";
+
+  if(zero_copy)
+  {
+    // group 0, moment 0 of phi, in place
+    data["fields/phi/values"].set_external_float64_ptr(phi.ptr(0,0,0),
+      sdom.num_zones, 0, phi.stride(2)*sizeof(conduit::float64));
+
+    std::vector<double> &phi_sum = zero_copy_buffers[sdom_idx].phi_sum;
+    phi_sum.resize(sdom.num_zones);
+    sumGroups(phi, &phi_sum[0]);
+
+    data["fields/phi_sum/association"] = "element";
+    data["fields/phi_sum/topology"] = "mesh";
+    data["fields/phi_sum/type"] = "scalar";
+    data["fields/phi_sum/values"].set_external(&phi_sum[0], sdom.num_zones);
+  }
+  else
+  {
+    data["fields/phi/values"].set(conduit::DataType::float64(sdom.num_zones));
+    conduit::float64 * phi_scalars = data["fields/phi/values"].value();
+
+    for(int i = 0; i < sdom.num_zones; i++)
+    {
+      phi_scalars[i] = phi(0,0,i);
+    }
+  }
+}
+
+void writeData(Grid_Data *grid_data, int timeStep, const std::string& file,
+  bool zero_copy)
 {
   
   grid_data->kernel->LTimes(grid_data);
@@ -35,15 +166,14 @@ void writeData(Grid_Data *grid_data, int timeStep, const std::string& file)
   MPI_Comm_rank(MPI_COMM_WORLD, &myid);
   int num_zone_sets = grid_data->zs_to_sdomid.size();
 
+  if(zero_copy)
+  {
+    zero_copy_buffers.resize(num_zone_sets);
+  }
+
   // TODO: we don't support domain overloading ... 
   for(int sdom_idx = 0; sdom_idx < grid_data->num_zone_sets; ++sdom_idx)
   {
-    
-    int sdom_id =  grid_data->zs_to_sdomid[sdom_idx];
-    Subdomain &sdom = grid_data->subdomains[sdom_id];
-    //create coords array
-    conduit::float64 *coords[3];
-
     data["state/time"]   = (conduit::float64)3.1415;
     data["state/domain_id"] = (conduit::uint64) myid;
     data["state/cycle"]  = (conduit::uint64) timeStep;
@@ -54,38 +184,7 @@ void writeData(Grid_Data *grid_data, int timeStep, const std::string& file)
     data["state/performance/max_backlog"] = max_backlog;
     ParallelComm::resetRequests();
 
-    data["coordsets/coords/type"]  = "rectilinear";
-    data["coordsets/coords/values/x"].set(conduit::DataType::float64(sdom.nzones[0]+1));
-    coords[0] = data["coordsets/coords/values/x"].value();
-    data["coordsets/coords/values/y"].set(conduit::DataType::float64(sdom.nzones[1]+1));
-    coords[1] = data["coordsets/coords/values/y"].value();
-    data["coordsets/coords/values/z"].set(conduit::DataType::float64(sdom.nzones[2]+1));
-    coords[2] = data["coordsets/coords/values/z"].value();
-
-    data["topologies/mesh/type"]      = "rectilinear";
-    data["topologies/mesh/coordset"]  = "coords";
-
-    for(int dim = 0; dim < 3;++ dim)
-    {
-      coords[dim][0] = sdom.zeros[dim];
-      for(int z = 0;z < sdom.nzones[dim]; ++z)
-      {
-        coords[dim][1+z] = coords[dim][z] + sdom.deltas[dim][z];
-      }
-    }
-    data["fields/phi/association"] = "element";
-    data["fields/phi/topology"] = "mesh";
-    data["fields/phi/type"] = "scalar";
-  
-    data["fields/phi/values"].set(conduit::DataType::float64(sdom.num_zones));
-    conduit::float64 * phi_scalars = data["fields/phi/values"].value();
-
-    // TODO can we do this with strides and not copy?
-    for(int i = 0; i < sdom.num_zones; i++)
-    {
-      phi_scalars[i] = (*sdom.phi)(0,0,i);  
-    } 
-
+    wrapZoneSet(grid_data, sdom_idx, zero_copy, data);
   }//each sdom
   
    //------- end wrapping with Conduit here -------//
@@ -102,14 +201,15 @@ void writeData(Grid_Data *grid_data, int timeStep, const std::string& file)
 
   //Pass data to SENSEI
   if(timeStep == 0)
-    initialize(MPI_COMM_WORLD, &data, file);
+    initialize(MPI_COMM_WORLD, &data, file, zero_copy);
   analyze(&data);
 }
 
 /**
   Run solver iterations.
 */
-int SweepSolver (Grid_Data *grid_data, bool block_jacobi, const std::string& file)
+int SweepSolver (Grid_Data *grid_data, bool block_jacobi, const std::string& file,
+  bool zero_copy)
 {
 
 
@@ -189,7 +289,7 @@ int SweepSolver (Grid_Data *grid_data, bool block_jacobi, const std::string& fil
     }
    }//end main loop timing
     double part = grid_data->particleEdit();
-    writeData(grid_data, iter, file);
+    writeData(grid_data, iter, file, zero_copy);
     if(mpi_rank==0){
       printf("iter %d: particle count=%e, change=%e\n", iter, part, (part-part_last)/part);
     }
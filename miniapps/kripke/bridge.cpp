@@ -21,13 +21,15 @@ namespace BridgeGuts
 
 void initialize(MPI_Comm comm, 
                 conduit::Node* node, 
-                const std::string& config_file)
+                const std::string& config_file,
+                bool zero_copy)
 {
   //setup communication
   BridgeGuts::comm = comm;
     
   //data adaptor
   BridgeGuts::DataAdaptor = vtkSmartPointer<sensei::ConduitDataAdaptor>::New();
+  BridgeGuts::DataAdaptor->SetZeroCopy(zero_copy);
   BridgeGuts::DataAdaptor->Initialize(node); 
 
   //analysis adaptor
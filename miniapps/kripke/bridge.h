@@ -5,10 +5,12 @@
 #include <string>
 #include <conduit.hpp>
 
-  //called before the simulation loops
+  //called before the simulation loops. with zero_copy, contiguous fields
+  //in the node are used in place and must outlive the analyses' use of them
   void initialize(MPI_Comm world, 
                   conduit::Node* node, 
-                  const std::string& config_file);
+                  const std::string& config_file,
+                  bool zero_copy = false);
 
   //called during simulation loop to update node
   void analyze(conduit::Node* node); 
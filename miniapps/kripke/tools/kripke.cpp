@@ -70,6 +70,8 @@ void usage(void){
     printf("                         Default:  --zst 1:1:1\n");
     printf("  --zones <x,y,z>        Number of zones in x,y,z\n");
     printf("                         Default:  --zones 12,12,12\n");
+    printf("  --zerocopy             Pass fields to SENSEI as strided views of phi\n");
+    printf("                         instead of copies\n");
     printf("\n");
   }
   MPI_Finalize();
@@ -131,7 +133,8 @@ void runPoint(int point, int num_tasks, int num_threads, Input_Variables &input_
   grid_data->timing.setPapiEvents(papi_names);
 
   /* Run the solver */
-  SweepSolver(grid_data, input_variables.parallel_method == PMETHOD_BJ, file);
+  SweepSolver(grid_data, input_variables.parallel_method == PMETHOD_BJ, file,
+    input_variables.zero_copy);
 
 #ifdef KRIPKE_USE_SILO
   /* output silo data, if requested */
@@ -251,6 +254,7 @@ int main(int argc, char **argv) {
   double sigt[3] = {0.10, 0.0001, 0.10};
   double sigs[3] = {0.05, 0.00005, 0.05};
   bool test = false;
+  bool zero_copy = false;
   bool perf_tools = false;
   int restart_point = 0;
   ParallelMethod parallel_method = PMETHOD_SWEEP;
@@ -379,6 +383,9 @@ int main(int argc, char **argv) {
     else if(opt == "--test"){
       test = true;
     }
+    else if(opt == "--zerocopy"){
+      zero_copy = true;
+    }
     else if(opt == "--papi"){
       papi_names = split(cmd.pop(), ',');
     }
@@ -466,6 +473,9 @@ int main(int argc, char **argv) {
     if(perf_tools){
       printf("Using Google Perftools\n");
     }
+    if(zero_copy){
+      printf("Passing fields to SENSEI without copying\n");
+    }
   }
 
   /*
@@ -501,6 +511,7 @@ int main(int argc, char **argv) {
   ivars.num_zonesets_dim[1] = zset[1];
   ivars.num_zonesets_dim[2] = zset[2];
   ivars.parallel_method = parallel_method;
+  ivars.zero_copy = zero_copy;
 
   for(int mat = 0;mat < 3;++ mat){
     ivars.sigt[mat] = sigt[mat];
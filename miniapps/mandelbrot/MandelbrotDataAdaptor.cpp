@@ -25,8 +25,31 @@
 
 struct MandelbrotDataAdaptor::DInternals
 {
+  // get the patch index of the current hierarchy, it is built by the
+  // simulation after refinement
+  const patch_index_t *GetPatchIndex()
+  {
+    if (!this->sim->patch_index.valid)
+      patch_index_build(&this->sim->patch_index, &this->sim->patch);
+    return &this->sim->patch_index;
+  }
+
+  // the metadata returned last, it describes the hierarchy with the given
+  // version as it was when the simulation had the given window
+  bool HaveMetadata(const sensei::MeshMetadataFlags &flags) const
+  {
+    return this->metadata && (this->version == this->sim->hierarchy_version) &&
+      (this->metadata->Flags.BlockDecompSet() == flags.BlockDecompSet()) &&
+      (this->metadata->Flags.BlockSizeSet() == flags.BlockSizeSet()) &&
+      (this->metadata->Flags.BlockExtentsSet() == flags.BlockExtentsSet()) &&
+      (this->metadata->Flags.BlockBoundsSet() == flags.BlockBoundsSet()) &&
+      (this->metadata->Flags.BlockArrayRangeSet() == flags.BlockArrayRangeSet());
+  }
+
   simulation_data *sim;
   sensei::MeshMetadataPtr metadata;
+  long version;
+  float window[4];
 };
 
 //-----------------------------------------------------------------------------
@@ -179,8 +202,7 @@ int MandelbrotDataAdaptor::AddGhostCellsArray(vtkDataObject* mesh,
     }
 
   // get the simulation data
-  int np = 0;
-  patch_t **patches = patch_flat_array(&this->Internals->sim->patch, &np);
+  const patch_index_t *patches = this->Internals->GetPatchIndex();
 
   // walk over all local blocks and zero-copy simulation data into the blocks
   vtkOverlappingAMR *amrMesh = dynamic_cast<vtkOverlappingAMR*>(mesh);
@@ -196,11 +218,10 @@ int MandelbrotDataAdaptor::AddGhostCellsArray(vtkDataObject* mesh,
     int gid = amrMesh->GetAMRBlockSourceIndex(level, index);
 
     // get the simulation data
-    patch_t *patch = nullptr;
-    if (patch_find_patch(patches, np, gid, patch))
+    patch_t *patch = patch_index_find(patches, gid);
+    if (!patch)
       {
       it->Delete();
-      patch_free_flat_array(patches);
       SENSEI_ERROR("at level " << level << " index " << index << " no patch " << gid);
       return -1;
       }
@@ -226,7 +247,6 @@ int MandelbrotDataAdaptor::AddGhostCellsArray(vtkDataObject* mesh,
     }
 
   it->Delete();
-  patch_free_flat_array(patches);
 
   return 0;
 }
@@ -246,8 +266,7 @@ int MandelbrotDataAdaptor::AddArray(vtkDataObject* mesh, const std::string &mesh
     }
 
   // get the simulation data
-  int np = 0;
-  patch_t **patches = patch_flat_array(&this->Internals->sim->patch, &np);
+  const patch_index_t *patches = this->Internals->GetPatchIndex();
 
   // walk over all local blocks and zero-copy simulation data into the blocks
   vtkOverlappingAMR *amrMesh = dynamic_cast<vtkOverlappingAMR*>(mesh);
@@ -263,11 +282,10 @@ int MandelbrotDataAdaptor::AddArray(vtkDataObject* mesh, const std::string &mesh
     int gid = amrMesh->GetAMRBlockSourceIndex(level, index);
 
     // get the simulation data
-    patch_t *patch = nullptr;
-    if (patch_find_patch(patches, np, gid, patch))
+    patch_t *patch = patch_index_find(patches, gid);
+    if (!patch)
       {
       it->Delete();
-      patch_free_flat_array(patches);
       SENSEI_ERROR("at level " << level << " index " << index << " no patch " << gid);
       return -1;
       }
@@ -283,7 +301,6 @@ int MandelbrotDataAdaptor::AddArray(vtkDataObject* mesh, const std::string &mesh
     }
 
   it->Delete();
-  patch_free_flat_array(patches);
 
   return 0;
 }
@@ -310,6 +327,33 @@ int MandelbrotDataAdaptor::GetMeshMetadata(unsigned int id,
 
   DInternals &internals = (*this->Internals);
 
+  // while the hierarchy is unchanged the metadata from the last call is
+  // reused, only the bounds move with the simulation's window
+  if (internals.HaveMetadata(metadata->Flags))
+    {
+    const float *w0 = internals.window;
+    const float *w1 = internals.sim->patch.window;
+    double scale[2] = {(w1[1] - w1[0])/(w0[1] - w0[0]),
+      (w1[3] - w1[2])/(w0[3] - w0[2])};
+
+    *metadata = *internals.metadata;
+
+    if (metadata->Flags.BlockBoundsSet())
+      {
+      metadata->Bounds = {w1[0], w1[1], w1[2], w1[3], 0, 0};
+
+      unsigned int nBlocks = metadata->BlockBounds.size();
+      for (unsigned int i = 0; i < nBlocks; ++i)
+        {
+        std::array<double,6> &bounds = metadata->BlockBounds[i];
+        for (int j = 0; j < 4; ++j)
+          bounds[j] = w1[j & ~1] + (bounds[j] - w0[j & ~1])*scale[j/2];
+        }
+      }
+
+    return 0;
+    }
+
   metadata->MeshName = "mesh";
   metadata->MeshType = VTK_OVERLAPPING_AMR;
   metadata->BlockType = VTK_UNIFORM_GRID;
@@ -347,22 +391,30 @@ int MandelbrotDataAdaptor::GetMeshMetadata(unsigned int id,
     metadata->NumCells = 0;
     }
 
-  int np = 0;
-  patch_t **local_patches = patch_flat_array(&internals.sim->patch, &np);
+  const std::vector<patch_t*> &local_patches = internals.GetPatchIndex()->patches;
+  int np = local_patches.size();
+
+  // group the local patches by level in a single pass
+  std::vector<std::vector<int>> level_patches(metadata->NumLevels);
+  for(int i = 0; i < np; ++i)
+    {
+    // skip non local patches.
+    if (local_patches[i]->owners[0] != internals.sim->par_rank)
+      continue;
+
+    int j = local_patches[i]->level;
+    if ((j >= 0) && (j < metadata->NumLevels))
+      level_patches[j].push_back(i);
+    }
 
   metadata->BlocksPerLevel.resize(metadata->NumLevels);
 
   for (int j = 0; j < metadata->NumLevels; ++j)
     {
-    for(int i = 0; i < np; ++i)
+    int nlp = level_patches[j].size();
+    for(int k = 0; k < nlp; ++k)
       {
-      // skip non local patches.
-      if (local_patches[i]->owners[0] != internals.sim->par_rank)
-        continue;
-
-      // work level by level.
-      if (local_patches[i]->level != j)
-        continue;
+      int i = level_patches[j][k];
 
       metadata->NumBlocks += 1;
       metadata->NumBlocksLocal[0] += 1;
@@ -401,11 +453,14 @@ int MandelbrotDataAdaptor::GetMeshMetadata(unsigned int id,
       }
     }
 
-  patch_free_flat_array(local_patches);
-
   // AMR data is always to be a global view.
   metadata->GlobalizeView(this->GetCommunicator());
 
+  internals.metadata = metadata->NewCopy();
+  internals.version = internals.sim->hierarchy_version;
+  for (int i = 0; i < 4; ++i)
+    internals.window[i] = internals.sim->patch.window[i];
+
   return 0;
 }
 
@@ -6,12 +6,16 @@
 #include <sstream>
 #include <string>
 #include <iostream>
+#include <vector>
+#include <thread>
+#include <algorithm>
 
 #include <mpi.h>
 
 #include "patch.h"
 #include "simulation_data.h"
 #include "senseiConfig.h"
+#include <ThreadPool.h>
 #ifdef ENABLE_SENSEI
 #include <vtkNew.h>
 #include <vtkSmartPointer.h>
@@ -66,10 +70,89 @@ mandelbrot(const complex &C)
     return 0;
 }
 
+// Lane masked escape time iteration over LANES cells of a row at a time.
+// All lanes iterate until every lane has escaped, a lane's mask is cleared
+// when it escapes and the mask is summed to count its iterations. Escaped
+// lanes may overflow to inf and nan, which fails the escape test and so
+// leaves their count alone. Floats are used throughout so that the lane
+// loop vectorizes, and the arithmetic is that of mandelbrot() so that the
+// results match.
+#define LANES 16
+
+void
+mandelbrot_row_simd(unsigned char *data, int nx, float x0, float x1, float y)
+{
+    for(int i0 = 0; i0 < nx; i0 += LANES)
+    {
+        float cr[LANES], zr[LANES], zi[LANES], mask[LANES], count[LANES];
+        for(int l = 0; l < LANES; ++l)
+        {
+            float tx = (float)(i0 + l) / (float)(nx - 1);
+            cr[l] = x0 + tx * (x1 - x0);
+            zr[l] = 0.f;
+            zi[l] = 0.f;
+            mask[l] = 1.f;
+            count[l] = 0.f;
+        }
+
+        for(int zit = 0; zit < MAXIT; ++zit)
+        {
+            float nactive = 0.f;
+            for(int l = 0; l < LANES; ++l)
+            {
+                float r = zr[l] * zr[l] - zi[l] * zi[l] + cr[l];
+                float m = zr[l] * zi[l] + zi[l] * zr[l] + y;
+                zr[l] = r;
+                zi[l] = m;
+                mask[l] = r * r + m * m > 4.f ? 0.f : mask[l];
+                count[l] += mask[l];
+                nactive += mask[l];
+            }
+            if(nactive == 0.f)
+                break;
+        }
+
+        // a lane that escapes on iteration zit was counted zit times
+        int n = nx - i0 < LANES ? nx - i0 : LANES;
+        for(int l = 0; l < n; ++l)
+            data[i0 + l] = count[l] == (float)MAXIT ? 0 :
+                (unsigned char)(count[l] + 1.f);
+    }
+}
+
+void
+mandelbrot_row(unsigned char *data, int nx, float x0, float x1, float y)
+{
+    for(int i = 0; i < nx; ++i)
+    {
+        float tx = (float)i / (float)(nx - 1);
+        float x = x0 + tx * (x1 - x0);
+
+        *data++ = mandelbrot(complex(x, y));
+    }
+}
+
+// -----------------------------------------------------------------------------
+// @brief Calls rows(j) for each j in [0, nrows) on the threads of the pool.
+//        Rows are handed out one at a time since their cost varies. The
+//        pool's threads persist across patches and steps.
+//
+template <typename rows_t>
+void
+parallel_rows(int nrows, const rows_t &rows)
+{
+    sensei::ThreadPool::ParallelFor(nrows, [&](unsigned int j) -> int
+    {
+        rows(j);
+        return 0;
+    });
+}
+
 void
-calculate_data(patch_t *patch)
+calculate_data(patch_t *patch, simulation_data *sim)
 {
     unsigned char *data = patch->data;
+    int nx = patch->nx;
 
     // Compute x0, x1 and y0,y1 which help us locate cell centers.
     float cellWidth = (patch->window[1] - patch->window[0]) / ((float)patch->nx);
@@ -78,18 +161,63 @@ calculate_data(patch_t *patch)
     float cellHeight = (patch->window[3] - patch->window[2]) / ((float)patch->ny);
     float y0 = patch->window[2] + cellHeight / 2.f;
     float y1 = patch->window[3] - cellHeight / 2.f;
-    for(int j = 0; j < patch->ny; ++j)
+
+    bool simd = sim->kernel != KERNEL_SCALAR;
+    parallel_rows(patch->ny, [&](int j)
     {
         float ty = (float)j / (float)(patch->ny - 1);
         float y = y0 + ty * (y1 - y0);
-        for(int i = 0; i < patch->nx; ++i)
-        {
-            float tx = (float)i / (float)(patch->nx - 1);
-            float x = x0 + tx * (x1 - x0);
+        if(simd)
+            mandelbrot_row_simd(data + (size_t)j * nx, nx, x0, x1, y);
+        else
+            mandelbrot_row(data + (size_t)j * nx, nx, x0, x1, y);
+    });
 
-            *data++ = mandelbrot(complex(x, y));
+    if(sim->kernel == KERNEL_VERIFY)
+    {
+        std::vector<unsigned char> row(nx);
+        for(int j = 0; j < patch->ny; ++j)
+        {
+            float ty = (float)j / (float)(patch->ny - 1);
+            float y = y0 + ty * (y1 - y0);
+            mandelbrot_row(row.data(), nx, x0, x1, y);
+            for(int i = 0; i < nx; ++i)
+                sim->kernel_mismatches += row[i] != data[(size_t)j * nx + i];
         }
+        sim->kernel_cells += (long long)nx * patch->ny;
+    }
+}
+
+// -----------------------------------------------------------------------------
+// @brief The cost of computing cells [i0,i1] x [j0,j1] of a patch, as the sum
+//        of their escape iterations.
+//
+double
+patch_cost(const patch_t *patch, int i0, int i1, int j0, int j1)
+{
+    double cost = 0.;
+    for(int j = j0; j <= j1; ++j)
+    {
+        const unsigned char *data = patch->data + (size_t)j * patch->nx;
+        for(int i = i0; i <= i1; ++i)
+            cost += data[i] ? data[i] : MAXIT;
     }
+    return cost;
+}
+
+// -----------------------------------------------------------------------------
+// @brief Estimates the cost of computing a subpatch from the data on its
+//        parent, each parent cell is refined into rr x rr cells that take
+//        about as many iterations.
+//
+double
+estimate_subpatch_cost(const patch_t *patch, const patch_t *sub, int rr)
+{
+    int i0 = sub->logical_extents[0] / rr - patch->logical_extents[0];
+    int i1 = (sub->logical_extents[1] + 1) / rr - 1 - patch->logical_extents[0];
+    int j0 = sub->logical_extents[2] / rr - patch->logical_extents[2];
+    int j1 = (sub->logical_extents[3] + 1) / rr - 1 - patch->logical_extents[2];
+    return rr * rr * patch_cost(patch, i0, i1, j0, j1);
 }
 
 //*****************************************************************************
@@ -250,6 +378,120 @@ sort_owners_by_workload(MPI_Comm comm, simulation_data *sim, patch_t *patch)
 }
 #endif
 
+// -----------------------------------------------------------------------------
+// @brief This routine is called among the owners of a patch to share the cost
+//        of the patches that each has computed so far this step.
+//
+void
+gather_owner_work(MPI_Comm comm, simulation_data *sim, patch_t *patch,
+    std::vector<double> &work)
+{
+    int tag = 1002, tag2 = 1003;
+    work.resize(patch->nowners);
+    if(sim->par_rank == patch->owners[0])
+    {
+        work[0] = sim->work;
+        MPI_Status status;
+        for(int i = 1; i < patch->nowners; ++i)
+            MPI_Recv(&work[i], 1, MPI_DOUBLE, patch->owners[i], tag, comm, &status);
+        for(int i = 1; i < patch->nowners; ++i)
+            MPI_Send(work.data(), patch->nowners, MPI_DOUBLE, patch->owners[i], tag2, comm);
+    }
+    else
+    {
+        MPI_Send(&sim->work, 1, MPI_DOUBLE, patch->owners[0], tag, comm);
+        MPI_Status status;
+        MPI_Recv(work.data(), patch->nowners, MPI_DOUBLE, patch->owners[0], tag2, comm, &status);
+    }
+}
+
+// -----------------------------------------------------------------------------
+// @brief Assigns the subpatches of a patch to its owners by estimated cost.
+//        Subpatches that cost more than an owner's share are first bisected.
+//        Then when there are at least as many subpatches as owners the
+//        longest processing time first rule is used: the most costly
+//        subpatch goes to the owner with the least work, and so on. Otherwise
+//        the owners are ordered by work and share the subpatches round robin.
+//        The result is a list of owner, subpatch index pairs. All of the
+//        owners compute the same assignment since they have the same patch.
+//
+void
+assign_subpatches_by_cost(MPI_Comm comm, simulation_data *sim, patch_t *patch,
+    std::vector<int> &assignment)
+{
+    if(patch->nsubpatches == 0)
+        return;
+
+    std::vector<double> work;
+    gather_owner_work(comm, sim, patch, work);
+
+    std::vector<double> cost(patch->nsubpatches);
+    double total = 0.;
+    for(int i = 0; i < patch->nsubpatches; ++i)
+    {
+        cost[i] = estimate_subpatch_cost(patch, &patch->subpatches[i],
+            sim->refinement_ratio);
+        total += cost[i];
+    }
+
+    // Bisect subpatches that cost more than an owner's share, largest first,
+    // so that there are pieces to balance.
+    double share = total / patch->nowners;
+    std::vector<int> split(patch->nsubpatches, 1);
+    while(true)
+    {
+        int k = -1;
+        for(int i = 0; i < patch->nsubpatches; ++i)
+            if(split[i] && (cost[i] > share) && ((k < 0) || (cost[i] > cost[k])))
+                k = i;
+        if(k < 0)
+            break;
+
+        int nsub = patch->nsubpatches;
+        if(patch_split_subpatch(patch, k, sim->refinement_ratio))
+        {
+            cost[k] = estimate_subpatch_cost(patch, &patch->subpatches[k],
+                sim->refinement_ratio);
+            cost.push_back(estimate_subpatch_cost(patch, &patch->subpatches[nsub],
+                sim->refinement_ratio));
+            split.push_back(1);
+        }
+        else
+            split[k] = 0;
+    }
+
+    if(patch->nsubpatches < patch->nowners)
+    {
+        std::vector<int> order(patch->nowners);
+        for(int i = 0; i < patch->nowners; ++i)
+            order[i] = i;
+        std::stable_sort(order.begin(), order.end(),
+            [&work](int a, int b) { return work[a] < work[b]; });
+
+        for(int i = 0; i < patch->nowners; ++i)
+        {
+            assignment.push_back(patch->owners[order[i]]);
+            assignment.push_back(i % patch->nsubpatches);
+        }
+        return;
+    }
+
+    std::vector<int> order(patch->nsubpatches);
+    for(int i = 0; i < patch->nsubpatches; ++i)
+        order[i] = i;
+    std::stable_sort(order.begin(), order.end(),
+        [&cost](int a, int b) { return cost[a] > cost[b]; });
+
+    for(int i = 0; i < patch->nsubpatches; ++i)
+    {
+        int sub = order[i];
+        int owner = std::min_element(work.begin(), work.end()) - work.begin();
+        work[owner] += cost[sub];
+        assignment.push_back(patch->owners[owner]);
+        assignment.push_back(sub);
+    }
+}
+
 // -----------------------------------------------------------------------------
 // @brief Takes the input patch and doles out the subpatches it contains to the
 //        ranks that own the input patch.
@@ -265,20 +507,34 @@ assign_patches(MPI_Comm comm, simulation_data *sim, patch_t *patch)
         fprintf(debuglog, "assign_patches: Current patch refined into %d subpatches\n", patch->nsubpatches);
 #endif
 
-#if 1
-        // Sort the owner list by the total amount of work so the least loaded
-        // ranks are first in the list.
-        if(sim->balance)
-            sort_owners_by_workload(comm, sim, patch);
-#endif
         // The current patch exists on more than one rank. Divide the
         // refined patch list among those ranks.
-        int n = std::max(patch->nowners, patch->nsubpatches);
+        std::vector<int> assignment;
+        if(sim->balance == BALANCE_COST)
+        {
+            assign_subpatches_by_cost(comm, sim, patch, assignment);
+        }
+        else
+        {
+#if 1
+            // Sort the owner list by the total amount of work so the least loaded
+            // ranks are first in the list.
+            if(sim->balance == BALANCE_COUNT)
+                sort_owners_by_workload(comm, sim, patch);
+#endif
+            int n = std::max(patch->nowners, patch->nsubpatches);
+            for(int i = 0; i < n; ++i)
+            {
+                assignment.push_back(patch->owners[i % patch->nowners]);
+                assignment.push_back(i % patch->nsubpatches);
+            }
+        }
+
         std::vector<int> patches_owned_by_this_rank;
-        for(int i = 0; i < n; ++i)
+        for(size_t i = 0; i < assignment.size(); i += 2)
         {
-            int owner = patch->owners[i % patch->nowners];
-            int subpatchIndex = i % patch->nsubpatches;
+            int owner = assignment[i];
+            int subpatchIndex = assignment[i+1];
             patch_add_owner(&patch->subpatches[subpatchIndex], owner);
 
             if(owner == sim->par_rank)
@@ -332,7 +588,8 @@ calculate_amr_helper(MPI_Comm comm, simulation_data *sim, patch_t *patch, int le
 
     // Calculate the data on this patch
     patch_alloc_data(patch, patch->nx, patch->ny);
-    calculate_data(patch);
+    calculate_data(patch, sim);
+    sim->work += patch_cost(patch, 0, patch->nx - 1, 0, patch->ny - 1);
 
     if(level+1 > sim->max_levels)
         return;
@@ -360,6 +617,48 @@ calculate_amr_helper(MPI_Comm comm, simulation_data *sim, patch_t *patch, int le
     }
 }
 
+// -----------------------------------------------------------------------------
+// @brief Recomputes the data on a patch of the previous step's hierarchy. The
+//        patch keeps its subpatches, their data and their ids if the cells
+//        flagged for refinement changed by no more than the regrid tolerance,
+//        otherwise it is refined again. Returns 1 if the hierarchy changed.
+//
+int
+regrid_amr_helper(MPI_Comm comm, simulation_data *sim, patch_t *patch)
+{
+    calculate_data(patch, sim);
+    sim->work += patch_cost(patch, 0, patch->nx - 1, 0, patch->ny - 1);
+
+    if(patch->level+1 > sim->max_levels)
+        return 0;
+
+    image_t mask;
+    mask.nx = patch->nx;
+    mask.ny = patch->ny;
+    mask.data = ALLOC(mask.nx*mask.ny, unsigned char);
+    detect_refinement(patch, &mask);
+    long long nchanged = patch_count_mask_changes(patch, &mask);
+    FREE(mask.data);
+
+    if(nchanged > sim->regrid_tolerance * patch->nx * patch->ny)
+    {
+        // The owners of a shared patch all come to the same decision since
+        // they have the same data.
+        patch_free_subpatches(patch);
+        patch_refine(patch, sim->refinement_ratio, detect_refinement);
+        assign_patches(comm, sim, patch);
+        for(int i = 0; i < patch->nsubpatches; ++i)
+            calculate_amr_helper(comm, sim, &patch->subpatches[i], patch->level+1);
+        return 1;
+    }
+
+    int changed = 0;
+    patch_update_subpatch_windows(patch, sim->refinement_ratio);
+    for(int i = 0; i < patch->nsubpatches; ++i)
+        changed |= regrid_amr_helper(comm, sim, &patch->subpatches[i]);
+    return changed;
+}
+
 // -----------------------------------------------------------------------------
 // @brief Assigns unique ids to the patches across all processors. Only the patches
 //        that a processor owns will get patch ids. The remaining patches that are
@@ -471,12 +770,19 @@ calculate_amr(MPI_Comm comm, simulation_data *sim)
     debuglog = fopen(filename, "wt");
 #endif
 
+    sim->hierarchy_changed = true;
+    sim->hierarchy_version += 1;
+
     // Compute the AMR patches.
+    sim->work = 0.;
     calculate_amr_helper(comm, sim, &sim->patch, 0);
 
     // Assign ids to all of the AMR patches.
     assign_unique_patch_ids(comm, sim);
 
+    // Index the patches by id for the data adaptor.
+    patch_index_build(&sim->patch_index, &sim->patch);
+
 #ifdef DO_LOG
     if(debuglog != NULL)
     {
@@ -486,6 +792,111 @@ calculate_amr(MPI_Comm comm, simulation_data *sim)
 #endif
 }
 
+// -----------------------------------------------------------------------------
+// @brief Records the id, level and logical extents of the patches on this rank.
+//
+void
+patch_signature(simulation_data *sim, std::vector<int> &sig)
+{
+    int np = 0;
+    patch_t **patches = patch_flat_array(&sim->patch, &np);
+    int next = sizeof(patches[0]->logical_extents) / sizeof(int);
+    for(int i = 0; i < np; ++i)
+    {
+        sig.push_back(patches[i]->id);
+        sig.push_back(patches[i]->level);
+        sig.insert(sig.end(), patches[i]->logical_extents,
+            patches[i]->logical_extents + next);
+    }
+    FREE(patches);
+}
+
+// -----------------------------------------------------------------------------
+// @brief Recomputes the data on the previous step's hierarchy, refining again
+//        only the patches whose flagged cells changed. Patch ids are assigned
+//        again and hierarchy_changed is set if any rank's hierarchy changed.
+//        When no rank's hierarchy changed the patches must keep their ids, a
+//        non-zero value is returned if they did not.
+//
+int
+regrid_amr(MPI_Comm comm, simulation_data *sim)
+{
+    std::vector<int> sig0;
+    patch_signature(sim, sig0);
+
+    sim->work = 0.;
+    int changed = regrid_amr_helper(comm, sim, &sim->patch);
+
+    MPI_Allreduce(MPI_IN_PLACE, &changed, 1, MPI_INT, MPI_MAX, comm);
+    sim->hierarchy_changed = changed;
+    sim->hierarchy_version += changed;
+
+    if(changed)
+    {
+        assign_unique_patch_ids(comm, sim);
+        patch_index_build(&sim->patch_index, &sim->patch);
+        return 0;
+    }
+
+    std::vector<int> sig1;
+    patch_signature(sim, sig1);
+
+    int status = sig0 != sig1 ? 1 : 0;
+    MPI_Allreduce(MPI_IN_PLACE, &status, 1, MPI_INT, MPI_MAX, comm);
+
+    if(sim->par_rank == 0)
+    {
+        if(status)
+            std::cerr << "ERROR: cycle " << sim->cycle << " the hierarchy is"
+                << " unchanged but the patch ids changed" << std::endl;
+        else
+            std::cerr << "cycle " << sim->cycle << " the hierarchy is"
+                << " unchanged and the patch ids were kept" << std::endl;
+    }
+
+    return status;
+}
+
+// -----------------------------------------------------------------------------
+// @brief Reports, for each level, the largest and the mean over the ranks of
+//        the cost of the patches that each rank computed, and the imbalance,
+//        their ratio. Must be called on all ranks after calculate_amr.
+//        Returns the largest imbalance over the levels on all ranks.
+//
+double
+report_balance(MPI_Comm comm, simulation_data *sim, std::ostream &os)
+{
+    int nlevels = sim->max_levels + 1;
+    std::vector<double> cost(nlevels, 0.), maxcost(nlevels), sumcost(nlevels);
+
+    const std::vector<patch_t *> &patches = sim->patch_index.patches;
+    for(size_t i = 0; i < patches.size(); ++i)
+    {
+        const patch_t *p = patches[i];
+        if(p->level < nlevels)
+            cost[p->level] += patch_cost(p, 0, p->nx - 1, 0, p->ny - 1);
+    }
+
+    MPI_Allreduce(cost.data(), maxcost.data(), nlevels, MPI_DOUBLE, MPI_MAX, comm);
+    MPI_Allreduce(cost.data(), sumcost.data(), nlevels, MPI_DOUBLE, MPI_SUM, comm);
+
+    double imbalance = 1.;
+    for(int i = 0; i < nlevels; ++i)
+    {
+        double mean = sumcost[i] / sim->par_size;
+        double level_imbalance = mean > 0. ? maxcost[i] / mean : 1.;
+        imbalance = std::max(imbalance, level_imbalance);
+        if(sim->par_rank == 0)
+        {
+            os << "cycle " << sim->cycle << " level " << i << " cost max "
+               << maxcost[i] << " mean " << mean << " imbalance "
+               << level_imbalance << std::endl;
+        }
+    }
+
+    return imbalance;
+}
+
 // -----------------------------------------------------------------------------
 // @brief Handle command line arguments.
 //
@@ -498,7 +909,9 @@ handle_command_line(int argc, char **argv, simulation_data *sim,
         if (strcmp(argv[i], "-h") == 0)
         {
             std::cerr << "usage: mandelbrot [-i num iterations] "
-                << "[-f SENSEI analysis XML] [-l max level] [-b balance]"
+                << "[-f SENSEI analysis XML] [-l max level] [-b balance] [-bc balance cost] "
+                << "[-t num threads] [-k scalar|simd|verify] [-ir incremental regrid] "
+                << "[-rt regrid tolerance] [-rb rebalance tolerance]"
                 << std::endl;
             exit(0);
         }
@@ -539,12 +952,53 @@ handle_command_line(int argc, char **argv, simulation_data *sim,
         else if((strcmp(argv[i], "-b") == 0 ||
                  strcmp(argv[i], "-balance") == 0))
         {
-            sim->balance = true;
+            sim->balance = BALANCE_COUNT;
+        }
+        else if((strcmp(argv[i], "-bc") == 0 ||
+                 strcmp(argv[i], "-balance_cost") == 0))
+        {
+            sim->balance = BALANCE_COST;
         }
         else if(strcmp(argv[i], "-log") == 0)
         {
             sim->log = true;
         }
+        else if((strcmp(argv[i], "-ir") == 0 ||
+                 strcmp(argv[i], "-incremental_regrid") == 0))
+        {
+            sim->incremental = true;
+        }
+        else if((strcmp(argv[i], "-rt") == 0 ||
+                 strcmp(argv[i], "-regrid_tolerance") == 0) && (i+1)<argc)
+        {
+            sim->regrid_tolerance = atof(argv[i+1]);
+            i++;
+        }
+        else if((strcmp(argv[i], "-rb") == 0 ||
+                 strcmp(argv[i], "-rebalance_tolerance") == 0) && (i+1)<argc)
+        {
+            sim->rebalance_tolerance = atof(argv[i+1]);
+            i++;
+        }
+        else if((strcmp(argv[i], "-t") == 0 ||
+                 strcmp(argv[i], "-threads") == 0) && (i+1)<argc)
+        {
+            sim->nthreads = atoi(argv[i+1]);
+            if(sim->nthreads < 1)
+                sim->nthreads = std::thread::hardware_concurrency();
+            i++;
+        }
+        else if((strcmp(argv[i], "-k") == 0 ||
+                 strcmp(argv[i], "-kernel") == 0) && (i+1)<argc)
+        {
+            if(strcmp(argv[i+1], "scalar") == 0)
+                sim->kernel = KERNEL_SCALAR;
+            else if(strcmp(argv[i+1], "simd") == 0)
+                sim->kernel = KERNEL_SIMD;
+            else if(strcmp(argv[i+1], "verify") == 0)
+                sim->kernel = KERNEL_VERIFY;
+            i++;
+        }
     }
 }
 
@@ -581,6 +1035,9 @@ int main(int argc, char **argv)
     // Handle any command line args.
     handle_command_line(argc, argv, &sim, max_iter, nx, ny, config_file);
 
+    // the rows of the patches are computed on the threads of the pool
+    sensei::ThreadPool::SetNumberOfThreads(sim.nthreads);
+
 #ifdef ENABLE_SENSEI
     sensei::Profiler::Initialize();
 
@@ -613,6 +1070,7 @@ int main(int argc, char **argv)
         patch0_owners[i] = i;
 
     // Iterate.
+    int status = 0;
     for(sim.cycle = 0; sim.cycle < max_iter; ++sim.cycle)
     {
         const float window0[] = {-1.6f, 0.6f, -1.1f, 1.1f};
@@ -637,26 +1095,51 @@ int main(int argc, char **argv)
                       << window[2] << ", " << window[3] << std::endl;
         }
 
-        // Blow away the previous patch data and calculate.
-        sim.patch.owners = NULL;
-        patch_dtor(&sim.patch);
-        patch_ctor(&sim.patch);
-        sim.patch.owners = patch0_owners;
-        sim.patch.nowners = sim.par_size;
-        sim.patch.window[0] = window[0];
-        sim.patch.window[1] = window[1];
-        sim.patch.window[2] = window[2];
-        sim.patch.window[3] = window[3];
-        sim.patch.logical_extents[0] = 0;
-        sim.patch.logical_extents[1] = nx-1;
-        sim.patch.logical_extents[2] = 0;
-        sim.patch.logical_extents[3] = ny-1;
-        sim.patch.nx = nx;
-        sim.patch.ny = ny;
 #ifdef ENABLE_SENSEI
         sensei::Profiler::StartEvent("mandelbrot::compute");
 #endif
-        calculate_amr(MPI_COMM_WORLD, &sim);
+        // The subpatches that incremental regridding keeps are not
+        // reassigned, the hierarchy is built again when the last step's
+        // imbalance grew too far past that of the last build.
+        double max_imbalance = sim.rebalance_tolerance * sim.built_imbalance;
+        bool rebalance = sim.imbalance > max_imbalance;
+        if(sim.incremental && sim.cycle > 0 && rebalance && sim.par_rank == 0)
+        {
+            std::cerr << "cycle " << sim.cycle << " imbalance " << sim.imbalance
+                << " exceeds " << max_imbalance << ", rebalancing" << std::endl;
+        }
+
+        bool regridded = sim.incremental && sim.cycle > 0 && !rebalance;
+        if(regridded)
+        {
+            // Recompute the data on the patches, refining only where needed.
+            sim.patch.window[0] = window[0];
+            sim.patch.window[1] = window[1];
+            sim.patch.window[2] = window[2];
+            sim.patch.window[3] = window[3];
+            status |= regrid_amr(MPI_COMM_WORLD, &sim);
+        }
+        else
+        {
+            // Blow away the previous patch data and calculate.
+            patch_index_invalidate(&sim.patch_index);
+            sim.patch.owners = NULL;
+            patch_dtor(&sim.patch);
+            patch_ctor(&sim.patch);
+            sim.patch.owners = patch0_owners;
+            sim.patch.nowners = sim.par_size;
+            sim.patch.window[0] = window[0];
+            sim.patch.window[1] = window[1];
+            sim.patch.window[2] = window[2];
+            sim.patch.window[3] = window[3];
+            sim.patch.logical_extents[0] = 0;
+            sim.patch.logical_extents[1] = nx-1;
+            sim.patch.logical_extents[2] = 0;
+            sim.patch.logical_extents[3] = ny-1;
+            sim.patch.nx = nx;
+            sim.patch.ny = ny;
+            calculate_amr(MPI_COMM_WORLD, &sim);
+        }
 
         if(sim.log && sim.par_rank == 0)
         {
@@ -665,6 +1148,13 @@ int main(int argc, char **argv)
                 log << i << " " << sim.npatches_per_rank[i] << std::endl;
         }
 
+        if(sim.balance != BALANCE_NONE)
+        {
+            sim.imbalance = report_balance(MPI_COMM_WORLD, &sim, std::cerr);
+            if(!regridded)
+                sim.built_imbalance = sim.imbalance;
+        }
+
 #ifdef ENABLE_SENSEI
         sensei::Profiler::EndEvent("mandelbrot::compute");
 
@@ -679,6 +1169,24 @@ int main(int argc, char **argv)
         sim.time += 0.1;
     }
 
+    // Report the differences between the kernels.
+    if(sim.kernel == KERNEL_VERIFY)
+    {
+        long long counts[2] = {sim.kernel_cells, sim.kernel_mismatches};
+        MPI_Allreduce(MPI_IN_PLACE, counts, 2, MPI_LONG_LONG, MPI_SUM,
+            MPI_COMM_WORLD);
+
+        // the kernels do the same arithmetic, which is not contracted, so
+        // every cell must agree
+        status |= counts[1] ? 1 : 0;
+        if(sim.par_rank == 0)
+        {
+            std::cerr << (counts[1] ? "ERROR: " : "") << counts[1] << " of "
+                << counts[0] << " cells differ between the simd and scalar"
+                << " kernels" << std::endl;
+        }
+    }
+
     // Cleanup
     if(sim.log && sim.par_rank == 0)
         log.close();
@@ -691,5 +1199,5 @@ int main(int argc, char **argv)
 #endif
     MPI_Finalize();
 
-    return 0;
+    return status;
 }
@@ -8,8 +8,20 @@ simulation_data::simulation_data()
     time = 0.;
     max_levels = 2;
     refinement_ratio = 2;
-    balance = false;
+    balance = BALANCE_NONE;
     log = false;
+    nthreads = 1;
+    kernel = KERNEL_SIMD;
+    kernel_cells = 0;
+    kernel_mismatches = 0;
+    work = 0.;
+    incremental = false;
+    regrid_tolerance = 0.01f;
+    rebalance_tolerance = 1.25f;
+    imbalance = 1.;
+    built_imbalance = 1.;
+    hierarchy_changed = true;
+    hierarchy_version = 0;
     patch_ctor(&patch);
     npatches_per_rank = NULL;
     npatches_per_level = NULL;
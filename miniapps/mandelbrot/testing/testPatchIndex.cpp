@@ -0,0 +1,93 @@
+#include "patch.h"
+
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+// Builds a hierarchy of patches and checks that the patch index finds the
+// same patch as a search of the flat array, and reports the time taken by
+// each to look up every patch.
+//
+// usage: testPatchIndex [number of patches] [refinement ratio]
+
+int main(int argc, char **argv)
+{
+    int npatches = argc > 1 ? atoi(argv[1]) : 100000;
+    int ratio = argc > 2 ? atoi(argv[2]) : 2;
+    int nsub = ratio*ratio;
+
+    // refine breadth first until there are enough patches. every 16th
+    // patch repeats the id of the one before it, as the duplicates of
+    // patches owned by other ranks do.
+    patch_t root;
+    patch_ctor(&root);
+
+    std::vector<patch_t *> queue(1, &root);
+    int n = 1;
+    for(size_t q = 0; (q < queue.size()) && (n < npatches); ++q)
+    {
+        patch_t *sub = patch_add_subpatches(queue[q], nsub);
+        for(int i = 0; i < nsub; ++i, ++n)
+        {
+            sub[i].id = (n % 16) ? n : n - 1;
+            sub[i].level = queue[q]->level + 1;
+            queue.push_back(&sub[i]);
+        }
+    }
+
+    int np = 0;
+    patch_t **plist = patch_flat_array(&root, &np);
+
+    typedef std::chrono::high_resolution_clock clock;
+
+    clock::time_point t0 = clock::now();
+    patch_index_t index;
+    patch_index_build(&index, &root);
+    std::vector<patch_t *> found(np);
+    for(int i = 0; i < np; ++i)
+        found[i] = patch_index_find(&index, plist[i]->id);
+    double indexTime = std::chrono::duration<double>(clock::now() - t0).count();
+
+    // the search is quadratic, time a subset and scale up
+    int stride = np > 10000 ? np/10000 : 1;
+    int testResult = 0;
+    t0 = clock::now();
+    for(int i = 0; i < np; i += stride)
+    {
+        patch_t *p = nullptr;
+        patch_find_patch(plist, np, plist[i]->id, p);
+        if(p != found[i])
+        {
+            std::cerr << "ERROR: patch " << i << " with id " << plist[i]->id
+                << " was not found" << std::endl;
+            testResult = -1;
+            break;
+        }
+    }
+    double searchTime = stride*
+        std::chrono::duration<double>(clock::now() - t0).count();
+
+    if((int)index.patches.size() != np || !index.valid ||
+        patch_index_find(&index, -1) != nullptr)
+    {
+        std::cerr << "ERROR: the index has " << index.patches.size()
+            << " patches, expected " << np << std::endl;
+        testResult = -1;
+    }
+
+    patch_index_invalidate(&index);
+    if(index.valid || !index.patches.empty() || !index.ids.empty())
+    {
+        std::cerr << "ERROR: the index was not cleared" << std::endl;
+        testResult = -1;
+    }
+
+    std::cerr << np << " patches, index " << indexTime << " s, search "
+        << searchTime << " s " << (testResult ? "failed" : "passed")
+        << std::endl;
+
+    patch_free_flat_array(plist);
+    patch_dtor(&root);
+
+    return testResult;
+}
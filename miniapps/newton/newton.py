@@ -57,7 +57,7 @@ class uniform_random_ic(initial_condition):
         self.n_bodies_global = npts
         n_lg = npts % n_ranks
         n_sm = n_ranks - n_lg
-        npts_sm = npts / n_ranks
+        npts_sm = npts // n_ranks
         self.n_bodies_local = npts_sm + (1 if rank > n_sm else 0)
         self.set_number_of_bodies(self.n_bodies_local)
         self.set_time_step(4*24*3600)
@@ -298,7 +298,9 @@ def check_arg(dic, arg, dfl=None, req=True):
     return True
 
 class data_adaptor:
-    def __init__(self):
+    def __init__(self, zero_copy=True):
+        # when set the VTK arrays share the simulation's memory
+        self.zero_copy = zero_copy
         # data from sim
         self.arrays = {}
         self.points = None
@@ -328,10 +330,17 @@ class data_adaptor:
         self.SetDataTime(t)
         self.SetDataTimeStep(i)
 
-    def set_array_1(self, vals, name):
-        arr = vtknp.numpy_to_vtk(vals, 1)
+    def to_vtk(self, vals, name=''):
+        if self.zero_copy:
+            # no copy is made. the VTK array keeps vals alive. this is safe
+            # because the analysis runs before the next solver step
+            return sensei.NumpyToVTK(vals, name)
+        arr = vtknp.numpy_to_vtk(vals, deep=1)
         arr.SetName(name)
-        self.arrays[name] = arr
+        return arr
+
+    def set_array_1(self, vals, name):
+        self.arrays[name] = self.to_vtk(vals, name)
 
     def set_array_3(self, vx,vy,vz, name):
         # scalars
@@ -339,20 +348,16 @@ class data_adaptor:
         self.set_array_1(vy, name + 'y')
         self.set_array_1(vz, name + 'z')
         # vector
-        nx = len(x)
-        vxyz = np.zeros(3*nx, dtype=vx.dtype)
-        vxyz[::3] = vx
-        vxyz[1::3] = vy
-        vxyz[2::3] = vz
-        vtkv = vtknp.numpy_to_vtk(vxyz, deep=1)
-        vtkv.SetName(name)
-        self.arrays[name] = vtkv
+        nx = len(vx)
+        vxyz = np.empty((nx, 3), dtype=vx.dtype)
+        vxyz[:,0] = vx
+        vxyz[:,1] = vy
+        vxyz[:,2] = vz
+        self.arrays[name] = self.to_vtk(vxyz, name)
         # mag
         mname = 'mag%s'%(name)
         mv = np.sqrt(vx**2 + vy**2 + vz**2)
-        vtkmv = vtknp.numpy_to_vtk(mv, deep=1)
-        vtkmv.SetName(mname)
-        self.arrays[mname] = vtkmv
+        self.arrays[mname] = self.to_vtk(mv, mname)
 
     def set_geometry(self, x,y,z):
         # scalars
@@ -361,15 +366,12 @@ class data_adaptor:
         self.set_array_1(z, 'z')
         # points
         nx = len(x)
-        xyz = np.zeros(3*nx, dtype=x.dtype)
-        xyz[::3] = x[:]
-        xyz[1::3] = y[:]
-        xyz[2::3] = z[:]
-        vxyz = vtknp.numpy_to_vtk(xyz, deep=1)
-        vxyz.SetNumberOfComponents(3)
-        vxyz.SetNumberOfTuples(nx)
+        xyz = np.empty((nx, 3), dtype=x.dtype)
+        xyz[:,0] = x
+        xyz[:,1] = y
+        xyz[:,2] = z
         pts = vtk.vtkPoints()
-        pts.SetData(vxyz)
+        pts.SetData(self.to_vtk(xyz))
         self.points = pts
         # cells
         cids = np.empty(2*nx, dtype=np.int32)
@@ -462,13 +464,13 @@ class data_adaptor:
         return callback
 
 class analysis_adaptor:
-    def __init__(self):
-        self.DataAdaptor = data_adaptor()
+    def __init__(self, zero_copy=True):
+        self.DataAdaptor = data_adaptor(zero_copy)
         self.AnalysisAdaptor = None
 
     def initialize(self, analysis, args=''):
         self.Analysis = analysis
-	args = csv_str_to_dict(args)
+        args = csv_str_to_dict(args)
         # Libsim
         if analysis == 'libsim':
             imProps = sensei.LibsimImageProperties()
@@ -532,6 +534,10 @@ if __name__ == '__main__':
     parser.add_argument('--dt', type=float,
         help="Time step in seconds")
 
+    parser.add_argument('--zero_copy', type=int, default=1,
+        help="Pass simulation arrays to SENSEI without copying (1) " \
+             "or deep copy them (0)")
+
     args = parser.parse_args()
 
     # set up the initial condition
@@ -544,7 +550,7 @@ if __name__ == '__main__':
     h = args.dt if args.dt else ic.get_time_step()
 
     # create an analysis adaptor
-    adaptor = analysis_adaptor()
+    adaptor = analysis_adaptor(args.zero_copy != 0)
     adaptor.initialize(args.analysis, args.analysis_opts)
 
     # print the config
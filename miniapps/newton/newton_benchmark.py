@@ -0,0 +1,84 @@
+from mpi4py import *
+import sensei
+import vtk, vtk.util.numpy_support as vtknp
+import numpy as np, sys, argparse
+import newton
+
+# Times the newton miniapp's analysis path, i.e. publishing the simulation
+# state through the ProgrammableDataAdaptor and reading every array back
+# into NumPy the way a Python analysis does, with and without copies.
+
+comm = MPI.COMM_WORLD
+rank = comm.Get_rank()
+
+def status(msg):
+    sys.stderr.write(msg if rank == 0 else '')
+
+def analyze(da, zero_copy):
+    # fetch the mesh and every array, reduce each array
+    # to its range as a PythonAnalysis Execute function would
+    md = da.GetMeshMetadata(0)
+    mesh = da.GetMesh(md.MeshName, False)
+    for name in md.ArrayName:
+        da.AddArray(mesh, md.MeshName, vtk.vtkDataObject.POINT, name)
+    pd = mesh.GetBlock(rank)
+    atts = pd.GetPointData()
+    rng = []
+    for i in range(atts.GetNumberOfArrays()):
+        vda = atts.GetArray(i)
+        vals = sensei.VTKToNumpy(vda) if zero_copy \
+            else np.array(vtknp.vtk_to_numpy(vda))
+        rng.append((np.min(vals), np.max(vals)))
+    return rng
+
+def run(ic, n_its, h, zero_copy):
+    ids,x,y,z,m,vx,vy,vz,fx,fy,fz = ic.allocate()
+    da = newton.data_adaptor(zero_copy)
+    t_pub = 0.
+    t_ana = 0.
+    i = 0
+    while i < n_its:
+        newton.velocity_verlet(x,y,z,m,vx,vy,vz,fx,fy,fz,h)
+        t0 = MPI.Wtime()
+        da.update(i,i*h,ids,x,y,z,m,vx,vy,vz,fx,fy,fz)
+        t1 = MPI.Wtime()
+        analyze(da, zero_copy)
+        da.ReleaseData()
+        t2 = MPI.Wtime()
+        t_pub += t1 - t0
+        t_ana += t2 - t1
+        i += 1
+    da.Delete()
+    t_pub = comm.allreduce(t_pub, op=MPI.MAX)
+    t_ana = comm.allreduce(t_ana, op=MPI.MAX)
+    return t_pub, t_ana
+
+if __name__ == '__main__':
+    parser = argparse.ArgumentParser()
+
+    parser.add_argument('--n_bodies', type=int,
+        default=100000, help="Number of bodies per process")
+
+    parser.add_argument('--n_its', type=int,
+        default=10, help="Number of iterations to time")
+
+    args = parser.parse_args()
+
+    n_bodies = args.n_bodies*newton.n_ranks
+    ic = newton.uniform_random_ic(n_bodies, -5906.4e9, \
+        5906.4e9, -5906.4e9, 5906.4e9, 10.0e24, \
+        100.0e24, 1.0e3, 10.0e3)
+    h = ic.get_time_step()
+
+    # the force calculation is O(N^2), skip it as we are
+    # only interested in the cost of moving the data
+    newton.F = lambda x,y,z,m,fx,fy,fz: None
+
+    status('%d bodies per rank, %d MPI ranks, %d iterations\n'%( \
+        ic.get_number_of_bodies(), newton.n_ranks, args.n_its))
+    status('%-10s %12s %12s %12s\n'%('mode', 'publish(s)', 'analyze(s)', 'total(s)'))
+
+    for zero_copy in [False, True]:
+        t_pub, t_ana = run(ic, args.n_its, h, zero_copy)
+        status('%-10s %12.6f %12.6f %12.6f\n'%('view' if zero_copy \
+            else 'copy', t_pub, t_ana, t_pub + t_ana))
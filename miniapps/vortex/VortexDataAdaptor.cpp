@@ -32,6 +32,15 @@ struct VortexDataAdaptor::DInternals
 #else
   vtkSmartPointer<vtkMultiBlockDataSet> Mesh;
 #endif
+  // get the patch index of the current hierarchy, it is built by the
+  // simulation after refinement
+  const patch_index_t *GetPatchIndex()
+  {
+    if (!this->sim->patch_index.valid)
+      patch_index_build(&this->sim->patch_index, &this->sim->patch);
+    return &this->sim->patch_index;
+  }
+
   simulation_data *sim;
 };
 
@@ -111,8 +120,9 @@ int VortexDataAdaptor::GetMesh(const std::string &meshName, bool /*structureOnly
         spacingSet[i] = false;
 
     // Now, let's insert local patches into the AMR dataset.
-    int np = 0;
-    patch_t **patches_this_rank = patch_flat_array(&internals.sim->patch, &np);
+    const std::vector<patch_t*> &patches_this_rank =
+      internals.GetPatchIndex()->patches;
+    int np = patches_this_rank.size();
 #ifdef DEBUG_GET_MESH
     if(f != NULL)
       {
@@ -251,7 +261,6 @@ int VortexDataAdaptor::GetMesh(const std::string &meshName, bool /*structureOnly
         fclose(f);
 #endif
     delete [] spacingSet;
-    FREE(patches_this_rank);
     }
 
   mesh = internals.Mesh;
@@ -279,8 +288,9 @@ int VortexDataAdaptor::AddArray(vtkDataObject* mesh, const std::string &meshName
   DInternals& internals = (*this->Internals);
   vtkOverlappingAMR *ds = vtkOverlappingAMR::SafeDownCast(mesh);
   // Set the arrays for the local domains.
-  int np = 0;
-  patch_t **patches_this_rank = patch_flat_array(&internals.sim->patch, &np);
+  const std::vector<patch_t*> &patches_this_rank =
+    internals.GetPatchIndex()->patches;
+  int np = patches_this_rank.size();
   for(int i = 0; i < np; ++i)
     {
     // Skip any duplicate patches not owned by this rank.
@@ -313,7 +323,6 @@ int VortexDataAdaptor::AddArray(vtkDataObject* mesh, const std::string &meshName
         }
       }
     }
-  FREE(patches_this_rank);
   return retVal;
 }
 
@@ -62,6 +62,7 @@ patch_dtor(patch_t *patch)
     {
         patch_free_data(patch);
         FREE(patch->blank);
+        FREE(patch->mask);
         if(patch->nowners > 1)
         {
             FREE(patch->owners);
@@ -111,6 +112,99 @@ patch_add_subpatches(patch_t *patch, int n)
     return &patch->subpatches[patch->nsubpatches-n];
 }
 
+// Bisects subpatch i of a patch along its longest axis, on a boundary
+// between cells of the patch, before the subpatch is given owners or data.
+// The subpatch keeps the low half and the high half is added as a new
+// subpatch, which is returned. Returns NULL if the subpatch is one cell of
+// the patch wide. Pointers to the subpatches are invalidated.
+patch_t *
+patch_split_subpatch(patch_t *patch, int i, int refinement_ratio)
+{
+    patch_t *sub = &patch->subpatches[i];
+    int psize[3] = {patch->nx, patch->ny, patch->nz};
+    int n[3] = {sub->nx / refinement_ratio, sub->ny / refinement_ratio,
+        sub->nz / refinement_ratio};
+    int axis = n[1] > n[0] ? 1 : 0;
+    axis = n[2] > n[axis] ? 2 : axis;
+    if(n[axis] < 2)
+        return NULL;
+
+    patch_t *newpatch = patch_add_subpatches(patch, 1);
+    sub = &patch->subpatches[i];
+    patch_shallow_copy(newpatch, sub);
+
+    int *size[3] = {&sub->nx, &sub->ny, &sub->nz};
+    int *newsize[3] = {&newpatch->nx, &newpatch->ny, &newpatch->nz};
+
+    // the windows are computed from the patch's cells as patch_refine does
+    int lo = 2*axis, hi = 2*axis + 1;
+    int m = n[axis] / 2;
+    int start = sub->logical_extents[lo] / refinement_ratio - patch->logical_extents[lo];
+    float cellSize = (patch->window[hi] - patch->window[lo]) / ((float)psize[axis]);
+
+    sub->logical_extents[hi] = sub->logical_extents[lo] + m*refinement_ratio - 1;
+    sub->window[hi] = sub->window[lo] + ((float)m) * cellSize;
+    *size[axis] = m*refinement_ratio;
+
+    newpatch->logical_extents[lo] = sub->logical_extents[hi] + 1;
+    newpatch->window[lo] = patch->window[lo] + (start + m) * cellSize;
+    newpatch->window[hi] = newpatch->window[lo] + ((float)(n[axis] - m)) * cellSize;
+    *newsize[axis] = (n[axis] - m)*refinement_ratio;
+
+    return newpatch;
+}
+
+// Frees the subpatches of a patch, and the blank and mask arrays that
+// describe them, so that the patch may be refined again.
+void
+patch_free_subpatches(patch_t *patch)
+{
+    for(int i = 0; i < patch->nsubpatches; ++i)
+        patch_dtor(&patch->subpatches[i]);
+    FREE(patch->subpatches);
+    patch->nsubpatches = 0;
+    FREE(patch->blank);
+    FREE(patch->mask);
+}
+
+// Computes the windows of the subpatches from the window of the patch, as
+// patch_refine does, after the patch's window has changed.
+void
+patch_update_subpatch_windows(patch_t *patch, int refinement_ratio)
+{
+    for(int i = 0; i < patch->nsubpatches; ++i)
+    {
+        patch_t *sub = &patch->subpatches[i];
+        float cellWidth = (patch->window[1] - patch->window[0]) / ((float)patch->nx);
+        float cellHeight = (patch->window[3] - patch->window[2]) / ((float)patch->ny);
+        float cellDepth = (patch->window[5] - patch->window[4]) / ((float)patch->nz);
+        int startx = sub->logical_extents[0] / refinement_ratio - patch->logical_extents[0];
+        int starty = sub->logical_extents[2] / refinement_ratio - patch->logical_extents[2];
+        int startz = sub->logical_extents[4] / refinement_ratio - patch->logical_extents[4];
+        sub->window[0] = patch->window[0] + startx * cellWidth;
+        sub->window[1] = sub->window[0] + ((float)(sub->nx / refinement_ratio)) * cellWidth;
+        sub->window[2] = patch->window[2] + starty * cellHeight;
+        sub->window[3] = sub->window[2] + ((float)(sub->ny / refinement_ratio)) * cellHeight;
+        sub->window[4] = patch->window[4] + startz * cellDepth;
+        sub->window[5] = sub->window[4] + ((float)(sub->nz / refinement_ratio)) * cellDepth;
+    }
+}
+
+// Counts the cells flagged differently in the mask and in the mask kept
+// when the patch was refined. All cells are counted if there is no mask.
+long long
+patch_count_mask_changes(const patch_t *patch, const image_t *mask)
+{
+    long long n = (long long)patch->nx * patch->ny * patch->nz;
+    if(patch->mask == NULL)
+        return n;
+
+    long long count = 0;
+    for(long long i = 0; i < n; ++i)
+        count += (patch->mask[i] != 0) != (mask->data[i] != 0);
+    return count;
+}
+
 void
 patch_add_owner(patch_t *patch, int owner)
 {
@@ -198,6 +292,45 @@ patch_flat_array_helper(patch_t *patch, patch_t **arr, int *index)
         patch_flat_array_helper(&patch->subpatches[i], arr, index);
 }
 
+static void
+patch_index_build_helper(patch_t *patch, std::vector<patch_t *> &patches)
+{
+    patches.push_back(patch);
+    for(int i = 0; i < patch->nsubpatches; ++i)
+        patch_index_build_helper(&patch->subpatches[i], patches);
+}
+
+void
+patch_index_build(patch_index_t *index, patch_t *patch)
+{
+    index->patches.clear();
+    index->ids.clear();
+
+    patch_index_build_helper(patch, index->patches);
+
+    size_t np = index->patches.size();
+    index->ids.reserve(np);
+    for(size_t i = 0; i < np; ++i)
+        index->ids.emplace(index->patches[i]->id, index->patches[i]);
+
+    index->valid = true;
+}
+
+void
+patch_index_invalidate(patch_index_t *index)
+{
+    index->patches.clear();
+    index->ids.clear();
+    index->valid = false;
+}
+
+patch_t *
+patch_index_find(const patch_index_t *index, int id)
+{
+    std::unordered_map<int, patch_t *>::const_iterator it = index->ids.find(id);
+    return it == index->ids.end() ? NULL : it->second;
+}
+
 patch_t **
 patch_flat_array(patch_t *patch, int *np)
 {
@@ -756,7 +889,9 @@ patch_refine(patch_t *patch, int refinement_ratio,
         }
     }
     FREE(score.data);
-    FREE(mask.data);
+    // Keep the mask so that a later regrid can tell if it changed.
+    FREE(patch->mask);
+    patch->mask = mask.data;
 
     // Combine compatible patches
     combine_patches(patchmap);    
@@ -2,6 +2,8 @@
 #define AMR_PATCH_H
 #include <stdio.h>
 #include <stdlib.h>
+#include <vector>
+#include <unordered_map>
 
 #define ALLOC(N,T) (T *)calloc(N, sizeof(T))
 #define REALLOC(P,N,T) (T *)realloc(P, (N) * sizeof(T))
@@ -33,6 +35,7 @@ struct patch_t
     /* End data */
 
     unsigned char *blank;
+    unsigned char *mask;  // the cells flagged for refinement
     int            nx;
     int            ny;
     int            nz;
@@ -45,12 +48,33 @@ struct patch_t
     int            nsubpatches;
 };
 
+// A flat list of the patches of a hierarchy and a map from patch id to
+// patch. It is built once the patches are refined and their ids assigned,
+// and invalidated when the hierarchy is refined again. Patches that share
+// an id, such as the duplicates of unowned patches, map to the first one.
+struct patch_index_t
+{
+    patch_index_t() : patches(), ids(), valid(false) {}
+
+    std::vector<patch_t *>             patches;
+    std::unordered_map<int, patch_t *> ids;
+    bool                               valid;
+};
+
+void      patch_index_build(patch_index_t *index, patch_t *patch);
+void      patch_index_invalidate(patch_index_t *index);
+patch_t  *patch_index_find(const patch_index_t *index, int id);
+
 void      patch_ctor(patch_t *patch);
 void      patch_dtor(patch_t *patch);
 void      patch_shallow_copy(patch_t *dest, patch_t *src);
 void      patch_print(FILE *f, patch_t *patch);
 void      patch_alloc_blank(patch_t *patch, int nx, int ny, int nz);
 patch_t  *patch_add_subpatches(patch_t *patch, int n);
+patch_t  *patch_split_subpatch(patch_t *patch, int i, int refinement_ratio);
+void      patch_free_subpatches(patch_t *patch);
+void      patch_update_subpatch_windows(patch_t *patch, int refinement_ratio);
+long long patch_count_mask_changes(const patch_t *patch, const image_t *mask);
 void      patch_add_owner(patch_t *patch, int owner);
 int       patch_num_patches(patch_t *patch);
 patch_t  *patch_get_patch(patch_t *patch, int id);
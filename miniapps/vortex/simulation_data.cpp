@@ -32,8 +32,20 @@ simulation_data::simulation_data()
     dt = 0.029;
     max_levels = 2;
     refinement_ratio = 4;
-    balance = false;
+    balance = BALANCE_NONE;
     log = false;
+    nthreads = 1;
+    kernel = KERNEL_SIMD;
+    kernel_cells = 0;
+    kernel_mismatches = 0;
+    work = 0.;
+    incremental = false;
+    regrid_tolerance = 0.01f;
+    rebalance_tolerance = 1.25f;
+    imbalance = 1.;
+    built_imbalance = 1.;
+    hierarchy_changed = true;
+    hierarchy_version = 0;
 
     dims[0] = 256;
     dims[1] = 32;
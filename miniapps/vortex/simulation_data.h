@@ -6,6 +6,19 @@
  * Simulation data and functions
  ******************************************************************************/
 
+// The kernels that compute the data on a patch. KERNEL_VERIFY computes
+// with KERNEL_SIMD and checks the result against KERNEL_SCALAR.
+#define KERNEL_SCALAR 0
+#define KERNEL_SIMD   1
+#define KERNEL_VERIFY 2
+
+// How the subpatches of a patch shared by several ranks are assigned.
+// BALANCE_COUNT evens out the number of patches on each rank, BALANCE_COST
+// the estimated cost of computing them.
+#define BALANCE_NONE  0
+#define BALANCE_COUNT 1
+#define BALANCE_COST  2
+
 #define MAX_VORTICES 10
 
 class vortex
@@ -36,8 +49,26 @@ public:
     double  dt;
     int     max_levels;
     int     refinement_ratio;
-    bool    balance;
+    int     balance;
     bool    log;
+    int     nthreads; // threads computing the rows of a patch
+    int     kernel;
+
+    long long kernel_cells;      // cells checked by KERNEL_VERIFY
+    long long kernel_mismatches; // and the number that differed
+
+    double  work; // cost of the patches computed this step
+
+    bool    incremental;       // regrid only where the refinement changed
+    float   regrid_tolerance;  // the fraction of a patch's cells that may
+                               // be flagged differently before it's refined
+    float   rebalance_tolerance; // the growth in imbalance since the last
+                                 // build past which the hierarchy is built
+                                 // again instead of regridded
+    double  imbalance;         // the last step's imbalance when balancing
+    double  built_imbalance;   // and that of the last step that built it
+    bool    hierarchy_changed; // set by calculate_amr and regrid_amr
+    long    hierarchy_version; // incremented when the hierarchy changes
 
     float   dims[3];
     float   window[6];
@@ -47,6 +78,7 @@ public:
     vortex  vortices[MAX_VORTICES];
 
     patch_t patch;
+    patch_index_t patch_index; // rebuilt by calculate_amr
 
     int     *npatches_per_rank;  // [par_size]
     int     *npatches_per_level; // [max_levels]
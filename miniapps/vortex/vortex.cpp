@@ -7,12 +7,16 @@
 #include <sstream>
 #include <string>
 #include <iostream>
+#include <vector>
+#include <thread>
+#include <algorithm>
 
 #include <mpi.h>
 
 #include "patch.h"
 #include "simulation_data.h"
 #include "senseiConfig.h"
+#include <ThreadPool.h>
 #ifdef ENABLE_SENSEI
 #include <vtkNew.h>
 #include <vtkSmartPointer.h>
@@ -81,10 +85,101 @@ float vortex(float x, float y, float z, simulation_data *sim)
     return value;
 }
 
+// The vortex field over LANES cells of a row at a time. The angle is not
+// needed since cos(atan2(dy,dx)) = dx/r and sin(atan2(dy,dx)) = dy/r where
+// r is the distance in the xy plane, and atan2(0,0) is 0. The loops over
+// lanes have no calls and vectorize.
+#define LANES 16
+
+void
+vortex_row_simd(float *data, int nx, float x0, float x1, float y, float z,
+    const simulation_data *sim)
+{
+    float umax = 1.0f;
+    float umin = 0.0f;
+
+    for(int i0 = 0; i0 < nx; i0 += LANES)
+    {
+        float x[LANES], u[LANES], v[LANES];
+        for(int l = 0; l < LANES; ++l)
+        {
+            float tx = (float)(i0 + l) / (float)(nx - 1);
+            x[l] = x0 + tx * (x1 - x0);
+            u[l] = 0.f;
+            v[l] = 0.f;
+        }
+
+        for(int i = 0; i < sim->nVortex; ++i)
+        {
+            const class vortex &vi = sim->vortices[i];
+            float vx = vi.location[0];
+            float dy = y - vi.location[1];
+            float dz = z - vi.location[2];
+            float r2 = vi.radius * vi.radius;
+            float g = vi.gamma / (2.f * (float)M_PI);
+
+            for(int l = 0; l < LANES; ++l)
+            {
+                float dx = x[l] - vx;
+                float rxy2 = dx * dx + dy * dy;
+                float rlocal2 = rxy2 + dz * dz;
+                float rlocal = sqrtf(rlocal2);
+                float utheta = g * rlocal / (r2 + rlocal2);
+
+                float rxy = sqrtf(rxy2);
+                float irxy = rxy > 0.f ? 1.f / rxy : 0.f;
+                float ct = rxy > 0.f ? dx * irxy : 1.f;
+                float st = dy * irxy;
+
+                v[l] += utheta * ct;
+                u[l] -= utheta * st;
+            }
+        }
+
+        int n = nx - i0 < LANES ? nx - i0 : LANES;
+        for(int l = 0; l < n; ++l)
+        {
+            float umag = sqrtf(u[l] * u[l] + v[l] * v[l]);
+            data[i0 + l] = (umag - umin) / (umax - umin);
+        }
+    }
+}
+
+void
+vortex_row(float *data, int nx, float x0, float x1, float y, float z,
+    simulation_data *sim)
+{
+    for(int i = 0; i < nx; ++i)
+    {
+        float tx = (float)i / (float)(nx - 1);
+        float x = x0 + tx * (x1 - x0);
+
+        *data++ = vortex(x, y, z, sim);
+    }
+}
+
+// -----------------------------------------------------------------------------
+// @brief Calls rows(j) for each j in [0, nrows) on the threads of the pool.
+//        Rows are handed out one at a time since their cost varies. The
+//        pool's threads persist across patches and steps.
+//
+template <typename rows_t>
+void
+parallel_rows(int nrows, const rows_t &rows)
+{
+    sensei::ThreadPool::ParallelFor(nrows, [&](unsigned int j) -> int
+    {
+        rows(j);
+        return 0;
+    });
+}
+
 void 
 calculate_data(patch_t *patch, simulation_data *sim)
 {
     float *data = patch->data;
+    int nx = patch->nx;
+    int ny = patch->ny;
 
     // Compute x0,x1, y0,y1, z0,z1 which help us locate cell centers. 
     float cellWidth = (patch->window[1] - patch->window[0]) / ((float)patch->nx);
@@ -97,25 +192,55 @@ calculate_data(patch_t *patch, simulation_data *sim)
     float z0 = patch->window[4] + cellDepth / 2.f;
     float z1 = patch->window[5] - cellDepth / 2.f;
 
-    for(int k = 0; k < patch->nz; ++k)
+    // the rows of all of the slices, row jk is row j of slice k
+    auto row = [&](int jk, float *rdata, bool simd)
     {
+        int j = jk % ny;
+        int k = jk / ny;
         float tz = (float)k / (float)(patch->nz - 1);
         float z = z0 + tz * (z1 - z0);
-        for(int j = 0; j < patch->ny; ++j)
-        {
-            float ty = (float)j / (float)(patch->ny - 1);
-            float y = y0 + ty * (y1 - y0);
-            for(int i = 0; i < patch->nx; ++i)
-            {
-                float tx = (float)i / (float)(patch->nx - 1);
-                float x = x0 + tx * (x1 - x0);
+        float ty = (float)j / (float)(patch->ny - 1);
+        float y = y0 + ty * (y1 - y0);
+        if(simd)
+            vortex_row_simd(rdata, nx, x0, x1, y, z, sim);
+        else
+            vortex_row(rdata, nx, x0, x1, y, z, sim);
+    };
 
-                *data++ = vortex(x, y, z, sim);
-            }
+    int nrows = ny * patch->nz;
+    bool simd = sim->kernel != KERNEL_SCALAR;
+    parallel_rows(nrows, [&](int jk)
+    {
+        row(jk, data + (size_t)jk * nx, simd);
+    });
+
+    if(sim->kernel == KERNEL_VERIFY)
+    {
+        // the trig functions are evaluated in double precision by the scalar
+        // kernel and so the results differ by rounding
+        std::vector<float> rdata(nx);
+        for(int jk = 0; jk < nrows; ++jk)
+        {
+            row(jk, rdata.data(), false);
+            const float *sdata = data + (size_t)jk * nx;
+            for(int i = 0; i < nx; ++i)
+                sim->kernel_mismatches += fabs(rdata[i] - sdata[i]) >
+                    1.e-5f * (1.f + fabs(rdata[i]));
         }
+        sim->kernel_cells += (long long)nrows * nx;
     }
 }
 
+// -----------------------------------------------------------------------------
+// @brief The cost of computing a patch, each cell sums over the vortices.
+//
+double
+patch_cost(const patch_t *patch, const simulation_data *sim)
+{
+    return (double)patch->nx * patch->ny * patch->nz *
+        (sim->nVortex > 0 ? sim->nVortex : 1);
+}
+
 //*****************************************************************************
 // Code for helping calculate AMR refinement
 //*****************************************************************************
@@ -347,6 +472,117 @@ sort_owners_by_workload(MPI_Comm comm, simulation_data *sim, patch_t *patch)
 }
 #endif
 
+// -----------------------------------------------------------------------------
+// @brief This routine is called among the owners of a patch to share the cost
+//        of the patches that each has computed so far this step.
+//
+void
+gather_owner_work(MPI_Comm comm, simulation_data *sim, patch_t *patch,
+    std::vector<double> &work)
+{
+    int tag = 1002, tag2 = 1003;
+    work.resize(patch->nowners);
+    if(sim->par_rank == patch->owners[0])
+    {
+        work[0] = sim->work;
+        MPI_Status status;
+        for(int i = 1; i < patch->nowners; ++i)
+            MPI_Recv(&work[i], 1, MPI_DOUBLE, patch->owners[i], tag, comm, &status);
+        for(int i = 1; i < patch->nowners; ++i)
+            MPI_Send(work.data(), patch->nowners, MPI_DOUBLE, patch->owners[i], tag2, comm);
+    }
+    else
+    {
+        MPI_Send(&sim->work, 1, MPI_DOUBLE, patch->owners[0], tag, comm);
+        MPI_Status status;
+        MPI_Recv(work.data(), patch->nowners, MPI_DOUBLE, patch->owners[0], tag2, comm, &status);
+    }
+}
+
+// -----------------------------------------------------------------------------
+// @brief Assigns the subpatches of a patch to its owners by estimated cost.
+//        Subpatches that cost more than an owner's share are first bisected.
+//        Then when there are at least as many subpatches as owners the
+//        longest processing time first rule is used: the most costly
+//        subpatch goes to the owner with the least work, and so on. Otherwise
+//        the owners are ordered by work and share the subpatches round robin.
+//        The result is a list of owner, subpatch index pairs. All of the
+//        owners compute the same assignment since they have the same patch.
+//
+void
+assign_subpatches_by_cost(MPI_Comm comm, simulation_data *sim, patch_t *patch,
+    std::vector<int> &assignment)
+{
+    if(patch->nsubpatches == 0)
+        return;
+
+    std::vector<double> work;
+    gather_owner_work(comm, sim, patch, work);
+
+    std::vector<double> cost(patch->nsubpatches);
+    double total = 0.;
+    for(int i = 0; i < patch->nsubpatches; ++i)
+    {
+        cost[i] = patch_cost(&patch->subpatches[i], sim);
+        total += cost[i];
+    }
+
+    // Bisect subpatches that cost more than an owner's share, largest first,
+    // so that there are pieces to balance.
+    double share = total / patch->nowners;
+    std::vector<int> split(patch->nsubpatches, 1);
+    while(true)
+    {
+        int k = -1;
+        for(int i = 0; i < patch->nsubpatches; ++i)
+            if(split[i] && (cost[i] > share) && ((k < 0) || (cost[i] > cost[k])))
+                k = i;
+        if(k < 0)
+            break;
+
+        int nsub = patch->nsubpatches;
+        if(patch_split_subpatch(patch, k, sim->refinement_ratio))
+        {
+            cost[k] = patch_cost(&patch->subpatches[k], sim);
+            cost.push_back(patch_cost(&patch->subpatches[nsub], sim));
+            split.push_back(1);
+        }
+        else
+            split[k] = 0;
+    }
+
+    if(patch->nsubpatches < patch->nowners)
+    {
+        std::vector<int> order(patch->nowners);
+        for(int i = 0; i < patch->nowners; ++i)
+            order[i] = i;
+        std::stable_sort(order.begin(), order.end(),
+            [&work](int a, int b) { return work[a] < work[b]; });
+
+        for(int i = 0; i < patch->nowners; ++i)
+        {
+            assignment.push_back(patch->owners[order[i]]);
+            assignment.push_back(i % patch->nsubpatches);
+        }
+        return;
+    }
+
+    std::vector<int> order(patch->nsubpatches);
+    for(int i = 0; i < patch->nsubpatches; ++i)
+        order[i] = i;
+    std::stable_sort(order.begin(), order.end(),
+        [&cost](int a, int b) { return cost[a] > cost[b]; });
+
+    for(int i = 0; i < patch->nsubpatches; ++i)
+    {
+        int sub = order[i];
+        int owner = std::min_element(work.begin(), work.end()) - work.begin();
+        work[owner] += cost[sub];
+        assignment.push_back(patch->owners[owner]);
+        assignment.push_back(sub);
+    }
+}
+
 // -----------------------------------------------------------------------------
 // @brief Takes the input patch and doles out the subpatches it contains to the
 //        ranks that own the input patch.
@@ -362,21 +598,35 @@ assign_patches(MPI_Comm comm, simulation_data *sim, patch_t *patch)
         fprintf(debuglog, "assign_patches: Current patch refined into %d subpatches\n", patch->nsubpatches);
 #endif
 
-#if 1
-        // Sort the owner list by the total amount of work so the least loaded
-        // ranks are first in the list.
-        if(sim->balance)
-            sort_owners_by_workload(comm, sim, patch);
-#endif
         // The current patch exists on more than one rank. Divide its
         // subpatches (if any) among those ranks.
         if(patch->nsubpatches > 0)
         {
+            std::vector<int> assignment;
+            if(sim->balance == BALANCE_COST)
+            {
+                assign_subpatches_by_cost(comm, sim, patch, assignment);
+            }
+            else
+            {
+#if 1
+                // Sort the owner list by the total amount of work so the least loaded
+                // ranks are first in the list.
+                if(sim->balance == BALANCE_COUNT)
+                    sort_owners_by_workload(comm, sim, patch);
+#endif
+                for(int i = 0; i < patch->nsubpatches; ++i)
+                {
+                    assignment.push_back(patch->owners[i % patch->nowners]);
+                    assignment.push_back(i % patch->nsubpatches);
+                }
+            }
+
             std::vector<int> patches_owned_by_this_rank;
-            for(int i = 0; i < patch->nsubpatches; ++i)
+            for(size_t i = 0; i < assignment.size(); i += 2)
             {
-                int owner = patch->owners[i % patch->nowners];
-                int subpatchIndex = i % patch->nsubpatches;
+                int owner = assignment[i];
+                int subpatchIndex = assignment[i+1];
                 patch_add_owner(&patch->subpatches[subpatchIndex], owner);
 
                 if(owner == sim->par_rank)
@@ -438,6 +688,7 @@ calculate_amr_helper(MPI_Comm comm, simulation_data *sim, patch_t *patch, int le
     // Calculate the data on this patch 
     patch_alloc_data(patch, patch->nx, patch->ny, patch->nz);
     calculate_data(patch,sim);
+    sim->work += patch_cost(patch, sim);
 
     if(level+1 > sim->max_levels)
         return;
@@ -465,6 +716,49 @@ calculate_amr_helper(MPI_Comm comm, simulation_data *sim, patch_t *patch, int le
     }
 }
 
+// -----------------------------------------------------------------------------
+// @brief Recomputes the data on a patch of the previous step's hierarchy. The
+//        patch keeps its subpatches, their data and their ids if the cells
+//        flagged for refinement changed by no more than the regrid tolerance,
+//        otherwise it is refined again. Returns 1 if the hierarchy changed.
+//
+int
+regrid_amr_helper(MPI_Comm comm, simulation_data *sim, patch_t *patch)
+{
+    calculate_data(patch, sim);
+    sim->work += patch_cost(patch, sim);
+
+    if(patch->level+1 > sim->max_levels)
+        return 0;
+
+    image_t mask;
+    mask.nx = patch->nx;
+    mask.ny = patch->ny;
+    mask.nz = patch->nz;
+    mask.data = ALLOC(mask.nx*mask.ny*mask.nz, unsigned char);
+    detect_refinement(patch, &mask, sim);
+    long long nchanged = patch_count_mask_changes(patch, &mask);
+    FREE(mask.data);
+
+    if(nchanged > sim->regrid_tolerance * patch->nx * patch->ny * patch->nz)
+    {
+        // The owners of a shared patch all come to the same decision since
+        // they have the same data.
+        patch_free_subpatches(patch);
+        patch_refine(patch, sim->refinement_ratio, detect_refinement, sim);
+        assign_patches(comm, sim, patch);
+        for(int i = 0; i < patch->nsubpatches; ++i)
+            calculate_amr_helper(comm, sim, &patch->subpatches[i], patch->level+1);
+        return 1;
+    }
+
+    int changed = 0;
+    patch_update_subpatch_windows(patch, sim->refinement_ratio);
+    for(int i = 0; i < patch->nsubpatches; ++i)
+        changed |= regrid_amr_helper(comm, sim, &patch->subpatches[i]);
+    return changed;
+}
+
 // -----------------------------------------------------------------------------
 // @brief Assigns unique ids to the patches across all processors. Only the patches
 //        that a processor owns will get patch ids. The remaining patches that are
@@ -576,12 +870,19 @@ calculate_amr(MPI_Comm comm, simulation_data *sim)
     debuglog = fopen(filename, "wt");
 #endif
 
+    sim->hierarchy_changed = true;
+    sim->hierarchy_version += 1;
+
     // Compute the AMR patches. 
+    sim->work = 0.;
     calculate_amr_helper(comm, sim, &sim->patch, 0);
 
     // Assign ids to all of the AMR patches. 
     assign_unique_patch_ids(comm, sim);
 
+    // Index the patches by id for the data adaptor.
+    patch_index_build(&sim->patch_index, &sim->patch);
+
 #ifdef DO_LOG
     if(debuglog != NULL)
     {
@@ -591,6 +892,111 @@ calculate_amr(MPI_Comm comm, simulation_data *sim)
 #endif
 }
 
+// -----------------------------------------------------------------------------
+// @brief Records the id, level and logical extents of the patches on this rank.
+//
+void
+patch_signature(simulation_data *sim, std::vector<int> &sig)
+{
+    int np = 0;
+    patch_t **patches = patch_flat_array(&sim->patch, &np);
+    int next = sizeof(patches[0]->logical_extents) / sizeof(int);
+    for(int i = 0; i < np; ++i)
+    {
+        sig.push_back(patches[i]->id);
+        sig.push_back(patches[i]->level);
+        sig.insert(sig.end(), patches[i]->logical_extents,
+            patches[i]->logical_extents + next);
+    }
+    FREE(patches);
+}
+
+// -----------------------------------------------------------------------------
+// @brief Recomputes the data on the previous step's hierarchy, refining again
+//        only the patches whose flagged cells changed. Patch ids are assigned
+//        again and hierarchy_changed is set if any rank's hierarchy changed.
+//        When no rank's hierarchy changed the patches must keep their ids, a
+//        non-zero value is returned if they did not.
+//
+int
+regrid_amr(MPI_Comm comm, simulation_data *sim)
+{
+    std::vector<int> sig0;
+    patch_signature(sim, sig0);
+
+    sim->work = 0.;
+    int changed = regrid_amr_helper(comm, sim, &sim->patch);
+
+    MPI_Allreduce(MPI_IN_PLACE, &changed, 1, MPI_INT, MPI_MAX, comm);
+    sim->hierarchy_changed = changed;
+    sim->hierarchy_version += changed;
+
+    if(changed)
+    {
+        assign_unique_patch_ids(comm, sim);
+        patch_index_build(&sim->patch_index, &sim->patch);
+        return 0;
+    }
+
+    std::vector<int> sig1;
+    patch_signature(sim, sig1);
+
+    int status = sig0 != sig1 ? 1 : 0;
+    MPI_Allreduce(MPI_IN_PLACE, &status, 1, MPI_INT, MPI_MAX, comm);
+
+    if(sim->par_rank == 0)
+    {
+        if(status)
+            std::cerr << "ERROR: cycle " << sim->cycle << " the hierarchy is"
+                << " unchanged but the patch ids changed" << std::endl;
+        else
+            std::cerr << "cycle " << sim->cycle << " the hierarchy is"
+                << " unchanged and the patch ids were kept" << std::endl;
+    }
+
+    return status;
+}
+
+// -----------------------------------------------------------------------------
+// @brief Reports, for each level, the largest and the mean over the ranks of
+//        the cost of the patches that each rank computed, and the imbalance,
+//        their ratio. Must be called on all ranks after calculate_amr.
+//        Returns the largest imbalance over the levels on all ranks.
+//
+double
+report_balance(MPI_Comm comm, simulation_data *sim, std::ostream &os)
+{
+    int nlevels = sim->max_levels + 1;
+    std::vector<double> cost(nlevels, 0.), maxcost(nlevels), sumcost(nlevels);
+
+    const std::vector<patch_t *> &patches = sim->patch_index.patches;
+    for(size_t i = 0; i < patches.size(); ++i)
+    {
+        const patch_t *p = patches[i];
+        if(p->level < nlevels)
+            cost[p->level] += patch_cost(p, sim);
+    }
+
+    MPI_Allreduce(cost.data(), maxcost.data(), nlevels, MPI_DOUBLE, MPI_MAX, comm);
+    MPI_Allreduce(cost.data(), sumcost.data(), nlevels, MPI_DOUBLE, MPI_SUM, comm);
+
+    double imbalance = 1.;
+    for(int i = 0; i < nlevels; ++i)
+    {
+        double mean = sumcost[i] / sim->par_size;
+        double level_imbalance = mean > 0. ? maxcost[i] / mean : 1.;
+        imbalance = std::max(imbalance, level_imbalance);
+        if(sim->par_rank == 0)
+        {
+            os << "cycle " << sim->cycle << " level " << i << " cost max "
+               << maxcost[i] << " mean " << mean << " imbalance "
+               << level_imbalance << std::endl;
+        }
+    }
+
+    return imbalance;
+}
+
 // -----------------------------------------------------------------------------
 // @brief Handle command line arguments.
 //
@@ -644,12 +1050,53 @@ handle_command_line(int argc, char **argv, simulation_data *sim,
         else if((strcmp(argv[i], "-b") == 0 ||
                  strcmp(argv[i], "-balance") == 0))
         {
-            sim->balance = true;
+            sim->balance = BALANCE_COUNT;
+        }
+        else if((strcmp(argv[i], "-bc") == 0 ||
+                 strcmp(argv[i], "-balance_cost") == 0))
+        {
+            sim->balance = BALANCE_COST;
         }
         else if(strcmp(argv[i], "-log") == 0)
         {
             sim->log = true;
         }
+        else if((strcmp(argv[i], "-ir") == 0 ||
+                 strcmp(argv[i], "-incremental_regrid") == 0))
+        {
+            sim->incremental = true;
+        }
+        else if((strcmp(argv[i], "-rt") == 0 ||
+                 strcmp(argv[i], "-regrid_tolerance") == 0) && (i+1)<argc)
+        {
+            sim->regrid_tolerance = atof(argv[i+1]);
+            i++;
+        }
+        else if((strcmp(argv[i], "-rb") == 0 ||
+                 strcmp(argv[i], "-rebalance_tolerance") == 0) && (i+1)<argc)
+        {
+            sim->rebalance_tolerance = atof(argv[i+1]);
+            i++;
+        }
+        else if((strcmp(argv[i], "-t") == 0 ||
+                 strcmp(argv[i], "-threads") == 0) && (i+1)<argc)
+        {
+            sim->nthreads = atoi(argv[i+1]);
+            if(sim->nthreads < 1)
+                sim->nthreads = std::thread::hardware_concurrency();
+            i++;
+        }
+        else if((strcmp(argv[i], "-k") == 0 ||
+                 strcmp(argv[i], "-kernel") == 0) && (i+1)<argc)
+        {
+            if(strcmp(argv[i+1], "scalar") == 0)
+                sim->kernel = KERNEL_SCALAR;
+            else if(strcmp(argv[i+1], "simd") == 0)
+                sim->kernel = KERNEL_SIMD;
+            else if(strcmp(argv[i+1], "verify") == 0)
+                sim->kernel = KERNEL_VERIFY;
+            i++;
+        }
     }
 }
 
@@ -696,6 +1143,9 @@ int main(int argc, char **argv)
     // Handle any command line args. 
     handle_command_line(argc, argv, &sim, max_iter, config_file);
 
+    // the rows of the patches are computed on the threads of the pool
+    sensei::ThreadPool::SetNumberOfThreads(sim.nthreads);
+
 #ifdef ENABLE_SENSEI
     sensei::Profiler::Initialize();
 
@@ -731,6 +1181,7 @@ int main(int argc, char **argv)
         patch0_owners[i] = i;
 
     // Iterate.
+    int status = 0;
     for(sim.cycle = 0; sim.cycle < max_iter; ++sim.cycle)
     {
         if(sim.par_rank == 0)
@@ -739,31 +1190,52 @@ int main(int argc, char **argv)
                       << ", time=" << sim.time << std::endl;
         }
 
-        // Blow away the previous patch data and calculate.
-        sim.patch.owners = NULL;
-        patch_dtor(&sim.patch);
-        patch_ctor(&sim.patch);
-        sim.patch.owners = patch0_owners;
-        sim.patch.nowners = sim.par_size;
-        sim.patch.window[0] = sim.window[0];
-        sim.patch.window[1] = sim.window[1];
-        sim.patch.window[2] = sim.window[2];
-        sim.patch.window[3] = sim.window[3];
-        sim.patch.window[4] = sim.window[4];
-        sim.patch.window[5] = sim.window[5];
-        sim.patch.logical_extents[0] = 0;
-        sim.patch.logical_extents[1] = sim.dims[0]-1;
-        sim.patch.logical_extents[2] = 0;
-        sim.patch.logical_extents[3] = sim.dims[1]-1;
-        sim.patch.logical_extents[4] = 0;
-        sim.patch.logical_extents[5] = sim.dims[2]-1;
-        sim.patch.nx = sim.dims[0];
-        sim.patch.ny = sim.dims[1];
-        sim.patch.nz = sim.dims[2];
 #ifdef ENABLE_SENSEI
         sensei::Profiler::StartEvent("vortex::compute");
 #endif
-        calculate_amr(MPI_COMM_WORLD, &sim);
+        // The subpatches that incremental regridding keeps are not
+        // reassigned, the hierarchy is built again when the last step's
+        // imbalance grew too far past that of the last build.
+        double max_imbalance = sim.rebalance_tolerance * sim.built_imbalance;
+        bool rebalance = sim.imbalance > max_imbalance;
+        if(sim.incremental && sim.cycle > 0 && rebalance && sim.par_rank == 0)
+        {
+            std::cerr << "cycle " << sim.cycle << " imbalance " << sim.imbalance
+                << " exceeds " << max_imbalance << ", rebalancing" << std::endl;
+        }
+
+        bool regridded = sim.incremental && sim.cycle > 0 && !rebalance;
+        if(regridded)
+        {
+            // Recompute the data on the patches, refining only where needed.
+            status |= regrid_amr(MPI_COMM_WORLD, &sim);
+        }
+        else
+        {
+            // Blow away the previous patch data and calculate.
+            patch_index_invalidate(&sim.patch_index);
+            sim.patch.owners = NULL;
+            patch_dtor(&sim.patch);
+            patch_ctor(&sim.patch);
+            sim.patch.owners = patch0_owners;
+            sim.patch.nowners = sim.par_size;
+            sim.patch.window[0] = sim.window[0];
+            sim.patch.window[1] = sim.window[1];
+            sim.patch.window[2] = sim.window[2];
+            sim.patch.window[3] = sim.window[3];
+            sim.patch.window[4] = sim.window[4];
+            sim.patch.window[5] = sim.window[5];
+            sim.patch.logical_extents[0] = 0;
+            sim.patch.logical_extents[1] = sim.dims[0]-1;
+            sim.patch.logical_extents[2] = 0;
+            sim.patch.logical_extents[3] = sim.dims[1]-1;
+            sim.patch.logical_extents[4] = 0;
+            sim.patch.logical_extents[5] = sim.dims[2]-1;
+            sim.patch.nx = sim.dims[0];
+            sim.patch.ny = sim.dims[1];
+            sim.patch.nz = sim.dims[2];
+            calculate_amr(MPI_COMM_WORLD, &sim);
+        }
 
         if(sim.log && sim.par_rank == 0)
         {
@@ -772,6 +1244,13 @@ int main(int argc, char **argv)
                 log << i << " " << sim.npatches_per_rank[i] << std::endl;
         }
 
+        if(sim.balance != BALANCE_NONE)
+        {
+            sim.imbalance = report_balance(MPI_COMM_WORLD, &sim, std::cerr);
+            if(!regridded)
+                sim.built_imbalance = sim.imbalance;
+        }
+
 #ifdef ENABLE_SENSEI
         sensei::Profiler::EndEvent("vortex::compute");
 
@@ -800,6 +1279,22 @@ int main(int argc, char **argv)
         }
     }
 
+    // Report the differences between the kernels.
+    if(sim.kernel == KERNEL_VERIFY)
+    {
+        long long counts[2] = {sim.kernel_cells, sim.kernel_mismatches};
+        MPI_Allreduce(MPI_IN_PLACE, counts, 2, MPI_LONG_LONG, MPI_SUM,
+            MPI_COMM_WORLD);
+
+        status |= counts[1] ? 1 : 0;
+        if(sim.par_rank == 0)
+        {
+            std::cerr << (counts[1] ? "ERROR: " : "") << counts[1] << " of "
+                << counts[0] << " cells differ between the simd and scalar"
+                << " kernels" << std::endl;
+        }
+    }
+
     // Cleanup
     if(sim.log && sim.par_rank == 0)
         log.close();
@@ -814,5 +1309,5 @@ int main(int argc, char **argv)
 #endif
     MPI_Finalize();
 
-    return 0;
+    return status;
 }
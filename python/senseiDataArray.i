@@ -0,0 +1,59 @@
+%{
+#include "senseiPyDataArray.h"
+#include <vtkPythonUtil.h>
+%}
+
+/****************************************************************************
+ * zero-copy exchange of array data between VTK and NumPy
+ ***************************************************************************/
+%feature("docstring") VTKToNumpy
+"VTKToNumpy(vtkDataArray) -> numpy.ndarray | tuple
+
+Returns a read-only NumPy view of the memory held by the vtkDataArray. No data
+is copied and the VTK array is kept alive for as long as the view is. AOS
+arrays produce a single array of shape (nTuples,) or (nTuples, nComps), SOA
+arrays produce a tuple of 1D arrays one per component."
+
+%feature("docstring") NumpyToVTK
+"NumpyToVTK(numpy.ndarray, name='') -> vtkDataArray
+
+Returns a vtkDataArray that points to the memory held by the NumPy array. 1D
+arrays produce single component arrays, 2D arrays of shape (nTuples, nComps)
+produce multi-component arrays. No data is copied unless the input is not
+aligned and C contiguous. The NumPy array is kept alive for as long as the VTK
+array is, even when the Python wrapping of the VTK array has gone away."
+
+%inline
+%{
+// **************************************************************************
+PyObject *VTKToNumpy(PyObject *obj)
+{
+  vtkDataArray *da = static_cast<vtkDataArray*>(
+    vtkPythonUtil::GetPointerFromObject(obj, "vtkDataArray"));
+
+  // a Python exception has been set
+  if (!da)
+    return nullptr;
+
+  return senseiPyDataArray::NewNumpyView(da);
+}
+
+// **************************************************************************
+PyObject *NumpyToVTK(PyObject *obj, const std::string &name = "")
+{
+  vtkDataArray *da = senseiPyDataArray::NewDataArray(obj);
+
+  // a Python exception has been set
+  if (!da)
+    return nullptr;
+
+  if (!name.empty())
+    da->SetName(name.c_str());
+
+  // the Python object takes a reference
+  PyObject *pyDa = vtkPythonUtil::GetObjectFromPointer(da);
+  da->Delete();
+
+  return pyDa;
+}
+%}
@@ -5,6 +5,7 @@
 #include <numpy/arrayobject.h>
 #include <Python.h>
 #include <cstdlib>
+#include <cstring>
 
 namespace senseiPyArray
 {
@@ -51,6 +52,7 @@ template <> struct NumpyTT<CPP_T>                  \
   { return PyArray_TYPE(arr) == CODE; }            \
 };
 senseiPyArray_NumpyTT_declare(NPY_BYTE, char)
+senseiPyArray_NumpyTT_declare(NPY_BYTE, signed char)
 senseiPyArray_NumpyTT_declare(NPY_INT16, short)
 senseiPyArray_NumpyTT_declare(NPY_INT32, int)
 senseiPyArray_NumpyTT_declare(NPY_LONG, long)
@@ -109,6 +111,14 @@ bool Copy(cpp_t *va, unsigned long n, PyObject *obj)
     return false;
     }
 
+  // when the types match and the source is contiguous there
+  // is no need to iterate, the buffer is copied in one shot
+  if (NumpyTT<cpp_t>::IsType(arr) && PyArray_ISCARRAY_RO(arr))
+    {
+    memcpy(va, PyArray_DATA(arr), n*sizeof(cpp_t));
+    return true;
+    }
+
   // copy
   SENSEI_PY_ARRAY_DISPATCH(arr,
     unsigned long i = 0;
@@ -0,0 +1,237 @@
+#ifndef senseiPyDataArray_h
+#define senseiPyDataArray_h
+
+#include "senseiPyArray.h"
+#include "senseiPyGILState.h"
+#include "Error.h"
+
+#include <Python.h>
+
+#include <vtkDataArray.h>
+#include <vtkAOSDataArrayTemplate.h>
+#include <vtkSOADataArrayTemplate.h>
+#include <vtkCallbackCommand.h>
+#include <vtkCommand.h>
+#include <vtkTypeTraits.h>
+#include <vtkSetGet.h>
+
+/// senseiPyDataArray -- zero-copy exchange of array data between VTK and NumPy
+/**
+NewNumpyView -- wrap the memory of a vtkDataArray in a read-only NumPy
+array. The NumPy array holds a reference to the VTK array so the memory stays
+valid as long as the NumPy array is alive. AOS layouts produce a single array
+of shape (nTuples,) or (nTuples, nComps). SOA layouts produce a tuple of 1D
+arrays, one per component.
+
+NewDataArray -- wrap the memory of a NumPy array in a vtkDataArray. The VTK
+array holds a reference to the NumPy array which is released when the VTK
+array is deleted. The NumPy array is only copied if it is not aligned and C
+contiguous.
+*/
+namespace senseiPyDataArray
+{
+// name used to tag the capsules that hold VTK references
+#define SENSEI_PY_DATA_ARRAY_CAPSULE "sensei.vtkObjectBase"
+
+// capsule destructor releasing the reference held on the VTK object that
+// owns the memory a NumPy view points to
+inline
+void ReleaseVTKReference(PyObject *capsule)
+{
+  vtkObjectBase *obj = static_cast<vtkObjectBase*>(
+    PyCapsule_GetPointer(capsule, SENSEI_PY_DATA_ARRAY_CAPSULE));
+
+  if (obj)
+    obj->UnRegister(nullptr);
+}
+
+// DeleteEvent observer releasing the reference held on the NumPy
+// array that owns the memory a VTK array points to
+inline
+void ReleasePyReference(vtkObject *, unsigned long, void *clientData, void *)
+{
+  // when the interpreter has already been shut down the
+  // NumPy array is gone and there is nothing to release
+  if (!Py_IsInitialized())
+    return;
+
+  senseiPyGILState gil;
+  Py_XDECREF(static_cast<PyObject*>(clientData));
+}
+
+// ****************************************************************************
+template <typename cpp_t>
+PyObject *NewNumpyView(vtkDataArray *owner, cpp_t *data,
+  npy_intp nTuples, npy_intp nComps)
+{
+  npy_intp dims[2] = {nTuples, nComps};
+  int nDims = nComps > 1 ? 2 : 1;
+
+  PyObject *obj = PyArray_SimpleNewFromData(nDims, dims,
+    senseiPyArray::NumpyTT<cpp_t>::code, data);
+
+  if (!obj)
+    return nullptr;
+
+  PyArrayObject *arr = reinterpret_cast<PyArrayObject*>(obj);
+
+  // the memory belongs to VTK, Python must not modify it
+  PyArray_CLEARFLAGS(arr, NPY_ARRAY_WRITEABLE);
+
+  // tie the lifetime of the VTK array to the NumPy array
+  owner->Register(nullptr);
+
+  PyObject *capsule = PyCapsule_New(static_cast<vtkObjectBase*>(owner),
+    SENSEI_PY_DATA_ARRAY_CAPSULE, ReleaseVTKReference);
+
+  if (!capsule)
+    {
+    owner->UnRegister(nullptr);
+    Py_DECREF(obj);
+    return nullptr;
+    }
+
+  // this steals the reference to the capsule even when it fails
+  if (PyArray_SetBaseObject(arr, capsule))
+    {
+    Py_DECREF(obj);
+    return nullptr;
+    }
+
+  return obj;
+}
+
+// ****************************************************************************
+inline
+PyObject *NewNumpyView(vtkDataArray *da)
+{
+  if (!da)
+    {
+    PyErr_Format(PyExc_TypeError, "A vtkDataArray is required");
+    return nullptr;
+    }
+
+  npy_intp nTuples = da->GetNumberOfTuples();
+  npy_intp nComps = da->GetNumberOfComponents();
+
+  switch (da->GetDataType())
+    {
+    vtkTemplateMacro(
+      if (vtkAOSDataArrayTemplate<VTK_TT> *aosda =
+        dynamic_cast<vtkAOSDataArrayTemplate<VTK_TT>*>(da))
+        {
+        return NewNumpyView<VTK_TT>(da, aosda->GetPointer(0),
+          nTuples, nComps);
+        }
+      else if (vtkSOADataArrayTemplate<VTK_TT> *soada =
+        dynamic_cast<vtkSOADataArrayTemplate<VTK_TT>*>(da))
+        {
+        PyObject *comps = PyTuple_New(nComps);
+        for (npy_intp i = 0; i < nComps; ++i)
+          {
+          PyObject *comp = NewNumpyView<VTK_TT>(da,
+            soada->GetComponentArrayPointer(i), nTuples, 1);
+
+          if (!comp)
+            {
+            Py_DECREF(comps);
+            return nullptr;
+            }
+
+          // the tuple takes ownership
+          PyTuple_SET_ITEM(comps, i, comp);
+          }
+        return comps;
+        }
+      )
+    }
+
+  PyErr_Format(PyExc_TypeError,
+    "Can't create a NumPy view of a %s", da->GetClassName());
+
+  return nullptr;
+}
+
+// ****************************************************************************
+template <typename cpp_t>
+vtkDataArray *NewDataArray(PyArrayObject *arr)
+{
+  int nDims = PyArray_NDIM(arr);
+  if (nDims > 2)
+    {
+    PyErr_Format(PyExc_ValueError, "Can't create a vtkDataArray "
+      "from a %d dimensional NumPy array", nDims);
+    return nullptr;
+    }
+
+  npy_intp nTuples = nDims ? PyArray_DIM(arr, 0) : 1;
+  npy_intp nComps = nDims == 2 ? PyArray_DIM(arr, 1) : 1;
+
+  vtkDataArray *da = vtkDataArray::CreateDataArray(
+    vtkTypeTraits<cpp_t>::VTK_TYPE_ID);
+
+  vtkAOSDataArrayTemplate<cpp_t> *aosda =
+    dynamic_cast<vtkAOSDataArrayTemplate<cpp_t>*>(da);
+
+  if (!aosda)
+    {
+    PyErr_Format(PyExc_TypeError, "Failed to create a vtkDataArray "
+      "for NumPy type %d", senseiPyArray::NumpyTT<cpp_t>::code);
+    if (da)
+      da->Delete();
+    return nullptr;
+    }
+
+  // point to the NumPy memory, save=1 so that VTK does not free it
+  aosda->SetNumberOfComponents(nComps);
+  aosda->SetArray(static_cast<cpp_t*>(PyArray_DATA(arr)), nTuples*nComps, 1);
+
+  // hold a reference to the NumPy array until the VTK array is deleted
+  Py_INCREF(arr);
+
+  vtkCallbackCommand *cc = vtkCallbackCommand::New();
+  cc->SetCallback(ReleasePyReference);
+  cc->SetClientData(arr);
+  aosda->AddObserver(vtkCommand::DeleteEvent, cc);
+  cc->Delete();
+
+  return da;
+}
+
+// ****************************************************************************
+inline
+vtkDataArray *NewDataArray(PyObject *obj)
+{
+  if (!PyArray_Check(obj))
+    {
+    PyErr_Format(PyExc_TypeError, "A NumPy array is required");
+    return nullptr;
+    }
+
+  // get an aligned, C contiguous, native byte order array.
+  // this is a new reference to obj when no copy is needed
+  PyArrayObject *arr = reinterpret_cast<PyArrayObject*>(
+    PyArray_FROM_OF(obj, NPY_ARRAY_IN_ARRAY|NPY_ARRAY_NOTSWAPPED));
+
+  if (!arr)
+    return nullptr;
+
+  vtkDataArray *da = nullptr;
+
+  SENSEI_PY_ARRAY_DISPATCH(arr,
+    da = NewDataArray<AT>(arr);
+    Py_DECREF(arr);
+    return da;
+    )
+
+  PyErr_Format(PyExc_TypeError, "Can't create a vtkDataArray "
+    "from NumPy type %d", PyArray_TYPE(arr));
+
+  Py_DECREF(arr);
+
+  return nullptr;
+}
+
+}
+
+#endif
@@ -32,6 +32,7 @@ import_array();
 %include "vtk.i"
 %include "senseiTypeMaps.i"
 %include "senseiSTL.i"
+%include "senseiDataArray.i"
 
 %mpi4py_typemap(Comm, MPI_Comm);
 
@@ -187,6 +188,68 @@ VTK_DERIVED(ConfigurableAnalysis)
 %ignore sensei::Histogram::GetHistogram;
 VTK_DERIVED(Histogram)
 
+/****************************************************************************
+ * DescriptiveStatistics
+ ***************************************************************************/
+%extend sensei::DescriptiveStatistics
+{
+  /* return a list with a dictionary per component of each array or raise
+     an exception if an error occurred */
+  PyObject *GetStatistics()
+  {
+    // invoke the C++ method
+    std::vector<sensei::DescriptiveStatistics::Statistics> stats;
+    if (self->GetStatistics(stats))
+      {
+      PyErr_Format(PyExc_RuntimeError,
+        "Failed to get the statistics");
+      return nullptr;
+      }
+
+    unsigned int nStats = stats.size();
+    PyObject *retList = PyList_New(nStats);
+    for (unsigned int i = 0; i < nStats; ++i)
+      {
+      const sensei::DescriptiveStatistics::Statistics &st = stats[i];
+
+      PyObject *dict = PyDict_New();
+      auto setItem = [dict](const char *key, PyObject *val)
+        {
+        PyDict_SetItemString(dict, key, val);
+        Py_DECREF(val);
+        };
+
+      using senseiPyObject::PyTT;
+      setItem("mesh", PyTT<std::string>::NewObject(st.MeshName));
+      setItem("association", PyTT<int>::NewObject(st.Association));
+      setItem("array", PyTT<std::string>::NewObject(st.ArrayName));
+      setItem("component", PyTT<int>::NewObject(st.Component));
+      setItem("count", PyTT<unsigned long long>::NewObject(st.Count));
+      setItem("mean", PyTT<double>::NewObject(st.Mean));
+      setItem("variance", PyTT<double>::NewObject(st.Variance));
+      setItem("skewness", PyTT<double>::NewObject(st.Skewness));
+      setItem("kurtosis", PyTT<double>::NewObject(st.Kurtosis));
+      setItem("min", PyTT<double>::NewObject(st.Min));
+      setItem("min_rank", PyTT<int>::NewObject(st.MinRank));
+      setItem("min_block", PyTT<long>::NewObject(st.MinBlock));
+      setItem("min_index", PyTT<long long>::NewObject(st.MinIndex));
+      setItem("min_location", senseiPySequence::NewList<double>(st.MinLocation, 3));
+      setItem("max", PyTT<double>::NewObject(st.Max));
+      setItem("max_rank", PyTT<int>::NewObject(st.MaxRank));
+      setItem("max_block", PyTT<long>::NewObject(st.MaxBlock));
+      setItem("max_index", PyTT<long long>::NewObject(st.MaxIndex));
+      setItem("max_location", senseiPySequence::NewList<double>(st.MaxLocation, 3));
+
+      PyList_SetItem(retList, i, dict);
+      }
+
+    return retList;
+  }
+}
+%ignore sensei::DescriptiveStatistics::GetStatistics;
+%ignore sensei::DescriptiveStatistics::Statistics;
+VTK_DERIVED(DescriptiveStatistics)
+
 /****************************************************************************
  * Autocorrelation
  ***************************************************************************/
@@ -206,8 +206,8 @@ bool ADIOS2AnalysisAdaptor::Execute(DataAdaptor* dataAdaptor)
     }
 
   // set everything up the first time trhough
-  if (!this->Schema)
-    this->InitializeADIOS2();
+  if (!this->Schema && this->InitializeADIOS2())
+    return false;
 
   unsigned long timeStep = dataAdaptor->GetDataTimeStep();
   double time = dataAdaptor->GetDataTime();
@@ -258,6 +258,24 @@ int ADIOS2AnalysisAdaptor::Initialize(pugi::xml_node &node)
   // enable file series for file based engines
   this->SetStepsPerFile(node.attribute("steps_per_file").as_int(0));
 
+  // configure temporal encoding
+  if (this->SetDeltaMode(node.attribute("delta").as_string("none")) ||
+    this->SetCompressor(node.attribute("compressor").as_string("none")))
+    {
+    SENSEI_ERROR("Failed to configure temporal encoding")
+    return -1;
+    }
+
+  this->SetShuffle(node.attribute("shuffle").as_int(0));
+  this->SetKeyFrameInterval(node.attribute("key_frame_interval").as_uint(10));
+
+  // configure error bounded compression of arrays
+  if (this->Compressor.Initialize(node))
+    {
+    SENSEI_ERROR("Failed to configure compression")
+    return -1;
+    }
+
   // pass a group of engine parameters
   pugi::xml_node params = node.child("engine_parameters");
   if (params)
@@ -294,6 +312,10 @@ int ADIOS2AnalysisAdaptor::InitializeADIOS2()
 {
   TimeEvent<128> mark("ADIOS2AnalysisAdaptor::IntializeADIOS2");
 
+  // already initialized
+  if (this->Schema)
+    return 0;
+
   if (this->StepsPerFile > 0)
     {
     // look for for a decimal format specifier in the file name.
@@ -331,6 +353,12 @@ int ADIOS2AnalysisAdaptor::InitializeADIOS2()
   // create space for ADIOS2 variables
   this->Schema = new senseiADIOS2::DataObjectCollectionSchema;
 
+  if (this->Encoder.Enabled())
+    this->Schema->SetTemporalEncoder(&this->Encoder);
+
+  if (this->Compressor.Enabled())
+    this->Schema->SetErrorBoundedCompressor(&this->Compressor);
+
   // Open the engine
   if (adios2_set_engine(this->Handles.io, this->EngineName.c_str()))
     {
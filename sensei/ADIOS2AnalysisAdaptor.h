@@ -4,6 +4,8 @@
 #include "AnalysisAdaptor.h"
 #include "DataRequirements.h"
 #include "MeshMetadata.h"
+#include "TemporalEncoder.h"
+#include "ErrorBoundedCompressor.h"
 
 #include <ADIOS2Schema.h>
 
@@ -70,6 +72,37 @@ public:
   void SetDebugMode(int mode)
   { this->DebugMode = mode; }
 
+  /// @brief Configure the lossless temporal encoding of arrays.
+  /// Arrays are written as the difference from the previous step ("xor" or
+  /// "arithmetic"), optionally byte shuffled and compressed ("rle" or
+  /// "zlib").
+  /// The geometry of meshes flagged static is written only on key frames.
+  /// Readers must read every step since the last key frame. When writing a
+  /// file series use a StepsPerFile that is a multiple of the key frame
+  /// interval so that each file starts with a key frame. Encoding is off by
+  /// default. See sensei::TemporalEncoder.
+  int SetDeltaMode(const std::string &mode)
+  { return this->Encoder.SetDeltaMode(mode); }
+
+  void SetShuffle(int val)
+  { this->Encoder.SetShuffle(val); }
+
+  int SetCompressor(const std::string &comp)
+  { return this->Encoder.SetCompressor(comp); }
+
+  void SetKeyFrameInterval(unsigned int n)
+  { this->Encoder.SetKeyFrameInterval(n); }
+
+  /// @brief Compress the named array with an error bound. The bound is
+  /// absolute or relative to the range of each block's values, see
+  /// sensei::ErrorBoundedCompressor. An empty mesh name matches every mesh
+  /// and an association of -1 every association. Compressed arrays are not
+  /// temporally encoded. Compression is off by default.
+  int SetErrorBound(const std::string &meshName, int association,
+    const std::string &arrayName, int mode, double bound)
+  { return this->Compressor.SetErrorBound(meshName, association,
+      arrayName, mode, bound); }
+
   /// data requirements tell the adaptor what to push
   /// if none are given then all data is pushed.
   int SetDataRequirements(const DataRequirements &reqs);
@@ -77,6 +110,12 @@ public:
   int AddDataRequirement(const std::string &meshName,
     int association, const std::vector<std::string> &arrays);
 
+  /// @brief Initialize ADIOS2 in no-xml mode.
+  /// This is done automatically during the first call to Execute. It may be
+  /// called after the adaptor has been configured to move the setup out of
+  /// the first time step. Subsequent calls have no effect.
+  int InitializeADIOS2();
+
   // SENSEI AnalysisAdaptor API
   bool Execute(DataAdaptor* data) override;
   int Finalize() override;
@@ -85,9 +124,6 @@ protected:
   ADIOS2AnalysisAdaptor();
   ~ADIOS2AnalysisAdaptor();
 
-  // intializes ADIOS2 in no-xml mode
-  int InitializeADIOS2();
-
   // tells ADIOS what we will write
   int DefineVariables(const std::vector<MeshMetadataPtr> &metadata);
 
@@ -119,6 +155,8 @@ protected:
   long StepsPerFile;
   long StepIndex;
   long FileIndex;
+  sensei::TemporalEncoder Encoder;
+  sensei::ErrorBoundedCompressor Compressor;
 
 private:
   ADIOS2AnalysisAdaptor(const ADIOS2AnalysisAdaptor&) = delete;
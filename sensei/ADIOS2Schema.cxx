@@ -6,6 +6,9 @@
 #include "MPIUtils.h"
 #include "Error.h"
 #include "Profiler.h"
+#include "TemporalEncoder.h"
+#include "ErrorBoundedCompressor.h"
+#include "ThreadPool.h"
 
 #include <vtkCellTypes.h>
 #include <vtkCellData.h>
@@ -898,16 +901,23 @@ int VersionSchema::Read(InputStream &iStream)
 
 struct ArraySchema
 {
+  ArraySchema() : Encoder(nullptr), Decoder(), Compressor(nullptr) {}
+
+  // true if the array is written as bytes, temporally encoded or compressed
+  bool Encodes(const std::string &mesh_name, int array_cen,
+    const std::string &array_name) const;
+
   int DefineVariables(MPI_Comm comm, AdiosHandle handles,
     const std::string &ons, const sensei::MeshMetadataPtr &md);
 
   int DefineVariable(MPI_Comm comm, AdiosHandle handles, const std::string &ons,
-    int i, int array_type, int num_components, int array_cen,
+    int i, bool encoded, int array_type, int num_components, int array_cen,
     unsigned long long num_points_total, unsigned long long num_cells_total,
     unsigned int num_blocks, const std::vector<long> &block_num_points,
     const std::vector<long> &block_num_cells,
     const std::vector<int> &block_owner, std::vector<size_t> &putVarsStart,
-    std::vector<size_t> &putVarsCount, adios2_variable *&putVar);
+    std::vector<size_t> &putVarsCount, adios2_variable *&putVar,
+    adios2_variable *&putBytesVar);
 
   int Write(MPI_Comm comm, AdiosHandle handles,
     const sensei::MeshMetadataPtr &md, vtkCompositeDataSet *dobj);
@@ -918,6 +928,13 @@ struct ArraySchema
     const std::vector<size_t> &putVarsStart, const std::vector<size_t> &putVarsCount,
     adios2_variable *putVar);
 
+  // write temporally encoded or compressed blocks
+  int WriteEncoded(MPI_Comm comm, AdiosHandle handles,
+    const std::string &mesh_name, unsigned int i, const std::string &array_name,
+    int array_cen, vtkCompositeDataSet *dobj, unsigned int num_blocks,
+    const std::vector<int> &block_owner, adios2_variable *putVar,
+    adios2_variable *putBytesVar);
+
   int Read(MPI_Comm comm, AdiosHandle handles, const std::string &ons,
     const std::string &array_name, int centering,
     const sensei::MeshMetadataPtr &md, vtkCompositeDataSet *dobj);
@@ -929,23 +946,73 @@ struct ArraySchema
     const std::vector<long> &block_num_cells, const std::vector<int> &block_owner,
     vtkCompositeDataSet *dobj);
 
+  // read temporally encoded or compressed blocks
+  int ReadEncoded(MPI_Comm comm, AdiosHandle handles, const std::string &ons,
+    const std::string &mesh_name, unsigned int i, const std::string &array_name,
+    int array_type, unsigned long long num_components, int array_cen,
+    unsigned int num_blocks, const std::vector<long> &block_num_points,
+    const std::vector<long> &block_num_cells, const std::vector<int> &block_owner,
+    vtkCompositeDataSet *dobj);
+
   std::map<std::string,std::vector<size_t>> PutVarsStart;
   std::map<std::string,std::vector<size_t>> PutVarsCount;
   std::map<std::string,std::vector<adios2_variable*>> PutVars;
+  std::map<std::string,std::vector<adios2_variable*>> PutBytesVars;
+
+  // when set arrays are written temporally encoded. not owned.
+  sensei::TemporalEncoder *Encoder;
+
+  // decodes temporally encoded arrays on the read side
+  sensei::TemporalEncoder Decoder;
+
+  // when set arrays with an error bound are written compressed. not owned.
+  sensei::ErrorBoundedCompressor *Compressor;
 };
 
+// --------------------------------------------------------------------------
+bool ArraySchema::Encodes(const std::string &mesh_name, int array_cen,
+  const std::string &array_name) const
+{
+  int mode = 0;
+  double bound = 0.0;
+  return this->Encoder || (this->Compressor &&
+    this->Compressor->GetErrorBound(mesh_name, array_cen, array_name,
+    mode, bound));
+}
+
+// --------------------------------------------------------------------------
+static
+void getEncoderKey(std::string &key, const std::string &mesh_name,
+  int array_cen, const std::string &array_name, unsigned int block)
+{
+  std::ostringstream oss;
+  oss << mesh_name << "/" << sensei::VTKUtils::GetAttributesName(array_cen)
+    << "/" << array_name << "/" << block;
+  key = oss.str();
+}
+
+// --------------------------------------------------------------------------
+static
+bool isEncoded(AdiosHandle handles, const std::string &ons, unsigned int i)
+{
+  std::ostringstream path;
+  path << ons << "data_array_" << i << "/encoded";
+  return adios2_inquire_variable(handles.io, path.str().c_str());
+}
+
 
 // --------------------------------------------------------------------------
 int ArraySchema::DefineVariable(MPI_Comm comm, AdiosHandle handles,
-  const std::string &ons, int i, int array_type, int num_components,
-  int array_cen, unsigned long long num_points_total,
+  const std::string &ons, int i, bool encoded, int array_type,
+  int num_components, int array_cen, unsigned long long num_points_total,
   unsigned long long num_cells_total, unsigned int num_blocks,
   const std::vector<long> &block_num_points,
   const std::vector<long> &block_num_cells,
   const std::vector<int> &block_owner,
   std::vector<size_t> &putVarsStart,
   std::vector<size_t> &putVarsCount,
-  adios2_variable *&putVar)
+  adios2_variable *&putVar,
+  adios2_variable *&putBytesVar)
 {
   sensei::TimeEvent<128> mark("senseiADIOS2::ArraySchema::DefineVariable");
 
@@ -981,6 +1048,38 @@ int ArraySchema::DefineVariable(MPI_Comm comm, AdiosHandle handles,
   size_t localStart = 0;
   size_t localCount = 0;
 
+  if (encoded)
+    {
+    // temporally encoded and compressed arrays are written as bytes, the
+    // size of each block is known only after it has been encoded. the
+    // global size is set when writing and the size of each block is
+    // written alongside.
+    // /data_object_<id>/data_array_<id>/encoded
+    // /data_object_<id>/data_array_<id>/encoded_bytes
+    path = ans.str() + "encoded";
+    size_t num_bytes_total = 1;
+
+    putVar = adios2_define_variable(handles.io,
+       path.c_str(), adios2_type_uint8_t, 1, &num_bytes_total, &localStart,
+       &localCount, adios2_constant_dims_false);
+
+    std::string bytesPath = ans.str() + "encoded_bytes";
+    size_t num_blocks_total = num_blocks;
+
+    putBytesVar = adios2_define_variable(handles.io,
+       bytesPath.c_str(), adios2_type_uint64_t, 1, &num_blocks_total,
+       &localStart, &localCount, adios2_constant_dims_false);
+
+    if (!putVar || !putBytesVar)
+      {
+      SENSEI_ERROR("adios2_define_variable failed with path=\""
+        << path << "\"")
+      return -1;
+      }
+
+    return 0;
+    }
+
   putVar = adios2_define_variable(handles.io,
      path.c_str(), elem_type, 1, &num_elem_total, &localStart,
      &localCount, adios2_constant_dims_false);
@@ -1024,6 +1123,7 @@ int ArraySchema::DefineVariables(MPI_Comm comm, AdiosHandle handles,
   std::vector<size_t> &putVarsStart = this->PutVarsStart[md->MeshName];
   std::vector<size_t> &putVarsCount = this->PutVarsCount[md->MeshName];
   std::vector<adios2_variable*> &putVars = this->PutVars[md->MeshName];
+  std::vector<adios2_variable*> &putBytesVars = this->PutBytesVars[md->MeshName];
 
   // allocate write ids
   unsigned int num_blocks = md->NumBlocks;
@@ -1039,6 +1139,7 @@ int ArraySchema::DefineVariables(MPI_Comm comm, AdiosHandle handles,
   putVarsStart.resize(num_blocks*num_arrays_total);
   putVarsCount.resize(num_blocks*num_arrays_total);
   putVars.resize(num_arrays_total);
+  putBytesVars.assign(num_arrays_total, nullptr);
 
   // compute global sizes
   unsigned long long num_points_total = 0;
@@ -1052,25 +1153,33 @@ int ArraySchema::DefineVariables(MPI_Comm comm, AdiosHandle handles,
   // define data arrays
   for (unsigned int i = 0; i < num_arrays; ++i)
     {
-    if (this->DefineVariable(comm, handles, ons, i, md->ArrayType[i],
+    bool encoded = this->Encodes(md->MeshName, md->ArrayCentering[i],
+      md->ArrayName[i]);
+
+    if (this->DefineVariable(comm, handles, ons, i, encoded, md->ArrayType[i],
       md->ArrayComponents[i], md->ArrayCentering[i], num_points_total,
       num_cells_total, num_blocks, md->BlockNumPoints, md->BlockNumCells,
-      md->BlockOwner, putVarsStart, putVarsCount, putVars[i]))
+      md->BlockOwner, putVarsStart, putVarsCount, putVars[i],
+      putBytesVars[i]))
       return -1;
     }
 
   // define ghost arrays
+  bool encoded = this->Encoder != nullptr;
+
   if (have_ghost_cells && this->DefineVariable(comm, handles, ons,
-      num_arrays, VTK_UNSIGNED_CHAR, 1, vtkDataObject::CELL, num_points_total,
-      num_cells_total, num_blocks, md->BlockNumPoints, md->BlockNumCells,
-      md->BlockOwner, putVarsStart, putVarsCount, putVars[num_arrays]))
+      num_arrays, encoded, VTK_UNSIGNED_CHAR, 1, vtkDataObject::CELL,
+      num_points_total, num_cells_total, num_blocks, md->BlockNumPoints, md->BlockNumCells,
+      md->BlockOwner, putVarsStart, putVarsCount, putVars[num_arrays],
+      putBytesVars[num_arrays]))
       return -1;
 
   if (md->NumGhostNodes && this->DefineVariable(comm, handles, ons,
-      num_arrays, VTK_UNSIGNED_CHAR, 1, vtkDataObject::POINT, num_points_total,
-      num_cells_total, num_blocks, md->BlockNumPoints, md->BlockNumCells,
+      num_arrays, encoded, VTK_UNSIGNED_CHAR, 1, vtkDataObject::POINT,
+      num_points_total, num_cells_total, num_blocks, md->BlockNumPoints, md->BlockNumCells,
       md->BlockOwner, putVarsStart, putVarsCount,
-      putVars[num_arrays + (have_ghost_cells ? 1 : 0)]))
+      putVars[num_arrays + (have_ghost_cells ? 1 : 0)],
+      putBytesVars[num_arrays + (have_ghost_cells ? 1 : 0)]))
       return -1;
 
   return 0;
@@ -1150,6 +1259,179 @@ int ArraySchema::Write(MPI_Comm comm, AdiosHandle handles, unsigned int i,
   return 0;
 }
 
+// --------------------------------------------------------------------------
+int ArraySchema::WriteEncoded(MPI_Comm comm, AdiosHandle handles,
+  const std::string &mesh_name, unsigned int i, const std::string &array_name,
+  int array_cen, vtkCompositeDataSet *dobj, unsigned int num_blocks,
+  const std::vector<int> &block_owner, adios2_variable *putVar,
+  adios2_variable *putBytesVar)
+{
+  sensei::Profiler::StartEvent("senseiADIOS2::ArraySchema::WriteEncoded");
+  long long numBytes = 0ll;
+
+  int rank = 0;
+  MPI_Comm_rank(comm, &rank);
+
+  vtkCompositeDataIterator *it = dobj->NewIterator();
+  it->SetSkipEmptyNodes(0);
+  it->InitTraversal();
+
+  // get the arrays of the local blocks. the sizes are needed on all
+  // ranks to place the blocks, hence a failure is recorded and reported
+  // after the sizes have been exchanged
+  int failed = 0;
+  std::vector<vtkDataArray*> arrays(num_blocks, nullptr);
+  std::vector<vtkDataSet*> datasets(num_blocks, nullptr);
+  for (unsigned int j = 0; (j < num_blocks) && !failed; ++j)
+    {
+    if (block_owner[j] == rank)
+      {
+      vtkDataSet *ds = dynamic_cast<vtkDataSet*>(it->GetCurrentDataObject());
+      datasets[j] = ds;
+      vtkDataSetAttributes *dsa = nullptr;
+      if (ds)
+        dsa = array_cen == vtkDataObject::POINT ?
+          dynamic_cast<vtkDataSetAttributes*>(ds->GetPointData()) :
+          dynamic_cast<vtkDataSetAttributes*>(ds->GetCellData());
+
+      arrays[j] = dsa ? dsa->GetArray(array_name.c_str()) : nullptr;
+      if (!arrays[j])
+        {
+        SENSEI_ERROR("Failed to get array \"" << array_name
+          << "\" block " << j << " array " << i)
+        failed = 1;
+        break;
+        }
+      }
+
+    it->GoToNextItem();
+    }
+
+  it->Delete();
+
+  // arrays with an error bound are compressed, others temporally encoded
+  int mode = 0;
+  double bound = 0.0;
+  bool compressed = this->Compressor &&
+    this->Compressor->GetErrorBound(mesh_name, array_cen, array_name,
+    mode, bound);
+
+  // encode the local blocks concurrently. the encoder's state is per
+  // block. the puts below are serial, ADIOS2 is not thread safe.
+  std::vector<std::vector<unsigned char>> encoded(num_blocks);
+  std::vector<uint64_t> block_bytes(num_blocks, 0);
+  if (!failed && sensei::ThreadPool::ParallelFor(num_blocks,
+    [&](unsigned int j) -> int
+    {
+    vtkDataArray *da = arrays[j];
+    if (!da)
+      return 0;
+
+    if (compressed)
+      {
+      // the predictor follows the layout of structured blocks
+      size_t dims[3] = {0, 0, 0};
+      bool structured = sensei::ErrorBoundedCompressor::GetDimensions(
+        datasets[j], array_cen, dims);
+
+      if (sensei::ErrorBoundedCompressor::Encode(da->GetDataType(),
+        da->GetVoidPointer(0), da->GetNumberOfTuples(),
+        da->GetNumberOfComponents(), structured ? dims : nullptr, mode,
+        bound, encoded[j]))
+        {
+        SENSEI_ERROR("Failed to compress block " << j << " array " << i)
+        return -1;
+        }
+
+      block_bytes[j] = encoded[j].size();
+      return 0;
+      }
+
+    std::string key;
+    getEncoderKey(key, mesh_name, array_cen, array_name, j);
+
+    unsigned int elem_size = size(da->GetDataType());
+    size_t n_bytes = da->GetNumberOfTuples()*
+      da->GetNumberOfComponents()*elem_size;
+
+    if (this->Encoder->Encode(key, da->GetVoidPointer(0), n_bytes,
+      elem_size, encoded[j]))
+      {
+      SENSEI_ERROR("Failed to encode block " << j << " array " << i)
+      return -1;
+      }
+
+    block_bytes[j] = encoded[j].size();
+    return 0;
+    }))
+    {
+    failed = 1;
+    }
+
+  for (unsigned int j = 0; j < num_blocks; ++j)
+    numBytes += block_bytes[j];
+
+  MPI_Allreduce(MPI_IN_PLACE, &failed, 1, MPI_INT, MPI_MAX, comm);
+  if (failed)
+    {
+    sensei::Profiler::EndEvent("senseiADIOS2::ArraySchema::WriteEncoded", numBytes);
+    return -1;
+    }
+
+  MPI_Allreduce(MPI_IN_PLACE, block_bytes.data(), num_blocks,
+    MPI_UINT64_T, MPI_SUM, comm);
+
+  // the global size of the variable changes from step to step
+  size_t num_bytes_total = 0;
+  for (unsigned int j = 0; j < num_blocks; ++j)
+    num_bytes_total += block_bytes[j];
+
+  if (adios2_set_shape(putVar, 1, &num_bytes_total))
+    {
+    SENSEI_ERROR("adios2_set_shape " << num_bytes_total
+      << " array " << i << " failed")
+    return -1;
+    }
+
+  size_t offset = 0;
+  for (unsigned int j = 0; j < num_blocks; ++j)
+    {
+    if (block_owner[j] == rank)
+      {
+      size_t start = offset;
+      size_t count = block_bytes[j];
+
+      size_t one = 1;
+      size_t jj = j;
+
+      if (adios2_set_selection(putVar, 1, &start, &count) ||
+        adios2_set_selection(putBytesVar, 1, &jj, &one))
+        {
+        SENSEI_ERROR("adios2_set_selection start=" << start
+          << " count=" << count << " block " << j << " array "
+          << i << " failed")
+        return -1;
+        }
+
+      // /data_object_<id>/data_array_<id>/encoded
+      // /data_object_<id>/data_array_<id>/encoded_bytes
+      if (adios2_put(handles.engine, putVar, encoded[j].data(),
+        adios2_mode_sync) || adios2_put(handles.engine, putBytesVar,
+        &block_bytes[j], adios2_mode_sync))
+        {
+        SENSEI_ERROR("adios2_put block " << j << " array "
+          << i << " failed")
+        return -1;
+        }
+      }
+
+    offset += block_bytes[j];
+    }
+
+  sensei::Profiler::EndEvent("senseiADIOS2::ArraySchema::WriteEncoded", numBytes);
+  return 0;
+}
+
 // --------------------------------------------------------------------------
 int ArraySchema::Write(MPI_Comm comm, AdiosHandle handles,
   const sensei::MeshMetadataPtr &md, vtkCompositeDataSet *dobj)
@@ -1162,13 +1444,50 @@ int ArraySchema::Write(MPI_Comm comm, AdiosHandle handles,
   std::vector<size_t> &putVarsStart = this->PutVarsStart[md->MeshName];
   std::vector<size_t> &putVarsCount = this->PutVarsCount[md->MeshName];
   std::vector<adios2_variable*> &putVars = this->PutVars[md->MeshName];
+  std::vector<adios2_variable*> &putBytesVars = this->PutBytesVars[md->MeshName];
 
-  // write data arrays
   unsigned int num_arrays = md->NumArrays;
   bool have_ghost_cells = md->NumGhostCells || sensei::VTKUtils::AMR(md);
 
+  if (this->Encoder)
+    {
+    // write temporally encoded data arrays
+    for (unsigned int i = 0; i < num_arrays; ++i)
+      {
+      if (this->WriteEncoded(comm, handles, md->MeshName, i, md->ArrayName[i],
+        md->ArrayCentering[i], dobj, md->NumBlocks, md->BlockOwner, putVars[i],
+        putBytesVars[i]))
+        return -1;
+      }
+
+    // write temporally encoded ghost arrays
+    if (have_ghost_cells && this->WriteEncoded(comm, handles, md->MeshName,
+      num_arrays, "vtkGhostType", vtkDataObject::CELL, dobj, md->NumBlocks,
+      md->BlockOwner, putVars[num_arrays], putBytesVars[num_arrays]))
+      return -1;
+
+    unsigned int gn = num_arrays + (have_ghost_cells ? 1 : 0);
+    if (md->NumGhostNodes && this->WriteEncoded(comm, handles, md->MeshName,
+      gn, "vtkGhostType", vtkDataObject::POINT, dobj, md->NumBlocks,
+      md->BlockOwner, putVars[gn], putBytesVars[gn]))
+      return -1;
+
+    return 0;
+    }
+
+  // write data arrays
   for (unsigned int i = 0; i < num_arrays; ++i)
     {
+    // arrays with an error bound are written compressed
+    if (this->Encodes(md->MeshName, md->ArrayCentering[i], md->ArrayName[i]))
+      {
+      if (this->WriteEncoded(comm, handles, md->MeshName, i,
+        md->ArrayName[i], md->ArrayCentering[i], dobj, md->NumBlocks,
+        md->BlockOwner, putVars[i], putBytesVars[i]))
+        return -1;
+      continue;
+      }
+
     if (this->Write(comm, handles, i, md->ArrayName[i], md->ArrayCentering[i],
       dobj, md->NumBlocks, md->BlockOwner, putVarsStart, putVarsCount, putVars[i]))
       return -1;
@@ -1286,6 +1605,132 @@ int ArraySchema::Read(MPI_Comm comm, AdiosHandle handles, const std::string &ons
   return 0;
 }
 
+// --------------------------------------------------------------------------
+int ArraySchema::ReadEncoded(MPI_Comm comm, AdiosHandle handles,
+  const std::string &ons, const std::string &mesh_name, unsigned int i,
+  const std::string &array_name, int array_type,
+  unsigned long long num_components, int array_cen, unsigned int num_blocks,
+  const std::vector<long> &block_num_points,
+  const std::vector<long> &block_num_cells, const std::vector<int> &block_owner,
+  vtkCompositeDataSet *dobj)
+{
+  sensei::Profiler::StartEvent("senseiADIOS2::ArraySchema::ReadEncoded");
+  long long numBytes = 0ll;
+
+  int rank = 0;
+  MPI_Comm_rank(comm, &rank);
+
+  // put each data array in its own namespace
+  std::ostringstream ans;
+  ans << ons << "data_array_" << i << "/";
+
+  std::string path = ans.str() + "encoded";
+  std::string bytesPath = ans.str() + "encoded_bytes";
+
+  adios2_variable *vinfo = adios2_inquire_variable(handles.io, path.c_str());
+  adios2_variable *binfo = adios2_inquire_variable(handles.io, bytesPath.c_str());
+  if (!vinfo || !binfo)
+    {
+    SENSEI_ERROR("adios2_inquire_variable \"" << path
+      << "\" array " << i << " failed")
+    return -1;
+    }
+
+  // /data_object_<id>/data_array_<id>/encoded_bytes
+  // the size of each block is needed to locate the local blocks
+  std::vector<uint64_t> block_bytes(num_blocks);
+  size_t start = 0;
+  size_t count = num_blocks;
+  if (adios2_set_selection(binfo, 1, &start, &count) ||
+    adios2_get(handles.engine, binfo, block_bytes.data(), adios2_mode_sync))
+    {
+    SENSEI_ERROR("Failed to read \"" << bytesPath << "\" array " << i)
+    return -1;
+    }
+
+  vtkCompositeDataIterator *it = dobj->NewIterator();
+  it->SetSkipEmptyNodes(0);
+  it->InitTraversal();
+
+  std::vector<unsigned char> encoded;
+  unsigned long long block_offset = 0;
+  for (unsigned int j = 0; j < num_blocks; ++j)
+    {
+    if (block_owner[j] ==  rank)
+      {
+      // /data_object_<id>/data_array_<id>/encoded
+      start = block_offset;
+      count = block_bytes[j];
+      encoded.resize(count);
+      if (adios2_set_selection(vinfo, 1, &start, &count) ||
+        adios2_get(handles.engine, vinfo, encoded.data(), adios2_mode_sync))
+        {
+        SENSEI_ERROR("Failed to read \"" << array_name
+          << "\" block " << j << " array " << i)
+        it->Delete();
+        return -1;
+        }
+
+      unsigned long long num_elem_local = (array_cen == vtkDataObject::POINT ?
+        block_num_points[j] : block_num_cells[j])*num_components;
+
+      vtkDataArray *array = vtkDataArray::CreateDataArray(array_type);
+      array->SetNumberOfComponents(num_components);
+      array->SetNumberOfTuples(num_elem_local/num_components);
+      array->SetName(array_name.c_str());
+
+      std::string key;
+      getEncoderKey(key, mesh_name, array_cen, array_name, j);
+
+      // compressed blocks are self contained, others temporally encoded
+      size_t n_bytes = num_elem_local*size(array_type);
+
+      int ierr = sensei::ErrorBoundedCompressor::IsEncoded(encoded.data(),
+        encoded.size()) ? sensei::ErrorBoundedCompressor::Decode(
+        encoded.data(), encoded.size(), array->GetVoidPointer(0), n_bytes) :
+        this->Decoder.Decode(key, encoded.data(), encoded.size(),
+        array->GetVoidPointer(0), n_bytes);
+
+      if (ierr)
+        {
+        SENSEI_ERROR("Failed to decode \"" << array_name
+          << "\" block " << j << " array " << i)
+        array->Delete();
+        it->Delete();
+        return -1;
+        }
+
+      // pass to vtk
+      vtkDataSet *ds = dynamic_cast<vtkDataSet*>(it->GetCurrentDataObject());
+      if (!ds)
+        {
+        SENSEI_ERROR("Failed to get block " << j)
+        array->Delete();
+        it->Delete();
+        return -1;
+        }
+
+      vtkDataSetAttributes *dsa = array_cen == vtkDataObject::POINT ?
+        dynamic_cast<vtkDataSetAttributes*>(ds->GetPointData()) :
+        dynamic_cast<vtkDataSetAttributes*>(ds->GetCellData());
+
+      dsa->AddArray(array);
+      array->Delete();
+
+      numBytes += encoded.size();
+      }
+
+    block_offset += block_bytes[j];
+
+    it->GoToNextItem();
+    }
+
+  it->Delete();
+
+  sensei::Profiler::EndEvent("senseiADIOS2::ArraySchema::ReadEncoded", numBytes);
+  return 0;
+}
+
 // --------------------------------------------------------------------------
 int ArraySchema::Read(MPI_Comm comm, AdiosHandle handles, const std::string &ons,
   const std::string &name, int centering, const sensei::MeshMetadataPtr &md,
@@ -1304,6 +1749,11 @@ int ArraySchema::Read(MPI_Comm comm, AdiosHandle handles, const std::string &ons
     unsigned int i = (centering == vtkDataObject::CELL ?
       num_arrays : num_arrays + (have_ghost_cells ? 1 : 0));
 
+    if (isEncoded(handles, ons, i))
+      return this->ReadEncoded(comm, handles, ons, md->MeshName, i,
+        "vtkGhostType", VTK_UNSIGNED_CHAR, 1, centering, num_blocks,
+        md->BlockNumPoints, md->BlockNumCells, md->BlockOwner, dobj);
+
     return this->Read(comm, handles, ons, i, "vtkGhostType",
       VTK_UNSIGNED_CHAR, 1, centering, num_blocks, md->BlockNumPoints,
       md->BlockNumCells, md->BlockOwner, dobj);
@@ -1319,6 +1769,12 @@ int ArraySchema::Read(MPI_Comm comm, AdiosHandle handles, const std::string &ons
     if ((centering != array_cen) || (name != array_name))
       continue;
 
+    if (isEncoded(handles, ons, i))
+      return this->ReadEncoded(comm, handles, ons, md->MeshName, i,
+        array_name, md->ArrayType[i], md->ArrayComponents[i], array_cen,
+        num_blocks, md->BlockNumPoints, md->BlockNumCells, md->BlockOwner,
+        dobj);
+
     return this->Read(comm, handles, ons, i, array_name, md->ArrayType[i],
       md->ArrayComponents[i], array_cen, num_blocks, md->BlockNumPoints,
       md->BlockNumCells, md->BlockOwner, dobj);
@@ -3332,6 +3788,8 @@ int StretchedCartesianSchema::Read(MPI_Comm comm, AdiosHandle handles,
 
 struct DataObjectSchema
 {
+  DataObjectSchema() : Encoder(nullptr) {}
+
   int DefineVariables(MPI_Comm comm, AdiosHandle handles,
     unsigned int doid,  const sensei::MeshMetadataPtr &md);
 
@@ -3349,6 +3807,25 @@ struct DataObjectSchema
   int InitializeDataObject(MPI_Comm comm,
     const sensei::MeshMetadataPtr &md, vtkCompositeDataSet *&dobj);
 
+  // keep a shallow copy of the geometry of a static mesh
+  void CacheGeometry(MPI_Comm comm, const sensei::MeshMetadataPtr &md,
+    vtkCompositeDataSet *dobj);
+
+  // restore the geometry of a static mesh from the cache
+  int ReadCachedGeometry(MPI_Comm comm, const sensei::MeshMetadataPtr &md,
+    vtkCompositeDataSet *dobj);
+
+  // set the encoder used for arrays
+  void SetTemporalEncoder(sensei::TemporalEncoder *enc);
+
+  // set the compressor used for arrays with an error bound
+  void SetErrorBoundedCompressor(sensei::ErrorBoundedCompressor *comp);
+
+  // when set, the geometry of static meshes is written only on key frames
+  sensei::TemporalEncoder *Encoder;
+  std::map<std::string, unsigned long> StaticMeshSteps;
+  std::map<std::string, std::vector<vtkSmartPointer<vtkDataSet>>> GeometryCache;
+
   ArraySchema DataArrays;
   PointSchema Points;
   UnstructuredCellSchema UnstructuredCells;
@@ -3382,6 +3859,17 @@ int DataObjectSchema::DefineVariables(MPI_Comm comm, AdiosHandle handles,
     return -1;
     }
 
+  // /data_object_<id>/cached_geometry
+  // non-zero when the geometry of a static mesh was not written
+  std::string path = ons.str() + "cached_geometry";
+  if (this->Encoder && md->StaticMesh &&
+    !adios2_define_variable(handles.io, path.c_str(), adios2_type_int32_t,
+    0, NULL, NULL, NULL, adios2_constant_dims_true))
+    {
+    SENSEI_ERROR("adios2_define_variable \"" << path << "\" failed")
+    return -1;
+    }
+
   return 0;
 }
 
@@ -3391,6 +3879,39 @@ int DataObjectSchema::Write(MPI_Comm comm, AdiosHandle handles, unsigned int doi
 {
   sensei::TimeEvent<128> mark("senseiADIOS2::DataObjectSchema::Write");
 
+  // when encoding, the geometry of a static mesh is written only on key
+  // frames, readers reuse the geometry of the last key frame
+  if (this->Encoder && md->StaticMesh)
+    {
+    unsigned long &step = this->StaticMeshSteps[md->MeshName];
+    unsigned int interval = this->Encoder->GetKeyFrameInterval();
+    int cached = !((step == 0) || (interval && ((step % interval) == 0)));
+    ++step;
+
+    std::ostringstream path;
+    path << "data_object_" << doid << "/cached_geometry";
+
+    if (adios2_put_by_name(handles.engine, path.str().c_str(),
+      &cached, adios2_mode_sync))
+      {
+      SENSEI_ERROR("adios2_put_by_name \"" << path.str() << "\" failed")
+      return -1;
+      }
+
+    if (cached)
+      {
+      if (this->DataArrays.Write(comm, handles, md, dobj) ||
+        this->UniformCartesian.Write(comm, handles, md, dobj) ||
+        this->LogicallyCartesian.Write(comm, handles, md, dobj))
+        {
+        SENSEI_ERROR("Failed to write for object "
+          << doid << " \"" << md->MeshName << "\"")
+        return -1;
+        }
+      return 0;
+      }
+    }
+
   if (this->DataArrays.Write(comm, handles, md, dobj) ||
     this->Points.Write(comm, handles, md, dobj) ||
     this->UnstructuredCells.Write(comm, handles, md, dobj) ||
@@ -3426,6 +3947,33 @@ int DataObjectSchema::ReadMesh(MPI_Comm comm, AdiosHandle handles,
   std::ostringstream ons;
   ons << "data_object_" << doid << "/";
 
+  // /data_object_<id>/cached_geometry
+  // when present and non-zero the geometry of the static mesh is that of
+  // the last key frame
+  std::string path = ons.str() + "cached_geometry";
+  if (adios2_variable *vinfo = adios2_inquire_variable(handles.io, path.c_str()))
+    {
+    int cached = 0;
+    if (adios2_get(handles.engine, vinfo, &cached, adios2_mode_sync))
+      {
+      SENSEI_ERROR("adios2_get \"" << path << "\" failed")
+      return -1;
+      }
+
+    if (cached)
+      {
+      if ((!structure_only && this->ReadCachedGeometry(comm, md, dobj)) ||
+        this->UniformCartesian.Read(comm, handles, ons.str(), md, dobj) ||
+        this->LogicallyCartesian.Read(comm, handles, ons.str(), md, dobj))
+        {
+        SENSEI_ERROR("Failed to read cached geometry for object "
+          << doid << " \"" << md->MeshName << "\"")
+        return -1;
+        }
+      return 0;
+      }
+    }
+
   if ((!structure_only &&
     (this->Points.Read(comm, handles, ons.str(), md, dobj) ||
     this->UnstructuredCells.Read(comm, handles, ons.str(), md, dobj) ||
@@ -3439,9 +3987,94 @@ int DataObjectSchema::ReadMesh(MPI_Comm comm, AdiosHandle handles,
     return -1;
     }
 
+  if (md->StaticMesh && !structure_only)
+    this->CacheGeometry(comm, md, dobj);
+
   return 0;
 }
 
+// --------------------------------------------------------------------------
+void DataObjectSchema::CacheGeometry(MPI_Comm comm,
+  const sensei::MeshMetadataPtr &md, vtkCompositeDataSet *dobj)
+{
+  int rank = 0;
+  MPI_Comm_rank(comm, &rank);
+
+  std::vector<vtkSmartPointer<vtkDataSet>> &cache =
+    this->GeometryCache[md->MeshName];
+
+  cache.assign(md->NumBlocks, nullptr);
+
+  vtkCompositeDataIterator *it = dobj->NewIterator();
+  it->SetSkipEmptyNodes(0);
+  it->InitTraversal();
+
+  for (int j = 0; j < md->NumBlocks; ++j)
+    {
+    vtkDataSet *ds = dynamic_cast<vtkDataSet*>(it->GetCurrentDataObject());
+    if ((md->BlockOwner[j] == rank) && ds)
+      {
+      // a shallow copy of the points and cells
+      cache[j].TakeReference(ds->NewInstance());
+      cache[j]->CopyStructure(ds);
+      }
+    it->GoToNextItem();
+    }
+
+  it->Delete();
+}
+
+// --------------------------------------------------------------------------
+int DataObjectSchema::ReadCachedGeometry(MPI_Comm comm,
+  const sensei::MeshMetadataPtr &md, vtkCompositeDataSet *dobj)
+{
+  int rank = 0;
+  MPI_Comm_rank(comm, &rank);
+
+  std::vector<vtkSmartPointer<vtkDataSet>> &cache =
+    this->GeometryCache[md->MeshName];
+
+  vtkCompositeDataIterator *it = dobj->NewIterator();
+  it->SetSkipEmptyNodes(0);
+  it->InitTraversal();
+
+  for (int j = 0; j < md->NumBlocks; ++j)
+    {
+    if (md->BlockOwner[j] == rank)
+      {
+      vtkDataSet *ds = dynamic_cast<vtkDataSet*>(it->GetCurrentDataObject());
+      if (!ds || (j >= int(cache.size())) || !cache[j])
+        {
+        SENSEI_ERROR("The geometry of block " << j << " of static mesh \""
+          << md->MeshName << "\" was not cached. The mesh must be read on"
+          " the last key frame")
+        it->Delete();
+        return -1;
+        }
+      ds->CopyStructure(cache[j]);
+      }
+    it->GoToNextItem();
+    }
+
+  it->Delete();
+
+  return 0;
+}
+
+// --------------------------------------------------------------------------
+void DataObjectSchema::SetTemporalEncoder(sensei::TemporalEncoder *enc)
+{
+  this->Encoder = enc;
+  this->DataArrays.Encoder = enc;
+}
+
+// --------------------------------------------------------------------------
+void DataObjectSchema::SetErrorBoundedCompressor(
+  sensei::ErrorBoundedCompressor *comp)
+{
+  this->DataArrays.Compressor = comp;
+}
+
 // --------------------------------------------------------------------------
 int DataObjectSchema::ReadArray(MPI_Comm comm, AdiosHandle handles,
   unsigned int doid, const std::string &name, int association,
@@ -3900,6 +4533,19 @@ int DataObjectCollectionSchema::ReadArray(MPI_Comm comm,
   return 0;
 }
 
+// --------------------------------------------------------------------------
+void DataObjectCollectionSchema::SetTemporalEncoder(sensei::TemporalEncoder *enc)
+{
+  this->Internals->DataObject.SetTemporalEncoder(enc);
+}
+
+// --------------------------------------------------------------------------
+void DataObjectCollectionSchema::SetErrorBoundedCompressor(
+  sensei::ErrorBoundedCompressor *comp)
+{
+  this->Internals->DataObject.SetErrorBoundedCompressor(comp);
+}
+
 // --------------------------------------------------------------------------
 int DataObjectCollectionSchema::ReadTimeStep(MPI_Comm comm,
   InputStream &iStream, unsigned long &time_step, double &time)
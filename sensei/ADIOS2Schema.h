@@ -4,6 +4,8 @@
 class vtkDataSet;
 class vtkDataObject;
 
+namespace sensei { class TemporalEncoder; class ErrorBoundedCompressor; }
+
 #include "MeshMetadata.h"
 #include <adios2_c.h>
 #include <adios2.h>
@@ -87,6 +89,16 @@ public:
   int ReadTimeStep(MPI_Comm comm, InputStream &iStream,
     unsigned long &time_step, double &time);
 
+  // when set arrays are written temporally encoded and the geometry of
+  // static meshes is written only on key frames. the encoder is not owned
+  // and must outlive the schema. reading detects encoded arrays itself.
+  void SetTemporalEncoder(sensei::TemporalEncoder *enc);
+
+  // when set arrays given an error bound are written compressed. the
+  // compressor is not owned and must outlive the schema. reading detects
+  // compressed arrays itself.
+  void SetErrorBoundedCompressor(sensei::ErrorBoundedCompressor *comp);
+
 private:
   // given a name get the id
   int GetObjectId(MPI_Comm comm,
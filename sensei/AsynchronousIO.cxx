@@ -0,0 +1,431 @@
+#include "AsynchronousIO.h"
+#include "DataAdaptor.h"
+#include "VTKDataAdaptor.h"
+#include "Profiler.h"
+#include "Error.h"
+
+#include <vtkObjectFactory.h>
+#include <vtkSmartPointer.h>
+
+#include <deque>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cctype>
+
+namespace sensei
+{
+
+struct AsynchronousIO::InternalsType
+{
+  InternalsType() : Analysis(), Requirements(), QueueDepth(1),
+    Policy(POLICY_BLOCK), MemoryBudget(0), DeepCopy(1), Mode(MODE_UNKNOWN),
+    HeldBytes(0), Done(false), WorkerErrors(0), Dropped(0) {}
+
+  // start the worker thread, or fall back to synchronous execution
+  int StartWorker();
+
+  // process queued steps until the queue is drained and Done is set
+  void RunWorker();
+
+  // drain the queue and join the worker thread
+  int StopWorker();
+
+  // true when a step of the given size fits in the memory budget
+  bool InBudget(unsigned long long nBytes) const
+  {
+    return !this->MemoryBudget || !this->HeldBytes ||
+      (this->HeldBytes + nBytes <= this->MemoryBudget);
+  }
+
+  vtkSmartPointer<AnalysisAdaptor> Analysis;
+  DataRequirements Requirements;
+  unsigned int QueueDepth;
+  int Policy;
+  unsigned long long MemoryBudget;
+  int DeepCopy;
+
+  enum {MODE_UNKNOWN=0, MODE_ASYNCHRONOUS=1, MODE_SYNCHRONOUS=2};
+  int Mode;
+
+  // a captured step and the memory it holds
+  struct Step
+    {
+    VTKDataAdaptor *Data;
+    unsigned long long Bytes;
+    };
+
+  // the adaptors used to pass data to the worker. an adaptor is either
+  // free, queued, or being written.
+  std::vector<VTKDataAdaptor*> Adaptors;
+  std::deque<VTKDataAdaptor*> FreeAdaptors;
+  std::deque<Step> Queue;
+  unsigned long long HeldBytes;
+
+  std::thread Worker;
+  std::mutex QueueMutex;
+  std::condition_variable QueueNotEmpty;
+  std::condition_variable SpaceFree;
+  bool Done;
+  int WorkerErrors;
+  unsigned long Dropped;
+};
+
+//-----------------------------------------------------------------------------
+int AsynchronousIO::InternalsType::StartWorker()
+{
+  // the worker and the simulation make MPI calls concurrently
+  int threadLevel = MPI_THREAD_SINGLE;
+  MPI_Query_thread(&threadLevel);
+  if (threadLevel < MPI_THREAD_MULTIPLE)
+    {
+    SENSEI_WARNING("Asynchronous I/O requires MPI_THREAD_MULTIPLE. "
+      << this->Analysis->GetClassName() << " will run synchronously")
+    this->Mode = MODE_SYNCHRONOUS;
+    return 0;
+    }
+
+  // the queue holds QueueDepth steps while one more is written. the
+  // adaptors are handed to the wrapped adaptor and use its communicator
+  unsigned int nAdaptors = this->QueueDepth + 1;
+  for (unsigned int i = 0; i < nAdaptors; ++i)
+    {
+    VTKDataAdaptor *vda = VTKDataAdaptor::New();
+    vda->SetCommunicator(this->Analysis->GetCommunicator());
+    this->Adaptors.push_back(vda);
+    this->FreeAdaptors.push_back(vda);
+    }
+
+  this->Done = false;
+  this->WorkerErrors = 0;
+  this->HeldBytes = 0;
+
+  this->Worker = std::thread(&AsynchronousIO::InternalsType::RunWorker, this);
+
+  this->Mode = MODE_ASYNCHRONOUS;
+
+  return 0;
+}
+
+//-----------------------------------------------------------------------------
+void AsynchronousIO::InternalsType::RunWorker()
+{
+  while (true)
+    {
+    Step step;
+
+    // wait for data
+      {
+      std::unique_lock<std::mutex> lock(this->QueueMutex);
+
+      this->QueueNotEmpty.wait(lock,
+        [this]() { return this->Done || !this->Queue.empty(); });
+
+      // the queue has been drained
+      if (this->Queue.empty())
+        return;
+
+      step = this->Queue.front();
+      this->Queue.pop_front();
+      }
+
+    // write the step
+    bool ok = false;
+      {
+      TimeEvent<128> event("AsynchronousIO::Write");
+      ok = this->Analysis->Execute(step.Data);
+      }
+
+    step.Data->ReleaseData();
+
+    // hand the adaptor back to the simulation
+      {
+      std::lock_guard<std::mutex> lock(this->QueueMutex);
+      this->FreeAdaptors.push_back(step.Data);
+      this->HeldBytes -= step.Bytes;
+      this->WorkerErrors += ok ? 0 : 1;
+      }
+
+    this->SpaceFree.notify_all();
+    }
+}
+
+//-----------------------------------------------------------------------------
+int AsynchronousIO::InternalsType::StopWorker()
+{
+  if (!this->Worker.joinable())
+    return 0;
+
+  // let the worker finish what is queued
+    {
+    std::lock_guard<std::mutex> lock(this->QueueMutex);
+    this->Done = true;
+    }
+
+  this->QueueNotEmpty.notify_one();
+  this->Worker.join();
+
+  unsigned int nAdaptors = this->Adaptors.size();
+  for (unsigned int i = 0; i < nAdaptors; ++i)
+    this->Adaptors[i]->Delete();
+
+  this->Adaptors.clear();
+  this->FreeAdaptors.clear();
+
+  if (this->WorkerErrors)
+    {
+    SENSEI_ERROR(<< this->Analysis->GetClassName() << "::Execute failed "
+      << this->WorkerErrors << " times on the worker thread")
+    return -1;
+    }
+
+  return 0;
+}
+
+
+
+//-----------------------------------------------------------------------------
+senseiNewMacro(AsynchronousIO);
+
+//-----------------------------------------------------------------------------
+AsynchronousIO::AsynchronousIO() : Internals(nullptr)
+{
+  this->Internals = new InternalsType;
+}
+
+//-----------------------------------------------------------------------------
+AsynchronousIO::~AsynchronousIO()
+{
+  if (this->Internals->Worker.joinable())
+    SENSEI_ERROR("AsynchronousIO::Finalize not called")
+
+  delete this->Internals;
+}
+
+//-----------------------------------------------------------------------------
+void AsynchronousIO::SetAnalysis(AnalysisAdaptor *analysis)
+{
+  this->Internals->Analysis = analysis;
+}
+
+//-----------------------------------------------------------------------------
+AnalysisAdaptor *AsynchronousIO::GetAnalysis()
+{
+  return this->Internals->Analysis.GetPointer();
+}
+
+//-----------------------------------------------------------------------------
+int AsynchronousIO::SetDataRequirements(const DataRequirements &reqs)
+{
+  this->Internals->Requirements = reqs;
+  return 0;
+}
+
+//-----------------------------------------------------------------------------
+void AsynchronousIO::SetQueueDepth(unsigned int depth)
+{
+  this->Internals->QueueDepth = depth < 1 ? 1 : depth;
+}
+
+//-----------------------------------------------------------------------------
+int AsynchronousIO::SetQueuePolicy(int policy)
+{
+  if ((policy != AsynchronousIO::POLICY_BLOCK) &&
+    (policy != AsynchronousIO::POLICY_DROP))
+    {
+    SENSEI_ERROR("Invalid queue policy " << policy)
+    return -1;
+    }
+
+  this->Internals->Policy = policy;
+  return 0;
+}
+
+//-----------------------------------------------------------------------------
+int AsynchronousIO::SetQueuePolicy(std::string policyStr)
+{
+  unsigned int n = policyStr.size();
+  for (unsigned int i = 0; i < n; ++i)
+    policyStr[i] = tolower(policyStr[i]);
+
+  int policy = 0;
+  if (policyStr == "block")
+    {
+    policy = AsynchronousIO::POLICY_BLOCK;
+    }
+  else if (policyStr == "drop")
+    {
+    policy = AsynchronousIO::POLICY_DROP;
+    }
+  else
+    {
+    SENSEI_ERROR("invalid queue policy \"" << policyStr << "\"")
+    return -1;
+    }
+
+  this->Internals->Policy = policy;
+  return 0;
+}
+
+//-----------------------------------------------------------------------------
+void AsynchronousIO::SetMemoryBudget(unsigned long long nBytes)
+{
+  this->Internals->MemoryBudget = nBytes;
+}
+
+//-----------------------------------------------------------------------------
+void AsynchronousIO::SetDeepCopy(int val)
+{
+  this->Internals->DeepCopy = val;
+}
+
+//-----------------------------------------------------------------------------
+unsigned long AsynchronousIO::GetNumberOfDroppedSteps()
+{
+  return this->Internals->Dropped;
+}
+
+//-----------------------------------------------------------------------------
+bool AsynchronousIO::Execute(DataAdaptor *dataAdaptor)
+{
+  InternalsType *internals = this->Internals;
+
+  if (!internals->Analysis)
+    {
+    SENSEI_ERROR("No analysis to run was set")
+    return false;
+    }
+
+  if ((internals->Mode == InternalsType::MODE_UNKNOWN) &&
+    internals->StartWorker())
+    {
+    SENSEI_ERROR("Failed to start the worker thread")
+    return false;
+    }
+
+  if (internals->Mode == InternalsType::MODE_SYNCHRONOUS)
+    return internals->Analysis->Execute(dataAdaptor);
+
+  bool drop = internals->Policy == AsynchronousIO::POLICY_DROP;
+
+  // get a free adaptor. when blocking, this is where the simulation is
+  // held back when the queue is full
+  VTKDataAdaptor *snap = nullptr;
+    {
+    TimeEvent<128> event("AsynchronousIO::QueueWait");
+
+    std::unique_lock<std::mutex> lock(internals->QueueMutex);
+
+    if (!drop)
+      internals->SpaceFree.wait(lock,
+        [internals]() { return !internals->FreeAdaptors.empty(); });
+
+    // report failures that occurred on the worker thread
+    if (internals->WorkerErrors)
+      {
+      SENSEI_ERROR(<< internals->Analysis->GetClassName()
+        << "::Execute failed on the worker thread")
+      return false;
+      }
+
+    if (!internals->FreeAdaptors.empty())
+      {
+      snap = internals->FreeAdaptors.front();
+      internals->FreeAdaptors.pop_front();
+      }
+    }
+
+  // capture the data by reference, it is copied once the step has been
+  // admitted
+  int ierr = 0;
+  unsigned long long nBytes = 0;
+  if (snap)
+    {
+    TimeEvent<128> event("AsynchronousIO::Capture");
+    ierr = snap->Capture(dataAdaptor, internals->Requirements, 0);
+    nBytes = snap->GetMemorySize();
+    }
+
+  if (ierr)
+    {
+    SENSEI_ERROR("Failed to capture data for the worker thread")
+    snap->ReleaseData();
+    std::lock_guard<std::mutex> lock(internals->QueueMutex);
+    internals->FreeAdaptors.push_front(snap);
+    return false;
+    }
+
+  // check the memory budget
+  int admit = 0;
+    {
+    TimeEvent<128> event("AsynchronousIO::QueueWait");
+
+    std::unique_lock<std::mutex> lock(internals->QueueMutex);
+
+    if (!drop)
+      internals->SpaceFree.wait(lock,
+        [internals, nBytes]() { return internals->InBudget(nBytes); });
+
+    admit = snap && internals->InBudget(nBytes);
+    }
+
+  // all ranks must drop the same steps since the wrapped adaptor
+  // makes collective calls
+  if (drop)
+    {
+    MPI_Allreduce(MPI_IN_PLACE, &admit, 1, MPI_INT, MPI_MIN,
+      this->GetCommunicator());
+
+    if (!admit)
+      {
+      if (snap)
+        {
+        snap->ReleaseData();
+        std::lock_guard<std::mutex> lock(internals->QueueMutex);
+        internals->FreeAdaptors.push_front(snap);
+        }
+
+      internals->Dropped += 1;
+
+      if (this->GetVerbose())
+        SENSEI_STATUS("Dropped step " << dataAdaptor->GetDataTimeStep()
+          << ", the queue is full")
+
+      return true;
+      }
+    }
+
+  // take a private copy so the simulation is free to modify its data
+  if (internals->DeepCopy)
+    {
+    TimeEvent<128> event("AsynchronousIO::Capture");
+    snap->DeepCopyDataObjects();
+    }
+
+  // hand it to the worker
+  std::lock_guard<std::mutex> lock(internals->QueueMutex);
+  internals->Queue.push_back({snap, nBytes});
+  internals->HeldBytes += nBytes;
+  internals->QueueNotEmpty.notify_one();
+
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+int AsynchronousIO::Finalize()
+{
+  // write any queued steps
+  int ierr = this->Internals->StopWorker();
+
+  if (this->Internals->Dropped)
+    SENSEI_STATUS(<< this->Internals->Dropped << " steps were dropped because"
+      " the queue was full")
+
+  if (this->Internals->Analysis && this->Internals->Analysis->Finalize())
+    ierr = -1;
+
+  return ierr;
+}
+
+}
@@ -0,0 +1,90 @@
+#ifndef sensei_AsynchronousIO_h
+#define sensei_AsynchronousIO_h
+
+#include "AnalysisAdaptor.h"
+#include "DataRequirements.h"
+
+#include <mpi.h>
+#include <string>
+
+namespace sensei
+{
+class DataAdaptor;
+
+/// @class AsynchronousIO
+/// @brief Runs another analysis adaptor, typically a writer, on a thread
+///
+/// Execute captures the meshes and arrays named in the data requirements
+/// (see SetDataRequirements), or all of the simulation's data when none are
+/// given, queues them and returns to the simulation. A dedicated thread
+/// passes each captured step to the wrapped adaptor's Execute, so that the
+/// simulation does not wait on the file system. The captured data is deep
+/// copied by default. When deep copies are disabled the arrays are
+/// referenced and the simulation must not modify them until they have been
+/// written.
+///
+/// The queue holds at most QueueDepth steps and, when a budget is set, the
+/// queued and in process steps hold at most MemoryBudget bytes. When either
+/// limit is reached Execute either blocks until the worker catches up, or
+/// drops the step. The decision to drop is made collectively so that all
+/// ranks skip the same steps. The queued steps are written before Finalize
+/// returns.
+///
+/// The wrapped adaptor makes its MPI calls on the worker thread using its
+/// own communicator, which every AnalysisAdaptor duplicates. This requires
+/// MPI_THREAD_MULTIPLE, when it is not available Execute runs the wrapped
+/// adaptor synchronously.
+class AsynchronousIO : public AnalysisAdaptor
+{
+public:
+  static AsynchronousIO *New();
+  senseiTypeMacro(AsynchronousIO, AnalysisAdaptor);
+
+  /// @brief Set the adaptor to run on the worker thread. It must be
+  /// initialized. A reference is held.
+  void SetAnalysis(AnalysisAdaptor *analysis);
+  AnalysisAdaptor *GetAnalysis();
+
+  /// @brief Set the meshes and arrays to capture. When none are given
+  /// everything the simulation provides is captured.
+  int SetDataRequirements(const DataRequirements &reqs);
+
+  /// @brief Set the number of steps that can wait to be written. The
+  /// default is 1.
+  void SetQueueDepth(unsigned int depth);
+
+  /// @brief Set what happens when the queue is full. POLICY_BLOCK, the
+  /// default, waits for the worker, POLICY_DROP skips the step. The string
+  /// form accepts "block" and "drop".
+  enum {POLICY_BLOCK=0, POLICY_DROP=1};
+  int SetQueuePolicy(int policy);
+  int SetQueuePolicy(std::string policy);
+
+  /// @brief Set the number of bytes that captured steps may hold. The
+  /// default of 0 places no limit. At least one step is always admitted.
+  void SetMemoryBudget(unsigned long long nBytes);
+
+  /// @brief When set, the default, captured arrays are deep copied.
+  void SetDeepCopy(int val);
+
+  /// @brief Get the number of steps dropped because the queue was full.
+  unsigned long GetNumberOfDroppedSteps();
+
+  // SENSEI API
+  bool Execute(DataAdaptor *data) override;
+  int Finalize() override;
+
+protected:
+  AsynchronousIO();
+  ~AsynchronousIO();
+
+  AsynchronousIO(const AsynchronousIO&) = delete;
+  void operator=(const AsynchronousIO&) = delete;
+
+  struct InternalsType;
+  InternalsType *Internals;
+};
+
+}
+
+#endif
@@ -1,10 +1,13 @@
 #include <algorithm>
+#include <iostream>
 #include <limits>
+#include <vector>
 
 #include <vtkCommunicator.h>
 #include <vtkMultiProcessController.h>
 
 #include "CDFReducer.h"
+#include "Error.h"
 
 // ----------------------------------------------------------------------------
 
@@ -35,7 +38,93 @@ struct Entry
 };
 
 // ----------------------------------------------------------------------------
+// Partially orders values such that the entries at the given positions hold
+// the value they would if values were sorted. Positions must be sorted,
+// unique, and relative to data.
 
+static void MultiSelect(double* data, double* first, double* last,
+                        const vtkIdType* pos, const vtkIdType* posEnd)
+{
+  if (pos == posEnd || first >= last)
+  {
+    return;
+  }
+
+  const vtkIdType* mid = pos + (posEnd - pos) / 2;
+  double* nth = data + *mid;
+  std::nth_element(first, nth, last);
+
+  MultiSelect(data, first, nth, pos, mid);
+  MultiSelect(data, nth + 1, last, mid + 1, posEnd);
+}
+
+// ----------------------------------------------------------------------------
+// A value and where it came from. Sample sort orders values by value, rank,
+// and position so that equal values are spread across the buckets rather
+// than all falling in one.
+
+struct SortKey
+{
+  double Value;
+  int Rank;
+  long long Index;
+
+  bool operator<(SortKey const& other) const
+  {
+    if (this->Value != other.Value)
+    {
+      return this->Value < other.Value;
+    }
+    if (this->Rank != other.Rank)
+    {
+      return this->Rank < other.Rank;
+    }
+    return this->Index < other.Index;
+  }
+};
+
+// ----------------------------------------------------------------------------
+// All-to-all exchange with 64 bit counts and offsets. Each pair of ranks
+// exchanges its values in messages of at most INT_MAX values.
+
+static int Alltoallv64(const double* sendValues, const std::vector<long long>& sendCounts,
+  const std::vector<long long>& sendOffsets, double* recvValues,
+  const std::vector<long long>& recvCounts, const std::vector<long long>& recvOffsets,
+  MPI_Comm comm)
+{
+  const long long maxCount = std::numeric_limits<int>::max();
+  const int tag = 3571;
+
+  int mpiSize = static_cast<int>(sendCounts.size());
+
+  std::vector<MPI_Request> requests;
+  for (int i = 0; i < mpiSize; i++)
+  {
+    for (long long j = 0; j < recvCounts[i]; j += maxCount)
+    {
+      MPI_Request request;
+      MPI_Irecv(recvValues + recvOffsets[i] + j,
+        static_cast<int>(std::min(maxCount, recvCounts[i] - j)), MPI_DOUBLE, i, tag,
+        comm, &request);
+      requests.push_back(request);
+    }
+  }
+
+  for (int i = 0; i < mpiSize; i++)
+  {
+    for (long long j = 0; j < sendCounts[i]; j += maxCount)
+    {
+      MPI_Request request;
+      MPI_Isend(const_cast<double*>(sendValues + sendOffsets[i] + j),
+        static_cast<int>(std::min(maxCount, sendCounts[i] - j)), MPI_DOUBLE, i, tag,
+        comm, &request);
+      requests.push_back(request);
+    }
+  }
+
+  return MPI_Waitall(static_cast<int>(requests.size()), requests.data(),
+    MPI_STATUSES_IGNORE);
+}
 
 // ----------------------------------------------------------------------------
 
@@ -208,3 +297,207 @@ double* CDFReducer::Compute(double* localSortedValues,
 
   return this->ReducedCDF;
 }
+
+// ----------------------------------------------------------------------------
+
+double* CDFReducer::ComputeSampleSort(MPI_Comm comm,
+                                      double* localValues,
+                                      vtkIdType localArraySize,
+                                      vtkIdType outputCDFSize)
+{
+  int mpiRank = 0;
+  int mpiSize = 1;
+  MPI_Comm_rank(comm, &mpiRank);
+  MPI_Comm_size(comm, &mpiSize);
+
+  if (outputCDFSize < 2)
+  {
+    SENSEI_ERROR("At least 2 quantiles are required, " << outputCDFSize
+      << " were requested")
+    return nullptr;
+  }
+
+  if (this->ReducedCDF == nullptr || this->ReducedCDFSize != outputCDFSize)
+  {
+    delete[] this->ReducedCDF;
+    this->ReducedCDF = new double[outputCDFSize];
+  }
+  this->ReducedCDFSize = outputCDFSize;
+
+  // Share basic information (min, max, counts). min is negated so that a
+  // single reduction finds both.
+  long long localCount = localArraySize;
+  long long totalCount = 0;
+  MPI_Allreduce(&localCount, &totalCount, 1, MPI_LONG_LONG, MPI_SUM, comm);
+  this->TotalCount = totalCount;
+
+  double localRange[2] = { -std::numeric_limits<double>::max(),
+                           -std::numeric_limits<double>::max() };
+  for (vtkIdType i = 0; i < localArraySize; i++)
+  {
+    localRange[0] = std::max(localRange[0], -localValues[i]);
+    localRange[1] = std::max(localRange[1], localValues[i]);
+  }
+  double globalRange[2];
+  MPI_Allreduce(localRange, globalRange, 2, MPI_DOUBLE, MPI_MAX, comm);
+
+  if (totalCount == 0)
+  {
+    std::fill(this->ReducedCDF, this->ReducedCDF + outputCDFSize, 0.0);
+    return this->ReducedCDF;
+  }
+
+  // Regular sampling, mpiSize - 1 samples per rank. The first entry holds
+  // the number of samples that are valid as ranks may have fewer values than
+  // that.
+  std::vector<vtkIdType> positions;
+  for (int i = 1; i < mpiSize; i++)
+  {
+    if (localArraySize > 0)
+    {
+      positions.push_back(i * localArraySize / mpiSize);
+    }
+  }
+  positions.erase(std::unique(positions.begin(), positions.end()), positions.end());
+
+  MultiSelect(localValues, localValues, localValues + localArraySize,
+    positions.data(), positions.data() + positions.size());
+
+  // Each sample is keyed by its value, rank, and position in the local
+  // values, see SortKey. The first entry holds the number of samples that
+  // are valid.
+  std::vector<double> localSamples(mpiSize, 0.0);
+  std::vector<long long> localSampleIds(mpiSize, 0);
+  localSamples[0] = static_cast<double>(positions.size());
+  for (size_t i = 0; i < positions.size(); i++)
+  {
+    localSamples[i + 1] = localValues[positions[i]];
+    localSampleIds[i + 1] = positions[i];
+  }
+
+  std::vector<double> allSamples(mpiSize * mpiSize);
+  MPI_Allgather(localSamples.data(), mpiSize, MPI_DOUBLE,
+    allSamples.data(), mpiSize, MPI_DOUBLE, comm);
+
+  std::vector<long long> allSampleIds(mpiSize * mpiSize);
+  MPI_Allgather(localSampleIds.data(), mpiSize, MPI_LONG_LONG,
+    allSampleIds.data(), mpiSize, MPI_LONG_LONG, comm);
+
+  std::vector<SortKey> samples;
+  for (int i = 0; i < mpiSize; i++)
+  {
+    double* rankSamples = allSamples.data() + i * mpiSize;
+    long long* rankSampleIds = allSampleIds.data() + i * mpiSize;
+    int nSamples = static_cast<int>(rankSamples[0]);
+    for (int j = 1; j <= nSamples; j++)
+    {
+      samples.push_back({ rankSamples[j], i, rankSampleIds[j] });
+    }
+  }
+  std::sort(samples.begin(), samples.end());
+
+  // Select splitters, bucket i holds values whose keys k are such that
+  // splitter[i-1] <= k < splitter[i]. Equal values are split between
+  // buckets by rank and position, a field with few distinct values is
+  // spread over the ranks.
+  SortKey last = { std::numeric_limits<double>::infinity(),
+    std::numeric_limits<int>::max(), std::numeric_limits<long long>::max() };
+  std::vector<SortKey> splitters(mpiSize - 1, last);
+  size_t nSamples = samples.size();
+  for (int i = 1; i < mpiSize && nSamples; i++)
+  {
+    splitters[i - 1] = samples[i * nSamples / mpiSize];
+  }
+
+  // Bucket the local values
+  std::vector<int> bucket(localArraySize);
+  std::vector<long long> sendCounts(mpiSize, 0);
+  for (vtkIdType i = 0; i < localArraySize; i++)
+  {
+    SortKey key = { localValues[i], mpiRank, static_cast<long long>(i) };
+    bucket[i] = static_cast<int>(
+      std::upper_bound(splitters.begin(), splitters.end(), key) - splitters.begin());
+    sendCounts[bucket[i]]++;
+  }
+
+  std::vector<long long> sendOffsets(mpiSize, 0);
+  for (int i = 1; i < mpiSize; i++)
+  {
+    sendOffsets[i] = sendOffsets[i - 1] + sendCounts[i - 1];
+  }
+
+  std::vector<double> sendValues(localArraySize);
+  std::vector<long long> insertAt(sendOffsets);
+  for (vtkIdType i = 0; i < localArraySize; i++)
+  {
+    sendValues[insertAt[bucket[i]]++] = localValues[i];
+  }
+
+  // Redistribute, after which the values on rank i are less than or equal
+  // to those on rank i + 1
+  std::vector<long long> recvCounts(mpiSize, 0);
+  MPI_Alltoall(sendCounts.data(), 1, MPI_LONG_LONG, recvCounts.data(), 1, MPI_LONG_LONG,
+    comm);
+
+  std::vector<long long> recvOffsets(mpiSize, 0);
+  for (int i = 1; i < mpiSize; i++)
+  {
+    recvOffsets[i] = recvOffsets[i - 1] + recvCounts[i - 1];
+  }
+
+  long long bucketSize = recvOffsets[mpiSize - 1] + recvCounts[mpiSize - 1];
+  std::vector<double> bucketValues(bucketSize);
+
+  if (Alltoallv64(sendValues.data(), sendCounts, sendOffsets, bucketValues.data(),
+        recvCounts, recvOffsets, comm) != MPI_SUCCESS)
+  {
+    SENSEI_ERROR("Failed to redistribute the values")
+    return nullptr;
+  }
+
+  sendValues.clear();
+  bucket.clear();
+
+  // Find the global index of the first value in our bucket
+  long long bucketStart = 0;
+  MPI_Exscan(&bucketSize, &bucketStart, 1, MPI_LONG_LONG, MPI_SUM, comm);
+  if (mpiRank == 0)
+  {
+    bucketStart = 0;
+  }
+
+  // Select the quantiles that fall in our bucket. Each is owned by exactly
+  // one rank, the others contribute zero to the sum.
+  vtkIdType splitSize = outputCDFSize - 1;
+  positions.clear();
+  std::vector<vtkIdType> owned;
+  for (vtkIdType i = 1; i < splitSize; i++)
+  {
+    long long target = i * totalCount / splitSize;
+    if (target >= bucketStart && target < bucketStart + bucketSize)
+    {
+      positions.push_back(target - bucketStart);
+      owned.push_back(i);
+    }
+  }
+
+  std::vector<vtkIdType> uniquePositions(positions);
+  uniquePositions.erase(
+    std::unique(uniquePositions.begin(), uniquePositions.end()), uniquePositions.end());
+
+  MultiSelect(bucketValues.data(), bucketValues.data(), bucketValues.data() + bucketSize,
+    uniquePositions.data(), uniquePositions.data() + uniquePositions.size());
+
+  std::vector<double> localCDF(outputCDFSize, 0.0);
+  for (size_t i = 0; i < owned.size(); i++)
+  {
+    localCDF[owned[i]] = bucketValues[positions[i]];
+  }
+
+  MPI_Allreduce(localCDF.data(), this->ReducedCDF, outputCDFSize, MPI_DOUBLE, MPI_SUM, comm);
+
+  this->ReducedCDF[0] = -globalRange[0];
+  this->ReducedCDF[outputCDFSize - 1] = globalRange[1];
+
+  return this->ReducedCDF;
+}
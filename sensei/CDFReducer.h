@@ -21,6 +21,8 @@
 #ifndef CDFReducer_h
 #define CDFReducer_h
 
+#include <mpi.h>
+
 class vtkMultiProcessController;
 
 struct StepHandler
@@ -140,6 +142,15 @@ public:
   ~CDFReducer();
 
   double* Compute(double* localSortedValues, vtkIdType localArraySize, vtkIdType outputCDFSize);
+
+  // Computes the exact CDF with a parallel sample sort. The local values need
+  // not be sorted and are reordered in place. Regular samples of the local
+  // values select splitters, a single all-to-all exchange redistributes the
+  // values into globally ordered buckets, and each rank selects the quantiles
+  // that fall in its bucket. The number of communication rounds is fixed and
+  // does not depend on the number of quantiles. Returns nullptr on error.
+  double* ComputeSampleSort(MPI_Comm comm, double* localValues,
+    vtkIdType localArraySize, vtkIdType outputCDFSize);
   vtkIdType GetBufferSize() { return this->CDFSize; };
   void SetBufferSize(vtkIdType exchangeCDFSize) { this->CDFSize = exchangeCDFSize; };
   vtkIdType GetTotalCount() { return this->TotalCount; };
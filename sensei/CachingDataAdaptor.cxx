@@ -0,0 +1,595 @@
+#include "CachingDataAdaptor.h"
+#include "DataRequirements.h"
+#include "MeshMetadata.h"
+#include "Profiler.h"
+#include "VTKUtils.h"
+#include "Error.h"
+
+#include <vtkCompositeDataIterator.h>
+#include <vtkCompositeDataSet.h>
+#include <vtkDataObject.h>
+#include <vtkDataSet.h>
+#include <vtkDataSetAttributes.h>
+#include <vtkFieldData.h>
+#include <vtkAbstractArray.h>
+#include <vtkObjectFactory.h>
+#include <vtkSmartPointer.h>
+
+#include <map>
+#include <set>
+#include <string>
+#include <utility>
+
+using vtkDataObjectPtr = vtkSmartPointer<vtkDataObject>;
+
+namespace sensei
+{
+
+// returns a key identifying the set of optional metadata requested
+static
+long long flagsKey(const MeshMetadataFlags &flags)
+{
+  return (flags.BlockDecompSet() ? 0x1 : 0) |
+    (flags.BlockSizeSet() ? 0x2 : 0) | (flags.BlockExtentsSet() ? 0x4 : 0) |
+    (flags.BlockBoundsSet() ? 0x8 : 0) | (flags.BlockArrayRangeSet() ? 0x10 : 0);
+}
+
+// returns the name VTK uses for ghost arrays
+static
+const char *getGhostArrayName()
+{
+#if VTK_MAJOR_VERSION == 6 && VTK_MINOR_VERSION == 1
+    return "vtkGhostType";
+#else
+    return vtkDataSetAttributes::GhostArrayName();
+#endif
+}
+
+// applies the function to the leaves of the cached mesh and one handed out
+// by GetMesh. callers may have wrapped a dataset in a multiblock, see
+// DataAdaptor::GetMesh, in that case the dataset is paired with the
+// multiblock's leaves.
+static
+int applyShared(vtkDataObject *cached, vtkDataObject *mesh,
+  VTKUtils::BinaryDatasetFunction &func)
+{
+  vtkDataSet *ds = dynamic_cast<vtkDataSet*>(cached);
+  if (ds && dynamic_cast<vtkCompositeDataSet*>(mesh))
+    {
+    VTKUtils::DatasetFunction pairWithLeaf = [&](vtkDataSet *dsOut) -> int
+      {
+      return func(ds, dsOut);
+      };
+    return VTKUtils::Apply(mesh, pairWithLeaf) < 0 ? -1 : 0;
+    }
+
+  return VTKUtils::Apply(cached, mesh, func);
+}
+
+// passes the named array from the cached mesh to one handed out by GetMesh
+static
+int passArray(vtkDataObject *cached, vtkDataObject *mesh,
+  int association, const std::string &arrayName)
+{
+  VTKUtils::BinaryDatasetFunction func =
+    [&](vtkDataSet *ds, vtkDataSet *dsOut) -> int
+    {
+    if (!dsOut)
+      return 0;
+
+    vtkFieldData *dsa = VTKUtils::GetAttributes(ds, association);
+    vtkFieldData *dsaOut = VTKUtils::GetAttributes(dsOut, association);
+
+    // the simulation need not provide the array on every block
+    vtkAbstractArray *aa = dsa ? dsa->GetAbstractArray(arrayName.c_str()) : nullptr;
+    if (aa && dsaOut)
+      dsaOut->AddArray(aa);
+
+    return 0;
+    };
+
+  return applyShared(cached, mesh, func);
+}
+
+// passes all point, cell, and field data arrays from one mesh to another
+static
+int passArrays(vtkDataObject *cached, vtkDataObject *mesh)
+{
+  VTKUtils::BinaryDatasetFunction func =
+    [&](vtkDataSet *ds, vtkDataSet *dsOut) -> int
+    {
+    if (!dsOut)
+      return 0;
+
+    int assocs[] = {vtkDataObject::POINT, vtkDataObject::CELL,
+      vtkDataObject::FIELD};
+
+    for (int i = 0; i < 3; ++i)
+      {
+      vtkFieldData *dsa = VTKUtils::GetAttributes(ds, assocs[i]);
+      vtkFieldData *dsaOut = VTKUtils::GetAttributes(dsOut, assocs[i]);
+
+      int nArrays = dsa->GetNumberOfArrays();
+      for (int j = 0; j < nArrays; ++j)
+        dsaOut->AddArray(dsa->GetAbstractArray(j));
+      }
+
+    return 0;
+    };
+
+  return applyShared(cached, mesh, func);
+}
+
+// create a new data object with the structure of the cached one. the
+// structure of the leaves is copied, sharing the geometry and topology of
+// the cached mesh when it was fetched with them, so that the object does
+// not depend on the order in which the consumers asked for the mesh.
+static
+vtkDataObject *newMesh(vtkDataObject *cached)
+{
+  if (vtkCompositeDataSet *cd = dynamic_cast<vtkCompositeDataSet*>(cached))
+    {
+    vtkCompositeDataSet *cdo = cd->NewInstance();
+    cdo->CopyStructure(cd);
+
+    vtkCompositeDataIterator *cdit = cd->NewIterator();
+    while (!cdit->IsDoneWithTraversal())
+      {
+      vtkDataObject *dobj = cd->GetDataSet(cdit);
+      vtkDataObject *dobjo = dobj->NewInstance();
+      if (vtkDataSet *ds = dynamic_cast<vtkDataSet*>(dobj))
+        static_cast<vtkDataSet*>(dobjo)->CopyStructure(ds);
+      cdo->SetDataSet(cdit, dobjo);
+      dobjo->Delete();
+
+      cdit->GoToNextItem();
+      }
+
+    cdit->Delete();
+
+    return cdo;
+    }
+
+  vtkDataSet *ds = static_cast<vtkDataSet*>(cached);
+  vtkDataSet *dso = ds->NewInstance();
+  dso->CopyStructure(ds);
+
+  return dso;
+}
+
+struct CachingDataAdaptor::InternalsType
+{
+  InternalsType() : Adaptor(nullptr), NumMeshes(0), HaveNumMeshes(false),
+    ShareData(0), ReleaseRequested(false) {}
+
+  // a mesh fetched from the simulation and the arrays
+  // that have been added to it
+  struct MeshCacheType
+  {
+    MeshCacheType() : StructureOnly(true),
+      GhostCells(false), GhostNodes(false) {}
+
+    vtkDataObjectPtr Mesh;
+    bool StructureOnly;
+    bool GhostCells;
+    bool GhostNodes;
+    std::set<std::pair<int, std::string>> Arrays;
+  };
+
+  // get the mesh from the cache, fetching it from the
+  // simulation if it's not present or doesn't have
+  // the requested geometry. returns 1 if the mesh
+  // can't be shared.
+  int GetMesh(const std::string &meshName, bool structureOnly,
+    MeshCacheType *&mc);
+
+  // add the array to the cached mesh, fetching it from
+  // the simulation if it's not already present
+  int AddArray(MeshCacheType &mc, const std::string &meshName,
+    int association, const std::string &arrayName);
+
+  // metadata is cached per mesh id and set of flags
+  using MetadataKeyType = std::pair<unsigned int, long long>;
+  using MetadataMapType = std::map<MetadataKeyType, MeshMetadataPtr>;
+
+  using MeshMapType = std::map<std::string, MeshCacheType>;
+
+  DataAdaptor *Adaptor;
+  unsigned int NumMeshes;
+  bool HaveNumMeshes;
+  MetadataMapType Metadata;
+  int ShareData;
+  bool ReleaseRequested;
+  MeshMapType Meshes;
+};
+
+//----------------------------------------------------------------------------
+int CachingDataAdaptor::InternalsType::GetMesh(const std::string &meshName,
+  bool structureOnly, MeshCacheType *&mc)
+{
+  mc = nullptr;
+
+  MeshMapType::iterator it = this->Meshes.find(meshName);
+  if ((it != this->Meshes.end()) &&
+    (structureOnly || !it->second.StructureOnly))
+    {
+    mc = &it->second;
+    return 0;
+    }
+
+  vtkDataObject *dobj = nullptr;
+  if (this->Adaptor->GetMesh(meshName, structureOnly, dobj))
+    return -1;
+
+  vtkDataObjectPtr mesh;
+  mesh.TakeReference(dobj);
+
+  // only datasets and composite datasets are shared, the caller
+  // should forward requests for other types of data
+  if (dobj && !dynamic_cast<vtkCompositeDataSet*>(dobj) &&
+    !dynamic_cast<vtkDataSet*>(dobj))
+    return 1;
+
+  MeshCacheType &entry = this->Meshes[meshName];
+
+  // replacing a mesh that was fetched structure only. keep the
+  // arrays that were already fetched
+  if (entry.Mesh && mesh && passArrays(entry.Mesh, mesh))
+    {
+    SENSEI_ERROR("Failed to move arrays to the new mesh \""
+      << meshName << "\"")
+    return -1;
+    }
+
+  entry.Mesh = mesh;
+  entry.StructureOnly = structureOnly;
+
+  mc = &entry;
+
+  return 0;
+}
+
+//----------------------------------------------------------------------------
+int CachingDataAdaptor::InternalsType::AddArray(MeshCacheType &mc,
+  const std::string &meshName, int association, const std::string &arrayName)
+{
+  std::pair<int, std::string> key(association, arrayName);
+
+  // this rank has no data
+  if (!mc.Mesh || mc.Arrays.count(key))
+    return 0;
+
+  if (this->Adaptor->AddArray(mc.Mesh, meshName, association, arrayName))
+    return -1;
+
+  mc.Arrays.insert(key);
+
+  return 0;
+}
+
+//----------------------------------------------------------------------------
+senseiNewMacro(CachingDataAdaptor);
+
+//----------------------------------------------------------------------------
+CachingDataAdaptor::CachingDataAdaptor()
+{
+  this->Internals = new InternalsType;
+}
+
+//----------------------------------------------------------------------------
+CachingDataAdaptor::~CachingDataAdaptor()
+{
+  delete this->Internals;
+}
+
+//----------------------------------------------------------------------------
+void CachingDataAdaptor::SetDataAdaptor(DataAdaptor *da)
+{
+  this->ClearCache();
+  this->Internals->Adaptor = da;
+}
+
+//----------------------------------------------------------------------------
+DataAdaptor *CachingDataAdaptor::GetDataAdaptor()
+{
+  return this->Internals->Adaptor;
+}
+
+//----------------------------------------------------------------------------
+void CachingDataAdaptor::SetShareData(int val)
+{
+  this->Internals->ShareData = val;
+}
+
+//----------------------------------------------------------------------------
+int CachingDataAdaptor::GetShareData()
+{
+  return this->Internals->ShareData;
+}
+
+//----------------------------------------------------------------------------
+bool CachingDataAdaptor::GetReleaseRequested()
+{
+  return this->Internals->ReleaseRequested;
+}
+
+//----------------------------------------------------------------------------
+void CachingDataAdaptor::ClearCache()
+{
+  this->Internals->NumMeshes = 0;
+  this->Internals->HaveNumMeshes = false;
+  this->Internals->Metadata.clear();
+  this->Internals->Meshes.clear();
+  this->Internals->ReleaseRequested = false;
+}
+
+//----------------------------------------------------------------------------
+int CachingDataAdaptor::Prefetch(const DataRequirements &reqs)
+{
+  TimeEvent<128> mark("CachingDataAdaptor::Prefetch");
+
+  if (!this->Internals->Adaptor)
+    {
+    SENSEI_ERROR("No data adaptor has been set")
+    return -1;
+    }
+
+  if (!this->Internals->ShareData)
+    return 0;
+
+  MeshRequirementsIterator mit = reqs.GetMeshRequirementsIterator();
+  for (; mit; ++mit)
+    {
+    // geometry is fetched when any of the consumers reads it
+    const std::string &meshName = mit.MeshName();
+
+    InternalsType::MeshCacheType *mc = nullptr;
+    int ierr = this->Internals->GetMesh(meshName, mit.StructureOnly(), mc);
+    if (ierr < 0)
+      {
+      SENSEI_ERROR("Failed to get mesh \"" << meshName << "\"")
+      return -1;
+      }
+
+    // this rank has no data or the mesh can't be shared
+    if ((ierr > 0) || !mc->Mesh)
+      continue;
+
+    ArrayRequirementsIterator ait = reqs.GetArrayRequirementsIterator(meshName);
+    for (; ait; ++ait)
+      {
+      if (this->Internals->AddArray(*mc, meshName,
+        ait.Association(), ait.Array()))
+        {
+        SENSEI_ERROR("Failed to add "
+          << VTKUtils::GetAttributesName(ait.Association())
+          << " data array \"" << ait.Array() << "\" to mesh \""
+          << meshName << "\"")
+        return -1;
+        }
+      }
+    }
+
+  return 0;
+}
+
+//----------------------------------------------------------------------------
+int CachingDataAdaptor::GetNumberOfMeshes(unsigned int &numMeshes)
+{
+  numMeshes = 0;
+
+  if (!this->Internals->Adaptor)
+    {
+    SENSEI_ERROR("No data adaptor has been set")
+    return -1;
+    }
+
+  if (!this->Internals->HaveNumMeshes)
+    {
+    if (this->Internals->Adaptor->GetNumberOfMeshes(this->Internals->NumMeshes))
+      return -1;
+
+    this->Internals->HaveNumMeshes = true;
+    }
+
+  numMeshes = this->Internals->NumMeshes;
+
+  return 0;
+}
+
+//----------------------------------------------------------------------------
+int CachingDataAdaptor::GetMeshMetadata(unsigned int id,
+  MeshMetadataPtr &metadata)
+{
+  if (!this->Internals->Adaptor)
+    {
+    SENSEI_ERROR("No data adaptor has been set")
+    return -1;
+    }
+
+  InternalsType::MetadataKeyType key(id, flagsKey(metadata->Flags));
+
+  InternalsType::MetadataMapType::iterator it =
+    this->Internals->Metadata.find(key);
+
+  if (it == this->Internals->Metadata.end())
+    {
+    if (this->Internals->Adaptor->GetMeshMetadata(id, metadata))
+      return -1;
+
+    // cache a copy, the caller owns what it was given
+    this->Internals->Metadata[key] = metadata->NewCopy();
+    return 0;
+    }
+
+  metadata = it->second->NewCopy();
+
+  return 0;
+}
+
+//----------------------------------------------------------------------------
+int CachingDataAdaptor::GetMesh(const std::string &meshName,
+  bool structureOnly, vtkDataObject *&mesh)
+{
+  mesh = nullptr;
+
+  if (!this->Internals->Adaptor)
+    {
+    SENSEI_ERROR("No data adaptor has been set")
+    return -1;
+    }
+
+  if (!this->Internals->ShareData)
+    return this->Internals->Adaptor->GetMesh(meshName, structureOnly, mesh);
+
+  InternalsType::MeshCacheType *mc = nullptr;
+  int ierr = this->Internals->GetMesh(meshName, structureOnly, mc);
+  if (ierr < 0)
+    return -1;
+
+  if (ierr > 0)
+    return this->Internals->Adaptor->GetMesh(meshName, structureOnly, mesh);
+
+  // it is not an error for a rank to have no data
+  if (mc->Mesh)
+    mesh = newMesh(mc->Mesh);
+
+  return 0;
+}
+
+//----------------------------------------------------------------------------
+int CachingDataAdaptor::AddGhostNodesArray(vtkDataObject *mesh,
+  const std::string &meshName)
+{
+  if (!this->Internals->Adaptor)
+    {
+    SENSEI_ERROR("No data adaptor has been set")
+    return -1;
+    }
+
+  InternalsType::MeshMapType::iterator it;
+
+  if (!this->Internals->ShareData || !mesh ||
+    ((it = this->Internals->Meshes.find(meshName)) == this->Internals->Meshes.end()) ||
+    !it->second.Mesh)
+    return this->Internals->Adaptor->AddGhostNodesArray(mesh, meshName);
+
+  InternalsType::MeshCacheType &mc = it->second;
+
+  if (!mc.GhostNodes)
+    {
+    if (this->Internals->Adaptor->AddGhostNodesArray(mc.Mesh, meshName))
+      return -1;
+    mc.GhostNodes = true;
+    }
+
+  return passArray(mc.Mesh, mesh, vtkDataObject::POINT, getGhostArrayName());
+}
+
+//----------------------------------------------------------------------------
+int CachingDataAdaptor::AddGhostCellsArray(vtkDataObject *mesh,
+  const std::string &meshName)
+{
+  if (!this->Internals->Adaptor)
+    {
+    SENSEI_ERROR("No data adaptor has been set")
+    return -1;
+    }
+
+  InternalsType::MeshMapType::iterator it;
+
+  if (!this->Internals->ShareData || !mesh ||
+    ((it = this->Internals->Meshes.find(meshName)) == this->Internals->Meshes.end()) ||
+    !it->second.Mesh)
+    return this->Internals->Adaptor->AddGhostCellsArray(mesh, meshName);
+
+  InternalsType::MeshCacheType &mc = it->second;
+
+  if (!mc.GhostCells)
+    {
+    if (this->Internals->Adaptor->AddGhostCellsArray(mc.Mesh, meshName))
+      return -1;
+    mc.GhostCells = true;
+    }
+
+  return passArray(mc.Mesh, mesh, vtkDataObject::CELL, getGhostArrayName());
+}
+
+//----------------------------------------------------------------------------
+int CachingDataAdaptor::AddArray(vtkDataObject *mesh,
+  const std::string &meshName, int association, const std::string &arrayName)
+{
+  if (!this->Internals->Adaptor)
+    {
+    SENSEI_ERROR("No data adaptor has been set")
+    return -1;
+    }
+
+  // meshes that didn't come from the cache are passed through
+  InternalsType::MeshMapType::iterator it;
+
+  if (!this->Internals->ShareData || !mesh ||
+    ((it = this->Internals->Meshes.find(meshName)) == this->Internals->Meshes.end()) ||
+    !it->second.Mesh)
+    return this->Internals->Adaptor->AddArray(mesh, meshName,
+      association, arrayName);
+
+  InternalsType::MeshCacheType &mc = it->second;
+
+  if (this->Internals->AddArray(mc, meshName, association, arrayName))
+    return -1;
+
+  return passArray(mc.Mesh, mesh, association, arrayName);
+}
+
+//----------------------------------------------------------------------------
+int CachingDataAdaptor::ReleaseData()
+{
+  if (!this->Internals->Adaptor)
+    return 0;
+
+  // other consumers may still need the data
+  if (this->Internals->ShareData)
+    {
+    this->Internals->ReleaseRequested = true;
+    return 0;
+    }
+
+  // the metadata describes the current time step and remains valid
+  return this->Internals->Adaptor->ReleaseData();
+}
+
+//----------------------------------------------------------------------------
+double CachingDataAdaptor::GetDataTime()
+{
+  return this->Internals->Adaptor ?
+    this->Internals->Adaptor->GetDataTime() : this->DataAdaptor::GetDataTime();
+}
+
+//----------------------------------------------------------------------------
+void CachingDataAdaptor::SetDataTime(double time)
+{
+  if (this->Internals->Adaptor)
+    this->Internals->Adaptor->SetDataTime(time);
+  else
+    this->DataAdaptor::SetDataTime(time);
+}
+
+//----------------------------------------------------------------------------
+long CachingDataAdaptor::GetDataTimeStep()
+{
+  return this->Internals->Adaptor ?
+    this->Internals->Adaptor->GetDataTimeStep() :
+    this->DataAdaptor::GetDataTimeStep();
+}
+
+//----------------------------------------------------------------------------
+void CachingDataAdaptor::SetDataTimeStep(long index)
+{
+  if (this->Internals->Adaptor)
+    this->Internals->Adaptor->SetDataTimeStep(index);
+  else
+    this->DataAdaptor::SetDataTimeStep(index);
+}
+
+}
@@ -0,0 +1,109 @@
+#ifndef sensei_CachingDataAdaptor_h
+#define sensei_CachingDataAdaptor_h
+
+#include "DataAdaptor.h"
+
+namespace sensei
+{
+
+class DataRequirements;
+
+/// @class CachingDataAdaptor
+/// @brief A DataAdaptor that forwards to another adaptor and caches metadata
+///
+/// CachingDataAdaptor is used by ConfigurableAnalysis to share the results of
+/// metadata queries between the analyses it runs. The number of meshes and
+/// each mesh's metadata are fetched from the wrapped adaptor at most once per
+/// combination of mesh id and MeshMetadataFlags. Later queries are served from
+/// the cache and receive a copy of the cached metadata so that analyses are
+/// free to modify what they are given. This avoids the collective
+/// communication that generating a global view of the metadata entails from
+/// being repeated by every analysis.
+///
+/// When data sharing is enabled meshes and arrays are also fetched from the
+/// wrapped adaptor at most once. GetMesh returns a new data object with the
+/// structure of the cached mesh, and AddArray, AddGhostCellsArray, and
+/// AddGhostNodesArray pass the cached arrays to it. No data is copied, the
+/// geometry and arrays are reference counted and shared by all of the objects
+/// handed out. Geometry is fetched the first time it is requested, meshes
+/// fetched structure only are replaced, keeping the arrays already fetched.
+/// Structure only requests are given the structure of the cached mesh too,
+/// including its geometry when another consumer asked for it, so that what a
+/// consumer is given does not depend on the order of the requests when the
+/// meshes are prefetched.
+/// Calls to ReleaseData are recorded rather than forwarded so that the data
+/// stays valid for every analysis, see GetReleaseRequested.
+///
+/// The cache is only valid for a single time step, ClearCache must be called
+/// or a new adaptor set before the simulation's data changes.
+class CachingDataAdaptor : public DataAdaptor
+{
+public:
+  static CachingDataAdaptor *New();
+  senseiTypeMacro(CachingDataAdaptor, DataAdaptor);
+
+  /// @brief Set the adaptor to forward to. This clears the cache.
+  void SetDataAdaptor(DataAdaptor *da);
+  DataAdaptor *GetDataAdaptor();
+
+  /// @brief Enable/disable caching of meshes and arrays.
+  /// The default is 0, only metadata is cached.
+  void SetShareData(int val);
+  int GetShareData();
+
+  /// @brief Fetch the meshes and arrays named by the requirements.
+  /// Meshes are fetched with their geometry unless the requirements say
+  /// structure only. This is used to fetch the union of a number of
+  /// consumers' requirements up front.
+  int Prefetch(const DataRequirements &reqs);
+
+  /// @brief Returns true if ReleaseData was called while data sharing was
+  /// enabled. The request should be forwarded to the wrapped adaptor once the
+  /// data is no longer needed.
+  bool GetReleaseRequested();
+
+  /// @brief Discard all cached data.
+  void ClearCache();
+
+  // SENSEI DataAdaptor API, forwarded to the wrapped adaptor
+  int GetNumberOfMeshes(unsigned int &numMeshes) override;
+
+  int GetMeshMetadata(unsigned int id, MeshMetadataPtr &metadata) override;
+
+  int GetMesh(const std::string &meshName, bool structureOnly,
+    vtkDataObject *&mesh) override;
+
+  using sensei::DataAdaptor::GetMesh;
+
+  int AddGhostNodesArray(vtkDataObject* mesh,
+    const std::string &meshName) override;
+
+  int AddGhostCellsArray(vtkDataObject* mesh,
+    const std::string &meshName) override;
+
+  int AddArray(vtkDataObject* mesh, const std::string &meshName,
+    int association, const std::string &arrayName) override;
+
+  int ReleaseData() override;
+
+  double GetDataTime() override;
+  void SetDataTime(double time) override;
+
+  long GetDataTimeStep() override;
+  void SetDataTimeStep(long index) override;
+
+protected:
+  CachingDataAdaptor();
+  ~CachingDataAdaptor();
+
+  CachingDataAdaptor(const CachingDataAdaptor&) = delete;
+  void operator=(const CachingDataAdaptor&) = delete;
+
+private:
+  struct InternalsType;
+  InternalsType *Internals;
+};
+
+}
+
+#endif
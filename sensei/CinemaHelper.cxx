@@ -9,6 +9,7 @@
 
 #include <vtksys/SystemTools.hxx>
 
+#include <vtkDataArray.h>
 #include <vtkFloatArray.h>
 #include <vtkImageData.h>
 #include <vtkPointData.h>
@@ -1367,18 +1368,54 @@ void CinemaHelper::CaptureImage(vtkSMViewProxy* view, const std::string fileName
 // --------------------------------------------------------------------------
 void CinemaHelper::WriteVolume(vtkImageData* image)
 {
-  std::string jsonName = "volume.json";
-  std::string dataName = "volume.data";
+  this->WriteVolume(image, "volume");
+}
 
-  if (!this->Data->IsRoot)
+// --------------------------------------------------------------------------
+// get the name of the javascript typed array matching a VTK type
+static const char* getTypedArrayName(int vtkType)
+{
+  switch (vtkType)
     {
-      std::ostringstream json;
-      json << "volume_" << this->Data->PID << ".json";
-      jsonName = json.str();
+    case VTK_CHAR:
+    case VTK_SIGNED_CHAR:
+      return "Int8Array";
+    case VTK_UNSIGNED_CHAR:
+      return "Uint8Array";
+    case VTK_SHORT:
+      return "Int16Array";
+    case VTK_UNSIGNED_SHORT:
+      return "Uint16Array";
+    case VTK_INT:
+      return "Int32Array";
+    case VTK_UNSIGNED_INT:
+      return "Uint32Array";
+    case VTK_DOUBLE:
+      return "Float64Array";
+    case VTK_FLOAT:
+      return "Float32Array";
+    }
+  return nullptr;
+}
+
+// --------------------------------------------------------------------------
+void CinemaHelper::WriteVolume(vtkImageData* image,
+  const std::string& baseName, int block, double scale)
+{
+  std::string jsonName = baseName + ".json";
+  std::string dataName = baseName + ".data";
+
+  if (!this->Data->IsRoot || (block > 0))
+    {
+    std::ostringstream suffix;
+    suffix << "_" << this->Data->PID;
+    if (block > 0)
+      {
+      suffix << "_" << block;
+      }
 
-      std::ostringstream data;
-      data << "volume_" << this->Data->PID << ".data";
-      dataName = data.str();
+    jsonName = baseName + suffix.str() + ".json";
+    dataName = baseName + suffix.str() + ".data";
     }
 
   if (image == nullptr)
@@ -1386,7 +1423,14 @@ void CinemaHelper::WriteVolume(vtkImageData* image)
     return;
     }
 
-  vtkFloatArray* array = vtkFloatArray::SafeDownCast(image->GetPointData()->GetScalars());
+  vtkDataArray* array = image->GetPointData()->GetScalars();
+  const char* dataType = array ? getTypedArrayName(array->GetDataType()) : nullptr;
+  if (!dataType)
+    {
+    std::cout << "Unable to write volume " << baseName << ", the scalars are "
+      << (array ? array->GetClassName() : "missing") << std::endl;
+    return;
+    }
 
   // Write volume.json
   std::string metaFileName = this->Data->getDataAbsoluteFilePath(jsonName, true);
@@ -1399,9 +1443,15 @@ void CinemaHelper::WriteVolume(vtkImageData* image)
     {
     int extent[6];
     image->GetExtent(extent);
+    double origin[3];
+    image->GetOrigin(origin);
+    double spacing[3];
+    image->GetSpacing(spacing);
     jsonFilePointer << "{" << endl;
-    jsonFilePointer << "    \"origin\": [0, 0, 0]," << endl;
-    jsonFilePointer << "    \"spacing\": [1, 1, 1]," << endl;
+    jsonFilePointer << "    \"origin\": ["
+       << origin[0] << ", " << origin[1] << ", " << origin[2] << "]," << endl;
+    jsonFilePointer << "    \"spacing\": ["
+       << spacing[0] << ", " << spacing[1] << ", " << spacing[2] << "]," << endl;
     jsonFilePointer << "    \"extent\": ["
        << extent[0] << ", " << (extent[1]) << ", "
        << extent[2] << ", " << (extent[3]) << ", "
@@ -1414,12 +1464,16 @@ void CinemaHelper::WriteVolume(vtkImageData* image)
     jsonFilePointer << "                \"numberOfComponents\": 1," << endl;
     jsonFilePointer << "                \"name\": \"scalars\"," << endl;
     jsonFilePointer << "                \"vtkClass\": \"vtkDataArray\"," << endl;
-    jsonFilePointer << "                \"dataType\": \"Float32Array\"," << endl;
+    jsonFilePointer << "                \"dataType\": \"" << dataType << "\"," << endl;
+    if (scale != 1.0)
+      {
+      jsonFilePointer << "                \"scale\": " << scale << "," << endl;
+      }
     jsonFilePointer << "                \"ref\": {" << endl;
     jsonFilePointer << "                    \"registration\": \"setScalars\"," << endl;
     jsonFilePointer << "                    \"encode\": \"LittleEndian\"," << endl;
     jsonFilePointer << "                    \"basepath\": \"" << this->Data->NumberOfTimeSteps << "\"," << endl;
-    jsonFilePointer << "                    \"id\": \"volume.data\"" << endl;
+    jsonFilePointer << "                    \"id\": \"" << dataName << "\"" << endl;
     jsonFilePointer << "                }," << endl;
     jsonFilePointer << "                \"size\": "<< array->GetNumberOfValues() << endl;
     jsonFilePointer << "            }" << endl;
@@ -1441,13 +1495,31 @@ void CinemaHelper::WriteVolume(vtkImageData* image)
     }
   else
     {
-    int stackSize = array->GetNumberOfTuples() * 4;
+    std::streamsize stackSize = array->GetNumberOfValues() * array->GetDataTypeSize();
     filePointer.write((char*)array->GetVoidPointer(0), stackSize);
     filePointer.flush();
     filePointer.close();
     }
 }
 
+// --------------------------------------------------------------------------
+void CinemaHelper::SetVolumeLevels(int numberOfLevels, double errorBound)
+{
+  // the coarsest level is the scene, register a file per finer level
+  for (int l = numberOfLevels - 1; l > 0; --l)
+    {
+    std::ostringstream name;
+    name << "detail_" << l;
+    this->Data->JSONData[name.str()] = "{ \"pattern\": \"{time}/" + name.str()
+      + ".json\", \"name\": \"" + name.str() + "\", \"type\": \"json\" }";
+    }
+
+  std::ostringstream xmeta;
+  xmeta << "   ,\"levels\": " << numberOfLevels
+    << "\n   ,\"errorBound\": " << errorBound;
+  this->Data->JSONExtraMetadata = xmeta.str();
+}
+
 void CinemaHelper::WriteCDF(long long totalArraySize, const double* cdfValues)
 {
   if (!this->Data->IsRoot)
@@ -81,6 +81,19 @@ public:
     // Volume handling
     void WriteVolume(vtkImageData* image);
 
+    // Write the point scalars of the image to <baseName>.json/.data. Files
+    // written by other ranks, or for blocks other than the first, are
+    // suffixed with the rank and block ids. The data type of the scalars is
+    // preserved. When scale is not 1, it is recorded so that a reader can
+    // convert the stored values back to the original units.
+    void WriteVolume(vtkImageData* image, const std::string& baseName,
+      int block = 0, double scale = 1.0);
+
+    // Record the structure of a multi-resolution volume in the metadata.
+    // "volume" holds the coarsest level and "detail_<l>", l = numberOfLevels-1
+    // ... 1, the residuals that refine level l to level l-1.
+    void SetVolumeLevels(int numberOfLevels, double errorBound);
+
     // CDF handling
     void WriteCDF(long long totalArraySize, const double* cdfValues);
 
@@ -45,7 +45,7 @@ namespace sensei
 senseiNewMacro(ConduitDataAdaptor);
 
 //-----------------------------------------------------------------------------
-ConduitDataAdaptor::ConduitDataAdaptor()
+ConduitDataAdaptor::ConduitDataAdaptor() : ZeroCopy(0)
 {
 }
 
@@ -82,8 +82,17 @@ static inline int VTKCellTypeSize( int cell_type )
 }
 
 //-----------------------------------------------------------------------------
-template<typename T> void Blueprint_MultiCompArray_To_VTKDataArray( const conduit::Node &n, int ncomps, int ntuples, vtkDataArray *darray )
+template<typename T> void Blueprint_MultiCompArray_To_VTKDataArray( const conduit::Node &n, int ncomps, int ntuples, vtkDataArray *darray, bool zeroCopy )
 {
+  // when enabled, a single contiguous array is used in place, the node must
+  // outlive the VTK array. strided and multi-component arrays are copied.
+  if( zeroCopy && (n.number_of_children() == 0) && n.dtype().is_compact() )
+  {
+    darray->SetNumberOfComponents( 1 );
+    darray->SetVoidArray( const_cast<void*>(n.element_ptr(0)), ntuples, 1 );
+    return;
+  }
+
   // vtk reqs us to set number of comps before number of tuples
   if( ncomps == 2 ) // we need 3 comps for vectors
     darray->SetNumberOfComponents( 3 );
@@ -124,7 +133,7 @@ template<typename T> void Blueprint_MultiCompArray_To_VTKDataArray( const condui
 }
 
 //-----------------------------------------------------------------------------
-vtkDataArray * ConduitArrayToVTKDataArray( const conduit::Node &n )
+vtkDataArray * ConduitArrayToVTKDataArray( const conduit::Node &n, bool zeroCopy )
 {
   vtkDataArray *retval = NULL;
   
@@ -159,47 +168,47 @@ vtkDataArray * ConduitArrayToVTKDataArray( const conduit::Node &n )
   if( vals_dtype.is_unsigned_char() )
   {
     retval = vtkUnsignedCharArray::New();
-    Blueprint_MultiCompArray_To_VTKDataArray<CONDUIT_NATIVE_UNSIGNED_CHAR>( n, ncomps, ntuples, retval );
+    Blueprint_MultiCompArray_To_VTKDataArray<CONDUIT_NATIVE_UNSIGNED_CHAR>( n, ncomps, ntuples, retval, zeroCopy );
   }
   else if( vals_dtype.is_unsigned_short() )
   {
     retval = vtkUnsignedShortArray::New();
-    Blueprint_MultiCompArray_To_VTKDataArray<CONDUIT_NATIVE_UNSIGNED_SHORT>( n, ncomps, ntuples, retval );
+    Blueprint_MultiCompArray_To_VTKDataArray<CONDUIT_NATIVE_UNSIGNED_SHORT>( n, ncomps, ntuples, retval, zeroCopy );
   }
   else if( vals_dtype.is_unsigned_int() )
   {
     retval = vtkUnsignedIntArray::New();
-    Blueprint_MultiCompArray_To_VTKDataArray<CONDUIT_NATIVE_UNSIGNED_INT>( n, ncomps, ntuples, retval );
+    Blueprint_MultiCompArray_To_VTKDataArray<CONDUIT_NATIVE_UNSIGNED_INT>( n, ncomps, ntuples, retval, zeroCopy );
   }
   else if( vals_dtype.is_char() )
   {
     retval = vtkCharArray::New();
-    Blueprint_MultiCompArray_To_VTKDataArray<CONDUIT_NATIVE_CHAR>( n, ncomps, ntuples, retval );
+    Blueprint_MultiCompArray_To_VTKDataArray<CONDUIT_NATIVE_CHAR>( n, ncomps, ntuples, retval, zeroCopy );
   }
   else if( vals_dtype.is_short() )
   {
     retval = vtkShortArray::New();
-    Blueprint_MultiCompArray_To_VTKDataArray<CONDUIT_NATIVE_SHORT>( n, ncomps, ntuples, retval );
+    Blueprint_MultiCompArray_To_VTKDataArray<CONDUIT_NATIVE_SHORT>( n, ncomps, ntuples, retval, zeroCopy );
   }
   else if( vals_dtype.is_int() )
   {
     retval = vtkIntArray::New();
-    Blueprint_MultiCompArray_To_VTKDataArray<CONDUIT_NATIVE_INT>( n, ncomps, ntuples, retval );
+    Blueprint_MultiCompArray_To_VTKDataArray<CONDUIT_NATIVE_INT>( n, ncomps, ntuples, retval, zeroCopy );
   }
   else if( vals_dtype.is_long() )
   {
     retval = vtkLongArray::New();
-    Blueprint_MultiCompArray_To_VTKDataArray<CONDUIT_NATIVE_LONG>( n, ncomps, ntuples, retval );
+    Blueprint_MultiCompArray_To_VTKDataArray<CONDUIT_NATIVE_LONG>( n, ncomps, ntuples, retval, zeroCopy );
   }
   else if( vals_dtype.is_float() )
   {
     retval = vtkFloatArray::New();
-    Blueprint_MultiCompArray_To_VTKDataArray<CONDUIT_NATIVE_FLOAT>( n, ncomps, ntuples, retval );
+    Blueprint_MultiCompArray_To_VTKDataArray<CONDUIT_NATIVE_FLOAT>( n, ncomps, ntuples, retval, zeroCopy );
   }
   else if( vals_dtype.is_double() )
   {
     retval = vtkDoubleArray::New();
-    Blueprint_MultiCompArray_To_VTKDataArray<CONDUIT_NATIVE_DOUBLE>( n, ncomps, ntuples, retval );
+    Blueprint_MultiCompArray_To_VTKDataArray<CONDUIT_NATIVE_DOUBLE>( n, ncomps, ntuples, retval, zeroCopy );
   }
   else
   {
@@ -364,7 +373,7 @@ vtkDataSet* UnstructuredMesh( const conduit::Node* node )
 }
 
 //-----------------------------------------------------------------------------
-vtkDataSet* RectilinearMesh( const conduit::Node* node )
+vtkDataSet* RectilinearMesh( const conduit::Node* node, bool zeroCopy )
 {
   vtkRectilinearGrid *rectgrid = vtkRectilinearGrid::New();
 
@@ -381,9 +390,9 @@ vtkDataSet* RectilinearMesh( const conduit::Node* node )
   rectgrid->SetDimensions( dims );
 
   vtkDataArray *vtk_coords[3] = {0, 0, 0};
-  vtk_coords[0] = ConduitArrayToVTKDataArray( coords_values["x"] );
+  vtk_coords[0] = ConduitArrayToVTKDataArray( coords_values["x"], zeroCopy );
   if( coords_values.has_child("y") )
-    vtk_coords[1] = ConduitArrayToVTKDataArray( coords_values["y"] );
+    vtk_coords[1] = ConduitArrayToVTKDataArray( coords_values["y"], zeroCopy );
   else
   {
     vtk_coords[1] = vtk_coords[0]->NewInstance();
@@ -391,7 +400,7 @@ vtkDataSet* RectilinearMesh( const conduit::Node* node )
     vtk_coords[1]->SetComponent( 0, 0, 0 );
   }
   if( coords_values.has_child("z") )
-    vtk_coords[2] = ConduitArrayToVTKDataArray( coords_values["z"]) ;
+    vtk_coords[2] = ConduitArrayToVTKDataArray( coords_values["z"], zeroCopy );
   else
   {
     vtk_coords[2] = vtk_coords[0]->NewInstance();
@@ -616,6 +625,18 @@ void ConduitDataAdaptor::UpdateFields()
   }
 }
 
+//-----------------------------------------------------------------------------
+void ConduitDataAdaptor::SetZeroCopy( int val )
+{
+  this->ZeroCopy = val;
+}
+
+//-----------------------------------------------------------------------------
+int ConduitDataAdaptor::GetZeroCopy() const
+{
+  return( this->ZeroCopy );
+}
+
 //-----------------------------------------------------------------------------
 int ConduitDataAdaptor::GetMesh( const std::string &meshName, bool /*structureOnly*/, vtkDataObject *&mesh )
 {   
@@ -669,7 +690,7 @@ int ConduitDataAdaptor::GetMesh( const std::string &meshName, bool /*structureOn
       }
       else if( coords["type"].as_string() == "rectilinear" )
       {
-        mb_mesh->SetBlock( block, RectilinearMesh(&d_node) );
+        mb_mesh->SetBlock( block, RectilinearMesh(&d_node, this->ZeroCopy) );
       }   
       else if( coords["type"].as_string() == "explicit" )
       {
@@ -712,7 +733,7 @@ int ConduitDataAdaptor::GetMesh( const std::string &meshName, bool /*structureOn
     }
     else if( coords["type"].as_string() == "rectilinear" )
     {
-      mb_mesh->SetBlock( block, RectilinearMesh(this->Node) );
+      mb_mesh->SetBlock( block, RectilinearMesh(this->Node, this->ZeroCopy) );
     }   
     else if( coords["type"].as_string() == "explicit" )
     {
@@ -800,7 +821,7 @@ int ConduitDataAdaptor::AddArray( vtkDataObject* mesh, const std::string &meshNa
       const conduit::Node& field  = fields[arrayname];
       const conduit::Node& values = field["values"];
             
-      vtkSmartPointer<vtkDataArray> array = ConduitArrayToVTKDataArray( values );
+      vtkSmartPointer<vtkDataArray> array = ConduitArrayToVTKDataArray( values, this->ZeroCopy );
       array->SetName( arrayname.c_str() );
        
       vtkDataObject *block = mb->GetBlock( start + domain );
@@ -853,7 +874,7 @@ int ConduitDataAdaptor::AddArray( vtkDataObject* mesh, const std::string &meshNa
     const conduit::Node& fields  = (*this->Node)["fields"];
     const conduit::Node& field   = fields[arrayname];
     const conduit::Node& values  = field["values"];
-    vtkSmartPointer<vtkDataArray> array = ConduitArrayToVTKDataArray( values );
+    vtkSmartPointer<vtkDataArray> array = ConduitArrayToVTKDataArray( values, this->ZeroCopy );
     array->SetName( arrayname.c_str() );
 
     vtkDataObject *block = mb->GetBlock( start );
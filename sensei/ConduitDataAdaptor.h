@@ -21,6 +21,13 @@ public:
   void SetNode(conduit::Node* node);
   void UpdateFields();
 
+  // When set, single contiguous Conduit arrays are used in place by the
+  // VTK arrays rather than copied. The node's data must then outlive the
+  // VTK arrays, including any an analysis keeps after ReleaseData.
+  // Strided and multi-component arrays are always copied. Off by default.
+  void SetZeroCopy(int val);
+  int GetZeroCopy() const;
+
   // SENSEI DataAdaptor API.
   int GetNumberOfMeshes(unsigned int &numMeshes) override;
 
@@ -48,6 +55,7 @@ private:
   void operator=(const ConduitDataAdaptor&) = delete; // not implemented.
 
   conduit::Node* Node;
+  int ZeroCopy;
 };
 
 } // namespace sensei
@@ -2,11 +2,24 @@
 #include <vtkSmartPointer.h>
 #include <vtkNew.h>
 #include <vtkDataObject.h>
+#include <vtkDataSet.h>
+#include <vtkDataArray.h>
+#include <vtkFieldData.h>
 
 #include <vector>
+#include <map>
 #include <fstream>
 #include <sstream>
 #include <cstdio>
+#include <functional>
+#include <algorithm>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <utility>
+#include <limits>
+#include <cmath>
 #include <errno.h>
 
 #include "ConfigurableAnalysis.h"
@@ -14,12 +27,19 @@
 #include "Error.h"
 #include "Profiler.h"
 #include "VTKUtils.h"
+#include "ThreadPool.h"
 #include "XMLUtils.h"
 #include "STLUtils.h"
 #include "DataRequirements.h"
+#include "MeshMetadata.h"
+#include "CachingDataAdaptor.h"
+#include "InTransitDataAdaptor.h"
 
 #include "Autocorrelation.h"
 #include "Histogram.h"
+#include "DescriptiveStatistics.h"
+#include "AsynchronousIO.h"
+#include "DataReduction.h"
 #ifdef ENABLE_VTK_IO
 #include "VTKPosthocIO.h"
 #ifdef ENABLE_VTK_MPI
@@ -73,7 +93,9 @@ using namespace STLUtils; // for operator<< overloads
 struct ConfigurableAnalysis::InternalsType
 {
   InternalsType()
-    : Comm(MPI_COMM_NULL)
+    : Comm(MPI_COMM_NULL), ConcurrentStartup(0), StartupThreads(0),
+    NextDeferred(0), StartupQueueClosed(false), StartupTime(0.0),
+    CachePlan(0), ShareData(0), PlanValidated(false)
   {
   }
 
@@ -81,9 +103,83 @@ struct ConfigurableAnalysis::InternalsType
   // optionally timing how long initialization takes.
   // If no \a initializer is passed, then no initialization is
   // required but a timer entry will be created for consistency.
+  // When concurrent startup is enabled and the initializer is
+  // flagged \a threadSafe it is queued and run on a startup thread
+  // while the remaining analyses are configured. Initializers that
+  // touch global state, such as VTK's global controller, the HDF5
+  // library, ADIOS2, or an embedded interpreter, must not be flagged
+  // thread safe. Only flag those that do enough work to be worth a
+  // thread. Initializers that are queued must not capture local
+  // variables by reference.
   int TimeInitialization(
     AnalysisAdaptorPtr adaptor,
-    std::function<int()> initializer = []() { return 0; });
+    std::function<int()> initializer = []() { return 0; },
+    bool threadSafe = false);
+
+  // waits for the initializers queued by TimeInitialization. each
+  // analysis has its own communicator thus initializers may make MPI
+  // calls when MPI_THREAD_MULTIPLE is available. returns non-zero if
+  // any of the initializers fail.
+  int RunDeferredInitialization();
+
+  // runs queued initializers until the queue is closed and empty
+  void RunStartupWorker();
+
+  // records the meshes, arrays and associations that the analyses
+  // configured by the node will read in the execution plan.
+  // firstAnalysis is the number of analyses before the node was
+  // processed.
+  void AddToPlan(pugi::xml_node node, unsigned int firstAnalysis);
+
+  // checks that the meshes and arrays in the execution plan are
+  // provided by the simulation and records those that are in
+  // Fetch. this is done once, on the first step in which an
+  // analysis runs.
+  int ValidatePlan(DataAdaptor *data);
+
+  // returns true if any of the analyses in the execution plan reads
+  // the geometry of the named mesh
+  bool ReadsGeometry(const std::string &meshName);
+
+  // parses the scheduling attributes of the node. see
+  // ConfigurableAnalysis::Initialize. firstAnalysis is the
+  // number of analyses before the node was processed.
+  int AddToSchedule(pugi::xml_node node, unsigned int firstAnalysis);
+
+  // when the node sets the asynchronous attribute the analyses it
+  // configured are wrapped in an AsynchronousIO adaptor that runs
+  // them on a worker thread. the data captured for the worker is
+  // taken from the execution plan. firstAnalysis is the number of
+  // analyses before the node was processed.
+  int AddAsynchronous(pugi::xml_node node, unsigned int firstAnalysis);
+
+  // when the node sets any of the stride, roi, or precision attributes
+  // the analyses it configured are wrapped in a DataReduction adaptor
+  // that passes them subsampled and down converted data. this is done
+  // after AddAsynchronous so that only the reduced data is captured.
+  // firstAnalysis is the number of analyses before the node was
+  // processed.
+  int AddReduction(pugi::xml_node node, unsigned int firstAnalysis);
+
+  // determines which analyses run in the current time step.
+  // active is indexed in the same order as Analyses. only the
+  // analyses that have a data trigger and are otherwise due to
+  // run make any calls to the data adaptor.
+  int ScheduleAnalyses(MPI_Comm comm, DataAdaptor *data,
+    std::vector<int> &active);
+
+  // computes the global range of an array used by a data trigger.
+  // ranges are computed once per time step and shared by all of
+  // the analyses that trigger on the same array.
+  int GetTriggerRange(MPI_Comm comm, DataAdaptor *data,
+    const std::string &meshName, int association,
+    const std::string &arrayName, double range[2]);
+
+  // accumulates the time used by the active analyses that have a
+  // wall time budget. active and elapsed are indexed in the same
+  // order as Analyses.
+  void UpdateTimeBudgets(MPI_Comm comm, const std::vector<int> &active,
+    const std::vector<double> &elapsed);
 
   // creates, initializes from xml, and adds the analysis
   // if it has been compiled into the build and is enabled.
@@ -100,6 +196,7 @@ struct ConfigurableAnalysis::InternalsType
   int AddCatalyst(pugi::xml_node node);
   int AddLibsim(pugi::xml_node node);
   int AddAutoCorrelation(pugi::xml_node node);
+  int AddStatistics(pugi::xml_node node);
   int AddPosthocIO(pugi::xml_node node);
   int AddVTKAmrWriter(pugi::xml_node node);
   int AddPythonAnalysis(pugi::xml_node node);
@@ -128,20 +225,94 @@ public:
   MPI_Comm Comm;
 
   std::vector<std::string> LogEventNames;
+
+  // concurrent startup. initializers of analyses that can be
+  // initialized independently are queued here during parsing and
+  // run by the startup threads while the others are configured on
+  // the main thread. a deque is used so that queued entries do not
+  // move while they run.
+  struct DeferredInitializerType
+  {
+    unsigned int Analysis;
+    std::string EventName;
+    std::function<int()> Initializer;
+    int Status;
+    double Time;
+  };
+
+  std::deque<DeferredInitializerType> DeferredInitializers;
+  std::vector<std::thread> StartupWorkers;
+  std::mutex StartupMutex;
+  std::condition_variable StartupWork;
+  unsigned int NextDeferred;
+  bool StartupQueueClosed;
+  int ConcurrentStartup;
+  int StartupThreads;
+  double StartupTime;
+
+  // the execution plan. the data each analysis reads and the
+  // subset of it that the simulation provides, both indexed in
+  // the same order as Analyses, and a wrapper that shares
+  // metadata queries and optionally data among the analyses
+  // during Execute.
+  std::vector<DataRequirements> Plan;
+  std::vector<DataRequirements> Fetch;
+  vtkSmartPointer<CachingDataAdaptor> Cache;
+  int CachePlan;
+  int ShareData;
+  bool PlanValidated;
+
+  // when an analysis runs. an analysis runs in steps between
+  // StartStep and StopStep, every Frequency steps, until it has
+  // used TimeBudget seconds. When a trigger is configured the
+  // analysis runs only in those steps where the global range of
+  // the trigger array satisfies the trigger's condition.
+  enum {TRIGGER_NONE, TRIGGER_ABOVE, TRIGGER_BELOW, TRIGGER_CHANGE};
+
+  struct ScheduleType
+  {
+    ScheduleType() : Frequency(1), StartStep(0), StopStep(-1),
+      TimeBudget(-1.0), TimeUsed(0.0), Trigger(TRIGGER_NONE),
+      TriggerAssociation(vtkDataObject::POINT), TriggerThreshold(0.0),
+      HaveLastRange(false), LastRange{0.0, 0.0} {}
+
+    long Frequency;
+    long StartStep;
+    long StopStep;
+    double TimeBudget;
+    double TimeUsed;
+    int Trigger;
+    std::string TriggerMesh;
+    std::string TriggerArray;
+    int TriggerAssociation;
+    double TriggerThreshold;
+    bool HaveLastRange;
+    double LastRange[2];
+  };
+
+  // the schedule of each analysis, indexed in the same order
+  // as Analyses, and the trigger ranges computed in the current
+  // time step.
+  using TriggerKeyType = std::pair<std::string, std::pair<int, std::string>>;
+  using TriggerRangeType = std::pair<double, double>;
+
+  std::vector<ScheduleType> Schedule;
+  std::map<TriggerKeyType, TriggerRangeType> TriggerRanges;
 };
 
 // --------------------------------------------------------------------------
 int ConfigurableAnalysis::InternalsType::TimeInitialization(
-  AnalysisAdaptorPtr adaptor, std::function<int()> initializer)
+  AnalysisAdaptorPtr adaptor, std::function<int()> initializer,
+  bool threadSafe)
 {
   const char* analysisName = nullptr;
   bool logEnabled = Profiler::Enabled();
+  auto analysisNumber = this->Analyses.size();
   if (logEnabled)
     {
     std::ostringstream initName;
     std::ostringstream execName;
     std::ostringstream finiName;
-    auto analysisNumber = this->Analyses.size();
     initName << adaptor->GetClassName() << "::" << analysisNumber << "::Initialize";
     execName << adaptor->GetClassName() << "::" << analysisNumber << "::Execute";
     finiName << adaptor->GetClassName() << "::" << analysisNumber << "::Finalize";
@@ -149,9 +320,33 @@ int ConfigurableAnalysis::InternalsType::TimeInitialization(
     this->LogEventNames.push_back(execName.str());
     this->LogEventNames.push_back(finiName.str());
     analysisName = this->LogEventNames[3 * analysisNumber].c_str();
-    Profiler::StartEvent(analysisName);
     }
 
+  if (this->ConcurrentStartup && threadSafe)
+    {
+    unsigned int nThreads = this->StartupThreads > 0 ?
+      this->StartupThreads : std::thread::hardware_concurrency();
+
+      {
+      std::lock_guard<std::mutex> lock(this->StartupMutex);
+      this->DeferredInitializers.push_back({(unsigned int)analysisNumber,
+        analysisName ? analysisName : "", initializer, 0, 0.0});
+      }
+
+    // start a thread per initializer, up to the limit. threads that
+    // are already running pick up the new initializer if they are idle
+    if (this->StartupWorkers.size() < std::max(1u, nThreads))
+      this->StartupWorkers.push_back(
+        std::thread(&InternalsType::RunStartupWorker, this));
+    else
+      this->StartupWork.notify_one();
+
+    return 0;
+    }
+
+  if (logEnabled)
+    Profiler::StartEvent(analysisName);
+
   int result = initializer();
 
   if (logEnabled)
@@ -160,6 +355,639 @@ int ConfigurableAnalysis::InternalsType::TimeInitialization(
   return result;
 }
 
+// --------------------------------------------------------------------------
+void ConfigurableAnalysis::InternalsType::RunStartupWorker()
+{
+  bool logEnabled = Profiler::Enabled();
+
+  while (true)
+    {
+    DeferredInitializerType *init = nullptr;
+
+      {
+      std::unique_lock<std::mutex> lock(this->StartupMutex);
+
+      this->StartupWork.wait(lock, [this]() {
+        return this->StartupQueueClosed ||
+          (this->NextDeferred < this->DeferredInitializers.size()); });
+
+      if (this->NextDeferred == this->DeferredInitializers.size())
+        return;
+
+      init = &this->DeferredInitializers[this->NextDeferred++];
+      }
+
+    if (logEnabled)
+      Profiler::StartEvent(init->EventName.c_str());
+
+    double t0 = MPI_Wtime();
+    init->Status = init->Initializer();
+    init->Time = MPI_Wtime() - t0;
+
+    if (logEnabled)
+      Profiler::EndEvent(init->EventName.c_str());
+    }
+}
+
+// --------------------------------------------------------------------------
+int ConfigurableAnalysis::InternalsType::RunDeferredInitialization()
+{
+  unsigned int nInit = this->DeferredInitializers.size();
+  if (nInit == 0)
+    return 0;
+
+  TimeEvent<128> mark("ConfigurableAnalysis::RunDeferredInitialization");
+
+  // no more initializers will be queued. the main thread helps with
+  // those that have not been started
+    {
+    std::lock_guard<std::mutex> lock(this->StartupMutex);
+    this->StartupQueueClosed = true;
+    }
+
+  this->StartupWork.notify_all();
+
+  this->RunStartupWorker();
+
+  unsigned int nThreads = this->StartupWorkers.size();
+  for (unsigned int i = 0; i < nThreads; ++i)
+    this->StartupWorkers[i].join();
+
+  this->StartupWorkers.clear();
+
+  int retVal = 0;
+  double initTime = 0.0;
+  for (unsigned int i = 0; i < nInit; ++i)
+    {
+    DeferredInitializerType &init = this->DeferredInitializers[i];
+    initTime += init.Time;
+    if (init.Status)
+      {
+      SENSEI_ERROR("Failed to initialize analysis " << init.Analysis << " "
+        << this->Analyses[init.Analysis]->GetClassName())
+      retVal = -1;
+      }
+    }
+
+  SENSEI_STATUS("Initialized " << nInit << " analyses concurrently on "
+    << nThreads << " threads, their initializers took " << initTime
+    << " seconds in total")
+
+  this->DeferredInitializers.clear();
+
+  return retVal;
+}
+
+// --------------------------------------------------------------------------
+void ConfigurableAnalysis::InternalsType::AddToPlan(pugi::xml_node node,
+  unsigned int firstAnalysis)
+{
+  unsigned int nAnalyses = this->Analyses.size();
+
+  // some adaptors, such as Catalyst, are shared by a number of
+  // nodes. in that case nothing new was added.
+  if (nAnalyses <= firstAnalysis)
+    return;
+
+  // analyses that are configured with mesh and array elements
+  DataRequirements req;
+  req.Initialize(node);
+
+  // analyses that are configured with attributes. the geometry is
+  // fetched on their behalf unless structure_only is set, as it is for
+  // mesh elements
+  if (node.attribute("mesh"))
+    {
+    std::string mesh = node.attribute("mesh").value();
+
+    bool structureOnly = node.attribute("structure_only").as_int(0);
+
+    req.AddRequirement(mesh, structureOnly);
+
+    pugi::xml_attribute array = node.attribute("array");
+    if (!array)
+      array = node.attribute("field");
+
+    int assoc = 0;
+    std::string assocStr = node.attribute("association").as_string("point");
+
+    if (array && !VTKUtils::GetAssociation(assocStr, assoc))
+      req.AddRequirement(mesh, assoc, std::string(array.value()));
+    }
+
+  this->Plan.resize(nAnalyses);
+  this->Plan[nAnalyses - 1] = req;
+}
+
+// --------------------------------------------------------------------------
+bool ConfigurableAnalysis::InternalsType::ReadsGeometry(
+  const std::string &meshName)
+{
+  unsigned int nPlan = this->Plan.size();
+  for (unsigned int ai = 0; ai < nPlan; ++ai)
+    {
+    MeshRequirementsIterator mit =
+      this->Plan[ai].GetMeshRequirementsIterator();
+
+    for (; mit; ++mit)
+      {
+      if ((mit.MeshName() == meshName) && !mit.StructureOnly())
+        return true;
+      }
+    }
+
+  return false;
+}
+
+// --------------------------------------------------------------------------
+int ConfigurableAnalysis::InternalsType::ValidatePlan(DataAdaptor *data)
+{
+  TimeEvent<128> mark("ConfigurableAnalysis::ValidatePlan");
+
+  // the plan is checked only once
+  this->PlanValidated = true;
+
+  unsigned int nPlan = this->Plan.size();
+  this->Fetch.clear();
+  this->Fetch.resize(nPlan);
+
+  // get what the simulation provides
+  unsigned int nMeshes = 0;
+  if (data->GetNumberOfMeshes(nMeshes))
+    {
+    SENSEI_ERROR("Failed to get the number of meshes")
+    return -1;
+    }
+
+  std::map<std::string, MeshMetadataPtr> mdMap;
+  for (unsigned int i = 0; i < nMeshes; ++i)
+    {
+    MeshMetadataPtr md = MeshMetadata::New();
+    if (data->GetMeshMetadata(i, md))
+      {
+      SENSEI_ERROR("Failed to get metadata for mesh " << i)
+      return -1;
+      }
+    mdMap[md->MeshName] = md;
+    }
+
+  // check each analysis' requirements against it
+  int nMissing = 0;
+  for (unsigned int ai = 0; ai < nPlan; ++ai)
+    {
+    const char *className = this->Analyses[ai]->GetClassName();
+
+    MeshRequirementsIterator mit =
+      this->Plan[ai].GetMeshRequirementsIterator();
+
+    for (; mit; ++mit)
+      {
+      const std::string &meshName = mit.MeshName();
+
+      std::map<std::string, MeshMetadataPtr>::iterator it =
+        mdMap.find(meshName);
+
+      if (it == mdMap.end())
+        {
+        SENSEI_WARNING("Analysis " << ai << " " << className
+          << " requires mesh \"" << meshName << "\" which the simulation"
+          " does not provide")
+        ++nMissing;
+        continue;
+        }
+
+      MeshMetadataPtr md = it->second;
+
+      this->Fetch[ai].AddRequirement(meshName, mit.StructureOnly());
+
+      ArrayRequirementsIterator ait =
+        this->Plan[ai].GetArrayRequirementsIterator(meshName);
+
+      for (; ait; ++ait)
+        {
+        int assoc = ait.Association();
+        const std::string &arrayName = ait.Array();
+
+        bool found = false;
+        for (int j = 0; !found && (j < md->NumArrays); ++j)
+          found = (md->ArrayCentering[j] == assoc) &&
+            (md->ArrayName[j] == arrayName);
+
+        if (!found)
+          {
+          SENSEI_WARNING("Analysis " << ai << " " << className
+            << " requires " << VTKUtils::GetAttributesName(assoc)
+            << " data array \"" << arrayName << "\" on mesh \""
+            << meshName << "\" which the simulation does not provide")
+          ++nMissing;
+          continue;
+          }
+
+        this->Fetch[ai].AddRequirement(meshName, assoc, arrayName);
+        }
+      }
+    }
+
+  return nMissing ? -1 : 0;
+}
+
+// --------------------------------------------------------------------------
+int ConfigurableAnalysis::InternalsType::AddAsynchronous(pugi::xml_node node,
+  unsigned int firstAnalysis)
+{
+  // the python analysis has its own worker thread
+  std::string type = node.attribute("type").value();
+  if (!node.attribute("asynchronous").as_int(0) || (type == "python"))
+    return 0;
+
+  unsigned int queueDepth = node.attribute("queue_depth").as_uint(1);
+  std::string queuePolicy = node.attribute("queue_policy").as_string("block");
+  unsigned long long memoryBudget = node.attribute("memory_budget").as_ullong(0);
+  int deepCopy = node.attribute("deep_copy").as_int(1);
+
+  unsigned int nAnalyses = this->Analyses.size();
+  for (unsigned int i = firstAnalysis; i < nAnalyses; ++i)
+    {
+    auto adaptor = vtkSmartPointer<AsynchronousIO>::New();
+
+    if (this->Comm != MPI_COMM_NULL)
+      adaptor->SetCommunicator(this->Comm);
+
+    adaptor->SetAnalysis(this->Analyses[i]);
+    adaptor->SetVerbose(this->Analyses[i]->GetVerbose());
+    adaptor->SetQueueDepth(queueDepth);
+    adaptor->SetDeepCopy(deepCopy);
+
+    // the budget is given in MiB
+    adaptor->SetMemoryBudget(memoryBudget*1024*1024);
+
+    if (adaptor->SetQueuePolicy(queuePolicy) ||
+      ((i < this->Plan.size()) && adaptor->SetDataRequirements(this->Plan[i])))
+      {
+      SENSEI_ERROR("Failed to initialize the AsynchronousIO adaptor")
+      return -1;
+      }
+
+    SENSEI_STATUS("Configured AsynchronousIO for "
+      << this->Analyses[i]->GetClassName() << " queue_depth=" << queueDepth
+      << " queue_policy=" << queuePolicy << " memory_budget=" << memoryBudget
+      << " deep_copy=" << deepCopy)
+
+    this->Analyses[i] = adaptor.GetPointer();
+    }
+
+  return 0;
+}
+
+// --------------------------------------------------------------------------
+// parses a list of integers separated by commas or spaces
+static
+void parseIntList(std::string str, std::vector<int> &vals)
+{
+  std::replace(str.begin(), str.end(), ',', ' ');
+  std::istringstream iss(str);
+  int val = 0;
+  while (iss >> val)
+    vals.push_back(val);
+}
+
+// --------------------------------------------------------------------------
+int ConfigurableAnalysis::InternalsType::AddReduction(pugi::xml_node node,
+  unsigned int firstAnalysis)
+{
+  pugi::xml_attribute strideAt = node.attribute("stride");
+  pugi::xml_attribute roiAt = node.attribute("roi");
+  pugi::xml_attribute precisionAt = node.attribute("precision");
+
+  if (!strideAt && !roiAt && !precisionAt)
+    return 0;
+
+  // a single stride applies in all directions
+  std::vector<int> stride;
+  parseIntList(strideAt.value(), stride);
+  if (stride.size() == 1)
+    stride.resize(3, stride[0]);
+
+  std::vector<int> roi;
+  parseIntList(roiAt.value(), roi);
+
+  if ((strideAt && (stride.size() != 3)) || (roiAt && (roi.size() != 6)))
+    {
+    SENSEI_ERROR("stride must have 1 or 3 values and roi 6 values, got \""
+      << strideAt.value() << "\" and \"" << roiAt.value() << "\"")
+    return -1;
+    }
+
+  std::string precision = precisionAt.as_string("native");
+
+  unsigned int nAnalyses = this->Analyses.size();
+  for (unsigned int i = firstAnalysis; i < nAnalyses; ++i)
+    {
+    auto adaptor = vtkSmartPointer<DataReduction>::New();
+
+    if (this->Comm != MPI_COMM_NULL)
+      adaptor->SetCommunicator(this->Comm);
+
+    adaptor->SetAnalysis(this->Analyses[i]);
+    adaptor->SetVerbose(this->Analyses[i]->GetVerbose());
+
+    if ((strideAt && adaptor->SetStride({{stride[0], stride[1], stride[2]}})) ||
+      (roiAt && adaptor->SetRegion({{roi[0], roi[1], roi[2],
+        roi[3], roi[4], roi[5]}})) || adaptor->SetPrecision(precision))
+      {
+      SENSEI_ERROR("Failed to initialize the DataReduction adaptor")
+      return -1;
+      }
+
+    SENSEI_STATUS("Configured DataReduction for "
+      << this->Analyses[i]->GetClassName() << " stride=\""
+      << strideAt.value() << "\" roi=\"" << roiAt.value()
+      << "\" precision=" << precision)
+
+    this->Analyses[i] = adaptor.GetPointer();
+    }
+
+  return 0;
+}
+
+// --------------------------------------------------------------------------
+int ConfigurableAnalysis::InternalsType::AddToSchedule(pugi::xml_node node,
+  unsigned int firstAnalysis)
+{
+  unsigned int nAnalyses = this->Analyses.size();
+
+  // some adaptors, such as Catalyst, are shared by a number of
+  // nodes. in that case the first node's schedule is used.
+  if (nAnalyses <= firstAnalysis)
+    return 0;
+
+  ScheduleType sched;
+
+  // libsim interprets the frequency attribute itself
+  std::string type = node.attribute("type").value();
+  if (type != "libsim")
+    sched.Frequency = std::max(1, node.attribute("frequency").as_int(1));
+
+  sched.StartStep = node.attribute("start_step").as_int(0);
+  sched.StopStep = node.attribute("stop_step").as_int(-1);
+  sched.TimeBudget = node.attribute("time_budget").as_double(-1.0);
+
+  const char *triggers[] = {"trigger_above", "trigger_below", "trigger_change"};
+  int modes[] = {TRIGGER_ABOVE, TRIGGER_BELOW, TRIGGER_CHANGE};
+  for (int i = 0; i < 3; ++i)
+    {
+    pugi::xml_attribute trigger = node.attribute(triggers[i]);
+    if (!trigger)
+      continue;
+
+    if (sched.Trigger != TRIGGER_NONE)
+      {
+      SENSEI_ERROR("Only one of trigger_above, trigger_below, or"
+        " trigger_change may be specified")
+      return -1;
+      }
+
+    sched.Trigger = modes[i];
+    sched.TriggerThreshold = trigger.as_double();
+    }
+
+  if (sched.Trigger != TRIGGER_NONE)
+    {
+    // by default trigger on the data the analysis reads
+    pugi::xml_attribute array = node.attribute("array");
+    if (!array)
+      array = node.attribute("field");
+
+    sched.TriggerMesh = node.attribute("trigger_mesh").as_string(
+      node.attribute("mesh").value());
+
+    sched.TriggerArray = node.attribute("trigger_array").as_string(
+      array.value());
+
+    std::string assocStr = node.attribute("trigger_association").as_string(
+      node.attribute("association").as_string("point"));
+
+    if (VTKUtils::GetAssociation(assocStr, sched.TriggerAssociation))
+      {
+      SENSEI_ERROR("Invalid trigger association \"" << assocStr << "\"")
+      return -1;
+      }
+
+    if (sched.TriggerMesh.empty() || sched.TriggerArray.empty())
+      {
+      SENSEI_ERROR("A data trigger requires a mesh and an array. Use the"
+        " trigger_mesh and trigger_array attributes")
+      return -1;
+      }
+    }
+
+  this->Schedule.resize(nAnalyses);
+  this->Schedule[nAnalyses - 1] = sched;
+
+  return 0;
+}
+
+// --------------------------------------------------------------------------
+int ConfigurableAnalysis::InternalsType::GetTriggerRange(MPI_Comm comm,
+  DataAdaptor *data, const std::string &meshName, int association,
+  const std::string &arrayName, double range[2])
+{
+  TriggerKeyType key(meshName, std::make_pair(association, arrayName));
+
+  std::map<TriggerKeyType, TriggerRangeType>::iterator it =
+    this->TriggerRanges.find(key);
+
+  if (it != this->TriggerRanges.end())
+    {
+    range[0] = it->second.first;
+    range[1] = it->second.second;
+    return 0;
+    }
+
+  TimeEvent<128> mark("ConfigurableAnalysis::GetTriggerRange");
+
+  // the range is stored negated min, max so that a single reduction
+  // with MPI_MAX finds both
+  double negRange[2] = {-std::numeric_limits<double>::max(),
+    -std::numeric_limits<double>::max()};
+
+  // triggers are evaluated before the data the analyses read is
+  // fetched. when the data is shared, asking for the geometry that
+  // the analyses will read avoids fetching the mesh twice.
+  bool structureOnly = !(this->ShareData && this->ReadsGeometry(meshName));
+
+  vtkDataObject *mesh = nullptr;
+  if (data->GetMesh(meshName, structureOnly, mesh))
+    {
+    SENSEI_ERROR("Failed to get mesh \"" << meshName << "\"")
+    return -1;
+    }
+
+  // it is not an error for a rank to have no data
+  if (mesh)
+    {
+    vtkSmartPointer<vtkDataObject> meshPtr;
+    meshPtr.TakeReference(mesh);
+
+    if (data->AddArray(mesh, meshName, association, arrayName))
+      {
+      SENSEI_ERROR("Failed to add " << VTKUtils::GetAttributesName(association)
+        << " data array \"" << arrayName << "\" to mesh \"" << meshName << "\"")
+      return -1;
+      }
+
+    VTKUtils::DatasetFunction func = [&](vtkDataSet *ds) -> int
+      {
+      vtkFieldData *atts = VTKUtils::GetAttributes(ds, association);
+      vtkDataArray *da = atts ? atts->GetArray(arrayName.c_str()) : nullptr;
+      if (!da || !da->GetNumberOfTuples())
+        return 0;
+
+      // use the magnitude of vectors
+      double blockRange[2] = {0.0, 0.0};
+      da->GetRange(blockRange, da->GetNumberOfComponents() > 1 ? -1 : 0);
+
+      negRange[0] = std::max(negRange[0], -blockRange[0]);
+      negRange[1] = std::max(negRange[1], blockRange[1]);
+
+      return 0;
+      };
+
+    if (VTKUtils::Apply(mesh, func) < 0)
+      return -1;
+    }
+
+  MPI_Allreduce(MPI_IN_PLACE, negRange, 2, MPI_DOUBLE, MPI_MAX, comm);
+
+  range[0] = -negRange[0];
+  range[1] = negRange[1];
+
+  this->TriggerRanges[key] = TriggerRangeType(range[0], range[1]);
+
+  return 0;
+}
+
+// --------------------------------------------------------------------------
+int ConfigurableAnalysis::InternalsType::ScheduleAnalyses(MPI_Comm comm,
+  DataAdaptor *data, std::vector<int> &active)
+{
+  unsigned int nAnalyses = this->Analyses.size();
+
+  active.assign(nAnalyses, 0);
+
+  this->Schedule.resize(nAnalyses);
+  this->TriggerRanges.clear();
+
+  long step = data->GetDataTimeStep();
+
+  for (unsigned int ai = 0; ai < nAnalyses; ++ai)
+    {
+    ScheduleType &sched = this->Schedule[ai];
+
+    // these checks are made first as they are free
+    if ((step < sched.StartStep) ||
+      ((sched.StopStep >= 0) && (step > sched.StopStep)) ||
+      ((step - sched.StartStep) % sched.Frequency) ||
+      ((sched.TimeBudget >= 0.0) && (sched.TimeUsed >= sched.TimeBudget)))
+      continue;
+
+    if (sched.Trigger == TRIGGER_NONE)
+      {
+      active[ai] = 1;
+      continue;
+      }
+
+    double range[2] = {0.0, 0.0};
+    if (this->GetTriggerRange(comm, data, sched.TriggerMesh,
+      sched.TriggerAssociation, sched.TriggerArray, range))
+      {
+      SENSEI_ERROR("Failed to evaluate the trigger for analysis "
+        << ai << " " << this->Analyses[ai]->GetClassName())
+      return -1;
+      }
+
+    // no rank has data
+    if (range[0] > range[1])
+      continue;
+
+    switch (sched.Trigger)
+      {
+      case TRIGGER_ABOVE:
+        active[ai] = range[1] > sched.TriggerThreshold;
+        break;
+
+      case TRIGGER_BELOW:
+        active[ai] = range[0] < sched.TriggerThreshold;
+        break;
+
+      case TRIGGER_CHANGE:
+        {
+        // the change relative to the range at the last run
+        double width = std::max(sched.LastRange[1] - sched.LastRange[0],
+          std::numeric_limits<double>::min());
+
+        double change = std::max(std::fabs(range[0] - sched.LastRange[0]),
+          std::fabs(range[1] - sched.LastRange[1])) / width;
+
+        active[ai] = !sched.HaveLastRange || (change > sched.TriggerThreshold);
+
+        if (active[ai])
+          {
+          sched.HaveLastRange = true;
+          sched.LastRange[0] = range[0];
+          sched.LastRange[1] = range[1];
+          }
+        }
+        break;
+      }
+    }
+
+  return 0;
+}
+
+// --------------------------------------------------------------------------
+void ConfigurableAnalysis::InternalsType::UpdateTimeBudgets(MPI_Comm comm,
+  const std::vector<int> &active, const std::vector<double> &elapsed)
+{
+  // gather the times of the analyses that have a budget so that
+  // a single reduction is made
+  std::vector<unsigned int> ids;
+  std::vector<double> times;
+
+  unsigned int nAnalyses = this->Schedule.size();
+  for (unsigned int ai = 0; ai < nAnalyses; ++ai)
+    {
+    if (active[ai] && (this->Schedule[ai].TimeBudget >= 0.0))
+      {
+      ids.push_back(ai);
+      times.push_back(elapsed[ai]);
+      }
+    }
+
+  // the schedule is the same on all ranks
+  if (ids.empty())
+    return;
+
+  MPI_Allreduce(MPI_IN_PLACE, times.data(), times.size(),
+    MPI_DOUBLE, MPI_MAX, comm);
+
+  unsigned int nIds = ids.size();
+  for (unsigned int i = 0; i < nIds; ++i)
+    {
+    ScheduleType &sched = this->Schedule[ids[i]];
+
+    sched.TimeUsed += times[i];
+
+    if (sched.TimeUsed >= sched.TimeBudget)
+      {
+      SENSEI_STATUS("Analysis " << ids[i] << " "
+        << this->Analyses[ids[i]]->GetClassName() << " has used "
+        << sched.TimeUsed << " of its " << sched.TimeBudget
+        << " second budget and will no longer run")
+      }
+    }
+}
+
 // --------------------------------------------------------------------------
 int ConfigurableAnalysis::InternalsType::AddHistogram(pugi::xml_node node)
 {
@@ -187,7 +1015,7 @@ int ConfigurableAnalysis::InternalsType::AddHistogram(pugi::xml_node node)
   if (this->Comm != MPI_COMM_NULL)
     histogram->SetCommunicator(this->Comm);
 
-  this->TimeInitialization(histogram, [&]() {
+  this->TimeInitialization(histogram, [=]() {
       histogram->Initialize(bins, mesh, association, array, fileName);
       return 0;
     });
@@ -201,6 +1029,42 @@ int ConfigurableAnalysis::InternalsType::AddHistogram(pugi::xml_node node)
   return 0;
 }
 
+// --------------------------------------------------------------------------
+int ConfigurableAnalysis::InternalsType::AddStatistics(pugi::xml_node node)
+{
+  DataRequirements req;
+  if (req.Initialize(node))
+    {
+    SENSEI_ERROR("Failed to initialize DescriptiveStatistics.")
+    return -1;
+    }
+
+  std::string fileName = node.attribute("file").value();
+  std::string format = node.attribute("format").as_string("csv");
+
+  auto stats = vtkSmartPointer<DescriptiveStatistics>::New();
+
+  if (this->Comm != MPI_COMM_NULL)
+    stats->SetCommunicator(this->Comm);
+
+  stats->SetFileName(fileName);
+
+  if (stats->SetFormat(format) || stats->SetDataRequirements(req))
+    {
+    SENSEI_ERROR("Failed to initialize DescriptiveStatistics.")
+    return -1;
+    }
+
+  this->TimeInitialization(stats);
+  this->Analyses.push_back(stats.GetPointer());
+
+  SENSEI_STATUS("Configured DescriptiveStatistics of "
+    << (req.Empty() ? "all arrays" : "the named arrays")
+    << (fileName.empty() ? std::string() : " writing " + format + " output to " + fileName))
+
+  return 0;
+}
+
 // --------------------------------------------------------------------------
 int ConfigurableAnalysis::InternalsType::AddVTKmContour(pugi::xml_node node)
 {
@@ -258,10 +1122,18 @@ int ConfigurableAnalysis::InternalsType::AddVTKmVolumeReduction(pugi::xml_node n
   auto field = node.attribute("field").as_string();
   auto assoc = node.attribute("association").as_string();
   auto reduction = node.attribute("reduction").as_int();
+  auto errorBound = node.attribute("error-bound").as_double(0.0);
 
   std::string workDir = node.attribute("working-directory").as_string(".");
 
+  if (errorBound < 0.0)
+    {
+    SENSEI_ERROR("Invalid error-bound " << errorBound << ". Use 0 for lossless output")
+    return -1;
+    }
+
   auto reducer = vtkSmartPointer<VTKmVolumeReductionAnalysis>::New();
+  reducer->SetErrorBound(errorBound);
   this->TimeInitialization(reducer, [&]() {
     reducer->Initialize(mesh, field, assoc, workDir, reduction, this->Comm);
     return 0;
@@ -297,6 +1169,19 @@ int ConfigurableAnalysis::InternalsType::AddVTKmCDF(pugi::xml_node node)
   auto assoc = node.attribute("association").as_string();
   auto quantiles = node.attribute("quantiles").as_int(10);
   auto exchangeSize = node.attribute("exchange-size").as_int(quantiles);
+  std::string mode = node.attribute("mode").as_string("exact");
+  auto errorBound = node.attribute("error-bound").as_double(0.01);
+
+  int modeId = VTKmCDFAnalysis::MODE_EXACT;
+  if (mode == "approximate")
+    modeId = VTKmCDFAnalysis::MODE_APPROXIMATE;
+  else if (mode == "search")
+    modeId = VTKmCDFAnalysis::MODE_SEARCH;
+  else if (mode != "exact")
+    {
+    SENSEI_ERROR("Invalid mode \"" << mode << "\". Use exact, approximate, or search")
+    return -1;
+    }
 
   bool haveWorkDir = !!node.attribute("working-directory");
   std::string workDir =  haveWorkDir ? node.attribute("working-directory").as_string() : ".";
@@ -306,9 +1191,12 @@ int ConfigurableAnalysis::InternalsType::AddVTKmCDF(pugi::xml_node node)
     analysis->Initialize(mesh, field, assoc, workDir, quantiles, exchangeSize, this->Comm);
     return 0;
   });
+  analysis->SetMode(modeId);
+  analysis->SetErrorBound(errorBound);
   this->Analyses.push_back(analysis.GetPointer());
 
-  SENSEI_STATUS("Configured VTKmCDFAnalysis " << mesh << "/" << field)
+  SENSEI_STATUS("Configured VTKmCDFAnalysis " << mesh << "/" << field
+    << " " << mode)
 
   return 0;
 #endif
@@ -434,7 +1322,22 @@ int ConfigurableAnalysis::InternalsType::AddAdios2(pugi::xml_node node)
     return -1;
     }
 
-  this->TimeInitialization(adiosAdaptor);
+  // when starting up concurrently open ADIOS2 now rather than in
+  // the first time step. ADIOS2 is not thread safe, this is done on
+  // the main thread while the startup threads run.
+  if (this->ConcurrentStartup)
+    {
+    if (this->TimeInitialization(adiosAdaptor, [=]() {
+      return adiosAdaptor->InitializeADIOS2(); }))
+      {
+      SENSEI_ERROR("Failed to initialize ADIOS2")
+      return -1;
+      }
+    }
+  else
+    {
+    this->TimeInitialization(adiosAdaptor);
+    }
   this->Analyses.push_back(adiosAdaptor.GetPointer());
 
   return 0;
@@ -474,6 +1377,27 @@ int ConfigurableAnalysis::InternalsType::AddHDF5(pugi::xml_node node)
         }
     }
 
+  // optional temporal encoding
+  pugi::xml_attribute deltaAttr = node.attribute("delta");
+  pugi::xml_attribute compressorAttr = node.attribute("compressor");
+
+  if((deltaAttr && dataE->SetDeltaMode(deltaAttr.value())) ||
+      (compressorAttr && dataE->SetCompressor(compressorAttr.value())))
+    {
+      SENSEI_ERROR("Failed to initialize HDF5 temporal encoding");
+      return -1;
+    }
+
+  dataE->SetShuffle(node.attribute("shuffle").as_int(0));
+  dataE->SetKeyFrameInterval(node.attribute("key_frame_interval").as_uint(10));
+
+  // optional error bounded compression
+  if (dataE->SetErrorBounds(node))
+    {
+    SENSEI_ERROR("Failed to initialize HDF5 compression")
+    return -1;
+    }
+
   DataRequirements req;
   if (req.Initialize(node))
     {
@@ -823,10 +1747,10 @@ int ConfigurableAnalysis::InternalsType::AddAutoCorrelation(pugi::xml_node node)
   if (this->Comm != MPI_COMM_NULL)
     adaptor->SetCommunicator(this->Comm);
 
-  this->TimeInitialization(adaptor, [&]() {
+  this->TimeInitialization(adaptor, [=]() {
     adaptor->Initialize(window, meshName, assoc, arrayName, kMax);
     return 0;
-  });
+  }, true);
 
   this->Analyses.push_back(adaptor.GetPointer());
 
@@ -858,6 +1782,9 @@ int ConfigurableAnalysis::InternalsType::AddPosthocIO(pugi::xml_node node)
   std::string mode = node.attribute("mode").as_string("visit");
   std::string writer = node.attribute("writer").as_string("xml");
   std::string ghostArrayName = node.attribute("ghost_array_name").as_string("");
+  std::string compressor = node.attribute("compressor").as_string("none");
+  int threads = node.attribute("threads").as_int(1);
+  int subfiling = node.attribute("subfiling").as_int(0);
   int verbose = node.attribute("verbose").as_int(0);
 
   auto adaptor = vtkSmartPointer<VTKPosthocIO>::New();
@@ -866,16 +1793,31 @@ int ConfigurableAnalysis::InternalsType::AddPosthocIO(pugi::xml_node node)
     adaptor->SetCommunicator(this->Comm);
 
   adaptor->SetGhostArrayName(ghostArrayName);
+  adaptor->SetNumberOfThreads(threads);
   adaptor->SetVerbose(verbose);
 
-  if (adaptor->SetOutputDir(outputDir) || adaptor->SetMode(mode) ||
-    adaptor->SetWriter(writer) || adaptor->SetDataRequirements(req))
+  if ((!this->ConcurrentStartup && adaptor->SetOutputDir(outputDir)) ||
+    adaptor->SetMode(mode) || adaptor->SetWriter(writer) ||
+    adaptor->SetCompressor(compressor) || adaptor->SetSubfiling(subfiling) ||
+    adaptor->SetDataRequirements(req))
     {
     SENSEI_ERROR("Failed to initialize the VTKPosthocIO analysis")
     return -1;
     }
 
-  this->TimeInitialization(adaptor);
+  // creating the output directory is a round trip to the file system's
+  // metadata server. when starting up concurrently it is done on a
+  // startup thread.
+  if (this->ConcurrentStartup)
+    {
+    this->TimeInitialization(adaptor, [=]() {
+      return adaptor->SetOutputDir(outputDir);
+      }, true);
+    }
+  else
+    {
+    this->TimeInitialization(adaptor);
+    }
   this->Analyses.push_back(adaptor.GetPointer());
 
   SENSEI_STATUS("Configured VTKPosthocIO")
@@ -917,7 +1859,6 @@ int ConfigurableAnalysis::InternalsType::AddVTKAmrWriter(pugi::xml_node node)
     return -1;
     }
 
-  this->TimeInitialization(adapter);
   this->Analyses.push_back(adapter.GetPointer());
 
   SENSEI_STATUS("Configured VTKAmrWriter")
@@ -949,6 +1890,18 @@ int ConfigurableAnalysis::InternalsType::AddPythonAnalysis(pugi::xml_node node)
   if (inode)
     initSource = inode.text().as_string();
 
+  // the data captured in asynchronous mode
+  DataRequirements req;
+  if (req.Initialize(node))
+    {
+    SENSEI_ERROR("Failed to initialize PythonAnalysis.")
+    return -1;
+    }
+
+  int async = node.attribute("asynchronous").as_int(0);
+  int queueDepth = node.attribute("queue_depth").as_int(1);
+  int deepCopy = node.attribute("deep_copy").as_int(1);
+
   auto pyAnalysis = vtkSmartPointer<PythonAnalysis>::New();
 
   if (this->Comm != MPI_COMM_NULL)
@@ -957,6 +1910,10 @@ int ConfigurableAnalysis::InternalsType::AddPythonAnalysis(pugi::xml_node node)
   pyAnalysis->SetScriptFile(scriptFile);
   pyAnalysis->SetScriptModule(scriptModule);
   pyAnalysis->SetInitializeSource(initSource);
+  pyAnalysis->SetAsynchronous(async);
+  pyAnalysis->SetQueueDepth(queueDepth);
+  pyAnalysis->SetDeepCopy(deepCopy);
+  pyAnalysis->SetDataRequirements(req);
 
   if (this->TimeInitialization(pyAnalysis, [&]() {
       return pyAnalysis->Initialize(); }))
@@ -972,7 +1929,8 @@ int ConfigurableAnalysis::InternalsType::AddPythonAnalysis(pugi::xml_node node)
     scriptFile.empty() ?  scriptModule.c_str() : scriptFile.c_str();
 
   SENSEI_STATUS("Configured python with " << scriptType
-    << " \"" << scriptName << "\"")
+    << " \"" << scriptName << "\"" << (pyAnalysis->GetAsynchronous() ?
+    " asynchronous" : ""))
 
   return 0;
 #endif
@@ -1169,6 +2127,32 @@ int ConfigurableAnalysis::Initialize(const pugi::xml_node &root)
 {
   TimeEvent<128> event("ConfigurableAnalysis::Initialize");
 
+  double startTime = MPI_Wtime();
+
+  // startup options
+  this->Internals->ConcurrentStartup =
+    root.attribute("concurrent_startup").as_int(0);
+
+  this->Internals->StartupThreads = root.attribute("startup_threads").as_int(0);
+  this->Internals->CachePlan = root.attribute("cache_plan").as_int(0);
+  this->Internals->ShareData = root.attribute("share_data").as_int(0);
+
+  // threads used to process blocks concurrently
+  if (pugi::xml_attribute att = root.attribute("num_threads"))
+    ThreadPool::SetNumberOfThreads(att.as_int(1));
+
+  if (this->Internals->ConcurrentStartup)
+    {
+    int threadLevel = MPI_THREAD_SINGLE;
+    MPI_Query_thread(&threadLevel);
+    if (threadLevel < MPI_THREAD_MULTIPLE)
+      {
+      SENSEI_WARNING("Concurrent startup requires MPI_THREAD_MULTIPLE."
+        " Analyses will be initialized serially")
+      this->Internals->ConcurrentStartup = 0;
+      }
+    }
+
   // create and configure analysis adaptors
   for (pugi::xml_node node = root.child("analysis");
     node; node = node.next_sibling("analysis"))
@@ -1176,9 +2160,12 @@ int ConfigurableAnalysis::Initialize(const pugi::xml_node &root)
     if (!node.attribute("enabled").as_int(0))
       continue;
 
+    unsigned int firstAnalysis = this->Internals->Analyses.size();
+
     std::string type = node.attribute("type").value();
     if (!(((type == "histogram") && !this->Internals->AddHistogram(node))
       || ((type == "autocorrelation") && !this->Internals->AddAutoCorrelation(node))
+      || ((type == "statistics") && !this->Internals->AddStatistics(node))
       || ((type == "adios1") && !this->Internals->AddAdios1(node))
       || ((type == "adios2") && !this->Internals->AddAdios2(node))
       || ((type == "ascent") && !this->Internals->AddAscent(node))
@@ -1196,6 +2183,26 @@ int ConfigurableAnalysis::Initialize(const pugi::xml_node &root)
       SENSEI_ERROR("Failed to add \"" << type << "\" analysis")
       MPI_Abort(this->GetCommunicator(), -1);
       }
+
+    this->Internals->AddToPlan(node, firstAnalysis);
+
+    if (this->Internals->AddAsynchronous(node, firstAnalysis))
+      {
+      SENSEI_ERROR("Failed to run \"" << type << "\" analysis asynchronously")
+      MPI_Abort(this->GetCommunicator(), -1);
+      }
+
+    if (this->Internals->AddReduction(node, firstAnalysis))
+      {
+      SENSEI_ERROR("Failed to reduce the data of \"" << type << "\" analysis")
+      MPI_Abort(this->GetCommunicator(), -1);
+      }
+
+    if (this->Internals->AddToSchedule(node, firstAnalysis))
+      {
+      SENSEI_ERROR("Failed to schedule \"" << type << "\" analysis")
+      MPI_Abort(this->GetCommunicator(), -1);
+      }
     }
 
   // create and configure transport analysis adaptors
@@ -1205,6 +2212,8 @@ int ConfigurableAnalysis::Initialize(const pugi::xml_node &root)
     if (!node.attribute("enabled").as_int(0))
       continue;
 
+    unsigned int firstAnalysis = this->Internals->Analyses.size();
+
     std::string type = node.attribute("type").value();
     if (!(((type == "adios1") && !this->Internals->AddAdios1(node))
       || ((type == "adios2") && !this->Internals->AddAdios2(node))
@@ -1213,21 +2222,168 @@ int ConfigurableAnalysis::Initialize(const pugi::xml_node &root)
       SENSEI_ERROR("Failed to add \"" << type << "\" transport")
       MPI_Abort(this->GetCommunicator(), -1);
       }
+
+    this->Internals->AddToPlan(node, firstAnalysis);
+
+    if (this->Internals->AddAsynchronous(node, firstAnalysis))
+      {
+      SENSEI_ERROR("Failed to run \"" << type << "\" transport asynchronously")
+      MPI_Abort(this->GetCommunicator(), -1);
+      }
+
+    if (this->Internals->AddReduction(node, firstAnalysis))
+      {
+      SENSEI_ERROR("Failed to reduce the data of \"" << type << "\" transport")
+      MPI_Abort(this->GetCommunicator(), -1);
+      }
+
+    if (this->Internals->AddToSchedule(node, firstAnalysis))
+      {
+      SENSEI_ERROR("Failed to schedule \"" << type << "\" transport")
+      MPI_Abort(this->GetCommunicator(), -1);
+      }
+    }
+
+  this->Internals->Plan.resize(this->Internals->Analyses.size());
+  this->Internals->Schedule.resize(this->Internals->Analyses.size());
+
+  // initialize the analyses that were queued for concurrent startup
+  if (this->Internals->RunDeferredInitialization())
+    {
+    SENSEI_ERROR("Failed to initialize analyses concurrently")
+    MPI_Abort(this->GetCommunicator(), -1);
     }
 
+  this->Internals->StartupTime = MPI_Wtime() - startTime;
+
+  SENSEI_STATUS("Started " << this->Internals->Analyses.size()
+    << " analyses in " << this->Internals->StartupTime << " seconds")
+
   return 0;
 }
 
+//----------------------------------------------------------------------------
+double ConfigurableAnalysis::GetStartupTime() const
+{
+  return this->Internals->StartupTime;
+}
+
 //----------------------------------------------------------------------------
 bool ConfigurableAnalysis::Execute(DataAdaptor* data)
 {
   TimeEvent<128> event("ConfigurableAnalysis::Execute");
 
+  // share metadata queries and data among the analyses. in transit
+  // data adaptors are passed through as analyses make direct use
+  // of their API.
+  DataAdaptor *dataAdaptor = data;
+  if (this->Internals->CachePlan &&
+    !dynamic_cast<InTransitDataAdaptor*>(data))
+    {
+    if (!this->Internals->Cache)
+      {
+      this->Internals->Cache = vtkSmartPointer<CachingDataAdaptor>::New();
+      this->Internals->Cache->SetCommunicator(data->GetCommunicator());
+      }
+
+    this->Internals->Cache->SetDataAdaptor(data);
+    this->Internals->Cache->SetShareData(this->Internals->ShareData);
+    dataAdaptor = this->Internals->Cache;
+    }
+
+  // decide which analyses run in this step. analyses that
+  // are skipped make no requests of the simulation
+  std::vector<int> active;
+  if (this->Internals->ScheduleAnalyses(this->GetCommunicator(),
+    dataAdaptor, active))
+    {
+    SENSEI_ERROR("Failed to schedule the analyses")
+    MPI_Abort(this->GetCommunicator(), -1);
+    }
+
+  bool anyActive = std::find(active.begin(), active.end(), 1) != active.end();
+
+  if (anyActive && (dataAdaptor != data))
+    {
+    // report missing data once, up front, rather than
+    // letting the analyses discover it one by one
+    if (!this->Internals->PlanValidated &&
+      this->Internals->ValidatePlan(dataAdaptor))
+      {
+      SENSEI_WARNING("Some of the data required by the configured"
+        " analyses is not provided by the simulation")
+      }
+
+    // fetch the union of what the active analyses read once.
+    // data that isn't in the plan is fetched on first use.
+    if (this->Internals->ShareData)
+      {
+      // a mesh is fetched with its geometry if any of the active
+      // analyses reads it
+      std::map<std::string, bool> structureOnly;
+
+      unsigned int nFetch = this->Internals->Fetch.size();
+      for (unsigned int i = 0; i < nFetch; ++i)
+        {
+        if (!active[i])
+          continue;
+
+        MeshRequirementsIterator mit =
+          this->Internals->Fetch[i].GetMeshRequirementsIterator();
+
+        for (; mit; ++mit)
+          {
+          auto it = structureOnly.insert(
+            std::make_pair(mit.MeshName(), mit.StructureOnly())).first;
+
+          it->second = it->second && mit.StructureOnly();
+          }
+        }
+
+      DataRequirements fetch;
+
+      std::map<std::string, bool>::iterator sit = structureOnly.begin();
+      for (; sit != structureOnly.end(); ++sit)
+        fetch.AddRequirement(sit->first, sit->second);
+
+      for (unsigned int i = 0; i < nFetch; ++i)
+        {
+        if (!active[i])
+          continue;
+
+        MeshRequirementsIterator mit =
+          this->Internals->Fetch[i].GetMeshRequirementsIterator();
+
+        for (; mit; ++mit)
+          {
+          ArrayRequirementsIterator ait =
+            this->Internals->Fetch[i].GetArrayRequirementsIterator(mit.MeshName());
+
+          for (; ait; ++ait)
+            fetch.AddRequirement(mit.MeshName(), ait.Association(), ait.Array());
+          }
+        }
+
+      if (this->Internals->Cache->Prefetch(fetch))
+        {
+        SENSEI_WARNING("Failed to prefetch the data required by the"
+          " configured analyses")
+        }
+      }
+    }
+
+  std::vector<double> elapsed(active.size(), 0.0);
+
   int ai = 0;
   AnalysisAdaptorVector::iterator iter = this->Internals->Analyses.begin();
   AnalysisAdaptorVector::iterator end = this->Internals->Analyses.end();
   for (; iter != end; ++iter, ++ai)
     {
+    if (!active[ai])
+      continue;
+
+    double startTime = MPI_Wtime();
+
     const char* analysisName = nullptr;
     bool logEnabled = Profiler::Enabled();
     if (logEnabled)
@@ -1236,7 +2392,7 @@ bool ConfigurableAnalysis::Execute(DataAdaptor* data)
       Profiler::StartEvent(analysisName);
       }
 
-    if (!(*iter)->Execute(data))
+    if (!(*iter)->Execute(dataAdaptor))
       {
       SENSEI_ERROR("Failed to execute " << (*iter)->GetClassName())
       MPI_Abort(this->GetCommunicator(), -1);
@@ -1244,6 +2400,26 @@ bool ConfigurableAnalysis::Execute(DataAdaptor* data)
 
     if (logEnabled)
       Profiler::EndEvent(analysisName);
+
+    elapsed[ai] = MPI_Wtime() - startTime;
+    }
+
+  this->Internals->UpdateTimeBudgets(this->GetCommunicator(), active, elapsed);
+
+  // the cached metadata and data are only valid for this time step.
+  // if any of the analyses asked to release the data it is done
+  // once now that all of them are finished with it.
+  if (dataAdaptor != data)
+    {
+    bool release = this->Internals->Cache->GetReleaseRequested();
+
+    this->Internals->Cache->SetDataAdaptor(nullptr);
+
+    if (release && data->ReleaseData())
+      {
+      SENSEI_ERROR("Failed to release data")
+      return false;
+      }
     }
 
   return true;
@@ -1277,6 +2453,8 @@ int ConfigurableAnalysis::Finalize()
       Profiler::EndEvent(analysisName);
     }
 
+  this->Internals->Cache = nullptr;
+
   return 0;
 }
 
@@ -28,9 +28,74 @@ public:
   int SetCommunicator(MPI_Comm comm) override;
 
   /// @brief Initialize the adaptor using the configuration specified.
+  ///
+  /// The following attributes of the root \<sensei\> element control startup
+  /// and execution:
+  ///
+  /// concurrent_startup -- when set to 1, the costly initializers that are
+  ///   thread safe run on a pool of threads while the other analyses are
+  ///   configured and initialized on the calling thread. These are the
+  ///   Autocorrelation's communicator setup and the creation of VTKPosthocIO's
+  ///   output directory. HDF5, ADIOS2, Catalyst, Libsim, Ascent, and Python
+  ///   set up library global state and are initialized on the calling thread.
+  ///   Since these dominate the cost of starting up, the startup time of most
+  ///   configurations is essentially unchanged. ADIOS2 transports open their
+  ///   streams during startup rather than in the first time step, which moves
+  ///   that cost out of the first time step but does not reduce it. Requires
+  ///   MPI_THREAD_MULTIPLE. The default is 0. The time taken to start up is
+  ///   reported, see GetStartupTime, so the benefit can be measured.
+  ///
+  /// startup_threads -- the number of threads used for concurrent startup.
+  ///   The default, 0, uses one per hardware thread.
+  ///
+  /// num_threads -- the number of threads the analyses use to process the
+  ///   blocks of a rank concurrently, see ThreadPool. 0 uses one per hardware
+  ///   thread. When not given the SENSEI_NUM_THREADS environment variable,
+  ///   or 1, is used.
+  ///
+  /// cache_plan -- when set to 1, the meshes and arrays each analysis reads
+  ///   are recorded during configuration and checked against the
+  ///   simulation's metadata in the first time step. Metadata queries made
+  ///   by the analyses during Execute are shared such that each is made once
+  ///   per time step. The default is 0.
+  ///
+  /// share_data -- when set to 1 and cache_plan is enabled, the union of the
+  ///   meshes and arrays the analyses read is fetched from the simulation
+  ///   once per time step and shared by reference among the analyses. Calls
+  ///   to ReleaseData made by the analyses are deferred until all of them
+  ///   have executed, at which point the data is released once. A mesh is
+  ///   fetched with its geometry unless every analysis that reads it sets
+  ///   structure_only to 1, on the \<analysis\> element when it is configured
+  ///   by attributes, or on its \<mesh\> elements. The default is 0.
+  ///
+  /// The following attributes of each \<analysis\> and \<transport\> element
+  /// control when it runs. Steps are those reported by the data adaptor's
+  /// GetDataTimeStep. Analyses that do not run in a step make no requests of
+  /// the simulation.
+  ///
+  /// frequency -- run every N steps counting from start_step. The default is
+  ///   1. Libsim interprets this attribute itself.
+  ///
+  /// start_step, stop_step -- the first and last step in which to run. The
+  ///   defaults are 0 and -1, which means that there is no last step.
+  ///
+  /// time_budget -- the number of seconds of wall time the analysis may use
+  ///   over the run. Once spent the analysis no longer runs. The default, -1,
+  ///   is no limit.
+  ///
+  /// trigger_above, trigger_below, trigger_change -- run only when the global
+  ///   maximum of an array is above the value, the global minimum is below the
+  ///   value, or either has changed by more than the value relative to the
+  ///   range at the last run. The array is given by trigger_mesh,
+  ///   trigger_array, and trigger_association, which default to the
+  ///   analysis' mesh, array, and association attributes. The magnitude of
+  ///   multi-component arrays is used.
   int Initialize(const std::string &filename);
   int Initialize(const pugi::xml_node &root);
 
+  /// @brief Get the wall time in seconds taken by Initialize on this rank.
+  double GetStartupTime() const;
+
   bool Execute(DataAdaptor *data) override;
 
   int Finalize() override;
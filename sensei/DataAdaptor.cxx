@@ -5,6 +5,7 @@
 
 #include <vtkDataObject.h>
 #include <vtkCompositeDataSet.h>
+#include <vtkOverlappingAMR.h>
 #include <vtkObjectFactory.h>
 
 #include <map>
@@ -24,6 +25,9 @@ struct DataAdaptor::InternalsType
   std::vector<MeshMetadataPtr> Metadata;
   double Time;
   long TimeStep;
+
+  // the nesting of AMR meshes, used to blank refined cells
+  std::map<std::string, VTKUtils::AMRNestingIndex> Nesting;
 };
 
 //----------------------------------------------------------------------------
@@ -120,8 +124,26 @@ int DataAdaptor::AddGhostNodesArray(vtkDataObject*, const std::string &)
 }
 
 //----------------------------------------------------------------------------
-int DataAdaptor::AddGhostCellsArray(vtkDataObject*, const std::string &)
+int DataAdaptor::AddGhostCellsArray(vtkDataObject *mesh,
+  const std::string &meshName)
 {
+  // AMR meshes are blanked where they are refined. the hierarchy is held
+  // by the mesh on every rank.
+  vtkOverlappingAMR *amr = dynamic_cast<vtkOverlappingAMR*>(mesh);
+  if (!amr)
+    return 0;
+
+  MeshMetadataPtr md = MeshMetadata::New();
+  md->MeshName = meshName;
+
+  if (VTKUtils::GetAMRMetadata(amr, md) ||
+    VTKUtils::AddAMRBlanking(amr, md, this->Internals->Nesting[meshName]))
+    {
+    SENSEI_ERROR("Failed to blank the refined cells of mesh \""
+      << meshName << "\"")
+    return -1;
+    }
+
   return 0;
 }
 
@@ -70,6 +70,8 @@ public:
   /// vtkCompositeDataSet subclass, passing \c structureOnly will still produce
   /// appropriate composite data hierarchy. The caller takes ownership of the
   /// returned mesh object, and will call Delete when it is no longer needed.
+  /// Implementations may share geometry and topology between the meshes they
+  /// return, but arrays added to one mesh must not appear in another.
   ///
   /// @param[in] meshName the name of the mesh to access (see GetMeshMetadata)
   /// @param[in] structureOnly When set to true (default; false) the returned mesh
@@ -99,6 +101,10 @@ public:
   /// @brief Adds ghost cells on the specified mesh. The array name must be set
   ///        to "vtkGhostType".
   ///
+  /// The default implementation blanks the refined cells of
+  /// vtkOverlappingAMR meshes, see VTKUtils::AddAMRBlanking, and does
+  /// nothing for other meshes.
+  ///
   /// @param[in] mesh the VTK object returned from GetMesh
   /// @param[in] meshName the name of the mesh to access (see GetMeshMetadata)
   /// @returns zero if successful, non zero if an error occurred
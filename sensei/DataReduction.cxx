@@ -0,0 +1,105 @@
+#include "DataReduction.h"
+#include "SubsetDataAdaptor.h"
+#include "DataAdaptor.h"
+#include "Profiler.h"
+#include "Error.h"
+
+#include <vtkObjectFactory.h>
+#include <vtkSmartPointer.h>
+
+namespace sensei
+{
+
+struct DataReduction::InternalsType
+{
+  InternalsType() : Analysis(),
+    Adaptor(vtkSmartPointer<SubsetDataAdaptor>::New()) {}
+
+  vtkSmartPointer<AnalysisAdaptor> Analysis;
+  vtkSmartPointer<SubsetDataAdaptor> Adaptor;
+};
+
+//-----------------------------------------------------------------------------
+senseiNewMacro(DataReduction);
+
+//-----------------------------------------------------------------------------
+DataReduction::DataReduction() : Internals(nullptr)
+{
+  this->Internals = new InternalsType;
+}
+
+//-----------------------------------------------------------------------------
+DataReduction::~DataReduction()
+{
+  delete this->Internals;
+}
+
+//-----------------------------------------------------------------------------
+void DataReduction::SetAnalysis(AnalysisAdaptor *analysis)
+{
+  this->Internals->Analysis = analysis;
+}
+
+//-----------------------------------------------------------------------------
+AnalysisAdaptor *DataReduction::GetAnalysis()
+{
+  return this->Internals->Analysis.GetPointer();
+}
+
+//-----------------------------------------------------------------------------
+int DataReduction::SetStride(const std::array<int,3> &stride)
+{
+  return this->Internals->Adaptor->SetStride(stride);
+}
+
+//-----------------------------------------------------------------------------
+int DataReduction::SetRegion(const std::array<int,6> &region)
+{
+  return this->Internals->Adaptor->SetRegion(region);
+}
+
+//-----------------------------------------------------------------------------
+int DataReduction::SetPrecision(int precision)
+{
+  return this->Internals->Adaptor->SetPrecision(precision);
+}
+
+//-----------------------------------------------------------------------------
+int DataReduction::SetPrecision(std::string precision)
+{
+  return this->Internals->Adaptor->SetPrecision(precision);
+}
+
+//-----------------------------------------------------------------------------
+bool DataReduction::Execute(DataAdaptor *dataAdaptor)
+{
+  TimeEvent<128> mark("DataReduction::Execute");
+
+  if (!this->Internals->Analysis)
+    {
+    SENSEI_ERROR("No analysis to run was set")
+    return false;
+    }
+
+  SubsetDataAdaptor *subset = this->Internals->Adaptor;
+  subset->SetDataAdaptor(dataAdaptor);
+
+  bool ok = this->Internals->Analysis->Execute(subset);
+
+  // release the source meshes, the simulation's data is released by the
+  // caller
+  subset->SetDataAdaptor(nullptr);
+
+  return ok;
+}
+
+//-----------------------------------------------------------------------------
+int DataReduction::Finalize()
+{
+  if (!this->Internals->Analysis)
+    return 0;
+
+  return this->Internals->Analysis->Finalize();
+}
+
+}
@@ -0,0 +1,63 @@
+#ifndef sensei_DataReduction_h
+#define sensei_DataReduction_h
+
+#include "AnalysisAdaptor.h"
+
+#include <array>
+#include <string>
+
+namespace sensei
+{
+class DataAdaptor;
+
+/// @class DataReduction
+/// @brief Runs another analysis adaptor, typically a transport, on a reduced
+/// copy of the simulation's data
+///
+/// Execute passes the wrapped adaptor a SubsetDataAdaptor that subsamples
+/// image, rectilinear, and structured blocks, restricts them to a region of
+/// interest, and reduces the precision of floating point arrays. See
+/// SubsetDataAdaptor for the details. The defaults leave the data
+/// unchanged.
+class DataReduction : public AnalysisAdaptor
+{
+public:
+  static DataReduction *New();
+  senseiTypeMacro(DataReduction, AnalysisAdaptor);
+
+  /// @brief Set the adaptor to pass the reduced data to. It must be
+  /// initialized. A reference is held.
+  void SetAnalysis(AnalysisAdaptor *analysis);
+  AnalysisAdaptor *GetAnalysis();
+
+  /// @brief Set the number of points to advance in the i, j, and k
+  /// directions.
+  int SetStride(const std::array<int,3> &stride);
+
+  /// @brief Set the region of interest [i0,i1, j0,j1, k0,k1] in point
+  /// indices.
+  int SetRegion(const std::array<int,6> &region);
+
+  /// @brief Set the precision of floating point arrays. The string form
+  /// accepts "native", "float32", and "float16".
+  int SetPrecision(int precision);
+  int SetPrecision(std::string precision);
+
+  // SENSEI API
+  bool Execute(DataAdaptor *data) override;
+  int Finalize() override;
+
+protected:
+  DataReduction();
+  ~DataReduction();
+
+  DataReduction(const DataReduction&) = delete;
+  void operator=(const DataReduction&) = delete;
+
+  struct InternalsType;
+  InternalsType *Internals;
+};
+
+}
+
+#endif
@@ -0,0 +1,796 @@
+#include "DescriptiveStatistics.h"
+#include "BinaryStream.h"
+#include "DataAdaptor.h"
+#include "MeshMetadata.h"
+#include "MeshMetadataMap.h"
+#include "Profiler.h"
+#include "VTKUtils.h"
+#include "Error.h"
+
+#include <vtkDataArray.h>
+#include <vtkDataObject.h>
+#include <vtkDataSet.h>
+#include <vtkDataSetAttributes.h>
+#include <vtkFieldData.h>
+#include <vtkObjectFactory.h>
+#include <vtkSmartPointer.h>
+#include <vtkUnsignedCharArray.h>
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+#include <vector>
+
+namespace sensei
+{
+
+// the layout of the packed statistics of one component. the moments are
+// the count, the mean, and the sums of the 2nd, 3rd and 4th powers of the
+// differences from the mean. extrema are followed by their location, the
+// rank, block, index, and coordinates.
+enum
+{
+  REC_COUNT = 0, REC_MEAN, REC_M2, REC_M3, REC_M4,
+  REC_MIN, REC_MIN_RANK, REC_MIN_BLOCK, REC_MIN_INDEX, REC_MIN_X,
+  REC_MAX = REC_MIN_X + 3, REC_MAX_RANK, REC_MAX_BLOCK, REC_MAX_INDEX, REC_MAX_X,
+  REC_SIZE = REC_MAX_X + 3
+};
+
+// values are processed in chunks of this size. a chunk is small enough to
+// stay in cache while its moments are computed.
+static const int ChunkSize = 1024;
+
+//-----------------------------------------------------------------------------
+static const char *getGhostArrayName()
+{
+#if VTK_MAJOR_VERSION == 6 && VTK_MINOR_VERSION == 1
+  return "vtkGhostType";
+#else
+  return vtkDataSetAttributes::GhostArrayName();
+#endif
+}
+
+//-----------------------------------------------------------------------------
+static void initRecord(double *rec)
+{
+  std::fill(rec, rec + REC_SIZE, 0.0);
+
+  rec[REC_MIN] = std::numeric_limits<double>::max();
+  rec[REC_MAX] = std::numeric_limits<double>::lowest();
+
+  for (int i = 0; i < 3; ++i)
+    {
+    rec[REC_MIN_X + i] = std::numeric_limits<double>::quiet_NaN();
+    rec[REC_MAX_X + i] = std::numeric_limits<double>::quiet_NaN();
+    }
+}
+
+//-----------------------------------------------------------------------------
+// combine the moments of b into a, using the pairwise update of Chan, Golub
+// and LeVeque extended to the 3rd and 4th moments by Pebay.
+static void mergeMoments(double *a, const double *b)
+{
+  double nb = b[REC_COUNT];
+  if (nb == 0.0)
+    return;
+
+  double na = a[REC_COUNT];
+  if (na == 0.0)
+    {
+    std::copy(b, b + REC_MIN, a);
+    return;
+    }
+
+  double n = na + nb;
+  double d = b[REC_MEAN] - a[REC_MEAN];
+  double dn = d/n;
+  double dn2 = dn*dn;
+  double nab = na*nb;
+
+  double m2a = a[REC_M2];
+  double m2b = b[REC_M2];
+  double m3a = a[REC_M3];
+  double m3b = b[REC_M3];
+
+  a[REC_M4] += b[REC_M4] + d*dn*dn2*nab*(na*na - nab + nb*nb)
+    + 6.0*dn2*(na*na*m2b + nb*nb*m2a) + 4.0*dn*(na*m3b - nb*m3a);
+
+  a[REC_M3] += m3b + d*dn2*nab*(na - nb) + 3.0*dn*(na*m2b - nb*m2a);
+
+  a[REC_M2] += m2b + d*dn*nab;
+
+  a[REC_MEAN] += nb*dn;
+  a[REC_COUNT] = n;
+}
+
+//-----------------------------------------------------------------------------
+// true if the extremum at b should replace the one at a. ties are broken by
+// location so that the result does not depend on the order of the merge.
+static bool replaceExtremum(const double *a, const double *b, bool isMin)
+{
+  if (isMin ? (b[0] < a[0]) : (b[0] > a[0]))
+    return true;
+
+  if (b[0] != a[0])
+    return false;
+
+  return std::lexicographical_compare(b + 1, b + 4, a + 1, a + 4);
+}
+
+//-----------------------------------------------------------------------------
+static void mergeRecords(double *a, const double *b)
+{
+  if (b[REC_COUNT] == 0.0)
+    return;
+
+  if ((a[REC_COUNT] == 0.0) || replaceExtremum(a + REC_MIN, b + REC_MIN, true))
+    std::copy(b + REC_MIN, b + REC_MAX, a + REC_MIN);
+
+  if ((a[REC_COUNT] == 0.0) || replaceExtremum(a + REC_MAX, b + REC_MAX, false))
+    std::copy(b + REC_MAX, b + REC_SIZE, a + REC_MAX);
+
+  mergeMoments(a, b);
+}
+
+//-----------------------------------------------------------------------------
+// the reduction operator, records are passed whole as they are described
+// by a contiguous datatype
+static void mergeRecordsOp(void *invec, void *inoutvec, int *len,
+  MPI_Datatype *)
+{
+  const double *in = static_cast<const double*>(invec);
+  double *inout = static_cast<double*>(inoutvec);
+
+  int n = *len;
+  for (int i = 0; i < n; ++i)
+    mergeRecords(inout + i*REC_SIZE, in + i*REC_SIZE);
+}
+
+//-----------------------------------------------------------------------------
+// compute the count, mean, and central moments of a chunk of contiguous
+// values. the sums are split into independent lanes so that the loops
+// vectorize.
+static void chunkMoments(const double *vals, int n, double *moments)
+{
+  double s[4] = {0.0, 0.0, 0.0, 0.0};
+
+  int n4 = n - n % 4;
+  for (int i = 0; i < n4; i += 4)
+    {
+    s[0] += vals[i];
+    s[1] += vals[i + 1];
+    s[2] += vals[i + 2];
+    s[3] += vals[i + 3];
+    }
+
+  for (int i = n4; i < n; ++i)
+    s[0] += vals[i];
+
+  double mean = ((s[0] + s[1]) + (s[2] + s[3]))/n;
+
+  double m2[4] = {0.0, 0.0, 0.0, 0.0};
+  double m3[4] = {0.0, 0.0, 0.0, 0.0};
+  double m4[4] = {0.0, 0.0, 0.0, 0.0};
+
+  for (int i = 0; i < n4; i += 4)
+    {
+    for (int j = 0; j < 4; ++j)
+      {
+      double d = vals[i + j] - mean;
+      double d2 = d*d;
+      m2[j] += d2;
+      m3[j] += d2*d;
+      m4[j] += d2*d2;
+      }
+    }
+
+  for (int i = n4; i < n; ++i)
+    {
+    double d = vals[i] - mean;
+    double d2 = d*d;
+    m2[0] += d2;
+    m3[0] += d2*d;
+    m4[0] += d2*d2;
+    }
+
+  moments[REC_COUNT] = n;
+  moments[REC_MEAN] = mean;
+  moments[REC_M2] = (m2[0] + m2[1]) + (m2[2] + m2[3]);
+  moments[REC_M3] = (m3[0] + m3[1]) + (m3[2] + m3[3]);
+  moments[REC_M4] = (m4[0] + m4[1]) + (m4[2] + m4[3]);
+}
+
+//-----------------------------------------------------------------------------
+// accumulate the statistics of one component of a block's array in a
+// single pass. ghost and NaN values are skipped. the index of the min and
+// max are stored in place of their location.
+template <typename T>
+void accumulate(const T *data, int nComps, int comp, vtkIdType nTuples,
+  const unsigned char *ghosts, double *rec)
+{
+  double vals[ChunkSize];
+  double moments[REC_MIN];
+
+  double vmin = rec[REC_MIN];
+  double vmax = rec[REC_MAX];
+  vtkIdType imin = -1;
+  vtkIdType imax = -1;
+
+  vtkIdType i = 0;
+  while (i < nTuples)
+    {
+    int n = 0;
+    for (; (i < nTuples) && (n < ChunkSize); ++i)
+      {
+      double val = static_cast<double>(data[i*nComps + comp]);
+
+      if ((ghosts && ghosts[i]) || std::isnan(val))
+        continue;
+
+      if (val < vmin)
+        {
+        vmin = val;
+        imin = i;
+        }
+
+      if (val > vmax)
+        {
+        vmax = val;
+        imax = i;
+        }
+
+      vals[n] = val;
+      ++n;
+      }
+
+    if (n)
+      {
+      chunkMoments(vals, n, moments);
+      mergeMoments(rec, moments);
+      }
+    }
+
+  if (imin >= 0)
+    {
+    rec[REC_MIN] = vmin;
+    rec[REC_MIN_INDEX] = imin;
+    }
+
+  if (imax >= 0)
+    {
+    rec[REC_MAX] = vmax;
+    rec[REC_MAX_INDEX] = imax;
+    }
+}
+
+//-----------------------------------------------------------------------------
+// get the coordinates of a point or the center of a cell
+static void getLocation(vtkDataSet *ds, int association, vtkIdType id,
+  double *x)
+{
+  if ((association == vtkDataObject::POINT) && (id < ds->GetNumberOfPoints()))
+    {
+    ds->GetPoint(id, x);
+    }
+  else if ((association == vtkDataObject::CELL) && ds->GetNumberOfPoints() &&
+    (id < ds->GetNumberOfCells()))
+    {
+    double bounds[6];
+    ds->GetCellBounds(id, bounds);
+    x[0] = 0.5*(bounds[0] + bounds[1]);
+    x[1] = 0.5*(bounds[2] + bounds[3]);
+    x[2] = 0.5*(bounds[4] + bounds[5]);
+    }
+}
+
+//-----------------------------------------------------------------------------
+static void unpackStatistics(const double *rec, DescriptiveStatistics::Statistics &stats)
+{
+  double n = rec[REC_COUNT];
+  double m2 = rec[REC_M2];
+
+  stats.Count = n;
+  if (n > 0.0)
+    {
+    stats.Mean = rec[REC_MEAN];
+    stats.Variance = m2/n;
+    stats.Skewness = m2 > 0.0 ? std::sqrt(n)*rec[REC_M3]/std::pow(m2, 1.5) : 0.0;
+    stats.Kurtosis = m2 > 0.0 ? n*rec[REC_M4]/(m2*m2) - 3.0 : 0.0;
+    stats.Min = rec[REC_MIN];
+    stats.Max = rec[REC_MAX];
+    }
+  else
+    {
+    double nan = std::numeric_limits<double>::quiet_NaN();
+    stats.Mean = stats.Variance = stats.Skewness = stats.Kurtosis = nan;
+    stats.Min = stats.Max = nan;
+    }
+
+  stats.MinRank = rec[REC_MIN_RANK];
+  stats.MinBlock = rec[REC_MIN_BLOCK];
+  stats.MinIndex = rec[REC_MIN_INDEX];
+
+  stats.MaxRank = rec[REC_MAX_RANK];
+  stats.MaxBlock = rec[REC_MAX_BLOCK];
+  stats.MaxIndex = rec[REC_MAX_INDEX];
+
+  for (int i = 0; i < 3; ++i)
+    {
+    stats.MinLocation[i] = rec[REC_MIN_X + i];
+    stats.MaxLocation[i] = rec[REC_MAX_X + i];
+    }
+}
+
+//-----------------------------------------------------------------------------
+struct DescriptiveStatistics::InternalsType
+{
+  InternalsType() : Format(DescriptiveStatistics::FORMAT_CSV),
+    RecordType(MPI_DATATYPE_NULL), MergeOp(MPI_OP_NULL) {}
+
+  // create the datatype and operator used in the reduction
+  void InitializeMPI();
+  void FinalizeMPI();
+
+  // append the results to the log on rank 0
+  int WriteLog(long step, double time);
+
+  DataRequirements Requirements;
+  std::string FileName;
+  int Format;
+  std::ofstream Log;
+  MPI_Datatype RecordType;
+  MPI_Op MergeOp;
+  std::vector<DescriptiveStatistics::Statistics> Results;
+};
+
+//-----------------------------------------------------------------------------
+void DescriptiveStatistics::InternalsType::InitializeMPI()
+{
+  if (this->RecordType != MPI_DATATYPE_NULL)
+    return;
+
+  MPI_Type_contiguous(REC_SIZE, MPI_DOUBLE, &this->RecordType);
+  MPI_Type_commit(&this->RecordType);
+
+  MPI_Op_create(mergeRecordsOp, 1, &this->MergeOp);
+}
+
+//-----------------------------------------------------------------------------
+void DescriptiveStatistics::InternalsType::FinalizeMPI()
+{
+  int finalized = 0;
+  MPI_Finalized(&finalized);
+
+  if (!finalized && (this->RecordType != MPI_DATATYPE_NULL))
+    {
+    MPI_Type_free(&this->RecordType);
+    MPI_Op_free(&this->MergeOp);
+    }
+
+  this->RecordType = MPI_DATATYPE_NULL;
+  this->MergeOp = MPI_OP_NULL;
+}
+
+//-----------------------------------------------------------------------------
+int DescriptiveStatistics::InternalsType::WriteLog(long step, double time)
+{
+  if (this->FileName.empty())
+    return 0;
+
+  bool binary = this->Format == DescriptiveStatistics::FORMAT_BINARY;
+
+  if (!this->Log.is_open())
+    {
+    this->Log.open(this->FileName.c_str(), binary ?
+      std::ios::out | std::ios::binary : std::ios::out);
+
+    if (!this->Log.good())
+      {
+      SENSEI_ERROR("Failed to open \"" << this->FileName << "\"")
+      return -1;
+      }
+
+    if (!binary)
+      {
+      this->Log << "step,time,mesh,association,array,component,count,"
+        "mean,variance,skewness,kurtosis,min,min_rank,min_block,min_index,"
+        "min_x,min_y,min_z,max,max_rank,max_block,max_index,"
+        "max_x,max_y,max_z" << std::endl;
+      }
+    }
+
+  unsigned int nResults = this->Results.size();
+
+  if (binary)
+    {
+    BinaryStream bs;
+    bs.Pack(step);
+    bs.Pack(time);
+    bs.Pack(nResults);
+
+    for (unsigned int i = 0; i < nResults; ++i)
+      {
+      const DescriptiveStatistics::Statistics &stats = this->Results[i];
+
+      std::ostringstream name;
+      name << stats.MeshName << "/" << VTKUtils::GetAttributesName(stats.Association)
+        << "/" << stats.ArrayName << "/" << stats.Component;
+
+      bs.Pack(name.str());
+      bs.Pack(stats.Count);
+      bs.Pack(stats.Mean);
+      bs.Pack(stats.Variance);
+      bs.Pack(stats.Skewness);
+      bs.Pack(stats.Kurtosis);
+      bs.Pack(stats.Min);
+      bs.Pack(stats.MinRank);
+      bs.Pack(stats.MinBlock);
+      bs.Pack(stats.MinIndex);
+      bs.Pack(stats.MinLocation, 3);
+      bs.Pack(stats.Max);
+      bs.Pack(stats.MaxRank);
+      bs.Pack(stats.MaxBlock);
+      bs.Pack(stats.MaxIndex);
+      bs.Pack(stats.MaxLocation, 3);
+      }
+
+    this->Log.write(reinterpret_cast<const char*>(bs.GetData()), bs.Size());
+    }
+  else
+    {
+    this->Log << std::setprecision(std::numeric_limits<double>::digits10 + 2);
+    for (unsigned int i = 0; i < nResults; ++i)
+      {
+      const DescriptiveStatistics::Statistics &stats = this->Results[i];
+
+      this->Log << step << "," << time << "," << stats.MeshName << ","
+        << VTKUtils::GetAttributesName(stats.Association) << ","
+        << stats.ArrayName << "," << stats.Component << ","
+        << stats.Count << "," << stats.Mean << "," << stats.Variance << ","
+        << stats.Skewness << "," << stats.Kurtosis << ","
+        << stats.Min << "," << stats.MinRank << "," << stats.MinBlock << ","
+        << stats.MinIndex << "," << stats.MinLocation[0] << ","
+        << stats.MinLocation[1] << "," << stats.MinLocation[2] << ","
+        << stats.Max << "," << stats.MaxRank << "," << stats.MaxBlock << ","
+        << stats.MaxIndex << "," << stats.MaxLocation[0] << ","
+        << stats.MaxLocation[1] << "," << stats.MaxLocation[2] << std::endl;
+      }
+    }
+
+  this->Log.flush();
+
+  if (!this->Log.good())
+    {
+    SENSEI_ERROR("Failed to write \"" << this->FileName << "\"")
+    return -1;
+    }
+
+  return 0;
+}
+
+//-----------------------------------------------------------------------------
+senseiNewMacro(DescriptiveStatistics);
+
+//-----------------------------------------------------------------------------
+DescriptiveStatistics::DescriptiveStatistics() : Internals(new InternalsType)
+{
+}
+
+//-----------------------------------------------------------------------------
+DescriptiveStatistics::~DescriptiveStatistics()
+{
+  this->Internals->FinalizeMPI();
+  delete this->Internals;
+}
+
+//-----------------------------------------------------------------------------
+int DescriptiveStatistics::SetDataRequirements(const DataRequirements &reqs)
+{
+  this->Internals->Requirements = reqs;
+  return 0;
+}
+
+//-----------------------------------------------------------------------------
+void DescriptiveStatistics::SetFileName(const std::string &fileName)
+{
+  this->Internals->FileName = fileName;
+}
+
+//-----------------------------------------------------------------------------
+int DescriptiveStatistics::SetFormat(int format)
+{
+  if ((format != FORMAT_CSV) && (format != FORMAT_BINARY))
+    {
+    SENSEI_ERROR("Invalid format " << format)
+    return -1;
+    }
+
+  this->Internals->Format = format;
+  return 0;
+}
+
+//-----------------------------------------------------------------------------
+int DescriptiveStatistics::SetFormat(const std::string &format)
+{
+  if (format == "csv")
+    return this->SetFormat(FORMAT_CSV);
+
+  if (format == "binary")
+    return this->SetFormat(FORMAT_BINARY);
+
+  SENSEI_ERROR("Invalid format \"" << format << "\". Use csv or binary")
+  return -1;
+}
+
+//-----------------------------------------------------------------------------
+int DescriptiveStatistics::GetStatistics(std::vector<Statistics> &stats)
+{
+  stats = this->Internals->Results;
+  return 0;
+}
+
+//-----------------------------------------------------------------------------
+int DescriptiveStatistics::GetStatistics(const std::string &meshName,
+  int association, const std::string &arrayName, int component,
+  Statistics &stats)
+{
+  unsigned int nResults = this->Internals->Results.size();
+  for (unsigned int i = 0; i < nResults; ++i)
+    {
+    const Statistics &res = this->Internals->Results[i];
+    if ((res.MeshName == meshName) && (res.Association == association) &&
+      (res.ArrayName == arrayName) && (res.Component == component))
+      {
+      stats = res;
+      return 0;
+      }
+    }
+
+  SENSEI_ERROR("No statistics for component " << component << " of "
+    << VTKUtils::GetAttributesName(association) << " data array \""
+    << arrayName << "\" on mesh \"" << meshName << "\"")
+  return -1;
+}
+
+//-----------------------------------------------------------------------------
+bool DescriptiveStatistics::Execute(DataAdaptor* data)
+{
+  TimeEvent<128> mark("DescriptiveStatistics::Execute");
+
+  MPI_Comm comm = this->GetCommunicator();
+
+  int rank = 0;
+  MPI_Comm_rank(comm, &rank);
+
+  this->Internals->Results.clear();
+
+  // see what the simulation is providing
+  MeshMetadataMap mdMap;
+  if (mdMap.Initialize(data))
+    {
+    SENSEI_ERROR("Failed to get metadata")
+    return false;
+    }
+
+  // when no arrays are named use everything
+  DataRequirements reqs = this->Internals->Requirements;
+  if (reqs.Empty() && reqs.Initialize(data, false))
+    {
+    SENSEI_ERROR("Failed to initialze the data description")
+    return false;
+    }
+
+  // the packed statistics of every component of every array, and a
+  // description of each. these must be the same on all ranks, so the
+  // number of components is taken from the metadata.
+  std::vector<double> records;
+  std::vector<Statistics> &results = this->Internals->Results;
+
+  int retVal = 0;
+
+  MeshRequirementsIterator mit = reqs.GetMeshRequirementsIterator();
+  for (; mit; ++mit)
+    {
+    const std::string &meshName = mit.MeshName();
+
+    MeshMetadataPtr mmd;
+    if (mdMap.GetMeshMetadata(meshName, mmd))
+      {
+      SENSEI_ERROR("Failed to get metadata for mesh \"" << meshName << "\"")
+      return false;
+      }
+
+    // get the mesh, it is not an error for a rank to have no data
+    vtkDataObject *dobj = nullptr;
+    if (data->GetMesh(meshName, mit.StructureOnly(), dobj))
+      {
+      SENSEI_ERROR("Failed to get mesh \"" << meshName << "\"")
+      retVal = -1;
+      }
+
+    vtkSmartPointer<vtkDataObject> mesh;
+    mesh.TakeReference(dobj);
+
+    // add the ghost zones
+    if (mesh && (mmd->NumGhostCells || VTKUtils::AMR(mmd)) &&
+      data->AddGhostCellsArray(mesh, meshName))
+      {
+      SENSEI_ERROR(<< data->GetClassName() << " failed to add ghost cells.")
+      retVal = -1;
+      }
+
+    if (mesh && mmd->NumGhostNodes && data->AddGhostNodesArray(mesh, meshName))
+      {
+      SENSEI_ERROR(<< data->GetClassName() << " failed to add ghost nodes.")
+      retVal = -1;
+      }
+
+    ArrayRequirementsIterator ait = reqs.GetArrayRequirementsIterator(meshName);
+    for (; ait; ++ait)
+      {
+      int association = ait.Association();
+      const std::string &arrayName = ait.Array();
+
+      // ghost arrays are used as masks
+      if (arrayName == getGhostArrayName())
+        continue;
+
+      // find the number of components
+      int nComps = 0;
+      unsigned int nArrays = mmd->ArrayName.size();
+      for (unsigned int i = 0; i < nArrays; ++i)
+        {
+        if ((mmd->ArrayName[i] == arrayName) &&
+          (mmd->ArrayCentering[i] == association))
+          {
+          nComps = mmd->ArrayComponents[i];
+          break;
+          }
+        }
+
+      if (nComps < 1)
+        {
+        SENSEI_ERROR("No " << VTKUtils::GetAttributesName(association)
+          << " data array \"" << arrayName << "\" on mesh \""
+          << meshName << "\"")
+        return false;
+        }
+
+      size_t first = records.size();
+      records.resize(first + nComps*REC_SIZE);
+
+      for (int j = 0; j < nComps; ++j)
+        {
+        initRecord(records.data() + first + j*REC_SIZE);
+
+        Statistics stats;
+        stats.MeshName = meshName;
+        stats.Association = association;
+        stats.ArrayName = arrayName;
+        stats.Component = j;
+        results.push_back(stats);
+        }
+
+      if (!mesh)
+        continue;
+
+      if (data->AddArray(mesh, meshName, association, arrayName))
+        {
+        SENSEI_ERROR(<< data->GetClassName() << " failed to add "
+          << VTKUtils::GetAttributesName(association) << " data array \""
+          << arrayName << "\"")
+        retVal = -1;
+        continue;
+        }
+
+      // accumulate the local blocks
+      long blockId = -1;
+      VTKUtils::DatasetFunction func = [&](vtkDataSet *ds) -> int
+        {
+        ++blockId;
+
+        vtkFieldData *atts = association == vtkDataObject::FIELD ?
+          ds->GetFieldData() : VTKUtils::GetAttributes(ds, association);
+
+        vtkDataArray *array = atts ? atts->GetArray(arrayName.c_str()) : nullptr;
+
+        // not every block need have the array
+        if (!array)
+          return 0;
+
+        if (array->GetNumberOfComponents() != nComps)
+          {
+          SENSEI_ERROR("Block " << blockId << " of \"" << arrayName
+            << "\" has " << array->GetNumberOfComponents()
+            << " components, expected " << nComps)
+          return -1;
+          }
+
+        vtkIdType nTuples = array->GetNumberOfTuples();
+
+        // skip ghost cells and nodes
+        vtkUnsignedCharArray *ghostArray = association == vtkDataObject::FIELD ?
+          nullptr : dynamic_cast<vtkUnsignedCharArray*>(
+            atts->GetArray(getGhostArrayName()));
+
+        const unsigned char *ghosts = ghostArray &&
+          (ghostArray->GetNumberOfTuples() == nTuples) ?
+          ghostArray->GetPointer(0) : nullptr;
+
+        for (int j = 0; j < nComps; ++j)
+          {
+          double rec[REC_SIZE];
+          initRecord(rec);
+
+          switch (array->GetDataType())
+            {
+            vtkTemplateMacro(
+              accumulate(static_cast<VTK_TT*>(array->GetVoidPointer(0)),
+                nComps, j, nTuples, ghosts, rec);
+              );
+            default:
+              SENSEI_ERROR("Unsupported array type " << array->GetClassName())
+              return -1;
+            }
+
+          if (rec[REC_COUNT] == 0.0)
+            continue;
+
+          // locate the extrema
+          rec[REC_MIN_RANK] = rank;
+          rec[REC_MIN_BLOCK] = blockId;
+          getLocation(ds, association, rec[REC_MIN_INDEX], rec + REC_MIN_X);
+
+          rec[REC_MAX_RANK] = rank;
+          rec[REC_MAX_BLOCK] = blockId;
+          getLocation(ds, association, rec[REC_MAX_INDEX], rec + REC_MAX_X);
+
+          mergeRecords(records.data() + first + j*REC_SIZE, rec);
+          }
+
+        return 0;
+        };
+
+      if (VTKUtils::Apply(mesh, func) < 0)
+        {
+        SENSEI_ERROR("Failed to compute statistics of "
+          << VTKUtils::GetAttributesName(association) << " data array \""
+          << arrayName << "\" on mesh \"" << meshName << "\"")
+        retVal = -1;
+        }
+      }
+    }
+
+  // combine the results of all arrays across ranks
+  this->Internals->InitializeMPI();
+
+  int nRecords = records.size()/REC_SIZE;
+
+  MPI_Allreduce(MPI_IN_PLACE, records.data(), nRecords,
+    this->Internals->RecordType, this->Internals->MergeOp, comm);
+
+  for (int i = 0; i < nRecords; ++i)
+    unpackStatistics(records.data() + i*REC_SIZE, results[i]);
+
+  if ((rank == 0) && this->Internals->WriteLog(data->GetDataTimeStep(),
+    data->GetDataTime()))
+    retVal = -1;
+
+  return retVal == 0;
+}
+
+//-----------------------------------------------------------------------------
+int DescriptiveStatistics::Finalize()
+{
+  this->Internals->FinalizeMPI();
+
+  if (this->Internals->Log.is_open())
+    this->Internals->Log.close();
+
+  return 0;
+}
+
+}
@@ -0,0 +1,104 @@
+#ifndef sensei_DescriptiveStatistics_h
+#define sensei_DescriptiveStatistics_h
+
+#include "AnalysisAdaptor.h"
+#include "DataRequirements.h"
+
+#include <mpi.h>
+#include <string>
+#include <vector>
+
+namespace sensei
+{
+
+/// @class DescriptiveStatistics
+/// @brief Computes moments and extrema of a set of arrays
+///
+/// For each component of each array named in the data requirements the count,
+/// mean, variance, skewness, kurtosis, minimum and maximum are computed along
+/// with the location of the minimum and maximum. Ghost cells and nodes are
+/// skipped. Each rank makes a single pass over its data, accumulating central
+/// moments with the numerically stable pairwise update of Chan and Pebay, and
+/// the results of all arrays are combined across ranks with one
+/// MPI_Allreduce. When no requirements are given every array the simulation
+/// provides is processed.
+///
+/// The results are available on all ranks through GetStatistics, and rank 0
+/// may append them to a CSV or binary log each step.
+class DescriptiveStatistics : public AnalysisAdaptor
+{
+public:
+  static DescriptiveStatistics *New();
+  senseiTypeMacro(DescriptiveStatistics, AnalysisAdaptor);
+
+  /// @brief Set the meshes and arrays to process.
+  int SetDataRequirements(const DataRequirements &reqs);
+
+  /// @brief Set the log file. No log is written when the name is empty,
+  /// the default.
+  void SetFileName(const std::string &fileName);
+
+  /// @brief Set the log format, FORMAT_CSV, the default, writes a header and
+  /// one row per component per step. FORMAT_BINARY writes, for each step, the
+  /// step, time, and number of results followed by, for each result, the
+  /// name (mesh/association/array/component) and the packed statistics.
+  enum { FORMAT_CSV = 0, FORMAT_BINARY = 1 };
+  int SetFormat(int format);
+  int SetFormat(const std::string &format);
+
+  /// @brief The statistics of one component of an array. The variance is
+  /// the population variance and the kurtosis is the excess kurtosis. The
+  /// location of an extremum is the rank and local block index holding it,
+  /// the index of the point or cell in that block, and the coordinates of
+  /// the point or cell center when the mesh geometry is available (NaN
+  /// otherwise).
+  struct Statistics
+    {
+    std::string MeshName;
+    int Association;
+    std::string ArrayName;
+    int Component;
+    unsigned long long Count;
+    double Mean;
+    double Variance;
+    double Skewness;
+    double Kurtosis;
+    double Min;
+    int MinRank;
+    long MinBlock;
+    long long MinIndex;
+    double MinLocation[3];
+    double Max;
+    int MaxRank;
+    long MaxBlock;
+    long long MaxIndex;
+    double MaxLocation[3];
+    };
+
+  /// @brief Get the statistics computed in the last call to Execute.
+  int GetStatistics(std::vector<Statistics> &stats);
+
+  /// @brief Get the statistics of one component of an array computed in the
+  /// last call to Execute. Returns non-zero if the array was not processed.
+  int GetStatistics(const std::string &meshName, int association,
+    const std::string &arrayName, int component, Statistics &stats);
+
+  bool Execute(DataAdaptor* data) override;
+
+  int Finalize() override;
+
+protected:
+  DescriptiveStatistics();
+  ~DescriptiveStatistics();
+
+  DescriptiveStatistics(const DescriptiveStatistics&) = delete;
+  void operator=(const DescriptiveStatistics&) = delete;
+
+private:
+  struct InternalsType;
+  InternalsType *Internals;
+};
+
+}
+
+#endif
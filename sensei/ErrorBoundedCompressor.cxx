@@ -0,0 +1,672 @@
+#include "ErrorBoundedCompressor.h"
+#include "VTKUtils.h"
+#include "XMLUtils.h"
+#include "Error.h"
+
+#include <vtkAbstractArray.h>
+#include <vtkDataObject.h>
+#include <vtkDataSet.h>
+#include <vtkImageData.h>
+#include <vtkRectilinearGrid.h>
+#include <vtkStructuredGrid.h>
+#include <vtkType.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#include <pugixml.hpp>
+
+namespace sensei
+{
+
+// every frame starts with a header of 72 bytes
+//
+//   0  magic "SEB1"
+//   4  the VTK type of the values
+//   5  the element size
+//   6  flags, FLAG_VERBATIM
+//   7  the bound mode of the writer
+//   8  the number of tuples (uint64)
+//  16  the number of components (uint64)
+//  24  the number of tuples in i, j, and k (3 x uint64)
+//  48  the absolute error bound (double)
+//  56  the number of values stored verbatim (uint64)
+//  64  the size of the packed codes in bytes (uint64)
+//
+// the packed codes follow, then the values stored verbatim. when
+// FLAG_VERBATIM is set the payload is the values as is.
+static const char Magic[4] = {'S', 'E', 'B', '1'};
+static const size_t HeaderSize = 72;
+
+enum { FLAG_VERBATIM = 0x1 };
+
+// codes are packed in groups of this many
+static const size_t GroupSize = 32;
+
+// limits on the grid coordinates and on the prediction residuals. the sum of
+// the Lorenzo predictor's seven terms is exact in 64 bits and the grid
+// coordinates convert to double exactly. residuals are coded in 32 bits.
+static const double MaxGrid = 1125899906842624.0; // 2^50
+static const int64_t MaxResidual = 1073741824;    // 2^30
+
+// --------------------------------------------------------------------------
+static inline
+uint32_t zigzag(int64_t r)
+{
+  return static_cast<uint32_t>(r < 0 ? -2*r - 1 : 2*r);
+}
+
+// --------------------------------------------------------------------------
+static inline
+int64_t unzigzag(uint32_t z)
+{
+  return (z & 1) ? -(int64_t(z) + 1)/2 : int64_t(z)/2;
+}
+
+// the coordinate of the nearest grid point, or one next to it. false if x
+// is not finite or too large
+template <typename T>
+bool gridIndex(T x, double invStep, int64_t &q)
+{
+  double g = double(x)*invStep;
+  if (!(std::fabs(g) < MaxGrid))
+    return false;
+
+  q = std::llround(g);
+  return true;
+}
+
+// the value at a grid point. the encoder and decoder must agree on this
+// bit for bit, it is a single rounding
+template <typename T>
+T reconstruct(int64_t q, double step)
+{
+  return static_cast<T>(double(q)*step);
+}
+
+// the sum of the already visited corners of the cube below tuple t
+static inline
+int64_t lorenzo(const int64_t *q, size_t t, size_t i, size_t j, size_t k,
+  size_t nx, size_t nxy)
+{
+  int64_t p = 0;
+  if (i)
+    p += q[t - 1];
+  if (j)
+    p += q[t - nx];
+  if (k)
+    p += q[t - nxy];
+  if (i && j)
+    p -= q[t - 1 - nx];
+  if (i && k)
+    p -= q[t - 1 - nxy];
+  if (j && k)
+    p -= q[t - nx - nxy];
+  if (i && j && k)
+    p += q[t - 1 - nx - nxy];
+  return p;
+}
+
+// code 0 marks a value stored verbatim, others are the zigzag of the
+// residual plus one. the codes of each component are contiguous.
+template <typename T>
+void quantize(const T *vals, size_t nTuples, unsigned int nComps,
+  const size_t *dims, double eb, std::vector<uint32_t> &codes,
+  std::vector<T> &verbatim)
+{
+  double step = 2.0*eb;
+  double invStep = 1.0/step;
+  size_t nx = dims[0];
+  size_t ny = dims[1];
+  size_t nz = dims[2];
+  size_t nxy = nx*ny;
+
+  std::vector<int64_t> q(nTuples);
+  codes.resize(nTuples*nComps);
+  verbatim.clear();
+
+  for (unsigned int c = 0; c < nComps; ++c)
+    {
+    uint32_t *code = codes.data() + c*nTuples;
+    size_t t = 0;
+    for (size_t k = 0; k < nz; ++k)
+      {
+      for (size_t j = 0; j < ny; ++j)
+        {
+        for (size_t i = 0; i < nx; ++i, ++t)
+          {
+          T x = vals[t*nComps + c];
+          int64_t pred = lorenzo(q.data(), t, i, j, k, nx, nxy);
+
+          int64_t qx = 0;
+          bool ok = gridIndex(x, invStep, qx);
+          int64_t r = qx - pred;
+
+          if (ok && (r > -MaxResidual) && (r < MaxResidual) &&
+            (std::fabs(double(reconstruct<T>(qx, step)) - double(x)) <= eb))
+            {
+            code[t] = zigzag(r) + 1;
+            }
+          else
+            {
+            code[t] = 0;
+            verbatim.push_back(x);
+            }
+
+          q[t] = qx;
+          }
+        }
+      }
+    }
+}
+
+// the inverse of quantize
+template <typename T>
+int dequantize(const uint32_t *codes, const unsigned char *verbatim,
+  size_t nVerbatim, size_t nTuples, unsigned int nComps, const size_t *dims,
+  double eb, T *vals)
+{
+  double step = 2.0*eb;
+  double invStep = 1.0/step;
+  size_t nx = dims[0];
+  size_t ny = dims[1];
+  size_t nz = dims[2];
+  size_t nxy = nx*ny;
+
+  std::vector<int64_t> q(nTuples);
+  size_t v = 0;
+
+  for (unsigned int c = 0; c < nComps; ++c)
+    {
+    const uint32_t *code = codes + c*nTuples;
+    size_t t = 0;
+    for (size_t k = 0; k < nz; ++k)
+      {
+      for (size_t j = 0; j < ny; ++j)
+        {
+        for (size_t i = 0; i < nx; ++i, ++t)
+          {
+          int64_t pred = lorenzo(q.data(), t, i, j, k, nx, nxy);
+
+          int64_t qx = 0;
+          T x;
+          if (code[t])
+            {
+            qx = pred + unzigzag(code[t] - 1);
+            if (!(std::fabs(double(qx)) < MaxGrid))
+              return -1;
+            x = reconstruct<T>(qx, step);
+            }
+          else
+            {
+            if (v == nVerbatim)
+              return -1;
+            memcpy(&x, verbatim + v*sizeof(T), sizeof(T));
+            ++v;
+            if (!gridIndex(x, invStep, qx))
+              qx = 0;
+            }
+
+          q[t] = qx;
+          vals[t*nComps + c] = x;
+          }
+        }
+      }
+    }
+
+  return v == nVerbatim ? 0 : -1;
+}
+
+// each group of codes is stored as a byte holding the number of bits per
+// code followed by the codes, least significant bits first. when a group
+// has no values stored verbatim GROUP_OFFSET is set in the byte and one is
+// subtracted from the codes, a group of exact predictions takes no bits.
+enum { GROUP_OFFSET = 0x80 };
+
+static
+void pack(const uint32_t *codes, size_t n, std::vector<unsigned char> &out)
+{
+  for (size_t g = 0; g < n; g += GroupSize)
+    {
+    size_t m = std::min(GroupSize, n - g);
+    const uint32_t *group = codes + g;
+
+    uint32_t off = 1;
+    for (size_t i = 0; (i < m) && off; ++i)
+      off = group[i] ? 1 : 0;
+
+    uint64_t all = 0;
+    for (size_t i = 0; i < m; ++i)
+      all |= group[i] - off;
+
+    unsigned int w = 0;
+    while (all >> w)
+      ++w;
+
+    out.push_back(static_cast<unsigned char>(w | (off ? GROUP_OFFSET : 0)));
+    if (!w)
+      continue;
+
+    uint64_t acc = 0;
+    unsigned int nb = 0;
+    for (size_t i = 0; i < m; ++i)
+      {
+      acc |= uint64_t(group[i] - off) << nb;
+      nb += w;
+      while (nb >= 8)
+        {
+        out.push_back(static_cast<unsigned char>(acc));
+        acc >>= 8;
+        nb -= 8;
+        }
+      }
+
+    if (nb)
+      out.push_back(static_cast<unsigned char>(acc));
+    }
+}
+
+// --------------------------------------------------------------------------
+static
+int unpack(const unsigned char *in, size_t nIn, uint32_t *codes, size_t n)
+{
+  size_t p = 0;
+  for (size_t g = 0; g < n; g += GroupSize)
+    {
+    size_t m = std::min(GroupSize, n - g);
+    uint32_t *group = codes + g;
+
+    if (p >= nIn)
+      return -1;
+
+    uint32_t off = (in[p] & GROUP_OFFSET) ? 1 : 0;
+    unsigned int w = in[p++] & ~GROUP_OFFSET;
+    if (w > 32)
+      return -1;
+
+    size_t nBytes = (m*w + 7)/8;
+    if (nBytes > nIn - p)
+      return -1;
+
+    uint64_t mask = (uint64_t(1) << w) - 1;
+    uint64_t acc = 0;
+    unsigned int nb = 0;
+    for (size_t i = 0; i < m; ++i)
+      {
+      while (nb < w)
+        {
+        acc |= uint64_t(in[p++]) << nb;
+        nb += 8;
+        }
+      group[i] = static_cast<uint32_t>(acc & mask) + off;
+      acc >>= w;
+      nb -= w;
+      }
+    }
+
+  return p == nIn ? 0 : -1;
+}
+
+// true if the tuples fill the i, j, k layout, without overflow
+static
+bool validDimensions(const size_t *dims, size_t n)
+{
+  if (!dims[0] || !dims[1] || !dims[2])
+    return n == 0;
+
+  if (dims[1] > n/dims[0])
+    return false;
+
+  size_t nxy = dims[0]*dims[1];
+  return (n % nxy == 0) && (n/nxy == dims[2]);
+}
+
+// the bound in the units of the values, 0 when the values should be stored
+// verbatim
+template <typename T>
+double absoluteBound(const T *vals, size_t n, int mode, double bound)
+{
+  double eb = bound;
+  if (mode == ErrorBoundedCompressor::MODE_RELATIVE)
+    {
+    double lo = 0.0;
+    double hi = 0.0;
+    bool found = false;
+    for (size_t i = 0; i < n; ++i)
+      {
+      double x = vals[i];
+      if (!std::isfinite(x))
+        continue;
+      lo = found ? std::min(lo, x) : x;
+      hi = found ? std::max(hi, x) : x;
+      found = true;
+      }
+    eb = bound*(hi - lo);
+    }
+
+  return (std::isfinite(eb) && (eb > 0.0)) ? eb : 0.0;
+}
+
+// --------------------------------------------------------------------------
+template <typename T>
+void encode(const T *vals, size_t nTuples, unsigned int nComps,
+  const size_t *dims, int mode, double bound, double &eb,
+  size_t &nVerbatim, std::vector<unsigned char> &out)
+{
+  nVerbatim = 0;
+  eb = absoluteBound(vals, nTuples*nComps, mode, bound);
+  if (eb == 0.0)
+    return;
+
+  // scratch space, per thread so that arrays can be encoded concurrently
+  thread_local std::vector<uint32_t> codes;
+  thread_local std::vector<T> verbatim;
+
+  quantize(vals, nTuples, nComps, dims, eb, codes, verbatim);
+
+  pack(codes.data(), codes.size(), out);
+
+  size_t codeBytes = out.size() - HeaderSize;
+  out.resize(out.size() + verbatim.size()*sizeof(T));
+  if (!verbatim.empty())
+    memcpy(out.data() + HeaderSize + codeBytes, verbatim.data(),
+      verbatim.size()*sizeof(T));
+
+  nVerbatim = verbatim.size();
+}
+
+// --------------------------------------------------------------------------
+int ErrorBoundedCompressor::ParseMode(std::string modeStr, int &mode)
+{
+  unsigned int n = modeStr.size();
+  for (unsigned int i = 0; i < n; ++i)
+    modeStr[i] = tolower(modeStr[i]);
+
+  if (modeStr == "absolute")
+    {
+    mode = MODE_ABSOLUTE;
+    }
+  else if (modeStr == "relative")
+    {
+    mode = MODE_RELATIVE;
+    }
+  else
+    {
+    SENSEI_ERROR("Invalid error bound mode \"" << modeStr
+      << "\". Use one of absolute or relative")
+    return -1;
+    }
+
+  return 0;
+}
+
+// --------------------------------------------------------------------------
+int ErrorBoundedCompressor::SetErrorBound(const std::string &meshName,
+  int association, const std::string &arrayName, int mode, double bound)
+{
+  if ((mode != MODE_ABSOLUTE) && (mode != MODE_RELATIVE))
+    {
+    SENSEI_ERROR("Invalid error bound mode " << mode)
+    return -1;
+    }
+
+  if (!(bound >= 0.0))
+    {
+    SENSEI_ERROR("Invalid error bound " << bound << " for \""
+      << arrayName << "\"")
+    return -1;
+    }
+
+  if (arrayName.empty())
+    {
+    SENSEI_ERROR("An array name is required")
+    return -1;
+    }
+
+  this->Settings.push_back({meshName, association, arrayName, mode, bound});
+  return 0;
+}
+
+// --------------------------------------------------------------------------
+int ErrorBoundedCompressor::Initialize(pugi::xml_node &node)
+{
+  for (pugi::xml_node comp = node.child("compress"); comp;
+    comp = comp.next_sibling("compress"))
+    {
+    if (XMLUtils::RequireAttribute(comp, "array") ||
+      XMLUtils::RequireAttribute(comp, "error_bound"))
+      {
+      SENSEI_ERROR("Failed to initialize the ErrorBoundedCompressor")
+      return -1;
+      }
+
+    std::string arrayName = comp.attribute("array").value();
+    std::string meshName = comp.attribute("mesh").as_string("");
+    double bound = comp.attribute("error_bound").as_double(-1.0);
+
+    int association = -1;
+    pugi::xml_attribute assocAt = comp.attribute("association");
+    if (assocAt && VTKUtils::GetAssociation(assocAt.value(), association))
+      {
+      SENSEI_ERROR("Invalid association \"" << assocAt.value()
+        << "\" for array \"" << arrayName << "\"")
+      return -1;
+      }
+
+    int mode = MODE_RELATIVE;
+    if (ErrorBoundedCompressor::ParseMode(
+      comp.attribute("mode").as_string("relative"), mode) ||
+      this->SetErrorBound(meshName, association, arrayName, mode, bound))
+      return -1;
+
+    SENSEI_STATUS("Configured ErrorBoundedCompressor array=\"" << arrayName
+      << "\" mesh=\"" << meshName << "\" association="
+      << assocAt.as_string("any") << " mode="
+      << (mode == MODE_RELATIVE ? "relative" : "absolute")
+      << " error_bound=" << bound)
+    }
+
+  return 0;
+}
+
+// --------------------------------------------------------------------------
+bool ErrorBoundedCompressor::GetErrorBound(const std::string &meshName,
+  int association, const std::string &arrayName, int &mode,
+  double &bound) const
+{
+  unsigned int n = this->Settings.size();
+  for (unsigned int i = 0; i < n; ++i)
+    {
+    const Setting &s = this->Settings[i];
+    if ((s.ArrayName == arrayName) &&
+      (s.MeshName.empty() || (s.MeshName == meshName)) &&
+      ((s.Association < 0) || (s.Association == association)))
+      {
+      mode = s.Mode;
+      bound = s.Bound;
+      return true;
+      }
+    }
+
+  return false;
+}
+
+// --------------------------------------------------------------------------
+size_t ErrorBoundedCompressor::GetHeaderSize()
+{
+  return HeaderSize;
+}
+
+// --------------------------------------------------------------------------
+bool ErrorBoundedCompressor::IsEncoded(const unsigned char *in,
+  size_t inBytes)
+{
+  return (inBytes >= HeaderSize) && !memcmp(in, Magic, 4);
+}
+
+// --------------------------------------------------------------------------
+int ErrorBoundedCompressor::Encode(int type, const void *data,
+  size_t nTuples, unsigned int nComps, const size_t *dims, int mode,
+  double bound, std::vector<unsigned char> &out)
+{
+  size_t elemSize = vtkAbstractArray::GetDataTypeSize(type);
+  if (!elemSize || (elemSize > 8) || !nComps)
+    {
+    SENSEI_ERROR("Can't encode values of type " << type << " with "
+      << nComps << " components")
+    return -1;
+    }
+
+  // without structure the tuples are a single row
+  size_t ijk[3] = {nTuples, 1, 1};
+  if (dims && validDimensions(dims, nTuples))
+    {
+    ijk[0] = dims[0];
+    ijk[1] = dims[1];
+    ijk[2] = dims[2];
+    }
+
+  size_t nBytes = nTuples*nComps*elemSize;
+
+  out.resize(HeaderSize);
+
+  double eb = 0.0;
+  size_t nVerbatim = 0;
+  if (type == VTK_FLOAT)
+    encode(static_cast<const float*>(data), nTuples, nComps, ijk, mode,
+      bound, eb, nVerbatim, out);
+  else if (type == VTK_DOUBLE)
+    encode(static_cast<const double*>(data), nTuples, nComps, ijk, mode,
+      bound, eb, nVerbatim, out);
+
+  // the values are stored as is when they are not floating point, the bound
+  // is 0, or that would be smaller
+  bool asIs = (eb == 0.0) || (out.size() - HeaderSize >= nBytes);
+  size_t codeBytes = 0;
+  if (asIs)
+    {
+    eb = 0.0;
+    nVerbatim = nTuples*nComps;
+    out.resize(HeaderSize + nBytes);
+    if (nBytes)
+      memcpy(out.data() + HeaderSize, data, nBytes);
+    }
+  else
+    {
+    codeBytes = out.size() - HeaderSize - nVerbatim*elemSize;
+    }
+
+  // fill in the header
+  uint64_t hdr[5] = {nTuples, nComps, ijk[0], ijk[1], ijk[2]};
+  uint64_t sizes[2] = {nVerbatim, codeBytes};
+
+  unsigned char *pout = out.data();
+  memcpy(pout, Magic, 4);
+  pout[4] = static_cast<unsigned char>(type);
+  pout[5] = static_cast<unsigned char>(elemSize);
+  pout[6] = asIs ? FLAG_VERBATIM : 0;
+  pout[7] = static_cast<unsigned char>(mode);
+  memcpy(pout + 8, hdr, sizeof(hdr));
+  memcpy(pout + 48, &eb, sizeof(eb));
+  memcpy(pout + 56, sizes, sizeof(sizes));
+
+  return 0;
+}
+
+// --------------------------------------------------------------------------
+int ErrorBoundedCompressor::Decode(const unsigned char *in, size_t inBytes,
+  void *data, size_t nBytes)
+{
+  if (!ErrorBoundedCompressor::IsEncoded(in, inBytes))
+    {
+    SENSEI_ERROR("The frame has no header")
+    return -1;
+    }
+
+  int type = in[4];
+  size_t elemSize = in[5];
+  bool asIs = in[6] & FLAG_VERBATIM;
+
+  uint64_t hdr[5] = {0, 0, 0, 0, 0};
+  uint64_t sizes[2] = {0, 0};
+  double eb = 0.0;
+  memcpy(hdr, in + 8, sizeof(hdr));
+  memcpy(&eb, in + 48, sizeof(eb));
+  memcpy(sizes, in + 56, sizeof(sizes));
+
+  size_t nTuples = hdr[0];
+  unsigned int nComps = hdr[1];
+  size_t dims[3] = {size_t(hdr[2]), size_t(hdr[3]), size_t(hdr[4])};
+  size_t nVerbatim = sizes[0];
+  size_t codeBytes = sizes[1];
+  size_t payloadBytes = inBytes - HeaderSize;
+
+  bool lossy = (type == VTK_FLOAT) || (type == VTK_DOUBLE);
+
+  if ((elemSize != size_t(vtkAbstractArray::GetDataTypeSize(type))) ||
+    !elemSize || (elemSize > 8) || !nComps || (hdr[1] != nComps) ||
+    (nTuples != nBytes/(nComps*elemSize)) ||
+    (nTuples*nComps*elemSize != nBytes) ||
+    !validDimensions(dims, nTuples) ||
+    (nVerbatim > nTuples*nComps) ||
+    (asIs ? (payloadBytes != nBytes) : (!lossy || !(eb > 0.0) ||
+    (codeBytes > payloadBytes) ||
+    (nVerbatim*elemSize != payloadBytes - codeBytes))))
+    {
+    SENSEI_ERROR("The frame is malformed or does not hold " << nBytes
+      << " bytes")
+    return -1;
+    }
+
+  if (asIs)
+    {
+    if (nBytes)
+      memcpy(data, in + HeaderSize, nBytes);
+    return 0;
+    }
+
+  // scratch space, per thread so that arrays can be decoded concurrently
+  thread_local std::vector<uint32_t> codes;
+  codes.resize(nTuples*nComps);
+
+  const unsigned char *verbatim = in + HeaderSize + codeBytes;
+
+  if (unpack(in + HeaderSize, codeBytes, codes.data(), codes.size()) ||
+    ((type == VTK_FLOAT) ? dequantize(codes.data(), verbatim, nVerbatim,
+      nTuples, nComps, dims, eb, static_cast<float*>(data)) :
+    dequantize(codes.data(), verbatim, nVerbatim, nTuples, nComps, dims,
+      eb, static_cast<double*>(data))))
+    {
+    SENSEI_ERROR("The codes of the frame are malformed")
+    return -1;
+    }
+
+  return 0;
+}
+
+// --------------------------------------------------------------------------
+bool ErrorBoundedCompressor::GetDimensions(vtkDataSet *ds, int association,
+  size_t *dims)
+{
+  int pdims[3] = {0, 0, 0};
+  if (vtkImageData *im = dynamic_cast<vtkImageData*>(ds))
+    im->GetDimensions(pdims);
+  else if (vtkRectilinearGrid *rg = dynamic_cast<vtkRectilinearGrid*>(ds))
+    rg->GetDimensions(pdims);
+  else if (vtkStructuredGrid *sg = dynamic_cast<vtkStructuredGrid*>(ds))
+    sg->GetDimensions(pdims);
+  else
+    return false;
+
+  // a flat direction has one layer of cells
+  int off = association == vtkDataObject::CELL ? 1 : 0;
+  for (int i = 0; i < 3; ++i)
+    dims[i] = std::max(pdims[i] - off, 1);
+
+  return true;
+}
+
+}
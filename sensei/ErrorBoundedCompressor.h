@@ -0,0 +1,113 @@
+#ifndef sensei_ErrorBoundedCompressor_h
+#define sensei_ErrorBoundedCompressor_h
+
+#include <string>
+#include <vector>
+#include <cstddef>
+
+class vtkDataSet;
+namespace pugi { class xml_node; }
+
+namespace sensei
+{
+
+/// @class ErrorBoundedCompressor
+/// @brief Lossy compression of floating point arrays with a guaranteed bound
+/// on the error of every value
+///
+/// Values are quantized onto a grid with a spacing of twice the error bound
+/// and the integer grid coordinates are predicted from the already coded
+/// neighbors, the Lorenzo predictor, using the i, j, k layout of structured
+/// blocks or the previous value otherwise. The prediction residuals of
+/// smooth fields are small, they are stored with the fewest bits that hold
+/// each group of 32. Each component of an array is coded separately. Values
+/// that are not finite, too large to be quantized, or whose reconstruction
+/// would exceed the bound after rounding to the array's precision are stored
+/// verbatim. Arrays that are not float or double are stored verbatim.
+///
+/// The bound is either absolute, or relative to the range of the values of
+/// the block. The coding of the grid coordinates is exact, the decoder's
+/// reconstruction is a single multiplication and is the same on every
+/// platform.
+///
+/// The arrays to compress and their bounds are configured per mesh,
+/// association, and array name, see SetErrorBound. The encoded stream is self
+/// describing, a decoder needs no configuration.
+class ErrorBoundedCompressor
+{
+public:
+  ErrorBoundedCompressor() = default;
+  ~ErrorBoundedCompressor() = default;
+
+  /// @brief How the bound is interpreted. MODE_ABSOLUTE bounds the
+  /// difference between a value and its reconstruction, MODE_RELATIVE
+  /// bounds it by the bound times the range of the block's values.
+  /// ParseMode accepts "absolute" and "relative".
+  enum { MODE_ABSOLUTE = 0, MODE_RELATIVE = 1 };
+  static int ParseMode(std::string modeStr, int &mode);
+
+  /// @brief Compress the named array with the given error bound. An empty
+  /// mesh name matches every mesh and an association of -1 every
+  /// association. The first matching setting is used.
+  int SetErrorBound(const std::string &meshName, int association,
+    const std::string &arrayName, int mode, double bound);
+
+  /// @brief Add the settings given by the compress elements that are
+  /// children of the node, for example
+  ///
+  ///   <compress mesh="mesh" association="point" array="data"
+  ///     mode="relative" error_bound="1e-4"/>
+  ///
+  /// The array and error_bound attributes are required. The mesh and
+  /// association attributes are optional, the mode defaults to relative.
+  int Initialize(pugi::xml_node &node);
+
+  /// @brief Get the setting for the named array. Returns false when the
+  /// array is not compressed.
+  bool GetErrorBound(const std::string &meshName, int association,
+    const std::string &arrayName, int &mode, double &bound) const;
+
+  /// @brief Returns true if any arrays are compressed.
+  bool Enabled() const { return !this->Settings.empty(); }
+
+  /// @brief Encode an array of nTuples tuples with nComps components of the
+  /// given VTK type. dims is the number of tuples in the i, j, and k
+  /// directions, or nullptr when the tuples have no structure. The encoded
+  /// bytes replace the contents of out.
+  static int Encode(int type, const void *data, size_t nTuples,
+    unsigned int nComps, const size_t *dims, int mode, double bound,
+    std::vector<unsigned char> &out);
+
+  /// @brief Decode a frame produced by Encode into data, which must hold
+  /// nBytes. Returns non-zero if the frame is malformed or of a different
+  /// size.
+  static int Decode(const unsigned char *in, size_t inBytes,
+    void *data, size_t nBytes);
+
+  /// @brief Returns true if the bytes start a frame produced by Encode.
+  static bool IsEncoded(const unsigned char *in, size_t inBytes);
+
+  /// @brief Get the size of the header that starts every encoded frame.
+  static size_t GetHeaderSize();
+
+  /// @brief Get the number of point or cell tuples in the i, j, and k
+  /// directions of image, rectilinear, and structured grids. Returns false
+  /// for other datasets.
+  static bool GetDimensions(vtkDataSet *ds, int association, size_t *dims);
+
+private:
+  struct Setting
+    {
+    std::string MeshName;
+    int Association;
+    std::string ArrayName;
+    int Mode;
+    double Bound;
+    };
+
+  std::vector<Setting> Settings;
+};
+
+}
+
+#endif
@@ -244,6 +244,12 @@ bool HDF5AnalysisAdaptor::InitializeHDF5()
         {
           return -1;
         }
+
+      if (this->m_Encoder.Enabled())
+        this->m_HDF5Writer->SetTemporalEncoder(&this->m_Encoder);
+
+      if (this->m_Compressor.Enabled())
+        this->m_HDF5Writer->SetErrorBoundedCompressor(&this->m_Compressor);
     }
   return true;
 }
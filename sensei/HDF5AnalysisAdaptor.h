@@ -4,6 +4,8 @@
 #include "AnalysisAdaptor.h"
 #include "DataRequirements.h"
 #include "MeshMetadata.h"
+#include "TemporalEncoder.h"
+#include "ErrorBoundedCompressor.h"
 
 #include "hdf5.h"
 #include <mpi.h>
@@ -40,6 +42,41 @@ public:
 
   void SetCollective(bool s) { m_Collective = s; }
 
+  /// @brief Enable temporal encoding of the arrays.
+  ///
+  /// Arrays are written as the difference from the previous step, see
+  /// sensei::TemporalEncoder for the delta modes ("none", "xor", and
+  /// "arithmetic"), shuffle, and compressors ("none", "rle", and "zlib").
+  /// When any of these are enabled the geometry of meshes flagged static in
+  /// their metadata is written only on key frames. Takes affect on first
+  /// Execute.
+  int SetDeltaMode(const std::string &mode)
+  { return this->m_Encoder.SetDeltaMode(mode); }
+
+  void SetShuffle(int val) { this->m_Encoder.SetShuffle(val); }
+
+  int SetCompressor(const std::string &comp)
+  { return this->m_Encoder.SetCompressor(comp); }
+
+  void SetKeyFrameInterval(unsigned int n)
+  { this->m_Encoder.SetKeyFrameInterval(n); }
+
+  /// @brief Compress the named array with an error bound.
+  ///
+  /// The bound is absolute or relative to the range of each block's values,
+  /// see sensei::ErrorBoundedCompressor. An empty mesh name matches every
+  /// mesh and an association of -1 every association. Compressed arrays
+  /// are not temporally encoded. Takes affect on first Execute.
+  int SetErrorBound(const std::string &meshName, int association,
+                    const std::string &arrayName, int mode, double bound)
+  { return this->m_Compressor.SetErrorBound(meshName, association,
+                                            arrayName, mode, bound); }
+
+  /// @brief Set error bounds from the compress elements that are children
+  /// of the node, see sensei::ErrorBoundedCompressor::Initialize.
+  int SetErrorBounds(pugi::xml_node &node)
+  { return this->m_Compressor.Initialize(node); }
+
   std::string GetFileName() const { return this->m_FileName; }
 
   /// data requirements tell the adaptor what to push
@@ -72,6 +109,8 @@ protected:
   std::string m_FileName;
   bool m_DoStreaming = false;
   bool m_Collective = false;
+  sensei::TemporalEncoder m_Encoder;
+  sensei::ErrorBoundedCompressor m_Compressor;
 
 private:
   senseiHDF5::WriteStream *m_HDF5Writer;
@@ -1,6 +1,7 @@
 #include "HDF5Schema.h"
 #include "Profiler.h"
 #include "VTKUtils.h"
+#include "ThreadPool.h"
 
 #include <vtkCellArray.h>
 #include <vtkCellData.h>
@@ -56,6 +57,7 @@ static const std::string ATTRNAME_TIMESTEP = "timestep";
 static const std::string ATTRNAME_TIME = "time";
 static const std::string ATTRNAME_NUM_TIMESTEP = "num_timestep";
 static const std::string ATTRNAME_NUM_MESH = "num_meshs";
+static const std::string ATTRNAME_CACHED_GEOMETRY = "cached_geometry";
 static const std::string TAG_MESH = "mesh_";
 static const std::string TAG_ARRAY = "array_";
 static const std::string TAG_VTK_GHOST =
@@ -760,6 +762,20 @@ bool ReadStream::ReadVar1D(const std::string &name,
   return true;
 }
 
+bool ReadStream::HasVar(const std::string &name)
+{
+  return H5Lexists(m_Streamer->m_TimeStepId, name.c_str(), H5P_DEFAULT) > 0;
+}
+
+bool ReadStream::HasAttr(const std::string &objName,
+                         const std::string &attrName)
+{
+  return H5Aexists_by_name(m_Streamer->m_TimeStepId,
+                           objName.c_str(),
+                           attrName.c_str(),
+                           H5P_DEFAULT) > 0;
+}
+
 bool ReadStream::ReadBinary(const std::string &name, sensei::BinaryStream &str)
 {
   hid_t varID = H5Dopen(m_Streamer->m_TimeStepId, name.c_str(), H5P_DEFAULT);
@@ -1003,8 +1019,7 @@ bool MeshFlow::ReadArray(ReadStream *reader,
 
   if (array_name == TAG_VTK_GHOST) {
     ArrayFlow arrayFlow(m_MeshID, association, md);
-    Load(&arrayFlow, md, reader);
-    return true;
+    return Load(&arrayFlow, md, reader);
   }
 
   // read data arrays
@@ -1015,29 +1030,78 @@ bool MeshFlow::ReadArray(ReadStream *reader,
       continue;
 
     ArrayFlow arrayFlow(md, m_MeshID, i);
-    Load(&arrayFlow, md, reader);
+    return Load(&arrayFlow, md, reader);
   }
 
   return true;
 }
 
-void MeshFlow::Load(ArrayFlow *arrayFlowPtr, const sensei::MeshMetadataPtr &md,
+bool MeshFlow::Load(ArrayFlow *arrayFlowPtr, const sensei::MeshMetadataPtr &md,
                     ReadStream *reader) {
+  if (reader->HasVar(arrayFlowPtr->GetEncodedPath()))
+    return LoadEncoded(arrayFlowPtr, md, reader);
+
   unsigned int num_blocks = md->NumBlocks;
 
   vtkCompositeDataIterator *it = m_VtkPtr->NewIterator();
   it->SetSkipEmptyNodes(0);
   it->InitTraversal();
 
+  bool ok = true;
   for (unsigned int j = 0; j < num_blocks; ++j) {
     if (md->BlockOwner[j] == reader->m_Rank) {
-      arrayFlowPtr->load(j, it, reader);
+      ok &= arrayFlowPtr->load(j, it, reader);
     }
     arrayFlowPtr->update(j);
     it->GoToNextItem();
   }
 
   it->Delete();
+
+  return ok;
+}
+
+bool MeshFlow::LoadEncoded(ArrayFlow *arrayFlowPtr,
+                           const sensei::MeshMetadataPtr &md,
+                           ReadStream *reader)
+{
+  unsigned int num_blocks = md->NumBlocks;
+
+  // the encoded size of every block is needed to locate the local blocks
+  const std::string &path = arrayFlowPtr->GetEncodedPath();
+
+  std::vector<unsigned long long> num_bytes(num_blocks);
+  if(!reader->ReadVar1D(path + "_bytes", 0, num_blocks, num_bytes.data()))
+    return false;
+
+  vtkCompositeDataIterator *it = m_VtkPtr->NewIterator();
+  it->SetSkipEmptyNodes(0);
+  it->InitTraversal();
+
+  bool ok = true;
+  unsigned long long offset = 0;
+  std::vector<unsigned char> encoded;
+  for(unsigned int j = 0; j < num_blocks; ++j)
+    {
+      if(md->BlockOwner[j] == reader->m_Rank)
+        {
+          encoded.resize(num_bytes[j]);
+          if(!num_bytes[j] ||
+              !reader->ReadVar1D(path, offset, num_bytes[j], encoded.data()) ||
+              !arrayFlowPtr->decode(j, it, reader, encoded))
+            {
+              SENSEI_ERROR("Failed to read encoded array \""
+                           << arrayFlowPtr->GetArrayName() << "\" block " << j);
+              ok = false;
+            }
+        }
+      offset += num_bytes[j];
+      it->GoToNextItem();
+    }
+
+  it->Delete();
+
+  return ok;
 }
 
 
@@ -1085,6 +1149,13 @@ bool MeshFlow::ReadFrom(ReadStream *input, bool structure_only)
   if(structure_only)
     return true;
 
+  // the geometry of a static mesh is only written on key frames
+  std::string meshPath;
+  gGetNameStr(meshPath, m_MeshID, "");
+
+  if(input->HasAttr(meshPath, ATTRNAME_CACHED_GEOMETRY))
+    return ReadCachedGeometry(input, md);
+
   {
     vtkCompositeDataIterator *it = m_VtkPtr->NewIterator();
     it->SetSkipEmptyNodes(0);
@@ -1104,12 +1175,85 @@ bool MeshFlow::ReadFrom(ReadStream *input, bool structure_only)
     it->Delete();
   }
 
+  if(md->StaticMesh)
+    CacheGeometry(input, md);
+
   return true;
 }
 
-bool MeshFlow::WriteTo(WriteStream *output, const sensei::MeshMetadataPtr &md)
+void MeshFlow::CacheGeometry(ReadStream *input,
+                             const sensei::MeshMetadataPtr &md)
+{
+  unsigned int num_blocks = md->NumBlocks;
+
+  std::vector<vtkSmartPointer<vtkDataSet>> &cache =
+    input->m_GeometryCache[md->MeshName];
+
+  cache.assign(num_blocks, nullptr);
+
+  vtkCompositeDataIterator *it = m_VtkPtr->NewIterator();
+  it->SetSkipEmptyNodes(0);
+  it->InitTraversal();
+
+  for(unsigned int j = 0; j < num_blocks; ++j)
+    {
+      vtkDataSet *ds = dynamic_cast<vtkDataSet *>(it->GetCurrentDataObject());
+      if((input->m_Rank == md->BlockOwner[j]) && ds)
+        {
+          // a shallow copy of the points and cells
+          cache[j].TakeReference(ds->NewInstance());
+          cache[j]->CopyStructure(ds);
+        }
+      it->GoToNextItem();
+    }
+
+  it->Delete();
+}
+
+bool MeshFlow::ReadCachedGeometry(ReadStream *input,
+                                  const sensei::MeshMetadataPtr &md)
+{
+  unsigned int num_blocks = md->NumBlocks;
+
+  std::vector<vtkSmartPointer<vtkDataSet>> &cache =
+    input->m_GeometryCache[md->MeshName];
+
+  vtkCompositeDataIterator *it = m_VtkPtr->NewIterator();
+  it->SetSkipEmptyNodes(0);
+  it->InitTraversal();
+
+  bool ok = true;
+  for(unsigned int j = 0; j < num_blocks; ++j)
+    {
+      if(input->m_Rank == md->BlockOwner[j])
+        {
+          vtkDataSet *ds = dynamic_cast<vtkDataSet *>(it->GetCurrentDataObject());
+          if(!ds || (j >= cache.size()) || !cache[j])
+            {
+              SENSEI_ERROR("The geometry of block " << j << " of static mesh \""
+                           << md->MeshName << "\" was not cached. The mesh must"
+                           " be read on the last key frame");
+              ok = false;
+            }
+          else
+            {
+              ds->CopyStructure(cache[j]);
+            }
+        }
+      it->GoToNextItem();
+    }
+
+  it->Delete();
+
+  return ok;
+}
+
+bool MeshFlow::WriteTo(WriteStream *output,
+                       const sensei::MeshMetadataPtr &md,
+                       bool writeGeometry)
 {
   unsigned int num_blocks = md->NumBlocks;
+  if(writeGeometry)
   {
     vtkCompositeDataIterator *it = m_VtkPtr->NewIterator();
     it->SetSkipEmptyNodes(0);
@@ -1155,6 +1299,15 @@ void MeshFlow::Unload(ArrayFlow *arrayFlowPtr,
                       const sensei::MeshMetadataPtr &md, 
 		      WriteStream *output) 
 {
+  int mode = 0;
+  double bound = 0.0;
+  if(output->m_Encoder ||
+     arrayFlowPtr->GetErrorBound(output->m_Compressor, mode, bound))
+    {
+      UnloadEncoded(arrayFlowPtr, md, output);
+      return;
+    }
+
   unsigned int num_blocks = md->NumBlocks;
 
   vtkCompositeDataIterator *it = m_VtkPtr->NewIterator();
@@ -1173,6 +1326,85 @@ void MeshFlow::Unload(ArrayFlow *arrayFlowPtr,
   it->Delete();
 }
 
+bool MeshFlow::UnloadEncoded(ArrayFlow *arrayFlowPtr,
+                             const sensei::MeshMetadataPtr &md,
+                             WriteStream *output)
+{
+  unsigned int num_blocks = md->NumBlocks;
+
+  // encode the local blocks. the encoded size varies from block to block
+  // and step to step, every rank needs the sizes of all blocks to place
+  // its own.
+  std::vector<std::vector<unsigned char>> encoded(num_blocks);
+  std::vector<unsigned long long> num_bytes(num_blocks, 0);
+
+  vtkCompositeDataIterator *it = m_VtkPtr->NewIterator();
+  it->SetSkipEmptyNodes(0);
+  it->InitTraversal();
+
+  // the blocks are gathered serially and encoded concurrently. the
+  // writes below are serial, HDF5 is not thread safe.
+  std::vector<vtkDataObject *> blocks(num_blocks, nullptr);
+  for(unsigned int j = 0; j < num_blocks; ++j)
+    {
+      if(output->m_Rank == md->BlockOwner[j])
+        blocks[j] = it->GetCurrentDataObject();
+      it->GoToNextItem();
+    }
+
+  it->Delete();
+
+  bool ok = !sensei::ThreadPool::ParallelFor(num_blocks,
+    [&](unsigned int j) -> int
+    {
+      if(output->m_Rank != md->BlockOwner[j])
+        return 0;
+
+      bool blockOk = arrayFlowPtr->encode(j, blocks[j], output->m_Encoder,
+                                          output->m_Compressor, encoded[j]);
+      num_bytes[j] = encoded[j].size();
+      return blockOk ? 0 : -1;
+    });
+
+  MPI_Allreduce(MPI_IN_PLACE, num_bytes.data(), num_blocks,
+                MPI_UNSIGNED_LONG_LONG, MPI_SUM, output->m_Comm);
+
+  unsigned long long total = 0;
+  for(unsigned int j = 0; j < num_blocks; ++j)
+    total += num_bytes[j];
+
+  // the size of each block followed by the encoded blocks
+  const std::string &path = arrayFlowPtr->GetEncodedPath();
+
+  HDF5SpaceGuard bytesSpace(num_blocks, 0, num_blocks);
+  hid_t bytesVarID = output->CreateVar(path + "_bytes", bytesSpace,
+                                       H5T_NATIVE_ULLONG);
+
+  HDF5SpaceGuard dataSpace(total, 0, total);
+  hid_t dataVarID = output->CreateVar(path, dataSpace, H5T_NATIVE_UCHAR);
+
+  unsigned long long offset = 0;
+  for(unsigned int j = 0; j < num_blocks; ++j)
+    {
+      if((output->m_Rank == md->BlockOwner[j]) && num_bytes[j])
+        {
+          HDF5SpaceGuard blockBytesSpace(num_blocks, j, 1);
+          output->WriteVar(bytesVarID, path + "_bytes", blockBytesSpace,
+                           H5T_NATIVE_ULLONG, &num_bytes[j]);
+
+          HDF5SpaceGuard blockSpace(total, offset, num_bytes[j]);
+          output->WriteVar(dataVarID, path, blockSpace, H5T_NATIVE_UCHAR,
+                           encoded[j].data());
+        }
+      offset += num_bytes[j];
+    }
+
+  H5Dclose(bytesVarID);
+  H5Dclose(dataVarID);
+
+  return ok;
+}
+
 //
 //
 //
@@ -1270,6 +1502,7 @@ ArrayFlow::ArrayFlow(const sensei::MeshMetadataPtr &md,
   m_NumArrayComponent = md->ArrayComponents[arrayID];
 
   gGetArrayNameStr(m_ArrayPath, m_MeshID, arrayID);
+  m_EncodedPath = m_ArrayPath + "_encoded";
   m_ArrayVarID = -1;
 
   for(int j = 0; j < md->NumBlocks; ++j)
@@ -1293,6 +1526,7 @@ ArrayFlow::ArrayFlow(unsigned int meshID, int GhostCentering,
   else if (GhostCentering == vtkDataObject::POINT)
     gGetNameStr(m_ArrayPath, m_MeshID, "ghostpoint");
 
+  m_EncodedPath = m_ArrayPath + "_encoded";
   m_ArrayVarID = -1;
 
   for (int j = 0; j < md->NumBlocks; ++j) {
@@ -1340,14 +1574,26 @@ bool ArrayFlow::load(unsigned int block_id,
   array->SetNumberOfTuples(num_elem_local);
 
   if(!reader->ReadVar1D(m_ArrayPath, start, count, array->GetVoidPointer(0)))
-    return false;
+    {
+      array->Delete();
+      return false;
+    }
+
+  return addArray(block_id, it, array, reader->m_Rank);
+}
 
+bool ArrayFlow::addArray(unsigned int block_id,
+                         vtkCompositeDataIterator *it,
+                         vtkDataArray *array,
+                         int rank)
+{
   // pass to vtk
   vtkDataSet *ds = dynamic_cast<vtkDataSet *>(it->GetCurrentDataObject());
   if(!ds)
     {
       SENSEI_ERROR("Failed to get block " << block_id << " rank"
-                   << reader->m_Rank);
+                   << rank);
+      array->Delete();
       return false;
     }
 
@@ -1362,6 +1608,120 @@ bool ArrayFlow::load(unsigned int block_id,
   return true;
 }
 
+void ArrayFlow::getEncoderKey(std::string &key, unsigned int block_id)
+{
+  std::ostringstream oss;
+  oss << m_Metadata->MeshName << "/"
+      << sensei::VTKUtils::GetAttributesName(m_ArrayCenter) << "/"
+      << GetArrayName() << "/" << block_id;
+  key = oss.str();
+}
+
+bool ArrayFlow::decode(unsigned int block_id,
+                       vtkCompositeDataIterator *it,
+                       ReadStream *reader,
+                       const std::vector<unsigned char> &encoded)
+{
+  unsigned long long num_elem_local =
+    m_NumArrayComponent * getLocalElement(block_id);
+
+  vtkDataArray *array = vtkDataArray::CreateDataArray(GetArrayType());
+  array->SetNumberOfComponents(m_NumArrayComponent);
+  array->SetName(GetArrayName().c_str());
+  array->SetNumberOfTuples(getLocalElement(block_id));
+
+  std::string key;
+  getEncoderKey(key, block_id);
+
+  // compressed blocks are self contained, others temporally encoded
+  size_t num_bytes = num_elem_local * array->GetDataTypeSize();
+
+  int ierr = sensei::ErrorBoundedCompressor::IsEncoded(encoded.data(),
+                                                       encoded.size())
+    ? sensei::ErrorBoundedCompressor::Decode(encoded.data(),
+                                             encoded.size(),
+                                             array->GetVoidPointer(0),
+                                             num_bytes)
+    : reader->m_Decoder.Decode(key,
+                               encoded.data(),
+                               encoded.size(),
+                               array->GetVoidPointer(0),
+                               num_bytes);
+  if(ierr)
+    {
+      array->Delete();
+      return false;
+    }
+
+  return addArray(block_id, it, array, reader->m_Rank);
+}
+
+bool ArrayFlow::GetErrorBound(sensei::ErrorBoundedCompressor *compressor,
+                              int &mode,
+                              double &bound)
+{
+  return compressor &&
+    compressor->GetErrorBound(m_Metadata->MeshName, m_ArrayCenter,
+                              GetArrayName(), mode, bound);
+}
+
+bool ArrayFlow::encode(unsigned int block_id,
+                       vtkDataObject *dobj,
+                       sensei::TemporalEncoder *encoder,
+                       sensei::ErrorBoundedCompressor *compressor,
+                       std::vector<unsigned char> &encoded)
+{
+  vtkDataSet *ds = dynamic_cast<vtkDataSet *>(dobj);
+  if(!ds)
+    {
+      SENSEI_ERROR("Failed to get block " << block_id);
+      return false;
+    }
+
+  vtkDataSetAttributes *dsa =
+    m_ArrayCenter == vtkDataObject::POINT
+    ? dynamic_cast<vtkDataSetAttributes *>(ds->GetPointData())
+    : dynamic_cast<vtkDataSetAttributes *>(ds->GetCellData());
+
+  vtkDataArray *da = dsa->GetArray(GetArrayName().c_str());
+  if(!da)
+    {
+      SENSEI_ERROR("Failed to get array \"" << GetArrayName() << "\"");
+      return false;
+    }
+
+  unsigned long long num_elem_local =
+    m_NumArrayComponent * getLocalElement(block_id);
+
+  int mode = 0;
+  double bound = 0.0;
+  if(GetErrorBound(compressor, mode, bound))
+    {
+      // the predictor follows the layout of structured blocks
+      size_t dims[3] = {0, 0, 0};
+      bool structured =
+        sensei::ErrorBoundedCompressor::GetDimensions(ds, m_ArrayCenter, dims);
+
+      return !sensei::ErrorBoundedCompressor::Encode(da->GetDataType(),
+                                                     da->GetVoidPointer(0),
+                                                     getLocalElement(block_id),
+                                                     m_NumArrayComponent,
+                                                     structured ? dims : nullptr,
+                                                     mode,
+                                                     bound,
+                                                     encoded);
+    }
+
+  std::string key;
+  getEncoderKey(key, block_id);
+
+  return !encoder->Encode(key,
+                          da->GetVoidPointer(0),
+                          num_elem_local * da->GetDataTypeSize(),
+                          da->GetDataTypeSize(),
+                          encoded);
+}
+
 bool ArrayFlow::unload(unsigned int block_id,
                        vtkCompositeDataIterator *it,
                        WriteStream *output)
@@ -2465,8 +2825,25 @@ bool WriteStream::WriteMesh(sensei::MeshMetadataPtr &md,
 
   WriteMetadata(md);
 
+  // when encoding, the geometry of a static mesh is written only on key
+  // frames, readers reuse the geometry of the last key frame
+  bool writeGeometry = true;
+  if(m_Encoder && md->StaticMesh)
+    {
+      unsigned long &step = m_StaticMeshSteps[md->MeshName];
+      unsigned int interval = m_Encoder->GetKeyFrameInterval();
+      writeGeometry = (step == 0) || (interval && ((step % interval) == 0));
+      ++step;
+    }
+
+  if(!writeGeometry)
+    {
+      unsigned int cached = 1;
+      WriteNativeAttr(ATTRNAME_CACHED_GEOMETRY, &cached, H5T_NATIVE_UINT, meshID);
+    }
+
   MeshFlow m(vtkPtr, m_MeshCounter);
-  m.WriteTo(this, md);
+  m.WriteTo(this, md, writeGeometry);
 
   m_MeshCounter++;
   return true;
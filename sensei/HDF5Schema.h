@@ -3,19 +3,25 @@
 
 class vtkDataSet;
 class vtkDataObject;
+class vtkDataArray;
 typedef struct _ADIOS_FILE ADIOS_FILE;
 
 #include "MeshMetadata.h"
 #include "MeshMetadataMap.h"
+#include "TemporalEncoder.h"
+#include "ErrorBoundedCompressor.h"
 #include "hdf5.h"
 //#include <adios_read.h>
 #include <cstdint>
+#include <map>
 #include <mpi.h>
 #include <set>
 #include <string>
 #include <vector>
 #include <vtkCompositeDataSet.h>
 #include <vtkDataObject.h>
+#include <vtkDataSet.h>
+#include <vtkSmartPointer.h>
 
 namespace senseiHDF5
 {
@@ -237,8 +243,22 @@ public:
                 hid_t h5Type,
                 void *data);
 
+  // when set arrays are temporally encoded, and the geometry of static
+  // meshes is written only on key frames. the encoder is not owned.
+  void SetTemporalEncoder(sensei::TemporalEncoder *enc) { m_Encoder = enc; }
+
+  sensei::TemporalEncoder *m_Encoder = nullptr;
+
+  // when set arrays given an error bound are compressed. compressed arrays
+  // are not temporally encoded. the compressor is not owned.
+  void SetErrorBoundedCompressor(sensei::ErrorBoundedCompressor *comp)
+  { m_Compressor = comp; }
+
+  sensei::ErrorBoundedCompressor *m_Compressor = nullptr;
+
 private:
   unsigned int m_MeshCounter;
+  std::map<std::string, unsigned long> m_StaticMeshSteps;
 };
 
 class ReadStream : public BasicStream
@@ -273,6 +293,16 @@ public:
   bool ReadBinary(const std::string &name, sensei::BinaryStream &str);
   bool ReadVar1D(const std::string &name, hsize_t s, hsize_t c, void *data);
 
+  bool HasVar(const std::string &name);
+  bool HasAttr(const std::string &objName, const std::string &attrName);
+
+  // decodes temporally encoded arrays
+  sensei::TemporalEncoder m_Decoder;
+
+  // the geometry of static meshes indexed by mesh name and block
+  std::map<std::string, std::vector<vtkSmartPointer<vtkDataSet>>>
+    m_GeometryCache;
+
 private:
   unsigned int m_TimeStepTotal;
 };
@@ -298,19 +328,31 @@ public:
   bool ReadFrom(ReadStream *StreamPtr, bool structureOnly);
   bool Initialize(const sensei::MeshMetadataPtr &md, ReadStream *input);
 
-  bool WriteTo(WriteStream *StreamPtr, const sensei::MeshMetadataPtr &md);
+  bool WriteTo(WriteStream *StreamPtr,
+               const sensei::MeshMetadataPtr &md,
+               bool writeGeometry = true);
 
   vtkCompositeDataSet *m_VtkPtr;
 
 private:
   bool ValidateMetaData(const sensei::MeshMetadataPtr &md);
 
+  bool ReadCachedGeometry(ReadStream *input,
+                          const sensei::MeshMetadataPtr &md);
+  void CacheGeometry(ReadStream *input, const sensei::MeshMetadataPtr &md);
+
   void Unload(ArrayFlow *arrayFlowPtr, 
 	      const sensei::MeshMetadataPtr &md,
               WriteStream *output);
-  void Load(ArrayFlow *arrayFlowPtr, 
+  bool UnloadEncoded(ArrayFlow *arrayFlowPtr,
+                     const sensei::MeshMetadataPtr &md,
+                     WriteStream *output);
+  bool Load(ArrayFlow *arrayFlowPtr, 
 	    const sensei::MeshMetadataPtr &md,
             ReadStream *reader);
+  bool LoadEncoded(ArrayFlow *arrayFlowPtr,
+                   const sensei::MeshMetadataPtr &md,
+                   ReadStream *reader);
 
 
   unsigned int m_MeshID;
@@ -385,15 +427,40 @@ public:
               WriteStream *output);
   bool update(unsigned int block_id);
 
+  // compress the block's array if the compressor has a bound for it,
+  // otherwise temporally encode it. blocks may be encoded concurrently
+  bool encode(unsigned int block_id,
+              vtkDataObject *dobj,
+              sensei::TemporalEncoder *encoder,
+              sensei::ErrorBoundedCompressor *compressor,
+              std::vector<unsigned char> &encoded);
+  // decode the block's array and pass it to the block
+  bool decode(unsigned int block_id,
+              vtkCompositeDataIterator *it,
+              ReadStream *reader,
+              const std::vector<unsigned char> &encoded);
+
   int GetArrayType();
   const std::string &GetArrayName();
+  const std::string &GetEncodedPath() { return m_EncodedPath; }
+
+  // get the compressor's bound for the array, false if it has none
+  bool GetErrorBound(sensei::ErrorBoundedCompressor *compressor,
+                     int &mode,
+                     double &bound);
 
 protected:
   unsigned long long getLocalElement(unsigned int block_id);
+  void getEncoderKey(std::string &key, unsigned int block_id);
+  bool addArray(unsigned int block_id,
+                vtkCompositeDataIterator *it,
+                vtkDataArray *array,
+                int rank);
 
 private:
   unsigned long long m_BlockOffset;
   std::string m_ArrayPath; // name in H5
+  std::string m_EncodedPath; // name in H5 when temporally encoded
   hid_t m_ArrayVarID;
 
   unsigned int m_ArrayID;
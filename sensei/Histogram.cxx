@@ -7,15 +7,16 @@
 #include "VTKUtils.h"
 #include "Error.h"
 
-#include <vtkCompositeDataIterator.h>
 #include <vtkCompositeDataSet.h>
 #include <vtkDataObject.h>
+#include <vtkDataSet.h>
 #include <vtkDataSetAttributes.h>
 #include <vtkObjectFactory.h>
 #include <vtkSmartPointer.h>
 #include <vtkUnsignedCharArray.h>
 
 #include <algorithm>
+#include <array>
 #include <vector>
 
 namespace sensei
@@ -138,54 +139,65 @@ bool Histogram::Execute(DataAdaptor* data)
 
   if (vtkCompositeDataSet* cd = dynamic_cast<vtkCompositeDataSet*>(mesh))
     {
-    vtkSmartPointer<vtkCompositeDataIterator> iter;
-    iter.TakeReference(cd->NewIterator());
+    // the blocks are processed concurrently. the arrays are looked up
+    // serially and the per block results are combined in block order so
+    // that the histogram does not depend on the number of threads
+    std::vector<vtkDataSet*> leaves;
+    VTKUtils::GetLeaves(cd, leaves);
 
-    for (iter->InitTraversal(); !iter->IsDoneWithTraversal(); iter->GoToNextItem())
-      {
-      // get the local mesh
-      vtkDataObject *curObj = iter->GetCurrentDataObject();
+    unsigned int nLeaves = leaves.size();
+    std::vector<vtkDataArray*> arrays(nLeaves, nullptr);
+    std::vector<vtkUnsignedCharArray*> ghostArrays(nLeaves, nullptr);
 
+    for (unsigned int i = 0; i < nLeaves; ++i)
+      {
       // get the array to compute histogram for
-      vtkDataArray* array = this->GetArray(curObj, this->ArrayName);
-      if (!array)
+      arrays[i] = this->GetArray(leaves[i], this->ArrayName);
+      if (!arrays[i])
         {
-        SENSEI_WARNING("Dataset " << iter->GetCurrentFlatIndex()
-          << " has no array named \"" << this->ArrayName << "\"")
+        SENSEI_WARNING("Dataset " << i << " has no array named \""
+          << this->ArrayName << "\"")
         continue;
         }
 
       // and get the ghost cell array
-      vtkUnsignedCharArray *ghostArray = dynamic_cast<vtkUnsignedCharArray*>(
-        this->GetArray(curObj, this->GetGhostArrayName()));
+      ghostArrays[i] = dynamic_cast<vtkUnsignedCharArray*>(
+        this->GetArray(leaves[i], this->GetGhostArrayName()));
+      }
 
-      // compute local histogram range
-      this->Internals->AddRange(array, ghostArray);
+    // compute local histogram range
+    std::vector<std::array<double,2>> ranges(nLeaves);
+
+    VTKUtils::ParallelApply(leaves, [&](unsigned int i, vtkDataSet*) -> int
+      {
+      VTKHistogram::GetRange(arrays[i], ghostArrays[i], ranges[i].data());
+      return 0;
+      });
+
+    for (unsigned int i = 0; i < nLeaves; ++i)
+      {
+      if (arrays[i])
+        this->Internals->AddRange(ranges[i].data());
       }
 
-    // compute global histogram range
+    // compute the global histogram range. the bins depend on it, the
+    // blocks are binned straight from their arrays with the ghost mask
+    // once it is known
     this->Internals->PreCompute(this->GetCommunicator(), this->Bins);
+    this->Internals->FinishPreCompute();
 
-    for (iter->InitTraversal(); !iter->IsDoneWithTraversal(); iter->GoToNextItem())
-      {
-      // get the local mesh
-      vtkDataObject *curObj = iter->GetCurrentDataObject();
-      // get the array to compute histogram for
-      vtkDataArray* array = this->GetArray(curObj, this->ArrayName);
-      if (!array)
-        {
-        SENSEI_WARNING("Dataset " << iter->GetCurrentFlatIndex()
-          << " has no array named \"" << this->ArrayName << "\"")
-        continue;
-        }
+    // compute local histogram
+    std::vector<std::vector<unsigned int>> hists(nLeaves);
 
-      // and get the ghost cell array
-      vtkUnsignedCharArray *ghostArray = dynamic_cast<vtkUnsignedCharArray*>(
-        this->GetArray(curObj, this->GetGhostArrayName()));
+    VTKUtils::ParallelApply(leaves, [&](unsigned int i, vtkDataSet*) -> int
+      {
+      if (arrays[i])
+        this->Internals->Compute(arrays[i], ghostArrays[i], hists[i]);
+      return 0;
+      });
 
-      // compute local histogram
-      this->Internals->Compute(array, ghostArray);
-      }
+    for (unsigned int i = 0; i < nLeaves; ++i)
+      this->Internals->AddHistogram(hists[i]);
 
     // compute the global histogram
     this->Internals->PostCompute(this->GetCommunicator(), this->Bins,
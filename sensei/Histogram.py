@@ -1,6 +1,5 @@
 import sys
 import numpy as np
-import vtk.util.numpy_support as vtknp
 from vtk import vtkDataObject, vtkCompositeDataSet, vtkMultiBlockDataSet
 
 # default values of control parameters
@@ -50,7 +49,8 @@ def Execute(adaptor):
         atts = do.GetPointData() if arrayCen == vtkDataObject.POINT \
              else do.GetCellData()
 
-        da = vtknp.vtk_to_numpy(atts.GetArray(arrayName))
+        # a read-only view, no copy is made
+        da = VTKToNumpy(atts.GetArray(arrayName))
 
         mn = min(mn, np.min(da))
         mx = max(mx, np.max(da))
@@ -69,7 +69,8 @@ def Execute(adaptor):
         atts = do.GetPointData() if arrayCen == vtkDataObject.POINT \
              else do.GetCellData()
 
-        da = vtknp.vtk_to_numpy(atts.GetArray(arrayName))
+        # a read-only view, no copy is made
+        da = VTKToNumpy(atts.GetArray(arrayName))
 
         h,be = np.histogram(da, bins=numBins, range=(mn,mx))
 
@@ -210,6 +210,10 @@ private:
 
     int ComputeNesting;
 
+    // the nesting of AMR meshes. kept across steps, rebuilt only when
+    // the hierarchy changes
+    std::map<std::string, VTKUtils::AMRNestingIndex> Nesting;
+
     std::string               traceFile, options, visitdir;
     std::vector<PlotRecord>   plots;
     std::string               mode;
@@ -1922,35 +1926,6 @@ LibsimAnalysisAdaptor::PrivateData::GetDomainList(const char *meshName, void *cb
     return h;
 }
 
-std::array<int,6> refine(const std::array<int,6> &cext, const std::array<int,3> rr)
-{
-    // refine the coarse patch to put it in the index space of the fine patch
-    return std::array<int,6>{{
-        cext[0]*rr[0], (cext[1] + 1) * rr[0] - 1,
-        cext[2]*rr[1], (cext[3] + 1) * rr[1] - 1,
-        cext[4]*rr[2], (cext[5] + 1) * rr[2] - 1}};
-}
-
-// check if a course patch,cext, intersects a rr refined fine patch, fext.
-// extents are to provided in VTK order: [ilo,ihi, jlo,jhi, klo,khi]
-// for 2D patches the 3d dim should have hi=lo and rr=1
-bool
-intersects(const std::array<int,6> &rcext, const std::array<int,6> &fext)
-{
-    // check that at least one corner of the fine patch is inside
-    // the coarse patch. calculation is made in the fine level index
-    // space
-    if ((((fext[0] >= rcext[0]) && (fext[0] <= rcext[1])) ||
-        ((fext[1] >= rcext[0]) && (fext[1] <= rcext[1]))) &&
-        (((fext[2] >= rcext[2]) && (fext[2] <= rcext[3])) ||
-        ((fext[3] >= rcext[2]) && (fext[3] <= rcext[3]))) &&
-        (((fext[4] >= rcext[4]) && (fext[4] <= rcext[5])) ||
-        ((fext[5] >= rcext[4]) && (fext[5] <= rcext[5]))))
-        return true;
-
-    return false;
-}
-
 // TODO -- this isn't working
 // --------------------------------------------------------------------------
 visit_handle
@@ -1998,40 +1973,30 @@ LibsimAnalysisAdaptor::PrivateData::GetDomainNesting(const char *name,
         VisIt_DomainNesting_set_levelRefinement(h, i, rr.data());
     }
 
+    // index the blocks by level and extent
+    VTKUtils::AMRNestingIndex &index = This->Nesting[meshName];
+    if (index.Update(mmd))
+    {
+        VisItDebug1("failed to index the AMR hierarchy.\n");
+        VisIt_DomainNesting_free(h);
+        return VISIT_INVALID_HANDLE;
+    }
+
     // for each block figure out the list of children
     std::vector<int> nesting;
     nesting.reserve(mmd->NumBlocks);
     for (int i = 0; i < mmd->NumBlocks; ++i)
     {
         int activeLevel = mmd->BlockLevel[i];
-        int nextLevel = activeLevel + 1;
         std::array<int,6> &activeExt = mmd->BlockExtents[i];
-        std::array<int,3> &rr = mmd->RefRatio[activeLevel];
-
-        // for blocks not on the finest level, find children
-        if (nextLevel < mmd->NumLevels)
-        {
-            // refine the active extent, calculations are made in
-            // the finer level index space
-            std::array<int,6> rActiveExt = refine(activeExt, rr);
-
-            for (int j = 0; j < mmd->NumBlocks; ++j)
-            {
-                if (mmd->BlockLevel[j] != nextLevel)
-                    continue;
 
-                const std::array<int,6> &otherExt = mmd->BlockExtents[j];
+        // blocks on the next finer level that overlap this one
+        index.GetChildren(i, nesting);
 
-                if (intersects(rActiveExt, otherExt))
-                {
 #ifdef USE_REAL_DOMAIN
-                    nesting.push_back(mmd->BlockIds[j]);
-#else
-                    nesting.push_back(j);
+        for (size_t j = 0; j < nesting.size(); ++j)
+            nesting[j] = mmd->BlockIds[nesting[j]];
 #endif
-                }
-            }
-        }
 
         // re-roder the block extent to be compatible w/ VisIt
         int vExt[6] = {activeExt[0], activeExt[2], activeExt[4],
@@ -0,0 +1,267 @@
+#include <mpi.h>
+#include "MPIUtils.h"
+#include "Error.h"
+
+#include <mutex>
+#include <vector>
+#include <algorithm>
+#include <cstdlib>
+
+namespace sensei
+{
+namespace MPIUtils
+{
+
+namespace
+{
+// the key used to cache NodeInfo on a communicator
+int NodeInfoKey = MPI_KEYVAL_INVALID;
+std::mutex NodeInfoKeyMutex;
+
+// the communicators that have a NodeInfo, in the order they were created
+std::vector<MPI_Comm> NodeInfoComms;
+
+// when the node aware collectives are used, see SetNodeAwareCollectives
+int NodeAwareMode = -2;
+
+// --------------------------------------------------------------------------
+int DeleteNodeInfo(MPI_Comm comm, int, void *attr, void *)
+{
+    {
+    std::lock_guard<std::mutex> lock(NodeInfoKeyMutex);
+    NodeInfoComms.erase(std::remove(NodeInfoComms.begin(),
+      NodeInfoComms.end(), comm), NodeInfoComms.end());
+    }
+
+  delete static_cast<NodeInfo*>(attr);
+  return MPI_SUCCESS;
+}
+
+// --------------------------------------------------------------------------
+int FinalizeNodeInfo(MPI_Comm, int, void *, void *)
+{
+  // the attributes of MPI_COMM_SELF are deleted at the start of
+  // MPI_Finalize. this releases the node level communicators of
+  // communicators that are still alive, such as MPI_COMM_WORLD, while MPI
+  // can still be used. this is collective, and is done in the reverse
+  // order of creation, which is the same on all ranks.
+  std::vector<MPI_Comm> comms;
+    {
+    std::lock_guard<std::mutex> lock(NodeInfoKeyMutex);
+    comms = NodeInfoComms;
+    }
+
+  for (auto it = comms.rbegin(); it != comms.rend(); ++it)
+    {
+    MPI_Comm comm = *it;
+    MPI_Comm_delete_attr(comm, NodeInfoKey);
+    }
+
+  return MPI_SUCCESS;
+}
+
+// --------------------------------------------------------------------------
+int GetNodeInfoKey()
+{
+  std::lock_guard<std::mutex> lock(NodeInfoKeyMutex);
+
+  if (NodeInfoKey == MPI_KEYVAL_INVALID)
+    {
+    MPI_Comm_create_keyval(MPI_COMM_NULL_COPY_FN, DeleteNodeInfo,
+      &NodeInfoKey, nullptr);
+
+    int finalizeKey = MPI_KEYVAL_INVALID;
+    MPI_Comm_create_keyval(MPI_COMM_NULL_COPY_FN, FinalizeNodeInfo,
+      &finalizeKey, nullptr);
+
+    MPI_Comm_set_attr(MPI_COMM_SELF, finalizeKey, nullptr);
+    }
+
+  return NodeInfoKey;
+}
+
+// --------------------------------------------------------------------------
+NodeInfo *NewNodeInfo(MPI_Comm comm)
+{
+  int rank = 0;
+  MPI_Comm_rank(comm, &rank);
+
+  NodeInfo *node = new NodeInfo;
+
+  // the ranks that share memory
+  MPI_Comm_split_type(comm, MPI_COMM_TYPE_SHARED, rank,
+    MPI_INFO_NULL, &node->NodeComm);
+
+  MPI_Comm_rank(node->NodeComm, &node->NodeRank);
+  MPI_Comm_size(node->NodeComm, &node->NodeSize);
+
+  // one rank from each node
+  MPI_Comm_split(comm, node->NodeRank == 0 ? 0 : MPI_UNDEFINED,
+    rank, &node->LeaderComm);
+
+  // the leaders record which ranks are on each node. the nodes are ordered
+  // as they are in LeaderComm.
+  std::vector<int> ranks(node->NodeRank == 0 ? node->NodeSize : 0);
+
+  MPI_Gather(&rank, 1, MPI_INT, ranks.data(), 1, MPI_INT,
+    0, node->NodeComm);
+
+  if (node->LeaderComm != MPI_COMM_NULL)
+    {
+    MPI_Comm_size(node->LeaderComm, &node->NumNodes);
+
+    node->NodeSizes.resize(node->NumNodes);
+    MPI_Allgather(&node->NodeSize, 1, MPI_INT, node->NodeSizes.data(),
+      1, MPI_INT, node->LeaderComm);
+
+    std::vector<int> offsets(node->NumNodes, 0);
+    for (int i = 1; i < node->NumNodes; ++i)
+      offsets[i] = offsets[i-1] + node->NodeSizes[i-1];
+
+    node->NodeRanks.resize(offsets.back() + node->NodeSizes.back());
+    MPI_Allgatherv(ranks.data(), node->NodeSize, MPI_INT,
+      node->NodeRanks.data(), node->NodeSizes.data(), offsets.data(),
+      MPI_INT, node->LeaderComm);
+    }
+
+  MPI_Bcast(&node->NumNodes, 1, MPI_INT, 0, node->NodeComm);
+
+  return node;
+}
+}
+
+// --------------------------------------------------------------------------
+NodeInfo::NodeInfo() : NodeComm(MPI_COMM_NULL), LeaderComm(MPI_COMM_NULL),
+  NodeRank(0), NodeSize(1), NumNodes(1), NodeRanks(), NodeSizes(),
+  Window(MPI_WIN_NULL), WindowData(nullptr), WindowSize(0), Parity(0)
+{
+}
+
+// --------------------------------------------------------------------------
+NodeInfo::~NodeInfo()
+{
+  if (this->Window != MPI_WIN_NULL)
+    {
+    MPI_Win_unlock_all(this->Window);
+    MPI_Win_free(&this->Window);
+    }
+
+  if (this->LeaderComm != MPI_COMM_NULL)
+    MPI_Comm_free(&this->LeaderComm);
+
+  if (this->NodeComm != MPI_COMM_NULL)
+    MPI_Comm_free(&this->NodeComm);
+}
+
+// --------------------------------------------------------------------------
+char *NodeInfo::GetSharedBuffer(size_t nBytes)
+{
+  // the window holds two buffers that are used in turn. a rank may start
+  // writing the next call's data while others are still reading the
+  // result of the last, but not before all ranks have entered the next
+  // call. alignment is kept for the largest type used.
+  nBytes = (nBytes + 15)/16*16;
+
+  if (nBytes > this->WindowSize)
+    {
+    if (this->Window != MPI_WIN_NULL)
+      {
+      MPI_Win_unlock_all(this->Window);
+      MPI_Win_free(&this->Window);
+      }
+
+    // grow geometrically so that a sequence of larger requests does not
+    // reallocate each time
+    this->WindowSize = std::max(nBytes, 2*this->WindowSize);
+
+    // the memory is allocated on the leader and mapped by the other ranks
+    MPI_Aint localSize = this->NodeRank == 0 ? 2*this->WindowSize : 0;
+    char *localData = nullptr;
+
+    MPI_Win_allocate_shared(localSize, 1, MPI_INFO_NULL, this->NodeComm,
+      &localData, &this->Window);
+
+    MPI_Aint size = 0;
+    int dispUnit = 0;
+    MPI_Win_shared_query(this->Window, 0, &size, &dispUnit, &this->WindowData);
+
+    // a passive target epoch is held for the life of the window, see Sync
+    MPI_Win_lock_all(MPI_MODE_NOCHECK, this->Window);
+
+    this->Parity = 0;
+    }
+
+  char *buf = this->WindowData + this->Parity*this->WindowSize;
+  this->Parity = !this->Parity;
+
+  return buf;
+}
+
+// --------------------------------------------------------------------------
+void NodeInfo::Sync()
+{
+  MPI_Win_sync(this->Window);
+  MPI_Barrier(this->NodeComm);
+  MPI_Win_sync(this->Window);
+}
+
+// --------------------------------------------------------------------------
+void SetNodeAwareCollectives(int mode)
+{
+  NodeAwareMode = mode;
+}
+
+// --------------------------------------------------------------------------
+int GetNodeAwareCollectives()
+{
+  if (NodeAwareMode == -2)
+    {
+    const char *env = getenv("SENSEI_NODE_AWARE_COLLECTIVES");
+    NodeAwareMode = env ? atoi(env) : -1;
+    }
+
+  return NodeAwareMode;
+}
+
+// --------------------------------------------------------------------------
+NodeInfo *GetNodeInfo(MPI_Comm comm)
+{
+  int mode = GetNodeAwareCollectives();
+  if ((mode == 0) || (comm == MPI_COMM_NULL))
+    return nullptr;
+
+  int inter = 0;
+  MPI_Comm_test_inter(comm, &inter);
+
+  int nRanks = 1;
+  MPI_Comm_size(comm, &nRanks);
+
+  if (inter || (nRanks < 2))
+    return nullptr;
+
+  // use the cached communicators
+  int key = GetNodeInfoKey();
+
+  NodeInfo *node = nullptr;
+  int found = 0;
+  MPI_Comm_get_attr(comm, key, &node, &found);
+
+  if (!found)
+    {
+    node = NewNodeInfo(comm);
+    MPI_Comm_set_attr(comm, key, node);
+
+    std::lock_guard<std::mutex> lock(NodeInfoKeyMutex);
+    NodeInfoComms.push_back(comm);
+    }
+
+  // in the default mode the two level path is used when there is a
+  // node with more than one rank and there is more than one node
+  if ((mode < 0) && ((node->NumNodes < 2) || (node->NumNodes == nRanks)))
+    return nullptr;
+
+  return node;
+}
+
+}
+}
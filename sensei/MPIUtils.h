@@ -2,6 +2,12 @@
 #define MPIUtils_h
 
 #include <algorithm>
+#include <array>
+#include <vector>
+#include <limits>
+#include <cstring>
+#include <functional>
+#include <memory>
 
 namespace sensei
 {
@@ -24,6 +30,183 @@ define_mpi_tt(unsigned long, MPI_UNSIGNED_LONG)
 define_mpi_tt(float, MPI_FLOAT)
 define_mpi_tt(double, MPI_DOUBLE)
 
+// Node aware collectives.
+//
+// The helpers below make collective calls in two levels when the
+// communicator spans a number of nodes with more than one rank per node.
+// Ranks on a node combine their data through an MPI-3 shared memory
+// window, one rank per node takes part in the collective across nodes,
+// and the result is read back from the window. This cuts the number of
+// ranks in the inter-node collective to the number of nodes.
+//
+// The node level communicators and the window are created the first time
+// a communicator is used, cached on it as an MPI attribute, and released
+// when it is freed. The two level path is used by the blocking helpers
+// when it is enabled (see SetNodeAwareCollectives) and is otherwise
+// transparent to the caller. ReductionBatch does not use it.
+struct NodeInfo
+{
+  NodeInfo();
+  ~NodeInfo();
+
+  NodeInfo(const NodeInfo&) = delete;
+  void operator=(const NodeInfo&) = delete;
+
+  // get a buffer of at least nBytes in the memory shared by the ranks on
+  // the node. this is collective over NodeComm, all ranks must pass the
+  // same size. successive calls alternate between two buffers so that a
+  // buffer can be written before all ranks have read the other one.
+  char *GetSharedBuffer(size_t nBytes);
+
+  // makes writes to the shared buffer visible to the ranks on the node.
+  // collective over NodeComm.
+  void Sync();
+
+  MPI_Comm NodeComm;        // ranks that share memory with this rank
+  MPI_Comm LeaderComm;      // rank 0 of each node, MPI_COMM_NULL elsewhere
+  int NodeRank;             // rank in NodeComm
+  int NodeSize;             // size of NodeComm
+  int NumNodes;             // number of nodes spanned by the communicator
+  std::vector<int> NodeRanks;   // on leaders, the ranks on each node
+  std::vector<int> NodeSizes;   // on leaders, the number of ranks on each node
+  MPI_Win Window;
+  char *WindowData;
+  size_t WindowSize;
+  int Parity;
+};
+
+// Set when the node aware collectives are used. 0 disables them, 1 uses
+// them whenever the communicator has more than one rank, and -1, the
+// default, uses them when the communicator spans more than one node and
+// at least one node has more than one rank. The default may be set with
+// the SENSEI_NODE_AWARE_COLLECTIVES environment variable. All ranks must
+// use the same setting.
+void SetNodeAwareCollectives(int mode);
+int GetNodeAwareCollectives();
+
+// Get the node level communicators of comm, creating them if needed.
+// Returns nullptr when the node aware path should not be used. This is
+// collective over comm.
+NodeInfo *GetNodeInfo(MPI_Comm comm);
+
+// Reduce n values in place across all ranks in comm with a predefined
+// MPI operation, as MPI_Allreduce would. n must be the same on all ranks.
+template<typename cpp_t>
+void Allreduce(MPI_Comm comm, cpp_t *data, int n, MPI_Op op)
+{
+  MPI_Datatype type = mpi_tt<cpp_t>::datatype();
+
+  NodeInfo *node = n > 0 ? GetNodeInfo(comm) : nullptr;
+  if (!node)
+    {
+    MPI_Allreduce(MPI_IN_PLACE, data, n, type, op, comm);
+    return;
+    }
+
+  // each rank has a slot in the shared buffer, the result is placed after
+  // the last slot so that it can be read while the slots are reused
+  size_t nBytes = n*sizeof(cpp_t);
+  cpp_t *slots = (cpp_t*)node->GetSharedBuffer((node->NodeSize + 1)*nBytes);
+  cpp_t *result = slots + node->NodeSize*n;
+
+  memcpy(slots + node->NodeRank*n, data, nBytes);
+  node->Sync();
+
+  // reduce within the node, each rank reduces a contiguous range of the
+  // values over the slots
+  int nPer = n / node->NodeSize;
+  int nLarge = n % node->NodeSize;
+  int first = node->NodeRank*nPer + std::min(node->NodeRank, nLarge);
+  int count = nPer + (node->NodeRank < nLarge ? 1 : 0);
+  if (count)
+    {
+    memcpy(result + first, slots + first, count*sizeof(cpp_t));
+    for (int i = 1; i < node->NodeSize; ++i)
+      MPI_Reduce_local(slots + i*n + first, result + first, count, type, op);
+    }
+  node->Sync();
+
+  // reduce across the nodes
+  if (node->LeaderComm != MPI_COMM_NULL)
+    MPI_Allreduce(MPI_IN_PLACE, result, n, type, op, node->LeaderComm);
+  node->Sync();
+
+  memcpy(data, result, nBytes);
+}
+
+// Gather the values of all ranks in comm into gdata, ordered by rank.
+// counts and offsets index gdata by rank, are the same on all ranks, and
+// gdata is sized to hold all of the values. The ranks on a node write
+// their values directly into the shared buffer, the leaders exchange the
+// values of their nodes, and the result is read from the shared buffer.
+template<typename cpp_t>
+void NodeAllgatherv(NodeInfo *node, int rank, const cpp_t *ldata,
+  const std::vector<int> &counts, const std::vector<int> &offsets,
+  std::vector<cpp_t> &gdata)
+{
+  size_t nTotal = gdata.size();
+  cpp_t *gd = (cpp_t*)node->GetSharedBuffer(
+    std::max(nTotal, size_t(1))*sizeof(cpp_t));
+
+  // each rank writes its values in place
+  memcpy(gd + offsets[rank], ldata, counts[rank]*sizeof(cpp_t));
+  node->Sync();
+
+  // the leaders exchange the values of their nodes
+  if ((node->LeaderComm != MPI_COMM_NULL) && (node->NumNodes > 1))
+    {
+    int nodeId = 0;
+    MPI_Comm_rank(node->LeaderComm, &nodeId);
+
+    // the number of values on each node
+    std::vector<int> nodeCounts(node->NumNodes, 0);
+    std::vector<int> nodeOffsets(node->NumNodes, 0);
+    std::vector<int> firstRank(node->NumNodes, 0);
+    for (int i = 0, q = 0; i < node->NumNodes; ++i)
+      {
+      if (i)
+        {
+        nodeOffsets[i] = nodeOffsets[i-1] + nodeCounts[i-1];
+        firstRank[i] = firstRank[i-1] + node->NodeSizes[i-1];
+        }
+
+      for (int j = 0; j < node->NodeSizes[i]; ++j, ++q)
+        nodeCounts[i] += counts[node->NodeRanks[q]];
+      }
+
+    // pack the values of this node
+    std::vector<cpp_t> packed(nTotal);
+    cpp_t *pp = packed.data() + nodeOffsets[nodeId];
+    for (int j = 0; j < node->NodeSizes[nodeId]; ++j)
+      {
+      int r = node->NodeRanks[firstRank[nodeId] + j];
+      memcpy(pp, gd + offsets[r], counts[r]*sizeof(cpp_t));
+      pp += counts[r];
+      }
+
+    MPI_Allgatherv(MPI_IN_PLACE, 0, MPI_DATATYPE_NULL, packed.data(),
+      nodeCounts.data(), nodeOffsets.data(), mpi_tt<cpp_t>::datatype(),
+      node->LeaderComm);
+
+    // unpack the values of the other nodes
+    for (int i = 0; i < node->NumNodes; ++i)
+      {
+      if (i == nodeId)
+        continue;
+
+      pp = packed.data() + nodeOffsets[i];
+      for (int j = 0; j < node->NodeSizes[i]; ++j)
+        {
+        int r = node->NodeRanks[firstRank[i] + j];
+        memcpy(gd + offsets[r], pp, counts[r]*sizeof(cpp_t));
+        pp += counts[r];
+        }
+      }
+    }
+  node->Sync();
+
+  memcpy(gdata.data(), gd, nTotal*sizeof(cpp_t));
+}
 
 // helper to recuce by summation elements in a vector
 // it's assumed that the vector is the same size on all
@@ -31,8 +214,7 @@ define_mpi_tt(double, MPI_DOUBLE)
 template<typename cpp_t>
 void GlobalCounts(MPI_Comm comm, std::vector<cpp_t> &vec)
 {
-  MPI_Allreduce(MPI_IN_PLACE, vec.data(), vec.size(),
-      mpi_tt<cpp_t>::datatype(), MPI_SUM, comm);
+  Allreduce(comm, vec.data(), vec.size(), MPI_SUM);
 }
 
 // helper function to compute an axis aligned bounding box
@@ -83,8 +265,7 @@ void GlobalBounds(MPI_Comm comm, const std::vector<std::array<cpp_t,6>> &lbounds
     gbounds[i] = -gbounds[i];
 
   // find the smallest bounding covering all distributed
-  MPI_Allreduce(MPI_IN_PLACE, gbounds.data(), 6,
-    mpi_tt<cpp_t>::datatype(), MPI_MAX, comm);
+  Allreduce(comm, gbounds.data(), 6, MPI_MAX);
 
   // because we used MPI_MAX
   for (size_t i = 0; i < 6; i += 2)
@@ -113,8 +294,7 @@ void GlobalRange(MPI_Comm comm, const std::vector<std::array<cpp_t,2>> &lrange,
   grange[0] = -grange[0];
 
   // find the smallest bounding covering all distributed
-  MPI_Allreduce(MPI_IN_PLACE, grange.data(), 2,
-    mpi_tt<cpp_t>::datatype(), MPI_MAX, comm);
+  Allreduce(comm, grange.data(), 2, MPI_MAX);
 
   // because we used MPI_MAX
   grange[0] = -grange[0];
@@ -136,6 +316,18 @@ void GlobalView(MPI_Comm comm, const std::vector<cpp_t> &ldata,
   int nLocal = ldata.size();
 
   gdata.resize(nRanks*nLocal);
+
+  if (NodeInfo *node = GetNodeInfo(comm))
+    {
+    std::vector<int> counts(nRanks, nLocal);
+    std::vector<int> offsets(nRanks);
+    for (int i = 0; i < nRanks; ++i)
+      offsets[i] = i*nLocal;
+
+    NodeAllgatherv(node, rank, ldata.data(), counts, offsets, gdata);
+    return;
+    }
+
   for (int i = 0; i < nLocal; ++i)
       gdata[nLocal*rank+i] = ldata[i];
 
@@ -166,8 +358,12 @@ void GlobalViewV(MPI_Comm comm, const std::vector<cpp_t> &ldata,
   int nLocal = ldata.size();
   gcounts[rank] = nLocal;
 
-  MPI_Allgather(MPI_IN_PLACE, 0, MPI_DATATYPE_NULL,
-    gcounts.data(), 1, MPI_INT, comm);
+  NodeInfo *node = GetNodeInfo(comm);
+  if (node)
+    Allreduce(comm, gcounts.data(), nRanks, MPI_SUM);
+  else
+    MPI_Allgather(MPI_IN_PLACE, 0, MPI_DATATYPE_NULL,
+      gcounts.data(), 1, MPI_INT, comm);
 
   goffset.clear();
   goffset.resize(nRanks);
@@ -184,6 +380,12 @@ void GlobalViewV(MPI_Comm comm, const std::vector<cpp_t> &ldata,
 
   gdata.resize(nTotal);
 
+  if (node)
+    {
+    NodeAllgatherv(node, rank, ldata.data(), gcounts, goffset, gdata);
+    return;
+    }
+
   const cpp_t *ld = ldata.data();
   cpp_t *gd = gdata.data() + goffset[rank];
   for (int i = 0; i < nLocal; ++i)
@@ -316,6 +518,274 @@ void GlobalViewV(MPI_Comm comm, std::vector<std::vector<cpp_t>> &ldata)
   ldata.swap(gdata);
 }
 
+// A batch of nonblocking collectives. The collectives are posted when the
+// methods are called and complete in Wait, so that an analysis can post a
+// number of them, continue with local work, and wait once. The methods
+// mirror the blocking helpers above and are made with MPI_Iallreduce,
+// MPI_Iallgather and MPI_Iallgatherv directly over the communicator. The
+// batch does not use the node aware collectives even when they are
+// enabled, their node level phase synchronizes the ranks on a node through
+// the shared memory window and can not be left in flight. Overlap wins
+// over the smaller inter-node collective, the blocking helpers above
+// remain node aware.
+//
+// The local contributions are read when the method is called, except for
+// the GlobalViewV variants, which read them once the counts are known.
+// Results are written during Wait. Until then the arguments must not be
+// modified or destroyed. As with all collectives, the ranks must
+// post the same collectives in the same order. Wait is called by the
+// destructor.
+class ReductionBatch
+{
+public:
+  ReductionBatch() : Comm(MPI_COMM_NULL) {}
+  explicit ReductionBatch(MPI_Comm comm) : Comm(comm) {}
+  ~ReductionBatch() { this->Wait(); }
+
+  ReductionBatch(const ReductionBatch&) = delete;
+  void operator=(const ReductionBatch&) = delete;
+
+  // set the communicator. pending collectives are completed first.
+  void SetCommunicator(MPI_Comm comm)
+  {
+    this->Wait();
+    this->Comm = comm;
+  }
+
+  MPI_Comm GetCommunicator() { return this->Comm; }
+
+  // reduce n values in place. done, when given, is called once the
+  // reduction has completed.
+  template<typename cpp_t>
+  void Allreduce(cpp_t *data, int n, MPI_Op op,
+    std::function<void()> done = nullptr)
+  {
+    MPI_Request req = MPI_REQUEST_NULL;
+    MPI_Iallreduce(MPI_IN_PLACE, data, n, mpi_tt<cpp_t>::datatype(),
+      op, this->Comm, &req);
+    this->Post(req, std::move(done));
+  }
+
+  // see MPIUtils::GlobalCounts
+  template<typename cpp_t>
+  void GlobalCounts(std::vector<cpp_t> &vec)
+  {
+    this->Allreduce(vec.data(), vec.size(), MPI_SUM);
+  }
+
+  // see MPIUtils::GlobalBounds
+  template <typename cpp_t>
+  void GlobalBounds(const std::vector<std::array<cpp_t,6>> &lbounds,
+    std::array<cpp_t,6> &gbounds)
+  {
+    gbounds = {std::numeric_limits<cpp_t>::max(), std::numeric_limits<cpp_t>::lowest(),
+      std::numeric_limits<cpp_t>::max(), std::numeric_limits<cpp_t>::lowest(),
+      std::numeric_limits<cpp_t>::max(), std::numeric_limits<cpp_t>::lowest()};
+
+    // find the smallest bounding covering all local
+    int nLocal = lbounds.size();
+    for (int q = 0; q < nLocal; ++q)
+      {
+      for (int i = 0; i < 6; ++i)
+        gbounds[i] = i % 2 ? std::max(gbounds[i], lbounds[q][i]) :
+          std::min(gbounds[i], lbounds[q][i]);
+      }
+
+    // so we can use MPI_MAX
+    for (size_t i = 0; i < 6; i += 2)
+      gbounds[i] = -gbounds[i];
+
+    std::array<cpp_t,6> *pgb = &gbounds;
+    this->Allreduce(gbounds.data(), 6, MPI_MAX, [pgb]()
+      {
+      // because we used MPI_MAX
+      for (size_t i = 0; i < 6; i += 2)
+        (*pgb)[i] = -(*pgb)[i];
+      });
+  }
+
+  // see MPIUtils::GlobalRange
+  template <typename cpp_t>
+  void GlobalRange(const std::vector<std::array<cpp_t,2>> &lrange,
+    std::array<cpp_t,2> &grange)
+  {
+    grange = {std::numeric_limits<cpp_t>::max(),
+      std::numeric_limits<cpp_t>::lowest()};
+
+    // find the range over local blocks
+    int nLocal = lrange.size();
+    for (int q = 0; q < nLocal; ++q)
+      {
+      grange[0] = std::min(grange[0], lrange[q][0]);
+      grange[1] = std::max(grange[1], lrange[q][1]);
+      }
+
+    // so we can use MPI_MAX
+    grange[0] = -grange[0];
+
+    std::array<cpp_t,2> *pgr = &grange;
+    this->Allreduce(grange.data(), 2, MPI_MAX, [pgr]()
+      {
+      // because we used MPI_MAX
+      (*pgr)[0] = -(*pgr)[0];
+      });
+  }
+
+  // see MPIUtils::GlobalView
+  template <typename cpp_t>
+  void GlobalView(const std::vector<cpp_t> &ldata, std::vector<cpp_t> &gdata)
+  {
+    int rank = 0;
+    int nRanks = 1;
+    MPI_Comm_rank(this->Comm, &rank);
+    MPI_Comm_size(this->Comm, &nRanks);
+
+    int nLocal = ldata.size();
+
+    gdata.resize(nRanks*nLocal);
+    std::copy(ldata.begin(), ldata.end(), gdata.begin() + nLocal*rank);
+
+    MPI_Request req = MPI_REQUEST_NULL;
+    MPI_Iallgather(MPI_IN_PLACE, 0, MPI_DATATYPE_NULL, gdata.data(),
+      nLocal, mpi_tt<cpp_t>::datatype(), this->Comm, &req);
+
+    this->Post(req, nullptr);
+  }
+
+  // see MPIUtils::GlobalViewV. this takes two steps, the counts are
+  // gathered and then the data. done, when given, is called once the
+  // data has been gathered.
+  template <typename cpp_t>
+  void GlobalViewV(const std::vector<cpp_t> &ldata, std::vector<cpp_t> &gdata,
+    std::function<void()> done = nullptr)
+  {
+    int rank = 0;
+    int nRanks = 1;
+    MPI_Comm_rank(this->Comm, &rank);
+    MPI_Comm_size(this->Comm, &nRanks);
+
+    auto counts = std::make_shared<std::vector<int>>(nRanks, 0);
+    (*counts)[rank] = ldata.size();
+
+    MPI_Request req = MPI_REQUEST_NULL;
+    MPI_Iallgather(MPI_IN_PLACE, 0, MPI_DATATYPE_NULL, counts->data(),
+      1, MPI_INT, this->Comm, &req);
+
+    const std::vector<cpp_t> *pld = &ldata;
+    std::vector<cpp_t> *pgd = &gdata;
+
+    this->Post(req, [this, rank, nRanks, counts, pld, pgd, done]()
+      {
+      auto offsets = std::make_shared<std::vector<int>>(nRanks, 0);
+      for (int i = 1; i < nRanks; ++i)
+        (*offsets)[i] = (*offsets)[i-1] + (*counts)[i-1];
+
+      pgd->resize((*offsets)[nRanks-1] + (*counts)[nRanks-1]);
+      std::copy(pld->begin(), pld->end(), pgd->begin() + (*offsets)[rank]);
+
+      MPI_Request dreq = MPI_REQUEST_NULL;
+      MPI_Iallgatherv(MPI_IN_PLACE, 0, MPI_DATATYPE_NULL, pgd->data(),
+        counts->data(), offsets->data(), mpi_tt<cpp_t>::datatype(),
+        this->Comm, &dreq);
+
+      // the counts and offsets are held until the gather completes
+      this->Post(dreq, [counts, offsets, done]()
+        {
+        if (done)
+          done();
+        });
+      });
+  }
+
+  // see MPIUtils::GlobalViewV. the result replaces the input.
+  template <typename cpp_t>
+  void GlobalViewV(std::vector<cpp_t> &ldata)
+  {
+    auto gdata = std::make_shared<std::vector<cpp_t>>();
+    std::vector<cpp_t> *pld = &ldata;
+    this->GlobalViewV(ldata, *gdata, [pld, gdata]()
+      {
+      pld->swap(*gdata);
+      });
+  }
+
+  // see MPIUtils::GlobalViewV. the result replaces the input.
+  template <typename cpp_t, std::size_t N>
+  void GlobalViewV(std::vector<std::array<cpp_t,N>> &ldata)
+  {
+    // serialize the data
+    size_t n = ldata.size();
+    auto ld = std::make_shared<std::vector<cpp_t>>(n*N);
+    for (size_t i = 0; i < n; ++i)
+      std::copy(ldata[i].begin(), ldata[i].end(), ld->begin() + i*N);
+
+    auto gd = std::make_shared<std::vector<cpp_t>>();
+    std::vector<std::array<cpp_t,N>> *pld = &ldata;
+    this->GlobalViewV(*ld, *gd, [pld, ld, gd]()
+      {
+      // deserialize
+      size_t ng = gd->size()/N;
+      pld->resize(ng);
+      for (size_t i = 0; i < ng; ++i)
+        std::copy(gd->begin() + i*N, gd->begin() + (i + 1)*N,
+          (*pld)[i].begin());
+      });
+  }
+
+  // make progress on the pending collectives without blocking. results
+  // are not written, see Wait. returns true when the collectives posted so
+  // far have completed.
+  bool Test()
+  {
+    int nReq = this->Requests.size();
+    if (!nReq)
+      return true;
+
+    int nDone = 0;
+    std::vector<int> done(nReq);
+    MPI_Testsome(nReq, this->Requests.data(), &nDone, done.data(),
+      MPI_STATUSES_IGNORE);
+
+    // completed requests are set to MPI_REQUEST_NULL
+    return (nDone == MPI_UNDEFINED) || std::all_of(this->Requests.begin(),
+      this->Requests.end(), [](MPI_Request r) { return r == MPI_REQUEST_NULL; });
+  }
+
+  // complete the pending collectives and write the results. collectives
+  // are completed in the order they were posted, as the continuations of
+  // the two step gathers post collectives, which must happen in the same
+  // order on all ranks.
+  void Wait()
+  {
+    while (!this->Requests.empty())
+      {
+      MPI_Wait(&this->Requests.front(), MPI_STATUS_IGNORE);
+
+      std::function<void()> then = std::move(this->Then.front());
+      this->Requests.erase(this->Requests.begin());
+      this->Then.erase(this->Then.begin());
+
+      // this may post more requests
+      if (then)
+        then();
+      }
+  }
+
+  // true when there are no pending collectives
+  bool Empty() { return this->Requests.empty(); }
+
+private:
+  void Post(MPI_Request req, std::function<void()> then)
+  {
+    this->Requests.push_back(req);
+    this->Then.push_back(std::move(then));
+  }
+
+  MPI_Comm Comm;
+  std::vector<MPI_Request> Requests;
+  std::vector<std::function<void()>> Then;
+};
+
 }
 }
 
@@ -387,18 +387,23 @@ int MeshMetadata::GlobalizeView(MPI_Comm comm)
   TimeEvent<128> mark("MeshMetadata::GlobalizeView");
   if (!this->GlobalView)
     {
-    MPIUtils::GlobalViewV(comm, this->BlockOwner);
-    MPIUtils::GlobalViewV(comm, this->BlockIds);
-    MPIUtils::GlobalViewV(comm, this->NumBlocksLocal);
-    MPIUtils::GlobalViewV(comm, this->BlockNumPoints);
-    MPIUtils::GlobalViewV(comm, this->BlockNumCells);
-    MPIUtils::GlobalViewV(comm, this->BlockCellArraySize);
-    MPIUtils::GlobalViewV(comm, this->BlockExtents);
-    MPIUtils::GlobalViewV(comm, this->BlockBounds);
+    // the gathers are in flight at once
+    MPIUtils::ReductionBatch batch(comm);
+    batch.GlobalViewV(this->BlockOwner);
+    batch.GlobalViewV(this->BlockIds);
+    batch.GlobalViewV(this->NumBlocksLocal);
+    batch.GlobalViewV(this->BlockNumPoints);
+    batch.GlobalViewV(this->BlockNumCells);
+    batch.GlobalViewV(this->BlockCellArraySize);
+    batch.GlobalViewV(this->BlockExtents);
+    batch.GlobalViewV(this->BlockBounds);
+    batch.GlobalViewV(this->BlockLevel);
+    batch.GlobalCounts(this->BlocksPerLevel);
+
+    // the ranges are nested vectors
     MPIUtils::GlobalViewV(comm, this->BlockArrayRange);
-    MPIUtils::GlobalViewV(comm, this->BlockLevel);
 
-    MPIUtils::GlobalCounts(comm, this->BlocksPerLevel);
+    batch.Wait();
 
     STLUtils::ReduceRange(this->BlockBounds, this->Bounds);
     STLUtils::ReduceRange(this->BlockExtents, this->Extent);
@@ -59,6 +59,13 @@ public:
   void ClearBlockArrayRange(){ Flags &= ~RANGE; }
   bool BlockArrayRangeSet() const { return Flags & RANGE; }
 
+  // check if the same optional fields are requested
+  bool operator==(const MeshMetadataFlags &other) const
+  { return Flags == other.Flags; }
+
+  bool operator!=(const MeshMetadataFlags &other) const
+  { return Flags != other.Flags; }
+
 
   /// serialize/deserialize for communication and/or I/O
   int ToStream(sensei::BinaryStream &str) const;
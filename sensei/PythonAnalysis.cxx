@@ -1,15 +1,25 @@
 #include "PythonAnalysis.h"
+#include "DataAdaptor.h"
+#include "VTKDataAdaptor.h"
+#include "Profiler.h"
 #include "Error.h"
 
 #include <vtkObjectFactory.h>
+#include <vtkDataObject.h>
 #include <mpi4py/mpi4py.MPI_api.h>
 #include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 #include <cstdio>
 #include <cstring>
 #include <errno.h>
 #include <Python.h>
 
 #include "senseiPyString.h"
+#include "senseiPyGILState.h"
 
 // Macro to report error through sensei's normal mechanism
 // and include Python exception info and stack
@@ -94,6 +104,26 @@ int runString(PyObject *module, const std::string &code)
   return 0;
 }
 
+// wrap the data adaptor and pass it to the Execute function
+static
+int callExecute(PyObject *func, sensei::DataAdaptor *dataAdaptor)
+{
+  // wrap the data adaptor instance
+  PyObject *pyDataAdaptor = SWIG_NewPointerObj(
+    SWIG_as_voidptr(dataAdaptor), SWIGTYPE_p_sensei__DataAdaptor, 0);
+
+  // the tuple takes owner ship with N
+  PyObject *args = Py_BuildValue("(N)", pyDataAdaptor);
+
+  // invoke the provided execute function
+  int ret = callFunction("Execute", func, args);
+
+  // clean up
+  Py_DECREF(args);
+
+  return ret;
+}
+
 static
 int loadScript(MPI_Comm comm, const std::string &scriptFile, PyObject *&module)
 {
@@ -172,16 +202,60 @@ int loadScript(MPI_Comm comm, const std::string &scriptFile, PyObject *&module)
   return 0;
 }
 
+// the interpreter is shared by all instances. the first to initialize
+// starts it and releases the GIL, after that every call into Python takes
+// the GIL with senseiPyGILState. the last to finalize shuts it down.
+static unsigned int InterpreterUsers = 0;
+static PyThreadState *InterpreterState = nullptr;
+
+static
+void startInterpreter()
+{
+  if (InterpreterUsers++)
+    return;
+
+  Py_SetProgramName(C_STRING_LITERAL("PythonAnalysis"));
+  Py_Initialize();
+#if PY_VERSION_HEX < 0x03070000
+  PyEval_InitThreads();
+#endif
+  InterpreterState = PyEval_SaveThread();
+}
+
+static
+void stopInterpreter()
+{
+  if (!InterpreterUsers || --InterpreterUsers)
+    return;
+
+  PyEval_RestoreThread(InterpreterState);
+  InterpreterState = nullptr;
+  Py_Finalize();
+}
+
 namespace sensei
 {
 
 struct PythonAnalysis::InternalsType
 {
   InternalsType() : Module(nullptr), Initialize(nullptr),
-    Execute(nullptr), Finalize(nullptr) {}
+    Execute(nullptr), Finalize(nullptr), Asynchronous(0), QueueDepth(1),
+    DeepCopy(1), Done(false), WorkerErrors(0), WorkerComm(MPI_COMM_NULL),
+    InterpreterStarted(false) {}
 
   ~InternalsType();
 
+  // start the worker thread. the worker takes the GIL when it calls
+  // into Python
+  int StartWorker(MPI_Comm comm);
+
+  // process queued data until the queue is drained and Done is set
+  void RunWorker();
+
+  // drain the queue and join the worker thread. the caller must not hold
+  // the GIL
+  int StopWorker();
+
   std::string ScriptModule;
   std::string ScriptFile;
   std::string InitializeSource;
@@ -190,11 +264,133 @@ struct PythonAnalysis::InternalsType
   PyObject *Initialize;
   PyObject *Execute;
   PyObject *Finalize;
+
+  // asynchronous execution
+  int Asynchronous;
+  unsigned int QueueDepth;
+  int DeepCopy;
+  DataRequirements Requirements;
+
+  // the adaptors used to pass data to the worker. an adaptor is either
+  // free, queued, or being processed. Execute blocks when none are free.
+  std::vector<VTKDataAdaptor*> Adaptors;
+  std::deque<VTKDataAdaptor*> FreeAdaptors;
+  std::deque<VTKDataAdaptor*> Queue;
+
+  std::thread Worker;
+  std::mutex QueueMutex;
+  std::condition_variable QueueNotEmpty;
+  std::condition_variable AdaptorFree;
+  bool Done;
+  int WorkerErrors;
+
+  MPI_Comm WorkerComm;
+
+  // set when this instance holds a reference to the interpreter
+  bool InterpreterStarted;
 };
 
+//-----------------------------------------------------------------------------
+int PythonAnalysis::InternalsType::StartWorker(MPI_Comm comm)
+{
+  // the queue holds QueueDepth steps while one more is processed
+  unsigned int nAdaptors = this->QueueDepth + 1;
+  for (unsigned int i = 0; i < nAdaptors; ++i)
+    {
+    VTKDataAdaptor *vda = VTKDataAdaptor::New();
+    vda->SetCommunicator(comm);
+    this->Adaptors.push_back(vda);
+    this->FreeAdaptors.push_back(vda);
+    }
+
+  this->Done = false;
+  this->WorkerErrors = 0;
+
+  this->Worker = std::thread(&PythonAnalysis::InternalsType::RunWorker, this);
+
+  return 0;
+}
+
+//-----------------------------------------------------------------------------
+void PythonAnalysis::InternalsType::RunWorker()
+{
+  while (true)
+    {
+    VTKDataAdaptor *data = nullptr;
+
+    // wait for data
+      {
+      std::unique_lock<std::mutex> lock(this->QueueMutex);
+
+      this->QueueNotEmpty.wait(lock,
+        [this]() { return this->Done || !this->Queue.empty(); });
+
+      // the queue has been drained
+      if (this->Queue.empty())
+        return;
+
+      data = this->Queue.front();
+      this->Queue.pop_front();
+      }
+
+    // run the analysis
+    int ierr = 0;
+      {
+      TimeEvent<128> event("PythonAnalysis::AsynchronousExecute");
+      senseiPyGILState gil;
+      ierr = callExecute(this->Execute, data);
+      }
+
+    data->ReleaseData();
+
+    // hand the adaptor back to the simulation
+      {
+      std::lock_guard<std::mutex> lock(this->QueueMutex);
+      this->FreeAdaptors.push_back(data);
+      this->WorkerErrors += ierr ? 1 : 0;
+      }
+
+    this->AdaptorFree.notify_one();
+    }
+}
+
+//-----------------------------------------------------------------------------
+int PythonAnalysis::InternalsType::StopWorker()
+{
+  if (!this->Worker.joinable())
+    return 0;
+
+  // let the worker finish what is queued
+    {
+    std::lock_guard<std::mutex> lock(this->QueueMutex);
+    this->Done = true;
+    }
+
+  this->QueueNotEmpty.notify_one();
+  this->Worker.join();
+
+  unsigned int nAdaptors = this->Adaptors.size();
+  for (unsigned int i = 0; i < nAdaptors; ++i)
+    this->Adaptors[i]->Delete();
+
+  this->Adaptors.clear();
+  this->FreeAdaptors.clear();
+
+  if (this->WorkerErrors)
+    {
+    SENSEI_ERROR("Execute failed " << this->WorkerErrors
+      << " times on the worker thread")
+    return -1;
+    }
+
+  return 0;
+}
+
 //-----------------------------------------------------------------------------
 PythonAnalysis::InternalsType::~InternalsType()
 {
+  this->StopWorker();
+
   if (this->Initialize || this->Execute || this->Finalize || this->Module)
     SENSEI_ERROR("PythonAnalysis::Finalize not called")
 }
@@ -234,32 +430,82 @@ void PythonAnalysis::SetScriptFile(const std::string &scriptName)
 }
 
 //-----------------------------------------------------------------------------
-int PythonAnalysis::Finalize()
+void PythonAnalysis::SetAsynchronous(int val)
 {
-  if (this->Internals->Finalize)
-    callFunction("Finalize", this->Internals->Finalize, nullptr);
+  this->Internals->Asynchronous = val;
+}
 
-  Py_XDECREF(this->Internals->Initialize);
-  Py_XDECREF(this->Internals->Execute);
-  Py_XDECREF(this->Internals->Finalize);
-  Py_XDECREF(this->Internals->Module);
+//-----------------------------------------------------------------------------
+int PythonAnalysis::GetAsynchronous()
+{
+  return this->Internals->Asynchronous;
+}
 
-  this->Internals->Initialize = nullptr;
-  this->Internals->Execute = nullptr;
-  this->Internals->Finalize = nullptr;
-  this->Internals->Module = nullptr;
+//-----------------------------------------------------------------------------
+void PythonAnalysis::SetQueueDepth(unsigned int depth)
+{
+  this->Internals->QueueDepth = depth < 1 ? 1 : depth;
+}
 
-  Py_Finalize();
+//-----------------------------------------------------------------------------
+void PythonAnalysis::SetDeepCopy(int val)
+{
+  this->Internals->DeepCopy = val;
+}
 
+//-----------------------------------------------------------------------------
+int PythonAnalysis::SetDataRequirements(const DataRequirements &reqs)
+{
+  this->Internals->Requirements = reqs;
   return 0;
 }
 
+//-----------------------------------------------------------------------------
+int PythonAnalysis::Finalize()
+{
+  // process any queued data. the worker needs the GIL to do so
+  int ierr = this->Internals->StopWorker();
+
+  if (!this->Internals->InterpreterStarted)
+    return ierr;
+
+    {
+    senseiPyGILState gil;
+
+    if (this->Internals->Finalize)
+      callFunction("Finalize", this->Internals->Finalize, nullptr);
+
+    Py_XDECREF(this->Internals->Initialize);
+    Py_XDECREF(this->Internals->Execute);
+    Py_XDECREF(this->Internals->Finalize);
+    Py_XDECREF(this->Internals->Module);
+
+    this->Internals->Initialize = nullptr;
+    this->Internals->Execute = nullptr;
+    this->Internals->Finalize = nullptr;
+    this->Internals->Module = nullptr;
+    }
+
+  stopInterpreter();
+  this->Internals->InterpreterStarted = false;
+
+  if (this->Internals->WorkerComm != MPI_COMM_NULL)
+    MPI_Comm_free(&this->Internals->WorkerComm);
+
+  return ierr;
+}
+
 //-----------------------------------------------------------------------------
 int PythonAnalysis::Initialize()
 {
-  // initialize the interpreter
-  Py_SetProgramName(C_STRING_LITERAL("PythonAnalysis"));
-  Py_Initialize();
+  // initialize the interpreter. it is shut down by Finalize
+  if (!this->Internals->InterpreterStarted)
+    {
+    startInterpreter();
+    this->Internals->InterpreterStarted = true;
+    }
+
+  senseiPyGILState gil;
 
   if (!this->Internals->ScriptFile.empty() && !this->Internals->ScriptModule.empty())
     {
@@ -329,9 +575,29 @@ int PythonAnalysis::Initialize()
     return -1;
     }
 
-  // set the communicator
+  // the worker thread and the simulation make MPI calls concurrently
+  if (this->Internals->Asynchronous)
+    {
+    int threadLevel = MPI_THREAD_SINGLE;
+    MPI_Query_thread(&threadLevel);
+    if (threadLevel < MPI_THREAD_MULTIPLE)
+      {
+      SENSEI_WARNING("Asynchronous execution requires MPI_THREAD_MULTIPLE. "
+        "The Python analysis will run synchronously")
+      this->Internals->Asynchronous = 0;
+      }
+    }
+
+  // set the communicator. the worker thread gets its own
+  MPI_Comm comm = this->GetCommunicator();
+  if (this->Internals->Asynchronous)
+    {
+    MPI_Comm_dup(comm, &this->Internals->WorkerComm);
+    comm = this->Internals->WorkerComm;
+    }
+
   PyModule_AddObject(this->Internals->Module,
-    "comm", PyMPIComm_New(this->GetCommunicator()));
+    "comm", PyMPIComm_New(comm));
 
   // set provided globals
   if (!this->Internals->InitializeSource.empty())
@@ -344,8 +610,17 @@ int PythonAnalysis::Initialize()
     }
 
   // call the provided initialize function
-  if (this->Internals->Initialize)
-    return callFunction("Initialize", this->Internals->Initialize, nullptr);
+  if (this->Internals->Initialize &&
+    callFunction("Initialize", this->Internals->Initialize, nullptr))
+    return -1;
+
+  // start the worker thread
+  if (this->Internals->Asynchronous &&
+    this->Internals->StartWorker(this->Internals->WorkerComm))
+    {
+    SENSEI_ERROR("Failed to start the worker thread")
+    return -1;
+    }
 
   return 0;
 }
@@ -359,20 +634,57 @@ bool PythonAnalysis::Execute(DataAdaptor *dataAdaptor)
     return false;
     }
 
-  // wrap the data adaptor instance
-  PyObject *pyDataAdaptor = SWIG_NewPointerObj(
-    SWIG_as_voidptr(dataAdaptor), SWIGTYPE_p_sensei__DataAdaptor, 0);
+  if (!this->Internals->Asynchronous)
+    {
+    senseiPyGILState gil;
+    return callExecute(this->Internals->Execute, dataAdaptor) == 0;
+    }
 
-  // the tuple takes owner ship with N
-  PyObject *args = Py_BuildValue("(N)", pyDataAdaptor);
+  // wait for the worker to free an adaptor. this is where
+  // the simulation is held back when the queue is full
+  VTKDataAdaptor *snap = nullptr;
+    {
+    TimeEvent<128> event("PythonAnalysis::QueueWait");
 
-  // invoke the provided execute function
-  int ret = callFunction("Execute", this->Internals->Execute, args);
+    std::unique_lock<std::mutex> lock(this->Internals->QueueMutex);
 
-  // clean up
-  Py_DECREF(args);
+    this->Internals->AdaptorFree.wait(lock,
+      [this]() { return !this->Internals->FreeAdaptors.empty(); });
+
+    snap = this->Internals->FreeAdaptors.front();
+    this->Internals->FreeAdaptors.pop_front();
+
+    // report failures that occurred on the worker thread
+    if (this->Internals->WorkerErrors)
+      {
+      SENSEI_ERROR("Execute failed on the worker thread")
+      this->Internals->FreeAdaptors.push_front(snap);
+      return false;
+      }
+    }
+
+  // capture the data
+  int ierr = 0;
+    {
+    TimeEvent<128> event("PythonAnalysis::CaptureData");
+    ierr = snap->Capture(dataAdaptor, this->Internals->Requirements,
+      this->Internals->DeepCopy);
+    }
+
+  std::lock_guard<std::mutex> lock(this->Internals->QueueMutex);
+  if (ierr)
+    {
+    SENSEI_ERROR("Failed to capture data for the worker thread")
+    snap->ReleaseData();
+    this->Internals->FreeAdaptors.push_front(snap);
+    return false;
+    }
+
+  // hand it to the worker
+  this->Internals->Queue.push_back(snap);
+  this->Internals->QueueNotEmpty.notify_one();
 
-  return ret == 0;
+  return true;
 }
 
 }
@@ -3,6 +3,7 @@
 
 #include "senseiConfig.h"
 #include "AnalysisAdaptor.h"
+#include "DataRequirements.h"
 #include <mpi.h>
 
 namespace sensei
@@ -43,6 +44,17 @@ class DataAdaptor;
 // initalization source (see SetInitializeSource) is provided in a string and
 // will be executed prior to your script functions. This lets you set global
 // variables that can modify the screipts run time behavior.
+//
+// In asynchronous mode (see SetAsynchronous) the script's Execute function
+// runs on a dedicated thread. Execute captures the meshes and arrays named in
+// the data requirements (see SetDataRequirements), or all of the simulation's
+// data when none are given, queues them and returns to the simulation
+// immediately. The script is then handed a sensei::VTKDataAdaptor serving the
+// captured data. When the queue is full Execute blocks until the worker
+// catches up. The queued steps are processed before Finalize returns. The
+// worker communicates on its own communicator, which is the one made
+// available in the comm global. Asynchronous mode requires
+// MPI_THREAD_MULTIPLE, when it is not available Execute runs synchronously.
 class PythonAnalysis : public AnalysisAdaptor
 {
 public:
@@ -66,6 +78,26 @@ public:
   /// before the script's functions.
   void SetInitializeSource(const std::string &source);
 
+  /// Enable asynchronous execution on a dedicated thread. This must be
+  /// set before Initialize. default 0.
+  void SetAsynchronous(int val);
+  int GetAsynchronous();
+
+  /// Set the number of time steps that may be waiting for the worker
+  /// thread before Execute blocks. This must be set before Initialize.
+  /// default 1.
+  void SetQueueDepth(unsigned int depth);
+
+  /// Set how data is captured in asynchronous mode. When set arrays are
+  /// deep copied. Otherwise arrays are pinned by reference, which is only
+  /// valid if the simulation does not modify them in place while they are
+  /// queued. default 1.
+  void SetDeepCopy(int val);
+
+  /// Set the meshes and arrays captured in asynchronous mode. If none are
+  /// given then all data is captured.
+  int SetDataRequirements(const DataRequirements &reqs);
+
   /// Initlize the interpreter, set file name or module name
   /// before initialization
   int Initialize();
@@ -32,6 +32,7 @@ import_array();
 %include <mpi4py/mpi4py.i>
 %include "vtk.i"
 %include "senseiSTL.i"
+%include "senseiDataArray.i"
 
 %mpi4py_typemap(Comm, MPI_Comm);
 
@@ -0,0 +1,380 @@
+#include "QuantileSketch.h"
+#include "Error.h"
+
+#include <algorithm>
+#include <limits>
+#include <utility>
+
+// tag used for the messages of the tree reduction
+#define SENSEI_QUANTILE_SKETCH_TAG 3127
+
+namespace sensei
+{
+
+// the smallest capacity of any level, and the rate at which
+// capacity decreases with distance from the top level
+static const size_t MinCapacity = 8;
+static const double CapacityRatio = 2.0/3.0;
+
+// sorts the retained values and their weights, the weight
+// of a value is 2^h where h is the level it is held at
+static
+void getWeightedValues(const std::vector<std::vector<double>> &levels,
+  std::vector<std::pair<double, unsigned long long>> &vals)
+{
+  vals.clear();
+
+  size_t nLevels = levels.size();
+  for (size_t h = 0; h < nLevels; ++h)
+    {
+    unsigned long long weight = 1ull << h;
+    size_t n = levels[h].size();
+    for (size_t i = 0; i < n; ++i)
+      vals.emplace_back(levels[h][i], weight);
+    }
+
+  std::sort(vals.begin(), vals.end());
+}
+
+// --------------------------------------------------------------------------
+QuantileSketch::QuantileSketch(double epsilon) : Epsilon(0.01), K(0),
+  Count(0), Min(std::numeric_limits<double>::max()),
+  Max(std::numeric_limits<double>::lowest()), Size(0), Capacity(0)
+{
+  this->SetEpsilon(epsilon);
+}
+
+// --------------------------------------------------------------------------
+void QuantileSketch::SetEpsilon(double epsilon)
+{
+  // the rank error of a KLL sketch is about 1.7/K
+  this->Epsilon = epsilon > 0.0 ? epsilon : 0.01;
+  this->K = std::max(MinCapacity, size_t(std::ceil(1.7/this->Epsilon)));
+  this->Clear();
+}
+
+// --------------------------------------------------------------------------
+void QuantileSketch::Clear()
+{
+  this->Count = 0;
+  this->Min = std::numeric_limits<double>::max();
+  this->Max = std::numeric_limits<double>::lowest();
+  this->Size = 0;
+  this->Levels.clear();
+  this->Levels.resize(1);
+  this->Random.seed(std::minstd_rand::default_seed);
+  this->UpdateCapacity();
+}
+
+// --------------------------------------------------------------------------
+size_t QuantileSketch::GetCapacity(size_t h) const
+{
+  size_t depth = this->Levels.size() - 1 - h;
+  size_t cap = size_t(std::ceil(this->K*std::pow(CapacityRatio, depth)));
+  return std::max(MinCapacity, cap);
+}
+
+// --------------------------------------------------------------------------
+void QuantileSketch::UpdateCapacity()
+{
+  this->Capacity = 0;
+  size_t nLevels = this->Levels.size();
+  for (size_t h = 0; h < nLevels; ++h)
+    this->Capacity += this->GetCapacity(h);
+}
+
+// --------------------------------------------------------------------------
+void QuantileSketch::Update(double val)
+{
+  if (std::isnan(val))
+    return;
+
+  this->Min = std::min(this->Min, val);
+  this->Max = std::max(this->Max, val);
+
+  this->Levels[0].push_back(val);
+  this->Size += 1;
+  this->Count += 1;
+
+  if (this->Size >= this->Capacity)
+    this->Compress();
+}
+
+// --------------------------------------------------------------------------
+void QuantileSketch::Compact(size_t h)
+{
+  if (h + 1 == this->Levels.size())
+    {
+    this->Levels.emplace_back();
+    this->UpdateCapacity();
+    }
+
+  std::vector<double> &level = this->Levels[h];
+  std::vector<double> &next = this->Levels[h + 1];
+
+  std::sort(level.begin(), level.end());
+
+  // an odd value out stays behind so that no weight is lost
+  size_t n = level.size();
+  size_t keep = n % 2;
+  size_t nCompact = n - keep;
+
+  // every other value, starting at a random offset, moves
+  // up a level with twice the weight
+  size_t offset = this->Random() % 2;
+  for (size_t i = offset; i < nCompact; i += 2)
+    next.push_back(level[i]);
+
+  if (keep)
+    level[0] = level[n - 1];
+
+  level.resize(keep);
+
+  this->Size -= nCompact/2;
+}
+
+// --------------------------------------------------------------------------
+void QuantileSketch::Compress()
+{
+  while (this->Size >= this->Capacity)
+    {
+    // when the sketch is over capacity at least one level is
+    // over its capacity. compact the lowest.
+    size_t nLevels = this->Levels.size();
+    for (size_t h = 0; h < nLevels; ++h)
+      {
+      if (this->Levels[h].size() >= this->GetCapacity(h))
+        {
+        this->Compact(h);
+        break;
+        }
+      }
+    }
+}
+
+// --------------------------------------------------------------------------
+void QuantileSketch::Merge(const QuantileSketch &other)
+{
+  if (!other.Count)
+    return;
+
+  size_t nLevels = other.Levels.size();
+  if (this->Levels.size() < nLevels)
+    this->Levels.resize(nLevels);
+
+  for (size_t h = 0; h < nLevels; ++h)
+    {
+    this->Levels[h].insert(this->Levels[h].end(),
+      other.Levels[h].begin(), other.Levels[h].end());
+    }
+
+  this->Count += other.Count;
+  this->Size += other.Size;
+  this->Min = std::min(this->Min, other.Min);
+  this->Max = std::max(this->Max, other.Max);
+
+  this->UpdateCapacity();
+  this->Compress();
+}
+
+// --------------------------------------------------------------------------
+double QuantileSketch::GetQuantile(double q) const
+{
+  if (!this->Count)
+    return std::numeric_limits<double>::quiet_NaN();
+
+  if (q <= 0.0)
+    return this->Min;
+
+  if (q >= 1.0)
+    return this->Max;
+
+  std::vector<std::pair<double, unsigned long long>> vals;
+  getWeightedValues(this->Levels, vals);
+
+  unsigned long long target = q*this->Count;
+  unsigned long long rank = 0;
+
+  size_t n = vals.size();
+  for (size_t i = 0; i < n; ++i)
+    {
+    rank += vals[i].second;
+    if (rank > target)
+      return vals[i].first;
+    }
+
+  return this->Max;
+}
+
+// --------------------------------------------------------------------------
+void QuantileSketch::GetCDF(unsigned int n, double *cdf) const
+{
+  if (!n)
+    return;
+
+  if (!this->Count)
+    {
+    std::fill(cdf, cdf + n, std::numeric_limits<double>::quiet_NaN());
+    return;
+    }
+
+  cdf[0] = this->Min;
+
+  if (n == 1)
+    return;
+
+  std::vector<std::pair<double, unsigned long long>> vals;
+  getWeightedValues(this->Levels, vals);
+
+  // the targets are increasing, walk the values once
+  unsigned int splitSize = n - 1;
+  unsigned long long rank = 0;
+  size_t nVals = vals.size();
+  size_t j = 0;
+
+  for (unsigned int i = 1; i < splitSize; ++i)
+    {
+    unsigned long long target = i*this->Count/splitSize;
+
+    while ((j < nVals) && (rank + vals[j].second <= target))
+      {
+      rank += vals[j].second;
+      ++j;
+      }
+
+    cdf[i] = j < nVals ? vals[j].first : this->Max;
+    }
+
+  cdf[n - 1] = this->Max;
+}
+
+// --------------------------------------------------------------------------
+void QuantileSketch::Pack(std::vector<double> &buf) const
+{
+  size_t nLevels = this->Levels.size();
+
+  buf.clear();
+  buf.reserve(6 + nLevels + this->Size);
+
+  buf.push_back(this->Epsilon);
+  buf.push_back(this->K);
+  buf.push_back(this->Count);
+  buf.push_back(this->Min);
+  buf.push_back(this->Max);
+  buf.push_back(nLevels);
+
+  for (size_t h = 0; h < nLevels; ++h)
+    buf.push_back(this->Levels[h].size());
+
+  for (size_t h = 0; h < nLevels; ++h)
+    buf.insert(buf.end(), this->Levels[h].begin(), this->Levels[h].end());
+}
+
+// --------------------------------------------------------------------------
+int QuantileSketch::Unpack(const double *buf, size_t n)
+{
+  if (n < 6)
+    {
+    SENSEI_ERROR("Invalid sketch, the header is truncated")
+    return -1;
+    }
+
+  this->Epsilon = buf[0];
+  this->K = buf[1];
+  this->Count = buf[2];
+  this->Min = buf[3];
+  this->Max = buf[4];
+
+  size_t nLevels = buf[5];
+  if (!nLevels || (n < 6 + nLevels))
+    {
+    SENSEI_ERROR("Invalid sketch with " << nLevels << " levels")
+    return -1;
+    }
+
+  const double *sizes = buf + 6;
+  const double *vals = sizes + nLevels;
+  const double *end = buf + n;
+
+  this->Size = 0;
+  this->Levels.resize(nLevels);
+  for (size_t h = 0; h < nLevels; ++h)
+    {
+    size_t levelSize = sizes[h];
+    if (vals + levelSize > end)
+      {
+      SENSEI_ERROR("Invalid sketch, level " << h << " is truncated")
+      return -1;
+      }
+
+    this->Levels[h].assign(vals, vals + levelSize);
+    this->Size += levelSize;
+    vals += levelSize;
+    }
+
+  this->UpdateCapacity();
+
+  return 0;
+}
+
+// --------------------------------------------------------------------------
+int QuantileSketch::Reduce(MPI_Comm comm, int root)
+{
+  int rank = 0;
+  int nRanks = 1;
+
+  MPI_Comm_rank(comm, &rank);
+  MPI_Comm_size(comm, &nRanks);
+
+  // rank relative to the root
+  int vrank = (rank - root + nRanks) % nRanks;
+
+  std::vector<double> buf;
+  QuantileSketch other(this->Epsilon);
+
+  for (int mask = 1; mask < nRanks; mask <<= 1)
+    {
+    if (vrank & mask)
+      {
+      // send to the parent and we're done
+      int dest = (vrank - mask + root) % nRanks;
+
+      this->Pack(buf);
+
+      MPI_Send(buf.data(), buf.size(), MPI_DOUBLE, dest,
+        SENSEI_QUANTILE_SKETCH_TAG, comm);
+
+      break;
+      }
+
+    int vsrc = vrank + mask;
+    if (vsrc < nRanks)
+      {
+      // receive from the child and merge
+      int src = (vsrc + root) % nRanks;
+
+      MPI_Status stat;
+      MPI_Probe(src, SENSEI_QUANTILE_SKETCH_TAG, comm, &stat);
+
+      int n = 0;
+      MPI_Get_count(&stat, MPI_DOUBLE, &n);
+
+      buf.resize(n);
+
+      MPI_Recv(buf.data(), n, MPI_DOUBLE, src,
+        SENSEI_QUANTILE_SKETCH_TAG, comm, MPI_STATUS_IGNORE);
+
+      if (other.Unpack(buf.data(), n))
+        {
+        SENSEI_ERROR("Failed to unpack the sketch from rank " << src)
+        return -1;
+        }
+
+      this->Merge(other);
+      }
+    }
+
+  return 0;
+}
+
+}
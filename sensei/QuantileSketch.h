@@ -0,0 +1,110 @@
+#ifndef sensei_QuantileSketch_h
+#define sensei_QuantileSketch_h
+
+#include <mpi.h>
+#include <vector>
+#include <random>
+#include <cmath>
+#include <cstddef>
+
+namespace sensei
+{
+
+/// @class QuantileSketch
+/// @brief A mergeable approximation of the distribution of a set of values
+///
+/// QuantileSketch implements a KLL sketch. Values are added in a single
+/// streaming pass and the sketch retains O(1/epsilon) of them in a hierarchy
+/// of compactors. Quantiles computed from the sketch are within epsilon*N
+/// ranks of the exact answer with high probability, where N is the number of
+/// values added. Sketches built independently on each rank are combined with
+/// Merge, or across a communicator with Reduce, without loss of accuracy
+/// beyond the bound. The minimum and maximum are tracked exactly.
+class QuantileSketch
+{
+public:
+  /// @brief Construct a sketch with the given rank error bound.
+  QuantileSketch(double epsilon = 0.01);
+
+  /// @brief Set the rank error bound. This clears the sketch.
+  void SetEpsilon(double epsilon);
+  double GetEpsilon() const { return this->Epsilon; }
+
+  /// @brief Discard all values.
+  void Clear();
+
+  /// @brief Add a value. NaN's are ignored.
+  void Update(double val);
+
+  /// @brief Add n values read with the given stride. NaN's are ignored.
+  template <typename T>
+  void Update(const T *vals, size_t n, size_t stride = 1);
+
+  /// @brief Combine another sketch into this one. Both sketches must have been
+  /// constructed with the same error bound.
+  void Merge(const QuantileSketch &other);
+
+  /// @brief Combine the sketches of all ranks. The result is valid on the
+  /// root rank. The reduction is done with a binomial tree in log2(P) rounds
+  /// of point to point messages.
+  int Reduce(MPI_Comm comm, int root = 0);
+
+  /// @brief Get the number of values added.
+  unsigned long long GetCount() const { return this->Count; }
+
+  /// @brief Get the number of values retained.
+  size_t GetSize() const { return this->Size; }
+
+  double GetMin() const { return this->Min; }
+  double GetMax() const { return this->Max; }
+
+  /// @brief Get the approximate value at quantile q in [0, 1].
+  double GetQuantile(double q) const;
+
+  /// @brief Compute n evenly spaced quantiles. cdf[0] is the minimum and
+  /// cdf[n-1] is the maximum. The i-th entry is the value of rank
+  /// i*(N)/(n-1) in sorted order, matching CDFReducer.
+  void GetCDF(unsigned int n, double *cdf) const;
+
+  /// @brief Serialize the sketch into a flat buffer of doubles.
+  void Pack(std::vector<double> &buf) const;
+
+  /// @brief Deserialize a sketch packed by Pack. Returns non-zero if the
+  /// buffer is malformed.
+  int Unpack(const double *buf, size_t n);
+
+private:
+  // get the number of values level h may hold before it is compacted
+  size_t GetCapacity(size_t h) const;
+
+  // compact levels until the sketch is within its capacity
+  void Compress();
+
+  // compact level h into level h + 1
+  void Compact(size_t h);
+
+  // update the cached capacity after levels have been added
+  void UpdateCapacity();
+
+  double Epsilon;
+  size_t K;
+  unsigned long long Count;
+  double Min;
+  double Max;
+  size_t Size;
+  size_t Capacity;
+  std::vector<std::vector<double>> Levels;
+  std::minstd_rand Random;
+};
+
+// --------------------------------------------------------------------------
+template <typename T>
+void QuantileSketch::Update(const T *vals, size_t n, size_t stride)
+{
+  for (size_t i = 0; i < n; ++i)
+    this->Update(static_cast<double>(vals[i*stride]));
+}
+
+}
+
+#endif
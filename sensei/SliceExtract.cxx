@@ -6,6 +6,7 @@
 #include "VTKPosthocIO.h"
 #include "VTKDataAdaptor.h"
 #include "VTKUtils.h"
+#include "ThreadPool.h"
 #include "Profiler.h"
 #include "Error.h"
 
@@ -24,6 +25,7 @@
 #include <vtkUniformGridAMRDataIterator.h>
 
 
+using vtkDataObjectPtr = vtkSmartPointer<vtkDataObject>;
 using vtkDataObjectAlgorithmPtr = vtkSmartPointer<vtkDataObjectAlgorithm>;
 using vtkCellDataToPointDataPtr = vtkSmartPointer<vtkCellDataToPointData>;
 using vtkContourFilterPtr = vtkSmartPointer<vtkContourFilter>;
@@ -440,30 +442,6 @@ int SliceExtract::IsoSurface(vtkCompositeDataSet *input,
   vtkCompositeDataSet *&output)
 {
   TimeEvent<128> mark("SliceExtract::IsoSurface");
-  // build pipeline
-  vtkContourFilterPtr contour = vtkContourFilterPtr::New();
-  contour->SetComputeScalars(1);
-
-  contour->SetInputArrayToProcess(0, 0, 0,
-    vtkDataObject::FIELD_ASSOCIATION_POINTS, arrayName.c_str());
-
-  unsigned int nVals = vals.size();
-  contour->SetNumberOfContours(nVals);
-  for (unsigned int i = 0; i < nVals; ++i)
-    contour->SetValue(i, vals[i]);
-
-  // when processing cell data first convert to point data
-  vtkCellDataToPointDataPtr cdpd;
-  if (arrayCen == vtkDataObject::CELL)
-    {
-    cdpd = vtkCellDataToPointDataPtr::New();
-    cdpd->SetPassCellData(1);
-    /* in newer VTK one can select specific arrays to convert
-     * it is important not to convert vtkGhostType.
-    cdpd->SetProcessAllArrays(0);
-    cdpd->AddCellDataArray(arrayName.c_str());*/
-    contour->SetInputConnection(cdpd->GetOutputPort());
-    }
 
   // allocate output
   vtkCompositeDataIterator *it = input->NewIterator();
@@ -482,7 +460,10 @@ int SliceExtract::IsoSurface(vtkCompositeDataSet *input,
   vtkUniformGridAMRDataIterator *amrIt = dynamic_cast<vtkUniformGridAMRDataIterator*>(it);
   vtkOverlappingAMR *amrMesh = dynamic_cast<vtkOverlappingAMR*>(input);
 
-  // process data
+  // gather the blocks. this is serial, VTK's iterators are not thread safe
+  std::vector<long> bids;
+  std::vector<vtkDataObject*> dobjsIn;
+
   it->SetSkipEmptyNodes(1);
   for (it->InitTraversal(); !it->IsDoneWithTraversal(); it->GoToNextItem())
     {
@@ -501,22 +482,58 @@ int SliceExtract::IsoSurface(vtkCompositeDataSet *input,
       bid = it->GetCurrentFlatIndex() - 1;
       }
 
-    vtkDataObject *dobjIn = it->GetCurrentDataObject();
+    bids.push_back(bid);
+    dobjsIn.push_back(it->GetCurrentDataObject());
+    }
 
-    // run the pipeline on the block
+  it->Delete();
+
+  // process the blocks concurrently, each with its own pipeline
+  unsigned int nIn = dobjsIn.size();
+  std::vector<vtkDataObjectPtr> dobjsOut(nIn);
+
+  ThreadPool::ParallelFor(nIn, [&](unsigned int i) -> int
+    {
+    // build pipeline
+    vtkContourFilterPtr contour = vtkContourFilterPtr::New();
+    contour->SetComputeScalars(1);
+
+    contour->SetInputArrayToProcess(0, 0, 0,
+      vtkDataObject::FIELD_ASSOCIATION_POINTS, arrayName.c_str());
+
+    unsigned int nVals = vals.size();
+    contour->SetNumberOfContours(nVals);
+    for (unsigned int j = 0; j < nVals; ++j)
+      contour->SetValue(j, vals[j]);
+
+    // when processing cell data first convert to point data
+    vtkCellDataToPointDataPtr cdpd;
     if (arrayCen == vtkDataObject::CELL)
-      cdpd->SetInputData(dobjIn);
+      {
+      cdpd = vtkCellDataToPointDataPtr::New();
+      cdpd->SetPassCellData(1);
+      /* in newer VTK one can select specific arrays to convert
+       * it is important not to convert vtkGhostType.
+      cdpd->SetProcessAllArrays(0);
+      cdpd->AddCellDataArray(arrayName.c_str());*/
+      contour->SetInputConnection(cdpd->GetOutputPort());
+      cdpd->SetInputData(dobjsIn[i]);
+      }
     else
-      contour->SetInputData(dobjIn);
-    contour->SetOutput(nullptr);
+      {
+      contour->SetInputData(dobjsIn[i]);
+      }
+
+    // run the pipeline on the block
     contour->Update();
 
-    // save the extract
-    vtkDataObject *dobjOut = contour->GetOutput();
-    mbds->SetBlock(bid, dobjOut);
-    }
+    dobjsOut[i] = contour->GetOutput();
+    return 0;
+    });
 
-  it->Delete();
+  // save the extracts in block order
+  for (unsigned int i = 0; i < nIn; ++i)
+    mbds->SetBlock(bids[i], dobjsOut[i]);
 
   output = mbds;
 
@@ -530,15 +547,6 @@ int SliceExtract::Slice(vtkCompositeDataSet *input,
 {
   TimeEvent<128> mark("SliceExtract::Slice");
 
-  // build pipeline
-  vtkCutterPtr slice = vtkCutterPtr::New();
-
-  vtkPlanePtr plane = vtkPlanePtr::New();
-  plane->SetOrigin(const_cast<double*>(point.data()));
-  plane->SetNormal(const_cast<double*>(normal.data()));
-
-  slice->SetCutFunction(plane.GetPointer());
-
   // allocate output
   vtkCompositeDataIterator *it = input->NewIterator();
   it->SetSkipEmptyNodes(0);
@@ -550,25 +558,45 @@ int SliceExtract::Slice(vtkCompositeDataSet *input,
   vtkMultiBlockDataSet *mbds = vtkMultiBlockDataSet::New();
   mbds->SetNumberOfBlocks(nBlocks);
 
-  // process data
+  // gather the blocks. this is serial, VTK's iterators are not thread safe
+  std::vector<unsigned int> bids;
+  std::vector<vtkDataObject*> dobjsIn;
+
   it->SetSkipEmptyNodes(1);
   for (it->InitTraversal(); !it->IsDoneWithTraversal(); it->GoToNextItem())
     {
-    // get the current block
-    unsigned int bid = it->GetCurrentFlatIndex() - 1;
-    vtkDataObject *dobjIn = it->GetCurrentDataObject();
+    bids.push_back(it->GetCurrentFlatIndex() - 1);
+    dobjsIn.push_back(it->GetCurrentDataObject());
+    }
 
-    // set up and run the pipeline
-    slice->SetInputData(dobjIn);
-    slice->SetOutput(nullptr);
+  it->Delete();
+
+  // process the blocks concurrently, each with its own pipeline
+  unsigned int nIn = dobjsIn.size();
+  std::vector<vtkDataObjectPtr> dobjsOut(nIn);
+
+  ThreadPool::ParallelFor(nIn, [&](unsigned int i) -> int
+    {
+    // build pipeline
+    vtkCutterPtr slice = vtkCutterPtr::New();
+
+    vtkPlanePtr plane = vtkPlanePtr::New();
+    plane->SetOrigin(const_cast<double*>(point.data()));
+    plane->SetNormal(const_cast<double*>(normal.data()));
+
+    slice->SetCutFunction(plane.GetPointer());
+
+    // run the pipeline on the block
+    slice->SetInputData(dobjsIn[i]);
     slice->Update();
 
-    // save the extract
-    vtkDataObject *dobjOut = slice->GetOutput();
-    mbds->SetBlock(bid, dobjOut);
-    }
+    dobjsOut[i] = slice->GetOutput();
+    return 0;
+    });
 
-  it->Delete();
+  // save the extracts in block order
+  for (unsigned int i = 0; i < nIn; ++i)
+    mbds->SetBlock(bids[i], dobjsOut[i]);
 
   output = mbds;
 
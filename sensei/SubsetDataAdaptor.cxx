@@ -0,0 +1,1048 @@
+#include "SubsetDataAdaptor.h"
+#include "MeshMetadata.h"
+#include "Profiler.h"
+#include "VTKUtils.h"
+#include "Error.h"
+
+#include <vtkCompositeDataIterator.h>
+#include <vtkCompositeDataSet.h>
+#include <vtkUniformGridAMR.h>
+#include <vtkDataObject.h>
+#include <vtkDataSet.h>
+#include <vtkImageData.h>
+#include <vtkRectilinearGrid.h>
+#include <vtkStructuredGrid.h>
+#include <vtkPoints.h>
+#include <vtkDataSetAttributes.h>
+#include <vtkFieldData.h>
+#include <vtkAbstractArray.h>
+#include <vtkDataArray.h>
+#include <vtkFloatArray.h>
+#include <vtkObjectFactory.h>
+#include <vtkSmartPointer.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <cctype>
+#include <limits>
+#include <map>
+#include <string>
+#include <vector>
+
+using vtkDataObjectPtr = vtkSmartPointer<vtkDataObject>;
+
+namespace sensei
+{
+
+// returns the name VTK uses for ghost arrays
+static
+const char *getGhostArrayName()
+{
+#if VTK_MAJOR_VERSION == 6 && VTK_MINOR_VERSION == 1
+    return "vtkGhostType";
+#else
+    return vtkDataSetAttributes::GhostArrayName();
+#endif
+}
+
+// integer division rounding toward negative and positive infinity, b > 0
+static
+int floorDiv(int a, int b)
+{
+  int q = a/b;
+  return ((a % b) && (a < 0)) ? q - 1 : q;
+}
+
+static
+int ceilDiv(int a, int b)
+{
+  return -floorDiv(-a, b);
+}
+
+// gets the point extent of image, rectilinear, and structured grids.
+// returns false for other types of dataset
+static
+bool getExtent(vtkDataSet *ds, int *ext)
+{
+  if (vtkImageData *im = dynamic_cast<vtkImageData*>(ds))
+    im->GetExtent(ext);
+  else if (vtkRectilinearGrid *rg = dynamic_cast<vtkRectilinearGrid*>(ds))
+    rg->GetExtent(ext);
+  else if (vtkStructuredGrid *sg = dynamic_cast<vtkStructuredGrid*>(ds))
+    sg->GetExtent(ext);
+  else
+    return false;
+
+  return true;
+}
+
+// true when an extent has no points
+static
+bool isEmpty(const int *ext)
+{
+  return (ext[1] < ext[0]) || (ext[3] < ext[2]) || (ext[5] < ext[4]);
+}
+
+// true for the block types that are subsampled
+static
+bool isStructured(int blockType)
+{
+  return (blockType == VTK_IMAGE_DATA) || (blockType == VTK_UNIFORM_GRID) ||
+    (blockType == VTK_STRUCTURED_POINTS) || (blockType == VTK_RECTILINEAR_GRID) ||
+    (blockType == VTK_STRUCTURED_GRID);
+}
+
+// true for the mesh types that are passed through
+static
+bool isAMR(int meshType)
+{
+  return (meshType == VTK_OVERLAPPING_AMR) ||
+    (meshType == VTK_NON_OVERLAPPING_AMR) || (meshType == VTK_UNIFORM_GRID_AMR);
+}
+
+// number of points and cells in an extent, using VTK's convention that a
+// direction with a single point contributes a single layer of cells
+static
+void getExtentSize(const std::array<int,6> &ext, long &nPoints, long &nCells)
+{
+  nPoints = 1;
+  nCells = 1;
+  for (int i = 0; i < 3; ++i)
+    {
+    long n = ext[2*i+1] - ext[2*i] + 1;
+    nPoints *= n;
+    nCells *= std::max(n - 1, 1l);
+    }
+}
+
+// copies the tuples at the given source indices. the tuples are visited in
+// VTK's order, i fastest
+template <typename src_t, typename dst_t>
+void subsetValues(const src_t *src, dst_t *dst, int nComps,
+  const std::vector<long> *ids, const long *srcDims)
+{
+  long nx = ids[0].size();
+  long ny = ids[1].size();
+  long nz = ids[2].size();
+
+  for (long k = 0; k < nz; ++k)
+    {
+    for (long j = 0; j < ny; ++j)
+      {
+      long row = (ids[2][k]*srcDims[1] + ids[1][j])*srcDims[0];
+      for (long i = 0; i < nx; ++i)
+        {
+        const src_t *psrc = src + (row + ids[0][i])*nComps;
+        for (int c = 0; c < nComps; ++c)
+          dst[c] = static_cast<dst_t>(psrc[c]);
+        dst += nComps;
+        }
+      }
+    }
+}
+
+// pairs the leaves of the source mesh with those of the reduced mesh.
+// callers may have wrapped a dataset in a multiblock, see
+// DataAdaptor::GetMesh, in that case the dataset is paired with the
+// multiblock's leaves.
+static
+int applyPaired(vtkDataObject *src, vtkDataObject *mesh,
+  VTKUtils::BinaryDatasetFunction &func)
+{
+  vtkDataSet *ds = dynamic_cast<vtkDataSet*>(src);
+  if (ds && dynamic_cast<vtkCompositeDataSet*>(mesh))
+    {
+    VTKUtils::DatasetFunction pairWithLeaf = [&](vtkDataSet *dsOut) -> int
+      {
+      return func(ds, dsOut);
+      };
+    return VTKUtils::Apply(mesh, pairWithLeaf) < 0 ? -1 : 0;
+    }
+
+  return VTKUtils::Apply(src, mesh, func);
+}
+
+
+
+struct SubsetDataAdaptor::InternalsType
+{
+  InternalsType() : Adaptor(nullptr), Stride{{1, 1, 1}},
+    Region{{0, -1, 0, -1, 0, -1}}, HaveRegion(false),
+    Precision(PRECISION_NATIVE) {}
+
+  // the source index of reduced point 0 in direction i, which places the
+  // lattice on the lower corner of the region
+  int Offset(int i) const
+  {
+    int s = this->Stride[i];
+    int r0 = this->HaveRegion ? this->Region[2*i] : 0;
+    return ((r0 % s) + s) % s;
+  }
+
+  // true when a block with the given extent is kept as is
+  bool KeepsExtent(const int *ext) const;
+
+  // computes the extent of the reduced block. returns false when no point
+  // of the lattice lies in both the extent and the region
+  bool ReduceExtent(const int *ext, int *rext) const;
+
+  // maps the bounds of an image block from the source to the reduced extent
+  void ReduceBounds(const int *ext, const int *rext, double *bounds) const;
+
+  // true when the precision of arrays of the given type is reduced
+  bool ReducesType(int type) const
+  {
+    return ((type == VTK_DOUBLE) && (this->Precision != PRECISION_NATIVE)) ||
+      ((type == VTK_FLOAT) && (this->Precision == PRECISION_FLOAT16));
+  }
+
+  // gets the indices of the source points or cells in each direction that
+  // make up the reduced block, and the dimensions of the source block
+  void GetSourceIds(const int *ext, const int *rext, bool cells,
+    std::vector<long> *ids, long *srcDims) const;
+
+  // makes the reduced block. a block that lies outside of the region is
+  // replaced by an empty block of the same type, so that the mesh agrees
+  // with the metadata. returns nullptr if an error occurred
+  vtkDataSet *NewBlock(vtkDataSet *ds) const;
+
+  // makes an array from the tuples at the given source indices, converted
+  // to the given precision
+  vtkAbstractArray *NewArray(vtkAbstractArray *aa, const std::vector<long> *ids,
+    const long *srcDims, int precision) const;
+
+  // passes the named array of a source block to the reduced block
+  int AddArray(vtkDataSet *ds, vtkDataSet *dso, int association,
+    const std::string &arrayName) const;
+
+  // gets the source of a reduced mesh, or nullptr when the mesh was
+  // passed through
+  vtkDataObject *GetSource(vtkDataObject *mesh, const std::string &meshName);
+
+  // passes the named array of the source mesh to the reduced mesh
+  int PassArray(vtkDataObject *src, vtkDataObject *mesh, int association,
+    const std::string &arrayName) const;
+
+  // updates the metadata to describe the reduced mesh
+  void ReduceMetadata(MeshMetadataPtr &md) const;
+
+  DataAdaptor *Adaptor;
+  std::array<int,3> Stride;
+  std::array<int,6> Region;
+  bool HaveRegion;
+  int Precision;
+
+  // the source meshes of the reduced meshes handed out
+  std::map<std::string, vtkDataObjectPtr> Meshes;
+};
+
+//----------------------------------------------------------------------------
+bool SubsetDataAdaptor::InternalsType::KeepsExtent(const int *ext) const
+{
+  for (int i = 0; i < 3; ++i)
+    {
+    if ((this->Stride[i] != 1) || (this->HaveRegion &&
+      ((ext[2*i] < this->Region[2*i]) || (ext[2*i+1] > this->Region[2*i+1]))))
+      return false;
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool SubsetDataAdaptor::InternalsType::ReduceExtent(const int *ext,
+  int *rext) const
+{
+  int tmp[6];
+  for (int i = 0; i < 3; ++i)
+    {
+    int lo = ext[2*i];
+    int hi = ext[2*i+1];
+
+    if (this->HaveRegion)
+      {
+      lo = std::max(lo, this->Region[2*i]);
+      hi = std::min(hi, this->Region[2*i+1]);
+      }
+
+    int s = this->Stride[i];
+    int o = this->Offset(i);
+
+    tmp[2*i] = ceilDiv(lo - o, s);
+    tmp[2*i+1] = floorDiv(hi - o, s);
+
+    if (tmp[2*i] > tmp[2*i+1])
+      return false;
+    }
+
+  memcpy(rext, tmp, sizeof(tmp));
+
+  return true;
+}
+
+//----------------------------------------------------------------------------
+void SubsetDataAdaptor::InternalsType::ReduceBounds(const int *ext,
+  const int *rext, double *bounds) const
+{
+  for (int i = 0; i < 3; ++i)
+    {
+    if (ext[2*i+1] <= ext[2*i])
+      continue;
+
+    double x0 = bounds[2*i];
+    double dx = (bounds[2*i+1] - x0)/(ext[2*i+1] - ext[2*i]);
+
+    int s = this->Stride[i];
+    int o = this->Offset(i);
+
+    bounds[2*i] = x0 + (rext[2*i]*s + o - ext[2*i])*dx;
+    bounds[2*i+1] = x0 + (rext[2*i+1]*s + o - ext[2*i])*dx;
+    }
+}
+
+//----------------------------------------------------------------------------
+void SubsetDataAdaptor::InternalsType::GetSourceIds(const int *ext,
+  const int *rext, bool cells, std::vector<long> *ids, long *srcDims) const
+{
+  for (int i = 0; i < 3; ++i)
+    {
+    long n = ext[2*i+1] - ext[2*i] + 1;
+    long rn = rext[2*i+1] - rext[2*i] + 1;
+    if (cells)
+      {
+      n = std::max(n - 1, 1l);
+      rn = std::max(rn - 1, 1l);
+      }
+
+    srcDims[i] = n;
+
+    int s = this->Stride[i];
+    int o = this->Offset(i);
+
+    // the cell at the lower corner of the reduced cell. in a direction with
+    // a single point there is a single layer of cells
+    ids[i].resize(rn);
+    for (long q = 0; q < rn; ++q)
+      ids[i][q] = std::min((rext[2*i] + q)*s + o - ext[2*i], n - 1);
+    }
+}
+
+//----------------------------------------------------------------------------
+vtkAbstractArray *SubsetDataAdaptor::InternalsType::NewArray(
+  vtkAbstractArray *aa, const std::vector<long> *ids, const long *srcDims,
+  int precision) const
+{
+  int type = aa->GetDataType();
+  bool reduce = (precision != PRECISION_NATIVE) && this->ReducesType(type);
+
+  int nComps = aa->GetNumberOfComponents();
+  long nTups = ids[0].size()*ids[1].size()*ids[2].size();
+
+  vtkAbstractArray *out = reduce ? vtkFloatArray::New() : aa->NewInstance();
+  out->SetName(aa->GetName());
+  out->SetNumberOfComponents(nComps);
+  out->SetNumberOfTuples(nTups);
+
+  vtkDataArray *da = dynamic_cast<vtkDataArray*>(aa);
+  if (!da)
+    {
+    // string and other non-numeric arrays are copied a tuple at a time
+    long q = 0;
+    for (unsigned long k = 0; k < ids[2].size(); ++k)
+      {
+      for (unsigned long j = 0; j < ids[1].size(); ++j)
+        {
+        long row = (ids[2][k]*srcDims[1] + ids[1][j])*srcDims[0];
+        for (unsigned long i = 0; i < ids[0].size(); ++i, ++q)
+          out->SetTuple(q, row + ids[0][i], aa);
+        }
+      }
+    return out;
+    }
+
+  switch (type)
+    {
+    vtkTemplateMacro(
+      const VTK_TT *src = static_cast<const VTK_TT*>(da->GetVoidPointer(0));
+      if (reduce)
+        subsetValues(src, static_cast<float*>(out->GetVoidPointer(0)),
+          nComps, ids, srcDims);
+      else
+        subsetValues(src, static_cast<VTK_TT*>(out->GetVoidPointer(0)),
+          nComps, ids, srcDims);
+      );
+    default:
+      SENSEI_ERROR("Invalid data array type " << aa->GetClassName())
+      out->Delete();
+      return nullptr;
+    }
+
+  if (reduce && (precision == PRECISION_FLOAT16))
+    {
+    float *pout = static_cast<float*>(out->GetVoidPointer(0));
+    long nVals = nTups*nComps;
+    for (long i = 0; i < nVals; ++i)
+      pout[i] = SubsetDataAdaptor::RoundToHalf(pout[i]);
+    }
+
+  return out;
+}
+
+//----------------------------------------------------------------------------
+vtkDataSet *SubsetDataAdaptor::InternalsType::NewBlock(vtkDataSet *ds) const
+{
+  // blocks that are kept as is share the source's geometry
+  int ext[6] = {0};
+  if (!getExtent(ds, ext) || this->KeepsExtent(ext))
+    {
+    vtkDataSet *dso = ds->NewInstance();
+    dso->CopyStructure(ds);
+    return dso;
+    }
+
+  int rext[6] = {0, -1, 0, -1, 0, -1};
+  bool empty = !this->ReduceExtent(ext, rext);
+
+  if (vtkImageData *im = dynamic_cast<vtkImageData*>(ds))
+    {
+    double x0[3] = {0.0};
+    double dx[3] = {0.0};
+    im->GetOrigin(x0);
+    im->GetSpacing(dx);
+
+    for (int i = 0; i < 3; ++i)
+      {
+      x0[i] += this->Offset(i)*dx[i];
+      dx[i] *= this->Stride[i];
+      }
+
+    vtkImageData *imo = im->NewInstance();
+    imo->SetOrigin(x0);
+    imo->SetSpacing(dx);
+    imo->SetExtent(rext);
+    return imo;
+    }
+
+  // an empty block gets geometry arrays with no tuples
+  std::vector<long> ids[3];
+  long srcDims[3] = {0};
+  if (!empty)
+    this->GetSourceIds(ext, rext, false, ids, srcDims);
+
+  if (vtkRectilinearGrid *rg = dynamic_cast<vtkRectilinearGrid*>(ds))
+    {
+    vtkRectilinearGrid *rgo = rg->NewInstance();
+    rgo->SetExtent(rext);
+
+    vtkDataArray *coords[3] = {rg->GetXCoordinates(),
+      rg->GetYCoordinates(), rg->GetZCoordinates()};
+
+    for (int i = 0; i < 3; ++i)
+      {
+      if (!coords[i])
+        continue;
+
+      std::vector<long> cids[3] = {ids[i], {0}, {0}};
+      long cdims[3] = {srcDims[i], 1, 1};
+
+      vtkDataArray *co = static_cast<vtkDataArray*>(
+        this->NewArray(coords[i], cids, cdims, PRECISION_NATIVE));
+
+      if (!co)
+        {
+        rgo->Delete();
+        return nullptr;
+        }
+
+      if (i == 0)
+        rgo->SetXCoordinates(co);
+      else if (i == 1)
+        rgo->SetYCoordinates(co);
+      else
+        rgo->SetZCoordinates(co);
+
+      co->Delete();
+      }
+
+    return rgo;
+    }
+
+  vtkStructuredGrid *sg = static_cast<vtkStructuredGrid*>(ds);
+  vtkStructuredGrid *sgo = sg->NewInstance();
+  sgo->SetExtent(rext);
+
+  if (vtkPoints *pts = sg->GetPoints())
+    {
+    vtkDataArray *pda = static_cast<vtkDataArray*>(
+      this->NewArray(pts->GetData(), ids, srcDims, PRECISION_NATIVE));
+
+    if (!pda)
+      {
+      sgo->Delete();
+      return nullptr;
+      }
+
+    vtkPoints *ptso = vtkPoints::New();
+    ptso->SetData(pda);
+    sgo->SetPoints(ptso);
+    ptso->Delete();
+    pda->Delete();
+    }
+
+  return sgo;
+}
+
+//----------------------------------------------------------------------------
+int SubsetDataAdaptor::InternalsType::AddArray(vtkDataSet *ds, vtkDataSet *dso,
+  int association, const std::string &arrayName) const
+{
+  // the block is not on this rank
+  if (!dso)
+    return 0;
+
+  vtkFieldData *dsa = VTKUtils::GetAttributes(ds, association);
+  vtkFieldData *dsaOut = VTKUtils::GetAttributes(dso, association);
+
+  // the simulation need not provide the array on every block
+  vtkAbstractArray *aa = dsa ? dsa->GetAbstractArray(arrayName.c_str()) : nullptr;
+  if (!aa || !dsaOut)
+    return 0;
+
+  int ext[6] = {0};
+  int rext[6] = {0};
+  bool subset = (association != vtkDataObject::FIELD) &&
+    getExtent(ds, ext) && !this->KeepsExtent(ext);
+
+  // shared without a copy
+  if (!subset && ((association == vtkDataObject::FIELD) ||
+    !this->ReducesType(aa->GetDataType())))
+    {
+    dsaOut->AddArray(aa);
+    return 0;
+    }
+
+  if (subset && !getExtent(dso, rext))
+    {
+    SENSEI_ERROR("Failed to get the extent of the reduced block")
+    return -1;
+    }
+
+  // a block outside of the region gets an array with no tuples
+  std::vector<long> ids[3];
+  long srcDims[3] = {0};
+  if (subset)
+    {
+    if (!isEmpty(rext))
+      this->GetSourceIds(ext, rext,
+        association == vtkDataObject::CELL, ids, srcDims);
+    }
+  else
+    {
+    // the precision of every tuple is reduced
+    long nTups = aa->GetNumberOfTuples();
+    ids[0].resize(nTups);
+    for (long i = 0; i < nTups; ++i)
+      ids[0][i] = i;
+    ids[1].assign(1, 0);
+    ids[2].assign(1, 0);
+    srcDims[0] = nTups;
+    srcDims[1] = 1;
+    srcDims[2] = 1;
+    }
+
+  vtkAbstractArray *ao = this->NewArray(aa, ids, srcDims, this->Precision);
+  if (!ao)
+    {
+    SENSEI_ERROR("Failed to reduce array \"" << arrayName << "\"")
+    return -1;
+    }
+
+  dsaOut->AddArray(ao);
+  ao->Delete();
+
+  return 0;
+}
+
+//----------------------------------------------------------------------------
+vtkDataObject *SubsetDataAdaptor::InternalsType::GetSource(vtkDataObject *mesh,
+  const std::string &meshName)
+{
+  std::map<std::string, vtkDataObjectPtr>::iterator it;
+  if (!mesh || ((it = this->Meshes.find(meshName)) == this->Meshes.end()))
+    return nullptr;
+
+  return it->second;
+}
+
+//----------------------------------------------------------------------------
+int SubsetDataAdaptor::InternalsType::PassArray(vtkDataObject *src,
+  vtkDataObject *mesh, int association, const std::string &arrayName) const
+{
+  VTKUtils::BinaryDatasetFunction func =
+    [&](vtkDataSet *ds, vtkDataSet *dsOut) -> int
+    {
+    return this->AddArray(ds, dsOut, association, arrayName);
+    };
+
+  return applyPaired(src, mesh, func);
+}
+
+//----------------------------------------------------------------------------
+void SubsetDataAdaptor::InternalsType::ReduceMetadata(MeshMetadataPtr &md) const
+{
+  if (isAMR(md->MeshType))
+    return;
+
+  if (this->Precision != PRECISION_NATIVE)
+    {
+    unsigned int nArrays = md->ArrayType.size();
+    for (unsigned int i = 0; i < nArrays; ++i)
+      {
+      if (md->ArrayType[i] == VTK_DOUBLE)
+        md->ArrayType[i] = VTK_FLOAT;
+      }
+    }
+
+  if (!isStructured(md->BlockType))
+    return;
+
+  bool isImage = (md->BlockType != VTK_RECTILINEAR_GRID) &&
+    (md->BlockType != VTK_STRUCTURED_GRID);
+
+  std::array<int,6> empty{{0, -1, 0, -1, 0, -1}};
+
+  if (md->Flags.BlockExtentsSet())
+    {
+    std::array<int,6> ext = md->Extent;
+    if (!this->ReduceExtent(ext.data(), md->Extent.data()))
+      md->Extent = empty;
+    else if (isImage)
+      this->ReduceBounds(ext.data(), md->Extent.data(), md->Bounds.data());
+    }
+
+  unsigned int nBlocks = md->BlockExtents.size();
+  bool haveSizes = (md->BlockNumPoints.size() == nBlocks) &&
+    (md->BlockNumCells.size() == nBlocks);
+  bool haveBounds = md->BlockBounds.size() == nBlocks;
+
+  for (unsigned int i = 0; i < nBlocks; ++i)
+    {
+    std::array<int,6> ext = md->BlockExtents[i];
+    std::array<int,6> &rext = md->BlockExtents[i];
+
+    // the block is served empty, it keeps its place and owner
+    if (!this->ReduceExtent(ext.data(), rext.data()))
+      {
+      rext = empty;
+      if (haveSizes)
+        {
+        md->BlockNumPoints[i] = 0;
+        md->BlockNumCells[i] = 0;
+        }
+      if (haveBounds)
+        md->BlockBounds[i] = {{1.0, -1.0, 1.0, -1.0, 1.0, -1.0}};
+      continue;
+      }
+
+    if (haveSizes)
+      getExtentSize(rext, md->BlockNumPoints[i], md->BlockNumCells[i]);
+
+    if (isImage && haveBounds)
+      this->ReduceBounds(ext.data(), rext.data(), md->BlockBounds[i].data());
+    }
+}
+
+
+
+//----------------------------------------------------------------------------
+senseiNewMacro(SubsetDataAdaptor);
+
+//----------------------------------------------------------------------------
+SubsetDataAdaptor::SubsetDataAdaptor()
+{
+  this->Internals = new InternalsType;
+}
+
+//----------------------------------------------------------------------------
+SubsetDataAdaptor::~SubsetDataAdaptor()
+{
+  delete this->Internals;
+}
+
+//----------------------------------------------------------------------------
+void SubsetDataAdaptor::SetDataAdaptor(DataAdaptor *da)
+{
+  this->Internals->Meshes.clear();
+  this->Internals->Adaptor = da;
+
+  // use the wrapped adaptor's communicator, duplicating it only when
+  // it changes
+  if (da)
+    {
+    int same = MPI_UNEQUAL;
+    MPI_Comm_compare(this->GetCommunicator(), da->GetCommunicator(), &same);
+    if ((same != MPI_IDENT) && (same != MPI_CONGRUENT))
+      this->SetCommunicator(da->GetCommunicator());
+    }
+}
+
+//----------------------------------------------------------------------------
+DataAdaptor *SubsetDataAdaptor::GetDataAdaptor()
+{
+  return this->Internals->Adaptor;
+}
+
+//----------------------------------------------------------------------------
+int SubsetDataAdaptor::SetStride(const std::array<int,3> &stride)
+{
+  if ((stride[0] < 1) || (stride[1] < 1) || (stride[2] < 1))
+    {
+    SENSEI_ERROR("Invalid stride " << stride[0] << ", "
+      << stride[1] << ", " << stride[2])
+    return -1;
+    }
+
+  this->Internals->Stride = stride;
+  return 0;
+}
+
+//----------------------------------------------------------------------------
+std::array<int,3> SubsetDataAdaptor::GetStride()
+{
+  return this->Internals->Stride;
+}
+
+//----------------------------------------------------------------------------
+int SubsetDataAdaptor::SetRegion(const std::array<int,6> &region)
+{
+  if ((region[0] > region[1]) || (region[2] > region[3]) ||
+    (region[4] > region[5]))
+    {
+    SENSEI_ERROR("Invalid region [" << region[0] << ", " << region[1]
+      << ", " << region[2] << ", " << region[3] << ", " << region[4]
+      << ", " << region[5] << "]")
+    return -1;
+    }
+
+  this->Internals->Region = region;
+  this->Internals->HaveRegion = true;
+  return 0;
+}
+
+//----------------------------------------------------------------------------
+void SubsetDataAdaptor::ClearRegion()
+{
+  this->Internals->Region = {{0, -1, 0, -1, 0, -1}};
+  this->Internals->HaveRegion = false;
+}
+
+//----------------------------------------------------------------------------
+int SubsetDataAdaptor::SetPrecision(int precision)
+{
+  if ((precision != SubsetDataAdaptor::PRECISION_NATIVE) &&
+    (precision != SubsetDataAdaptor::PRECISION_FLOAT32) &&
+    (precision != SubsetDataAdaptor::PRECISION_FLOAT16))
+    {
+    SENSEI_ERROR("Invalid precision " << precision)
+    return -1;
+    }
+
+  this->Internals->Precision = precision;
+  return 0;
+}
+
+//----------------------------------------------------------------------------
+int SubsetDataAdaptor::SetPrecision(std::string precisionStr)
+{
+  unsigned int n = precisionStr.size();
+  for (unsigned int i = 0; i < n; ++i)
+    precisionStr[i] = tolower(precisionStr[i]);
+
+  int precision = 0;
+  if (precisionStr == "native")
+    {
+    precision = SubsetDataAdaptor::PRECISION_NATIVE;
+    }
+  else if (precisionStr == "float32")
+    {
+    precision = SubsetDataAdaptor::PRECISION_FLOAT32;
+    }
+  else if (precisionStr == "float16")
+    {
+    precision = SubsetDataAdaptor::PRECISION_FLOAT16;
+    }
+  else
+    {
+    SENSEI_ERROR("invalid precision \"" << precisionStr << "\"")
+    return -1;
+    }
+
+  this->Internals->Precision = precision;
+  return 0;
+}
+
+//----------------------------------------------------------------------------
+int SubsetDataAdaptor::GetPrecision()
+{
+  return this->Internals->Precision;
+}
+
+//----------------------------------------------------------------------------
+float SubsetDataAdaptor::RoundToHalf(float val)
+{
+  if (std::isnan(val))
+    return val;
+
+  // the largest half is 65504, values from half way to the next power of
+  // two up overflow
+  float mag = std::fabs(val);
+  if (mag >= 65520.0f)
+    return std::copysign(std::numeric_limits<float>::infinity(), val);
+
+  // subnormal halves are multiples of 2^-24
+  if (mag < 6.103515625e-05f)
+    return std::copysign(std::nearbyint(mag*16777216.0f)/16777216.0f, val);
+
+  // normal halves have 10 of single precision's 23 mantissa bits. round
+  // the 13 bits dropped to nearest, ties to even
+  uint32_t bits = 0;
+  memcpy(&bits, &val, sizeof(float));
+  bits += 0xfff + ((bits >> 13) & 1);
+  bits &= 0xffffe000;
+  memcpy(&val, &bits, sizeof(float));
+
+  return val;
+}
+
+//----------------------------------------------------------------------------
+int SubsetDataAdaptor::GetNumberOfMeshes(unsigned int &numMeshes)
+{
+  numMeshes = 0;
+
+  if (!this->Internals->Adaptor)
+    {
+    SENSEI_ERROR("No data adaptor has been set")
+    return -1;
+    }
+
+  return this->Internals->Adaptor->GetNumberOfMeshes(numMeshes);
+}
+
+//----------------------------------------------------------------------------
+int SubsetDataAdaptor::GetMeshMetadata(unsigned int id,
+  MeshMetadataPtr &metadata)
+{
+  if (!this->Internals->Adaptor)
+    {
+    SENSEI_ERROR("No data adaptor has been set")
+    return -1;
+    }
+
+  // the extents are needed to reduce the sizes and bounds
+  MeshMetadataFlags flags = metadata->Flags;
+  metadata->Flags.SetBlockExtents();
+
+  if (this->Internals->Adaptor->GetMeshMetadata(id, metadata))
+    return -1;
+
+  this->Internals->ReduceMetadata(metadata);
+
+  if (!flags.BlockExtentsSet())
+    {
+    metadata->BlockExtents.clear();
+    metadata->Flags = flags;
+    }
+
+  return 0;
+}
+
+//----------------------------------------------------------------------------
+int SubsetDataAdaptor::GetMesh(const std::string &meshName,
+  bool structureOnly, vtkDataObject *&mesh)
+{
+  (void)structureOnly;
+
+  mesh = nullptr;
+
+  if (!this->Internals->Adaptor)
+    {
+    SENSEI_ERROR("No data adaptor has been set")
+    return -1;
+    }
+
+  TimeEvent<128> mark("SubsetDataAdaptor::GetMesh");
+
+  this->Internals->Meshes.erase(meshName);
+
+  // the geometry is needed to make the reduced blocks
+  vtkDataObject *dobj = nullptr;
+  if (this->Internals->Adaptor->GetMesh(meshName, false, dobj))
+    {
+    SENSEI_ERROR("Failed to get mesh \"" << meshName << "\"")
+    return -1;
+    }
+
+  // it is not an error for a rank to have no data
+  if (!dobj)
+    return 0;
+
+  vtkCompositeDataSet *cd = dynamic_cast<vtkCompositeDataSet*>(dobj);
+  vtkDataSet *ds = dynamic_cast<vtkDataSet*>(dobj);
+
+  // AMR and other types of data are passed through
+  if (dynamic_cast<vtkUniformGridAMR*>(dobj) || (!cd && !ds))
+    {
+    mesh = dobj;
+    return 0;
+    }
+
+  vtkDataObjectPtr src;
+  src.TakeReference(dobj);
+
+  if (cd)
+    {
+    vtkCompositeDataSet *cdo = cd->NewInstance();
+    cdo->CopyStructure(cd);
+
+    vtkCompositeDataIterator *cdit = cd->NewIterator();
+    while (!cdit->IsDoneWithTraversal())
+      {
+      if (vtkDataSet *leaf = dynamic_cast<vtkDataSet*>(cd->GetDataSet(cdit)))
+        {
+        vtkDataSet *dso = this->Internals->NewBlock(leaf);
+        if (!dso)
+          {
+          SENSEI_ERROR("Failed to reduce a block of mesh \""
+            << meshName << "\"")
+          cdit->Delete();
+          cdo->Delete();
+          return -1;
+          }
+        cdo->SetDataSet(cdit, dso);
+        dso->Delete();
+        }
+      cdit->GoToNextItem();
+      }
+
+    cdit->Delete();
+
+    mesh = cdo;
+    }
+  else if (!(mesh = this->Internals->NewBlock(ds)))
+    {
+    SENSEI_ERROR("Failed to reduce mesh \"" << meshName << "\"")
+    return -1;
+    }
+
+  this->Internals->Meshes[meshName] = src;
+
+  return 0;
+}
+
+//----------------------------------------------------------------------------
+int SubsetDataAdaptor::AddGhostNodesArray(vtkDataObject *mesh,
+  const std::string &meshName)
+{
+  if (!this->Internals->Adaptor)
+    {
+    SENSEI_ERROR("No data adaptor has been set")
+    return -1;
+    }
+
+  // meshes that were passed through are forwarded
+  vtkDataObject *src = this->Internals->GetSource(mesh, meshName);
+  if (!src)
+    return this->Internals->Adaptor->AddGhostNodesArray(mesh, meshName);
+
+  if (this->Internals->Adaptor->AddGhostNodesArray(src, meshName))
+    return -1;
+
+  return this->Internals->PassArray(src, mesh,
+    vtkDataObject::POINT, getGhostArrayName());
+}
+
+//----------------------------------------------------------------------------
+int SubsetDataAdaptor::AddGhostCellsArray(vtkDataObject *mesh,
+  const std::string &meshName)
+{
+  if (!this->Internals->Adaptor)
+    {
+    SENSEI_ERROR("No data adaptor has been set")
+    return -1;
+    }
+
+  vtkDataObject *src = this->Internals->GetSource(mesh, meshName);
+  if (!src)
+    return this->Internals->Adaptor->AddGhostCellsArray(mesh, meshName);
+
+  if (this->Internals->Adaptor->AddGhostCellsArray(src, meshName))
+    return -1;
+
+  return this->Internals->PassArray(src, mesh,
+    vtkDataObject::CELL, getGhostArrayName());
+}
+
+//----------------------------------------------------------------------------
+int SubsetDataAdaptor::AddArray(vtkDataObject *mesh,
+  const std::string &meshName, int association, const std::string &arrayName)
+{
+  if (!this->Internals->Adaptor)
+    {
+    SENSEI_ERROR("No data adaptor has been set")
+    return -1;
+    }
+
+  vtkDataObject *src = this->Internals->GetSource(mesh, meshName);
+  if (!src)
+    return this->Internals->Adaptor->AddArray(mesh, meshName,
+      association, arrayName);
+
+  if (this->Internals->Adaptor->AddArray(src, meshName,
+    association, arrayName))
+    return -1;
+
+  return this->Internals->PassArray(src, mesh, association, arrayName);
+}
+
+//----------------------------------------------------------------------------
+int SubsetDataAdaptor::ReleaseData()
+{
+  this->Internals->Meshes.clear();
+  return 0;
+}
+
+//----------------------------------------------------------------------------
+double SubsetDataAdaptor::GetDataTime()
+{
+  return this->Internals->Adaptor ?
+    this->Internals->Adaptor->GetDataTime() : this->DataAdaptor::GetDataTime();
+}
+
+//----------------------------------------------------------------------------
+void SubsetDataAdaptor::SetDataTime(double time)
+{
+  if (this->Internals->Adaptor)
+    this->Internals->Adaptor->SetDataTime(time);
+  else
+    this->DataAdaptor::SetDataTime(time);
+}
+
+//----------------------------------------------------------------------------
+long SubsetDataAdaptor::GetDataTimeStep()
+{
+  return this->Internals->Adaptor ?
+    this->Internals->Adaptor->GetDataTimeStep() :
+    this->DataAdaptor::GetDataTimeStep();
+}
+
+//----------------------------------------------------------------------------
+void SubsetDataAdaptor::SetDataTimeStep(long index)
+{
+  if (this->Internals->Adaptor)
+    this->Internals->Adaptor->SetDataTimeStep(index);
+  else
+    this->DataAdaptor::SetDataTimeStep(index);
+}
+
+}
@@ -0,0 +1,121 @@
+#ifndef sensei_SubsetDataAdaptor_h
+#define sensei_SubsetDataAdaptor_h
+
+#include "DataAdaptor.h"
+
+#include <array>
+#include <string>
+
+namespace sensei
+{
+
+/// @class SubsetDataAdaptor
+/// @brief A DataAdaptor that forwards to another adaptor and reduces the
+/// size of the structured blocks it serves
+///
+/// The blocks of image, rectilinear, and structured grids are subsampled
+/// every Stride points in each direction and restricted to a box of point
+/// indices, the region of interest. Indices are those of the blocks'
+/// extents. The subsampling lattice passes through the lower corner of the
+/// region, or through index 0 when no region is set, and is shared by all
+/// blocks: point i of a reduced block is point i*Stride[0] + o of the source,
+/// where o is Region[0] modulo Stride[0]. Cell data is taken from the source
+/// cell at the lower corner of each reduced cell. Blocks with no point on
+/// the lattice inside the region are served as empty blocks of the same
+/// type, with an empty extent and arrays with no tuples, and keep their
+/// place and owner in the metadata. Cells between blocks that do not share
+/// a layer of points on the lattice are lost.
+///
+/// The precision of floating point arrays can be reduced. PRECISION_FLOAT32
+/// converts double precision arrays to single precision. PRECISION_FLOAT16
+/// additionally rounds the values of double and single precision arrays to
+/// the nearest half precision value. Since neither VTK nor the transports
+/// have a half precision type the values are stored in single precision,
+/// where the cleared low order bits compress well.
+///
+/// When the stride is 1, a block lies inside the region, and the precision
+/// of an array is unchanged, the reduced block shares the source block's
+/// geometry and arrays and nothing is copied.
+///
+/// Blocks of other types are passed through with their arrays' precision
+/// reduced, AMR meshes are passed through unchanged. The mesh metadata is
+/// updated to describe the reduced meshes: the global and block extents,
+/// block sizes, image bounds, and array types. Other bounds and the array
+/// ranges are those of the source, which contain those of the reduced data.
+class SubsetDataAdaptor : public DataAdaptor
+{
+public:
+  static SubsetDataAdaptor *New();
+  senseiTypeMacro(SubsetDataAdaptor, DataAdaptor);
+
+  /// @brief Set the adaptor to forward to. This releases the meshes held
+  /// for the previous adaptor.
+  void SetDataAdaptor(DataAdaptor *da);
+  DataAdaptor *GetDataAdaptor();
+
+  /// @brief Set the number of points to advance in the i, j, and k
+  /// directions. The default of 1 keeps every point.
+  int SetStride(const std::array<int,3> &stride);
+  std::array<int,3> GetStride();
+
+  /// @brief Set the region of interest [i0,i1, j0,j1, k0,k1] in point
+  /// indices. By default the whole mesh is kept.
+  int SetRegion(const std::array<int,6> &region);
+  void ClearRegion();
+
+  /// @brief Set the precision of floating point arrays. PRECISION_NATIVE,
+  /// the default, leaves arrays unchanged. The string form accepts "native",
+  /// "float32", and "float16".
+  enum {PRECISION_NATIVE=0, PRECISION_FLOAT32=1, PRECISION_FLOAT16=2};
+  int SetPrecision(int precision);
+  int SetPrecision(std::string precision);
+  int GetPrecision();
+
+  /// @brief Rounds a value to the nearest half precision value, with ties
+  /// to even. Values too large for half precision become infinite.
+  static float RoundToHalf(float val);
+
+  // SENSEI DataAdaptor API, forwarded to the wrapped adaptor
+  int GetNumberOfMeshes(unsigned int &numMeshes) override;
+
+  int GetMeshMetadata(unsigned int id, MeshMetadataPtr &metadata) override;
+
+  int GetMesh(const std::string &meshName, bool structureOnly,
+    vtkDataObject *&mesh) override;
+
+  using sensei::DataAdaptor::GetMesh;
+
+  int AddGhostNodesArray(vtkDataObject* mesh,
+    const std::string &meshName) override;
+
+  int AddGhostCellsArray(vtkDataObject* mesh,
+    const std::string &meshName) override;
+
+  int AddArray(vtkDataObject* mesh, const std::string &meshName,
+    int association, const std::string &arrayName) override;
+
+  /// @brief Releases the source meshes held by this adaptor. The wrapped
+  /// adaptor's data is released by its owner.
+  int ReleaseData() override;
+
+  double GetDataTime() override;
+  void SetDataTime(double time) override;
+
+  long GetDataTimeStep() override;
+  void SetDataTimeStep(long index) override;
+
+protected:
+  SubsetDataAdaptor();
+  ~SubsetDataAdaptor();
+
+  SubsetDataAdaptor(const SubsetDataAdaptor&) = delete;
+  void operator=(const SubsetDataAdaptor&) = delete;
+
+private:
+  struct InternalsType;
+  InternalsType *Internals;
+};
+
+}
+
+#endif
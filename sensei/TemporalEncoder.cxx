@@ -0,0 +1,545 @@
+#include "TemporalEncoder.h"
+#include "Error.h"
+
+#include <vtkZLibDataCompressor.h>
+
+#include <cstdint>
+#include <cstring>
+
+namespace sensei
+{
+
+// every frame starts with a header of 32 bytes
+//
+//   0  magic "STE1"
+//   4  the delta mode of the writer
+//   5  flags, FLAG_KEY_FRAME and FLAG_SHUFFLE
+//   6  the compressor applied to the payload
+//   7  the element size
+//   8  the index of the frame in the key's sequence (uint64)
+//  16  the size of the decoded values in bytes (uint64)
+//  24  the size of the payload in bytes (uint64)
+//
+static const char Magic[4] = {'S', 'T', 'E', '1'};
+static const size_t HeaderSize = 32;
+
+enum { FLAG_KEY_FRAME = 0x1, FLAG_SHUFFLE = 0x2 };
+
+// runs shorter than this are stored as literals
+static const size_t MinRun = 3;
+
+// --------------------------------------------------------------------------
+static
+bool validElementSize(unsigned int elemSize)
+{
+  return (elemSize == 1) || (elemSize == 2) || (elemSize == 4) || (elemSize == 8);
+}
+
+// r = a - b or r = a ^ b, on the bit patterns as unsigned integers
+template <typename T>
+void difference(int mode, const unsigned char *a, const unsigned char *b,
+  unsigned char *r, size_t nBytes)
+{
+  const T *pa = reinterpret_cast<const T*>(a);
+  const T *pb = reinterpret_cast<const T*>(b);
+  T *pr = reinterpret_cast<T*>(r);
+  size_t n = nBytes/sizeof(T);
+
+  if (mode == TemporalEncoder::DELTA_XOR)
+    {
+    for (size_t i = 0; i < n; ++i)
+      pr[i] = pa[i] ^ pb[i];
+    }
+  else
+    {
+    for (size_t i = 0; i < n; ++i)
+      pr[i] = T(pa[i] - pb[i]);
+    }
+}
+
+// a = r + b or a = r ^ b, the inverse of difference
+template <typename T>
+void integrate(int mode, const unsigned char *r, const unsigned char *b,
+  unsigned char *a, size_t nBytes)
+{
+  const T *pr = reinterpret_cast<const T*>(r);
+  const T *pb = reinterpret_cast<const T*>(b);
+  T *pa = reinterpret_cast<T*>(a);
+  size_t n = nBytes/sizeof(T);
+
+  if (mode == TemporalEncoder::DELTA_XOR)
+    {
+    for (size_t i = 0; i < n; ++i)
+      pa[i] = pr[i] ^ pb[i];
+    }
+  else
+    {
+    for (size_t i = 0; i < n; ++i)
+      pa[i] = T(pr[i] + pb[i]);
+    }
+}
+
+// --------------------------------------------------------------------------
+static
+void difference(int mode, unsigned int elemSize, const unsigned char *a,
+  const unsigned char *b, unsigned char *r, size_t nBytes)
+{
+  switch (elemSize)
+    {
+    case 1: difference<uint8_t>(mode, a, b, r, nBytes); break;
+    case 2: difference<uint16_t>(mode, a, b, r, nBytes); break;
+    case 4: difference<uint32_t>(mode, a, b, r, nBytes); break;
+    case 8: difference<uint64_t>(mode, a, b, r, nBytes); break;
+    }
+}
+
+// --------------------------------------------------------------------------
+static
+void integrate(int mode, unsigned int elemSize, const unsigned char *r,
+  const unsigned char *b, unsigned char *a, size_t nBytes)
+{
+  switch (elemSize)
+    {
+    case 1: integrate<uint8_t>(mode, r, b, a, nBytes); break;
+    case 2: integrate<uint16_t>(mode, r, b, a, nBytes); break;
+    case 4: integrate<uint32_t>(mode, r, b, a, nBytes); break;
+    case 8: integrate<uint64_t>(mode, r, b, a, nBytes); break;
+    }
+}
+
+// gather byte b of every element into the b-th plane
+static
+void shuffle(const unsigned char *in, size_t nBytes, unsigned int elemSize,
+  unsigned char *out)
+{
+  size_t n = nBytes/elemSize;
+  for (unsigned int b = 0; b < elemSize; ++b)
+    {
+    unsigned char *plane = out + b*n;
+    for (size_t i = 0; i < n; ++i)
+      plane[i] = in[i*elemSize + b];
+    }
+}
+
+// --------------------------------------------------------------------------
+static
+void unshuffle(const unsigned char *in, size_t nBytes, unsigned int elemSize,
+  unsigned char *out)
+{
+  size_t n = nBytes/elemSize;
+  for (unsigned int b = 0; b < elemSize; ++b)
+    {
+    const unsigned char *plane = in + b*n;
+    for (size_t i = 0; i < n; ++i)
+      out[i*elemSize + b] = plane[i];
+    }
+}
+
+// the run length code is a sequence of tokens. a control byte c < 0x80 is
+// followed by c + 1 literal bytes. a control byte c >= 0x80 is followed by
+// the value of a run of (c & 0x7f) + MinRun bytes, when c is 0xff a variable
+// length integer holding the remainder of the length comes before the value.
+static
+void rleLiterals(const unsigned char *in, size_t n, std::vector<unsigned char> &out)
+{
+  while (n)
+    {
+    size_t len = n > 128 ? 128 : n;
+    out.push_back(static_cast<unsigned char>(len - 1));
+    out.insert(out.end(), in, in + len);
+    in += len;
+    n -= len;
+    }
+}
+
+// --------------------------------------------------------------------------
+static
+void rleRun(unsigned char val, size_t len, std::vector<unsigned char> &out)
+{
+  len -= MinRun;
+  if (len < 0x7f)
+    {
+    out.push_back(static_cast<unsigned char>(0x80 | len));
+    }
+  else
+    {
+    out.push_back(0xff);
+    len -= 0x7f;
+    while (len >= 0x80)
+      {
+      out.push_back(static_cast<unsigned char>(0x80 | (len & 0x7f)));
+      len >>= 7;
+      }
+    out.push_back(static_cast<unsigned char>(len));
+    }
+  out.push_back(val);
+}
+
+// --------------------------------------------------------------------------
+static
+void rleEncode(const unsigned char *in, size_t n, std::vector<unsigned char> &out)
+{
+  size_t lit = 0;
+  size_t i = 0;
+  while (i < n)
+    {
+    size_t j = i + 1;
+    while ((j < n) && (in[j] == in[i]))
+      ++j;
+
+    if (j - i >= MinRun)
+      {
+      rleLiterals(in + lit, i - lit, out);
+      rleRun(in[i], j - i, out);
+      lit = j;
+      }
+
+    i = j;
+    }
+
+  rleLiterals(in + lit, n - lit, out);
+}
+
+// --------------------------------------------------------------------------
+static
+int rleDecode(const unsigned char *in, size_t nIn, unsigned char *out, size_t nOut)
+{
+  size_t i = 0;
+  size_t o = 0;
+  while (i < nIn)
+    {
+    unsigned char c = in[i++];
+    if (c < 0x80)
+      {
+      size_t len = size_t(c) + 1;
+      if ((i + len > nIn) || (o + len > nOut))
+        return -1;
+      memcpy(out + o, in + i, len);
+      i += len;
+      o += len;
+      }
+    else
+      {
+      size_t len = c & 0x7f;
+      if (c == 0xff)
+        {
+        size_t extra = 0;
+        unsigned int shift = 0;
+        unsigned char b = 0x80;
+        while (b & 0x80)
+          {
+          if ((i >= nIn) || (shift > 56))
+            return -1;
+          b = in[i++];
+          extra |= size_t(b & 0x7f) << shift;
+          shift += 7;
+          }
+        len += extra;
+        }
+      len += MinRun;
+      if ((i >= nIn) || (o + len > nOut))
+        return -1;
+      memset(out + o, in[i++], len);
+      o += len;
+      }
+    }
+
+  return o == nOut ? 0 : -1;
+}
+
+// compress with zlib through VTK's compressor, at the fastest level since
+// the delta and shuffle stages have already exposed the redundancy. returns
+// the size of the compressed bytes appended to out, or 0 if zlib failed.
+static
+size_t zlibEncode(const unsigned char *in, size_t n, std::vector<unsigned char> &out)
+{
+  vtkZLibDataCompressor *zc = vtkZLibDataCompressor::New();
+  zc->SetCompressionLevel(1);
+
+  size_t nOut = out.size();
+  size_t space = zc->GetMaximumCompressionSpace(n);
+  out.resize(nOut + space);
+
+  size_t nComp = zc->Compress(in, n, out.data() + nOut, space);
+  out.resize(nOut + nComp);
+
+  zc->Delete();
+
+  return nComp;
+}
+
+// --------------------------------------------------------------------------
+static
+int zlibDecode(const unsigned char *in, size_t nIn, unsigned char *out, size_t nOut)
+{
+  vtkZLibDataCompressor *zc = vtkZLibDataCompressor::New();
+  size_t nDec = zc->Uncompress(in, nIn, out, nOut);
+  zc->Delete();
+  return nDec == nOut ? 0 : -1;
+}
+
+// --------------------------------------------------------------------------
+TemporalEncoder::TemporalEncoder() : DeltaMode(DELTA_NONE), Shuffle(0),
+  Compressor(COMPRESSOR_NONE), KeyFrameInterval(10), Frames()
+{
+}
+
+// --------------------------------------------------------------------------
+int TemporalEncoder::SetDeltaMode(int mode)
+{
+  if ((mode != DELTA_NONE) && (mode != DELTA_XOR) && (mode != DELTA_ARITHMETIC))
+    {
+    SENSEI_ERROR("Invalid delta mode " << mode)
+    return -1;
+    }
+
+  this->DeltaMode = mode;
+  return 0;
+}
+
+// --------------------------------------------------------------------------
+int TemporalEncoder::SetDeltaMode(const std::string &mode)
+{
+  if (mode == "none")
+    return this->SetDeltaMode(DELTA_NONE);
+  else if (mode == "xor")
+    return this->SetDeltaMode(DELTA_XOR);
+  else if (mode == "arithmetic")
+    return this->SetDeltaMode(DELTA_ARITHMETIC);
+
+  SENSEI_ERROR("Invalid delta mode \"" << mode
+    << "\". Use one of none, xor, or arithmetic")
+  return -1;
+}
+
+// --------------------------------------------------------------------------
+int TemporalEncoder::SetCompressor(int comp)
+{
+  if ((comp != COMPRESSOR_NONE) && (comp != COMPRESSOR_RLE) &&
+    (comp != COMPRESSOR_ZLIB))
+    {
+    SENSEI_ERROR("Invalid compressor " << comp)
+    return -1;
+    }
+
+  this->Compressor = comp;
+  return 0;
+}
+
+// --------------------------------------------------------------------------
+int TemporalEncoder::SetCompressor(const std::string &comp)
+{
+  if (comp == "none")
+    return this->SetCompressor(COMPRESSOR_NONE);
+  else if (comp == "rle")
+    return this->SetCompressor(COMPRESSOR_RLE);
+  else if (comp == "zlib")
+    return this->SetCompressor(COMPRESSOR_ZLIB);
+
+  SENSEI_ERROR("Invalid compressor \"" << comp
+    << "\". Use one of none, rle, or zlib")
+  return -1;
+}
+
+// --------------------------------------------------------------------------
+TemporalEncoder::Frame &TemporalEncoder::GetFrame(const std::string &key)
+{
+  std::lock_guard<std::mutex> lock(this->FramesMutex);
+  return this->Frames[key];
+}
+
+// --------------------------------------------------------------------------
+size_t TemporalEncoder::GetHeaderSize()
+{
+  return HeaderSize;
+}
+
+// --------------------------------------------------------------------------
+int TemporalEncoder::Encode(const std::string &key, const void *data,
+  size_t nBytes, unsigned int elemSize, std::vector<unsigned char> &out)
+{
+  if (!validElementSize(elemSize) || (nBytes % elemSize))
+    {
+    SENSEI_ERROR("Can't encode " << nBytes << " bytes of \"" << key
+      << "\" with elements of " << elemSize << " bytes")
+    return -1;
+    }
+
+  const unsigned char *vals = static_cast<const unsigned char*>(data);
+
+  // scratch space, per thread so that keys can be encoded concurrently
+  thread_local std::vector<unsigned char> work[2];
+
+  // decide if this is a key frame
+  Frame &prev = this->GetFrame(key);
+  unsigned long long index = prev.Index;
+
+  bool keyFrame = (this->DeltaMode == DELTA_NONE) || (index == 0) ||
+    (prev.Data.size() != nBytes) ||
+    (this->KeyFrameInterval && ((index % this->KeyFrameInterval) == 0));
+
+  // difference against the previous step
+  const unsigned char *res = vals;
+  if (!keyFrame)
+    {
+    work[0].resize(nBytes);
+    difference(this->DeltaMode, elemSize, vals, prev.Data.data(),
+      work[0].data(), nBytes);
+    res = work[0].data();
+    }
+
+  // group the bytes by significance
+  bool shuf = this->Shuffle && (elemSize > 1);
+  if (shuf)
+    {
+    work[1].resize(nBytes);
+    shuffle(res, nBytes, elemSize, work[1].data());
+    res = work[1].data();
+    }
+
+  // compress. the values are stored as is when that would be smaller
+  out.resize(HeaderSize);
+
+  int comp = this->Compressor;
+  if (comp == COMPRESSOR_RLE)
+    {
+    rleEncode(res, nBytes, out);
+    if (out.size() - HeaderSize >= nBytes)
+      comp = COMPRESSOR_NONE;
+    }
+  else if (comp == COMPRESSOR_ZLIB)
+    {
+    size_t nComp = zlibEncode(res, nBytes, out);
+    if ((nComp == 0) || (nComp >= nBytes))
+      comp = COMPRESSOR_NONE;
+    }
+
+  if (comp == COMPRESSOR_NONE)
+    {
+    out.resize(HeaderSize + nBytes);
+    memcpy(out.data() + HeaderSize, res, nBytes);
+    }
+
+  // fill in the header
+  uint64_t hdr[3] = {index, nBytes, out.size() - HeaderSize};
+
+  unsigned char *pout = out.data();
+  memcpy(pout, Magic, 4);
+  pout[4] = static_cast<unsigned char>(this->DeltaMode);
+  pout[5] = (keyFrame ? FLAG_KEY_FRAME : 0) | (shuf ? FLAG_SHUFFLE : 0);
+  pout[6] = static_cast<unsigned char>(comp);
+  pout[7] = static_cast<unsigned char>(elemSize);
+  memcpy(pout + 8, hdr, sizeof(hdr));
+
+  // keep the values for the next step
+  if (this->DeltaMode != DELTA_NONE)
+    prev.Data.assign(vals, vals + nBytes);
+
+  prev.Index = index + 1;
+
+  return 0;
+}
+
+// --------------------------------------------------------------------------
+int TemporalEncoder::Decode(const std::string &key, const unsigned char *in,
+  size_t inBytes, void *data, size_t nBytes)
+{
+  if ((inBytes < HeaderSize) || memcmp(in, Magic, 4))
+    {
+    SENSEI_ERROR("The frame of \"" << key << "\" has no header")
+    return -1;
+    }
+
+  int mode = in[4];
+  bool keyFrame = in[5] & FLAG_KEY_FRAME;
+  bool shuf = in[5] & FLAG_SHUFFLE;
+  int comp = in[6];
+  unsigned int elemSize = in[7];
+
+  uint64_t hdr[3] = {0, 0, 0};
+  memcpy(hdr, in + 8, sizeof(hdr));
+
+  unsigned long long index = hdr[0];
+  size_t payloadBytes = hdr[2];
+
+  if (!validElementSize(elemSize) || (hdr[1] != nBytes) ||
+    (payloadBytes != inBytes - HeaderSize) || (nBytes % elemSize) ||
+    (mode > DELTA_ARITHMETIC) || (comp > COMPRESSOR_ZLIB))
+    {
+    SENSEI_ERROR("The frame of \"" << key << "\" is malformed or does not"
+      " hold " << nBytes << " bytes")
+    return -1;
+    }
+
+  Frame &prev = this->GetFrame(key);
+  if (!keyFrame && ((prev.Index != index) || (prev.Data.size() != nBytes)))
+    {
+    SENSEI_ERROR("Frame " << index << " of \"" << key << "\" depends on"
+      " frame " << index - 1 << " which was not decoded. Every step since the"
+      " last key frame must be read")
+    return -1;
+    }
+
+  unsigned char *vals = static_cast<unsigned char*>(data);
+  const unsigned char *res = in + HeaderSize;
+
+  // scratch space, per thread so that keys can be decoded concurrently
+  thread_local std::vector<unsigned char> work[2];
+
+  // decompress
+  if (comp == COMPRESSOR_RLE)
+    {
+    work[0].resize(nBytes);
+    if (rleDecode(res, payloadBytes, work[0].data(), nBytes))
+      {
+      SENSEI_ERROR("The run length code of \"" << key << "\" is malformed")
+      return -1;
+      }
+    res = work[0].data();
+    }
+  else if (comp == COMPRESSOR_ZLIB)
+    {
+    work[0].resize(nBytes);
+    if (zlibDecode(res, payloadBytes, work[0].data(), nBytes))
+      {
+      SENSEI_ERROR("The zlib stream of \"" << key << "\" is malformed")
+      return -1;
+      }
+    res = work[0].data();
+    }
+  else if (payloadBytes != nBytes)
+    {
+    SENSEI_ERROR("The payload of \"" << key << "\" has " << payloadBytes
+      << " bytes, expected " << nBytes)
+    return -1;
+    }
+
+  // restore the byte order
+  if (shuf)
+    {
+    unsigned char *dest = vals;
+    if (!keyFrame)
+      {
+      work[1].resize(nBytes);
+      dest = work[1].data();
+      }
+    unshuffle(res, nBytes, elemSize, dest);
+    res = dest;
+    }
+
+  // add the previous step back in
+  if (!keyFrame)
+    integrate(mode, elemSize, res, prev.Data.data(), vals, nBytes);
+  else if (res != vals)
+    memcpy(vals, res, nBytes);
+
+  // keep the values for the next step
+  if (mode != DELTA_NONE)
+    prev.Data.assign(vals, vals + nBytes);
+
+  prev.Index = index + 1;
+
+  return 0;
+}
+
+}
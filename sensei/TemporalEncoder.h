@@ -0,0 +1,113 @@
+#ifndef sensei_TemporalEncoder_h
+#define sensei_TemporalEncoder_h
+
+#include <map>
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <mutex>
+
+namespace sensei
+{
+
+/// @class TemporalEncoder
+/// @brief Lossless temporal compression of arrays that are written every step
+///
+/// Each array is identified by a key, typically mesh, association, array and
+/// block. The encoder keeps a copy of the previous step of each key and
+/// replaces the values by their difference from that copy, either the XOR of
+/// the bit patterns or their difference as unsigned integers of the element
+/// size. Fields that change slowly in time produce residuals whose high order
+/// bytes are zero. An optional byte shuffle gathers the bytes of equal
+/// significance together and the optional run length coder or zlib removes
+/// the redundancy that results. Every KeyFrameInterval steps, and whenever the size of an
+/// array changes, the values are encoded without reference to the previous
+/// step so that a reader can start or recover there.
+///
+/// The encoded stream is self describing, a decoder needs no configuration,
+/// however it must be passed every frame of a key since the last key frame,
+/// in order.
+///
+/// Different keys may be encoded or decoded concurrently from several
+/// threads, a given key must be used by one thread at a time.
+class TemporalEncoder
+{
+public:
+  TemporalEncoder();
+  ~TemporalEncoder() = default;
+
+  /// @brief Set how values are differenced against the previous step.
+  /// DELTA_NONE, the default, encodes every step as a key frame, DELTA_XOR
+  /// XOR's the bit patterns, and DELTA_ARITHMETIC subtracts the bit patterns
+  /// as unsigned integers. The string form accepts "none", "xor", and
+  /// "arithmetic".
+  enum { DELTA_NONE = 0, DELTA_XOR = 1, DELTA_ARITHMETIC = 2 };
+  int SetDeltaMode(int mode);
+  int SetDeltaMode(const std::string &mode);
+  int GetDeltaMode() const { return this->DeltaMode; }
+
+  /// @brief Enable the byte shuffle. Off by default.
+  void SetShuffle(int val) { this->Shuffle = val; }
+  int GetShuffle() const { return this->Shuffle; }
+
+  /// @brief Set the compressor applied last. COMPRESSOR_NONE is the default.
+  /// COMPRESSOR_RLE is a byte oriented run length coder, it is fast but only
+  /// removes runs of equal bytes. COMPRESSOR_ZLIB is zlib at its fastest
+  /// level, through the copy that VTK provides, and compresses shuffled
+  /// residuals substantially better. The string form accepts "none", "rle",
+  /// and "zlib".
+  enum { COMPRESSOR_NONE = 0, COMPRESSOR_RLE = 1, COMPRESSOR_ZLIB = 2 };
+  int SetCompressor(int comp);
+  int SetCompressor(const std::string &comp);
+  int GetCompressor() const { return this->Compressor; }
+
+  /// @brief Set the number of steps between key frames. The default is 10,
+  /// 0 encodes only the first step of each key as a key frame.
+  void SetKeyFrameInterval(unsigned int n) { this->KeyFrameInterval = n; }
+  unsigned int GetKeyFrameInterval() const { return this->KeyFrameInterval; }
+
+  /// @brief Returns true if any of the encoding stages are enabled.
+  bool Enabled() const
+  { return this->DeltaMode || this->Shuffle || this->Compressor; }
+
+  /// @brief Encode nBytes of values with elements of elemSize bytes, 1, 2, 4,
+  /// or 8. The encoded bytes replace the contents of out.
+  int Encode(const std::string &key, const void *data, size_t nBytes,
+    unsigned int elemSize, std::vector<unsigned char> &out);
+
+  /// @brief Decode a frame produced by Encode into data, which must hold
+  /// nBytes. Returns non-zero if the frame is malformed, has a different
+  /// size, or depends on a frame of the key that was not decoded.
+  int Decode(const std::string &key, const unsigned char *in, size_t inBytes,
+    void *data, size_t nBytes);
+
+  /// @brief Get the size of the header that starts every encoded frame.
+  static size_t GetHeaderSize();
+
+  /// @brief Discard the previous steps of all keys.
+  void Clear() { this->Frames.clear(); }
+
+private:
+  // the previous step of a key
+  struct Frame
+    {
+    Frame() : Index(0), Data() {}
+    unsigned long long Index;
+    std::vector<unsigned char> Data;
+    };
+
+  int DeltaMode;
+  int Shuffle;
+  int Compressor;
+  unsigned int KeyFrameInterval;
+  // returns the previous step of a key. references to the elements of a
+  // map are not invalidated by insertion, only the lookup is serialized
+  Frame &GetFrame(const std::string &key);
+
+  std::map<std::string, Frame> Frames;
+  std::mutex FramesMutex;
+};
+
+}
+
+#endif
@@ -0,0 +1,219 @@
+#include "ThreadPool.h"
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <algorithm>
+#include <cstdlib>
+
+namespace sensei
+{
+
+namespace
+{
+// set on the threads of the pool, and on a thread while it runs a
+// ParallelFor, to detect nested calls
+thread_local bool InParallelFor = false;
+
+// the pool. workers wait for a new generation of work, take items until
+// none remain, and report that they are done.
+struct PoolType
+{
+  PoolType() : NumberOfThreads(0), Generation(0), Func(nullptr),
+    N(0), Next(0), Active(0), Errors(0), Shutdown(false) {}
+
+  ~PoolType() { this->StopThreads(); }
+
+  // run items of the current work until none remain
+  void RunItems()
+    {
+    unsigned int i = 0;
+    while ((i = this->Next++) < this->N)
+      {
+      if ((*this->Func)(i))
+        ++this->Errors;
+      }
+    }
+
+  // generation is that of the last work published before the thread
+  // started
+  void RunWorker(unsigned long generation)
+    {
+    InParallelFor = true;
+    while (true)
+      {
+        {
+        std::unique_lock<std::mutex> lock(this->Mutex);
+        this->WorkReady.wait(lock, [this, generation]()
+          { return this->Shutdown || (this->Generation != generation); });
+
+        if (this->Shutdown)
+          return;
+
+        generation = this->Generation;
+        }
+
+      this->RunItems();
+
+        {
+        std::lock_guard<std::mutex> lock(this->Mutex);
+        --this->Active;
+        }
+      this->WorkDone.notify_one();
+      }
+    }
+
+  void StartThreads(int nThreads)
+    {
+    for (int i = 1; i < nThreads; ++i)
+      this->Threads.push_back(std::thread(&PoolType::RunWorker, this,
+        this->Generation));
+    }
+
+  void StopThreads()
+    {
+      {
+      std::lock_guard<std::mutex> lock(this->Mutex);
+      this->Shutdown = true;
+      }
+    this->WorkReady.notify_all();
+
+    unsigned int nThreads = this->Threads.size();
+    for (unsigned int i = 0; i < nThreads; ++i)
+      this->Threads[i].join();
+
+    this->Threads.clear();
+    this->Shutdown = false;
+    }
+
+  int NumberOfThreads;
+  std::vector<std::thread> Threads;
+
+  // serializes ParallelFor and configuration
+  std::mutex CallMutex;
+
+  std::mutex Mutex;
+  std::condition_variable WorkReady;
+  std::condition_variable WorkDone;
+  unsigned long Generation;
+
+  // the current work
+  const std::function<int(unsigned int)> *Func;
+  unsigned int N;
+  std::atomic<unsigned int> Next;
+  int Active;
+  std::atomic<int> Errors;
+  bool Shutdown;
+};
+
+PoolType &GetPool()
+{
+  static PoolType pool;
+  return pool;
+}
+
+// --------------------------------------------------------------------------
+int GetDefaultNumberOfThreads()
+{
+  const char *env = getenv("SENSEI_NUM_THREADS");
+  return env ? atoi(env) : 1;
+}
+
+// --------------------------------------------------------------------------
+int RunSerial(unsigned int n, const std::function<int(unsigned int)> &func)
+{
+  int errors = 0;
+  for (unsigned int i = 0; i < n; ++i)
+    errors += func(i) ? 1 : 0;
+  return errors ? -1 : 0;
+}
+
+// --------------------------------------------------------------------------
+int ValidNumberOfThreads(int nThreads)
+{
+  return nThreads > 0 ? nThreads :
+    std::max(1, int(std::thread::hardware_concurrency()));
+}
+}
+
+// --------------------------------------------------------------------------
+void ThreadPool::SetNumberOfThreads(int nThreads)
+{
+  PoolType &pool = GetPool();
+  std::lock_guard<std::mutex> lock(pool.CallMutex);
+
+  nThreads = ValidNumberOfThreads(nThreads);
+  if (nThreads == pool.NumberOfThreads)
+    return;
+
+  // the threads are restarted on the next call
+  pool.StopThreads();
+  pool.NumberOfThreads = nThreads;
+}
+
+// --------------------------------------------------------------------------
+int ThreadPool::GetNumberOfThreads()
+{
+  PoolType &pool = GetPool();
+  std::lock_guard<std::mutex> lock(pool.CallMutex);
+
+  if (!pool.NumberOfThreads)
+    pool.NumberOfThreads = ValidNumberOfThreads(GetDefaultNumberOfThreads());
+
+  return pool.NumberOfThreads;
+}
+
+// --------------------------------------------------------------------------
+int ThreadPool::ParallelFor(unsigned int n,
+  const std::function<int(unsigned int)> &func)
+{
+  PoolType &pool = GetPool();
+
+  // run serially when nested, when the pool is in use, or when there is
+  // nothing to gain
+  std::unique_lock<std::mutex> callLock(pool.CallMutex, std::defer_lock);
+  if ((n < 2) || InParallelFor || !callLock.try_lock())
+    return RunSerial(n, func);
+
+  if (!pool.NumberOfThreads)
+    pool.NumberOfThreads = ValidNumberOfThreads(GetDefaultNumberOfThreads());
+
+  if (pool.NumberOfThreads < 2)
+    {
+    callLock.unlock();
+    return RunSerial(n, func);
+    }
+
+  if (pool.Threads.empty())
+    pool.StartThreads(pool.NumberOfThreads);
+
+  // publish the work
+    {
+    std::lock_guard<std::mutex> lock(pool.Mutex);
+    pool.Func = &func;
+    pool.N = n;
+    pool.Next = 0;
+    pool.Errors = 0;
+    pool.Active = pool.Threads.size();
+    ++pool.Generation;
+    }
+  pool.WorkReady.notify_all();
+
+  // the calling thread takes part
+  InParallelFor = true;
+  pool.RunItems();
+  InParallelFor = false;
+
+  // wait for the workers
+    {
+    std::unique_lock<std::mutex> lock(pool.Mutex);
+    pool.WorkDone.wait(lock, [&pool]() { return pool.Active == 0; });
+    pool.Func = nullptr;
+    }
+
+  return pool.Errors ? -1 : 0;
+}
+
+}
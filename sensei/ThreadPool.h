@@ -0,0 +1,43 @@
+#ifndef sensei_ThreadPool_h
+#define sensei_ThreadPool_h
+
+#include <functional>
+
+namespace sensei
+{
+
+/// @class ThreadPool
+/// @brief A pool of threads shared by the analyses in the library.
+///
+/// The analyses use the pool to process the blocks of a rank concurrently,
+/// see VTKUtils::ParallelApply. The threads are started on first use and
+/// persist until the program exits. The number of threads defaults to 1,
+/// in which case work is done serially on the calling thread. The default
+/// may be set with the SENSEI_NUM_THREADS environment variable, or with
+/// the num_threads attribute of ConfigurableAnalysis' sensei element.
+///
+/// The pool runs one ParallelFor at a time. Nested calls, and calls made
+/// while the pool is busy with another thread's work, run serially on the
+/// calling thread.
+class ThreadPool
+{
+public:
+  /// Set the number of threads, including the calling thread. Values
+  /// less than 1 select the number of hardware threads.
+  static void SetNumberOfThreads(int nThreads);
+
+  /// Get the number of threads
+  static int GetNumberOfThreads();
+
+  /// Calls func for each i in [0, n) on the threads of the pool and
+  /// returns when all calls have completed. The order of the calls is not
+  /// specified, per item results should be indexed by i and combined by
+  /// the caller. The calls may not make MPI collective calls. Returns
+  /// non-zero if any of the calls returned non-zero.
+  static int ParallelFor(unsigned int n,
+    const std::function<int(unsigned int)> &func);
+};
+
+}
+
+#endif
@@ -2,6 +2,8 @@
 #include "VTKUtils.h"
 #include "Error.h"
 #include "MeshMetadata.h"
+#include "MeshMetadataMap.h"
+#include "DataRequirements.h"
 
 #include <vtkCompositeDataIterator.h>
 #include <vtkCompositeDataSet.h>
@@ -20,13 +22,13 @@
 #include <vtkSmartPointer.h>
 
 #include <functional>
-#include <map>
+#include <unordered_map>
+#include <algorithm>
 #include <utility>
+#include <vector>
 
 using vtkDataObjectPtr = vtkSmartPointer<vtkDataObject>;
 
-using MeshMapType = std::map<std::string, vtkDataObjectPtr>;
-
 using vtkCompositeDataIteratorPtr =
   vtkSmartPointer<vtkCompositeDataIterator>;
 
@@ -35,9 +37,145 @@ namespace sensei
 
 struct VTKDataAdaptor::InternalsType
 {
-  MeshMapType MeshMap;
+  // a mesh and what has been made from it since it was set. the structure
+  // of the meshes returned by GetMesh, with and without geometry, and the
+  // metadata for each set of flags that was asked for are made once. the
+  // metadata is copied and the structure is shared by the meshes handed out
+  struct MeshType
+  {
+    MeshType(const std::string &name) : Name(name) {}
+
+    // forget what was made from the data object
+    void Invalidate()
+      {
+      this->Mesh[0] = nullptr;
+      this->Mesh[1] = nullptr;
+      this->Metadata.clear();
+      }
+
+    std::string Name;
+    vtkDataObjectPtr Object;
+    vtkDataObjectPtr Mesh[2];
+    std::vector<MeshMetadataPtr> Metadata;
+  };
+
+  // get the named mesh, or nullptr if there is none
+  MeshType *Find(const std::string &meshName)
+    {
+    std::unordered_map<std::string, unsigned int>::iterator it =
+      this->Ids.find(meshName);
+    return it == this->Ids.end() ? nullptr : &this->Meshes[it->second];
+    }
+
+  // get the named mesh, adding it if there is none
+  MeshType *FindOrInsert(const std::string &meshName);
+
+  // the meshes ordered by name, so that the ids are the same on all ranks
+  std::vector<MeshType> Meshes;
+  std::unordered_map<std::string, unsigned int> Ids;
 };
 
+//----------------------------------------------------------------------------
+VTKDataAdaptor::InternalsType::MeshType *
+VTKDataAdaptor::InternalsType::FindOrInsert(const std::string &meshName)
+{
+  if (MeshType *mesh = this->Find(meshName))
+    return mesh;
+
+  std::vector<MeshType>::iterator it = std::lower_bound(this->Meshes.begin(),
+    this->Meshes.end(), meshName, [](const MeshType &mesh,
+      const std::string &name) -> bool { return mesh.Name < name; });
+
+  unsigned int id = it - this->Meshes.begin();
+  this->Meshes.insert(it, MeshType(meshName));
+
+  unsigned int nMeshes = this->Meshes.size();
+  for (unsigned int i = id; i < nMeshes; ++i)
+    this->Ids[this->Meshes[i].Name] = i;
+
+  return &this->Meshes[id];
+}
+
+// make a new object of the same type with the same composite structure. the
+// geometry and topology of the datasets are shared unless structureOnly is
+// set. returns nullptr if the type is not supported
+static vtkDataObject *newMesh(vtkDataObject *dobj, bool structureOnly)
+{
+  if (vtkCompositeDataSet *cd = dynamic_cast<vtkCompositeDataSet*>(dobj))
+    {
+    vtkCompositeDataSet *cdo = cd->NewInstance();
+    cdo->CopyStructure(cd);
+
+    vtkCompositeDataIterator *cdit = cd->NewIterator();
+    while (!cdit->IsDoneWithTraversal())
+      {
+      vtkDataObject *dobj = cd->GetDataSet(cdit);
+      vtkDataObject *dobjo = dobj->NewInstance();
+      if (!structureOnly)
+        {
+        if (vtkDataSet *ds = dynamic_cast<vtkDataSet*>(dobj))
+          {
+          vtkDataSet *dso = static_cast<vtkDataSet*>(dobjo);
+          dso->CopyStructure(ds);
+          }
+        }
+      cdo->SetDataSet(cdit, dobjo);
+      dobjo->Delete();
+
+      cdit->GoToNextItem();
+      }
+
+    cdit->Delete();
+
+    return cdo;
+    }
+
+  if (vtkDataSet *ds = dynamic_cast<vtkDataSet*>(dobj))
+    {
+    vtkDataSet *dsOut = ds->NewInstance();
+
+    if (!structureOnly)
+      dsOut->CopyStructure(ds);
+
+    return dsOut;
+    }
+
+  return nullptr;
+}
+
+// make a shallow wrapper around a mesh made by newMesh. the wrapper has its
+// own composite hierarchy and datasets, so that arrays added to it are not
+// seen through the cached mesh, but nothing is derived from the data object
+// again. the geometry and topology are shared by reference
+static vtkDataObject *newWrapper(vtkDataObject *cached)
+{
+  if (vtkCompositeDataSet *cd = dynamic_cast<vtkCompositeDataSet*>(cached))
+    {
+    vtkCompositeDataSet *cdo = cd->NewInstance();
+    cdo->CopyStructure(cd);
+
+    vtkCompositeDataIterator *cdit = cd->NewIterator();
+    while (!cdit->IsDoneWithTraversal())
+      {
+      vtkDataObject *dobj = cd->GetDataSet(cdit);
+      vtkDataObject *dobjo = dobj->NewInstance();
+      dobjo->ShallowCopy(dobj);
+      cdo->SetDataSet(cdit, dobjo);
+      dobjo->Delete();
+
+      cdit->GoToNextItem();
+      }
+
+    cdit->Delete();
+
+    return cdo;
+    }
+
+  vtkDataObject *dobjo = cached->NewInstance();
+  dobjo->ShallowCopy(cached);
+  return dobjo;
+}
+
 //----------------------------------------------------------------------------
 senseiNewMacro(VTKDataAdaptor);
 
@@ -57,54 +195,58 @@ VTKDataAdaptor::~VTKDataAdaptor()
 void VTKDataAdaptor::SetDataObject(const std::string &meshName,
   vtkDataObject* dobj)
 {
-  this->Internals->MeshMap[meshName] = dobj;
+  InternalsType::MeshType *mesh = this->Internals->FindOrInsert(meshName);
+  mesh->Object = dobj;
+  mesh->Invalidate();
 }
 
 //----------------------------------------------------------------------------
 int VTKDataAdaptor::GetDataObject(const std::string &meshName,
   vtkDataObject *&mesh)
 {
- MeshMapType::iterator it = this->Internals->MeshMap.find(meshName);
-  if (it == this->Internals->MeshMap.end())
+  InternalsType::MeshType *it = this->Internals->Find(meshName);
+  if (!it)
     {
     SENSEI_ERROR("No mesh named \"" << meshName << "\"")
     return -1;
     }
 
-  mesh = it->second.GetPointer();
+  mesh = it->Object.GetPointer();
   return 0;
 }
 
 //----------------------------------------------------------------------------
 int VTKDataAdaptor::GetNumberOfMeshes(unsigned int &numMeshes)
 {
-  numMeshes = this->Internals->MeshMap.size();
+  numMeshes = this->Internals->Meshes.size();
   return 0;
 }
 
 //----------------------------------------------------------------------------
 int VTKDataAdaptor::GetMeshMetadata(unsigned int id, MeshMetadataPtr &metadata)
 {
-  int rank = 0;
-  int nRanks = 1;
-
-  MPI_Comm_rank(this->GetCommunicator(), &rank);
-  MPI_Comm_size(this->GetCommunicator(), &nRanks);
-
-  if (id >= this->Internals->MeshMap.size())
+  if (id >= this->Internals->Meshes.size())
     {
     SENSEI_ERROR("Index " << id << " out of bounds")
     return -1;
     }
 
   // get i'th mesh
-  MeshMapType::iterator it = this->Internals->MeshMap.begin();
+  InternalsType::MeshType &mesh = this->Internals->Meshes[id];
 
-  for (unsigned int i = 0; i < id; ++i)
-    ++it;
+  const std::string &meshName = mesh.Name;
+  vtkDataObject *dobj = mesh.Object;
 
-  std::string meshName = it->first;
-  vtkDataObject *dobj = it->second;
+  // use the metadata made for the same flags since the data object was set
+  unsigned int nCached = mesh.Metadata.size();
+  for (unsigned int i = 0; i < nCached; ++i)
+    {
+    if (mesh.Metadata[i]->Flags == metadata->Flags)
+      {
+      *metadata = *mesh.Metadata[i];
+      return 0;
+      }
+    }
 
   // fill in metadata
   metadata->MeshName = meshName;
@@ -118,6 +260,7 @@ int VTKDataAdaptor::GetMeshMetadata(unsigned int id, MeshMetadataPtr &metadata)
         << meshName << "\"")
       return -1;
       }
+    mesh.Metadata.push_back(metadata->NewCopy());
     return 0;
     }
 
@@ -130,6 +273,7 @@ int VTKDataAdaptor::GetMeshMetadata(unsigned int id, MeshMetadataPtr &metadata)
         << meshName << "\"")
       return -1;
       }
+    mesh.Metadata.push_back(metadata->NewCopy());
     return 0;
     }
 
@@ -141,58 +285,33 @@ int VTKDataAdaptor::GetMeshMetadata(unsigned int id, MeshMetadataPtr &metadata)
 int VTKDataAdaptor::GetMesh(const std::string &meshName, bool structureOnly,
   vtkDataObject *&mesh)
 {
-  vtkDataObject *dobj = nullptr;
-  if (this->GetDataObject(meshName, dobj))
+  InternalsType::MeshType *it = this->Internals->Find(meshName);
+  if (!it)
     {
     SENSEI_ERROR("Failed to get mesh \"" << meshName << "\"")
     return -1;
     }
 
-  if (vtkCompositeDataSet *cd = dynamic_cast<vtkCompositeDataSet*>(dobj))
+  // the structure is made from the data object once since it was set. each
+  // caller gets a shallow wrapper around it, so that arrays and ghosts added
+  // by one caller are not seen by the others
+  vtkDataObjectPtr &cached = it->Mesh[structureOnly ? 1 : 0];
+  if (!cached)
     {
-    vtkCompositeDataSet *cdo = cd->NewInstance();
-    cdo->CopyStructure(cd);
-
-    vtkCompositeDataIterator *cdit = cd->NewIterator();
-    while (!cdit->IsDoneWithTraversal())
+    vtkDataObject *dobj = newMesh(it->Object, structureOnly);
+    if (!dobj)
       {
-      vtkDataObject *dobj = cd->GetDataSet(cdit);
-      vtkDataObject *dobjo = dobj->NewInstance();
-      if (!structureOnly)
-        {
-        if (vtkDataSet *ds = dynamic_cast<vtkDataSet*>(dobj))
-          {
-          vtkDataSet *dso = static_cast<vtkDataSet*>(dobjo);
-          dso->CopyStructure(ds);
-          }
-        }
-      cdo->SetDataSet(cdit, dobjo);
-      dobjo->Delete();
-
-      cdit->GoToNextItem();
+      SENSEI_ERROR("Unsupoorted data object type "
+        << it->Object->GetClassName())
+      return -1;
       }
-
-    cdit->Delete();
-
-    mesh = cdo;
-    return 0;
+    cached.TakeReference(dobj);
     }
 
-  if (vtkDataSet *ds = dynamic_cast<vtkDataSet*>(dobj))
-    {
-    vtkDataSet *dsOut = ds->NewInstance();
-
-    if (!structureOnly)
-      dsOut->CopyStructure(ds);
-
-    mesh = dsOut;
-    // caller takes ownership
-
-    return 0;
-    }
+  mesh = newWrapper(cached);
+  // caller takes ownership
 
-  SENSEI_ERROR("Unsupoorted data object type " << dobj->GetClassName())
-  return -1;
+  return 0;
 }
 
 //----------------------------------------------------------------------------
@@ -324,10 +443,150 @@ int VTKDataAdaptor::GetArrayName(const std::string &meshName, int association,
   return 0;
 }
 */
+//----------------------------------------------------------------------------
+int VTKDataAdaptor::Capture(DataAdaptor *dataAdaptor,
+  const DataRequirements &reqs, int deepCopy)
+{
+  this->SetDataTime(dataAdaptor->GetDataTime());
+  this->SetDataTimeStep(dataAdaptor->GetDataTimeStep());
+
+  // see what the simulation is providing
+  MeshMetadataMap mdMap;
+  if (mdMap.Initialize(dataAdaptor))
+    {
+    SENSEI_ERROR("Failed to get metadata")
+    return -1;
+    }
+
+  // if no requirements are given capture everything the simulation provides
+  // now. the caller's requirements are left empty so that the next step
+  // captures what is provided then
+  DataRequirements allReqs;
+  const DataRequirements *capReqs = &reqs;
+  if (reqs.Empty())
+    {
+    if (allReqs.Initialize(dataAdaptor, false))
+      {
+      SENSEI_ERROR("Failed to initialze data requirements")
+      return -1;
+      }
+    capReqs = &allReqs;
+    }
+
+  MeshRequirementsIterator mit = capReqs->GetMeshRequirementsIterator();
+  for (; mit; ++mit)
+    {
+    const std::string &meshName = mit.MeshName();
+
+    MeshMetadataPtr mmd;
+    if (mdMap.GetMeshMetadata(meshName, mmd))
+      {
+      SENSEI_ERROR("Failed to get metadata for mesh \"" << meshName << "\"")
+      return -1;
+      }
+
+    vtkDataObject *dobj = nullptr;
+    if (dataAdaptor->GetMesh(meshName, mit.StructureOnly(), dobj))
+      {
+      SENSEI_ERROR("Failed to get mesh \"" << meshName << "\"")
+      return -1;
+      }
+
+    // this rank has no blocks. an empty object of the same type is kept so
+    // that the meshes are numbered the same on all ranks
+    if (!dobj)
+      {
+      if (!(dobj = VTKUtils::NewDataObject(mmd->MeshType)))
+        {
+        SENSEI_ERROR("Failed to make an empty mesh \"" << meshName << "\"")
+        return -1;
+        }
+      this->SetDataObject(meshName, dobj);
+      dobj->Delete();
+      continue;
+      }
+
+    // add the ghost cell arrays to the mesh
+    if ((mmd->NumGhostCells || VTKUtils::AMR(mmd)) &&
+      dataAdaptor->AddGhostCellsArray(dobj, meshName))
+      {
+      SENSEI_ERROR("Failed to get ghost cells for mesh \"" << meshName << "\"")
+      dobj->Delete();
+      return -1;
+      }
+
+    // add the ghost node arrays to the mesh
+    if (mmd->NumGhostNodes && dataAdaptor->AddGhostNodesArray(dobj, meshName))
+      {
+      SENSEI_ERROR("Failed to get ghost nodes for mesh \"" << meshName << "\"")
+      dobj->Delete();
+      return -1;
+      }
+
+    // add the required arrays
+    ArrayRequirementsIterator ait =
+      capReqs->GetArrayRequirementsIterator(meshName);
+    for (; ait; ++ait)
+      {
+      if (dataAdaptor->AddArray(dobj, meshName, ait.Association(), ait.Array()))
+        {
+        SENSEI_ERROR("Failed to add "
+          << VTKUtils::GetAttributesName(ait.Association())
+          << " data array \"" << ait.Array() << "\" to mesh \""
+          << meshName << "\"")
+        dobj->Delete();
+        return -1;
+        }
+      }
+
+    this->SetDataObject(meshName, dobj);
+    dobj->Delete();
+    }
+
+  // take a private copy so the simulation is free to modify its data
+  if (deepCopy)
+    this->DeepCopyDataObjects();
+
+  return 0;
+}
+
+//----------------------------------------------------------------------------
+void VTKDataAdaptor::DeepCopyDataObjects()
+{
+  unsigned int nMeshes = this->Internals->Meshes.size();
+  for (unsigned int i = 0; i < nMeshes; ++i)
+    {
+    InternalsType::MeshType &mesh = this->Internals->Meshes[i];
+    if (!mesh.Object)
+      continue;
+
+    vtkDataObject *tmp = mesh.Object->NewInstance();
+    tmp->DeepCopy(mesh.Object);
+    mesh.Object.TakeReference(tmp);
+    mesh.Invalidate();
+    }
+}
+
+//----------------------------------------------------------------------------
+unsigned long long VTKDataAdaptor::GetMemorySize()
+{
+  // VTK reports the size in kibibytes
+  unsigned long long nBytes = 0;
+  unsigned int nMeshes = this->Internals->Meshes.size();
+  for (unsigned int i = 0; i < nMeshes; ++i)
+    {
+    InternalsType::MeshType &mesh = this->Internals->Meshes[i];
+    if (mesh.Object)
+      nBytes += 1024ull*mesh.Object->GetActualMemorySize();
+    }
+  return nBytes;
+}
+
 //----------------------------------------------------------------------------
 int VTKDataAdaptor::ReleaseData()
 {
-  this->Internals->MeshMap.clear();
+  this->Internals->Meshes.clear();
+  this->Internals->Ids.clear();
   return 0;
 }
 
@@ -8,6 +8,8 @@ class vtkDataObject;
 
 namespace sensei
 {
+class DataRequirements;
+
 /// @brief DataAdaptor for a vtkDataObject.
 ///
 /// sensei::VTKDataAdaptor is a simple implementation of sensei::DataAdaptor
@@ -19,6 +21,14 @@ namespace sensei
 /// If the DataObject is a composite-dataset, the first non-null block on the
 /// current rank is assumed to the representative block for answering all
 /// queries.
+///
+/// The structure of the meshes returned by GetMesh and the metadata are made
+/// once per data object, so that several analyses of the same data object do
+/// not repeat the work. Each GetMesh call returns a shallow wrapper, a new
+/// object that references the cached geometry and topology, so arrays and
+/// ghosts added by one analysis are not seen by the others. The cache is
+/// released when the data object is set again and by ReleaseData, changes
+/// made to the data object in between are not seen by GetMesh.
 class VTKDataAdaptor : public DataAdaptor
 {
 public:
@@ -45,6 +55,30 @@ public:
   /// @returns zero if the named mesh is present, non zero if it was not
   int GetDataObject(const std::string &meshName, vtkDataObject *&dobj);
 
+  /// @brief Capture the meshes and arrays named in the requirements
+  ///
+  /// The meshes, their ghost arrays, and the required arrays are fetched
+  /// from another data adaptor along with the time and time step, so that
+  /// they can be processed after the simulation has moved on. If no
+  /// requirements are given every mesh and array provided in this step is
+  /// captured. Meshes that have no blocks on this rank are captured as empty
+  /// objects of the type given in their metadata.
+  ///
+  /// @param[in] source the data adaptor to capture from
+  /// @param[in] reqs the meshes and arrays to capture
+  /// @param[in] deepCopy if set the data is copied, otherwise it is
+  ///            referenced and the simulation must not modify it until
+  ///            ReleaseData is called
+  /// @returns zero if successful, non zero if an error occurred
+  int Capture(DataAdaptor *source, const DataRequirements &reqs,
+    int deepCopy);
+
+  /// @brief Replace each data object by a deep copy of itself.
+  void DeepCopyDataObjects();
+
+  /// @brief Get the memory used by the data objects in bytes.
+  unsigned long long GetMemorySize();
+
   /// @breif Gets the number of meshes a simulation can provide
   ///
   /// The caller passes a reference to an integer variable in the first
@@ -79,7 +113,9 @@ public:
   /// @param[in] meshName the name of the mesh to access (see GetMeshName)
   /// @param[in] structure_only When set to true (default; false) the returned mesh
   ///            may not have any geometry or topology information.
-  /// @param[out] a reference to a pointer where a new VTK object is stored
+  /// @param[out] a reference to a pointer where a new VTK object is stored,
+  ///             the caller takes ownership of it. Its geometry and topology
+  ///             are shared with the meshes returned to other callers.
   /// @returns zero if successful, non zero if an error occurred
   int GetMesh(const std::string &meshName, bool structure_only,
     vtkDataObject *&mesh) override;
@@ -1,6 +1,7 @@
 #include "senseiConfig.h"
 #include "VTKHistogram.h"
 #include "Error.h"
+#include "MPIUtils.h"
 
 #include <algorithm>
 #include <vector>
@@ -164,50 +165,67 @@ VTKHistogram::VTKHistogram()
 {
   this->Range[0] = VTK_DOUBLE_MAX;
   this->Range[1] = VTK_DOUBLE_MIN;
+  this->Bins = 0;
   this->Worker = NULL;
+  this->Pending = new MPIUtils::ReductionBatch;
 }
 
 // --------------------------------------------------------------------------
 VTKHistogram::~VTKHistogram()
 {
+  // finish reductions left in flight by PostCompute
+  delete this->Pending;
   delete this->Worker;
 }
 
 // --------------------------------------------------------------------------
-void VTKHistogram::AddRange(vtkDataArray* da,
-  vtkUnsignedCharArray* ghostArray)
+void VTKHistogram::GetRange(vtkDataArray* da,
+  vtkUnsignedCharArray* ghostArray, double range[2])
 {
+  range[0] = VTK_DOUBLE_MAX;
+  range[1] = VTK_DOUBLE_MIN;
 #ifdef ENABLE_VTK_GENERIC_ARRAYS
   (void)ghostArray;
   if (da)
-    {
-    double crange[2];
-    da->GetRange(crange);
-    this->Range[0] = std::min(this->Range[0], crange[0]);
-    this->Range[1] = std::max(this->Range[1], crange[1]);
-    }
+    da->GetRange(range);
 #else
-  double crange[2] = { vtkTypeTraits<double>::Max(), vtkTypeTraits<double>::Min() };
   if (da && ghostArray)
     {
     ComponentRangeWorker worker(ghostArray);
     vtkDataArrayDispatcher<ComponentRangeWorker> dispatcher(worker);
     dispatcher.Go(da);
-    worker.GetRange(crange);
+    worker.GetRange(range);
     }
   else if (da)
     {
-    da->GetRange(crange);
+    da->GetRange(range);
     }
-  this->Range[0] = std::min(this->Range[0], crange[0]);
-  this->Range[1] = std::max(this->Range[1], crange[1]);
 #endif
 }
 
+// --------------------------------------------------------------------------
+void VTKHistogram::AddRange(const double range[2])
+{
+  this->Range[0] = std::min(this->Range[0], range[0]);
+  this->Range[1] = std::max(this->Range[1], range[1]);
+}
+
+// --------------------------------------------------------------------------
+void VTKHistogram::AddRange(vtkDataArray* da,
+  vtkUnsignedCharArray* ghostArray)
+{
+  double crange[2];
+  VTKHistogram::GetRange(da, ghostArray, crange);
+  this->AddRange(crange);
+}
+
 // --------------------------------------------------------------------------
 void VTKHistogram::Compute(vtkDataArray* da,
   vtkUnsignedCharArray* ghostArray)
 {
+  if (!this->Worker)
+    this->FinishPreCompute();
+
   if (da)
     {
 #ifdef ENABLE_VTK_GENERIC_ARRAYS
@@ -222,16 +240,58 @@ void VTKHistogram::Compute(vtkDataArray* da,
     }
 }
 
+// --------------------------------------------------------------------------
+void VTKHistogram::Compute(vtkDataArray* da,
+  vtkUnsignedCharArray* ghostArray, std::vector<unsigned int> &hist)
+{
+  // each block is binned by its own worker
+  Internals worker(this->Range, this->Bins);
+
+  if (da)
+    {
+#ifdef ENABLE_VTK_GENERIC_ARRAYS
+    (void)ghostArray;
+    vtkArrayDispatch::Dispatch::Execute(da, worker);
+#else
+    worker.GhostArray = ghostArray;
+    vtkDataArrayDispatcher<Internals> dispatcher(worker);
+    dispatcher.Go(da);
+#endif
+    }
+
+  hist.swap(worker.Histogram);
+}
+
+// --------------------------------------------------------------------------
+void VTKHistogram::AddHistogram(const std::vector<unsigned int> &hist)
+{
+  if (!this->Worker)
+    this->FinishPreCompute();
+
+  unsigned int nBins = std::min(hist.size(), this->Worker->Histogram.size());
+  for (unsigned int i = 0; i < nBins; ++i)
+    this->Worker->Histogram[i] += hist[i];
+}
+
 // --------------------------------------------------------------------------
 void VTKHistogram::PreCompute(MPI_Comm comm, int bins)
 {
-  double g_range[2];
-  // Find the global max/min
-  MPI_Allreduce(&this->Range[0], &g_range[0], 1, MPI_DOUBLE, MPI_MIN, comm);
-  MPI_Allreduce(&this->Range[1], &g_range[1], 1, MPI_DOUBLE, MPI_MAX, comm);
-  this->Range[0] = g_range[0];
-  this->Range[1] = g_range[1];
-  this->Worker = new Internals(this->Range, bins);
+  this->Bins = bins;
+
+  // Find the global max/min. negate the min so that both are
+  // found in a single reduction
+  this->Range[0] = -this->Range[0];
+
+  this->Pending->SetCommunicator(comm);
+  this->Pending->Allreduce(this->Range, 2, MPI_MAX,
+    [this]() { this->Range[0] = -this->Range[0]; });
+}
+
+// --------------------------------------------------------------------------
+void VTKHistogram::FinishPreCompute()
+{
+  this->Pending->Wait();
+  this->Worker = new Internals(this->Range, this->Bins);
 }
 
 // --------------------------------------------------------------------------
@@ -239,16 +299,24 @@ void VTKHistogram::PostCompute(MPI_Comm comm, int nBins, int step,
   double time, const std::string &meshName, const std::string &arrayName,
   const std::string &fileName)
 {
-  std::vector<unsigned int> gHist(nBins, 0);
+  if (!this->Worker)
+    this->FinishPreCompute();
 
-  MPI_Reduce(&this->Worker->Histogram[0], &gHist[0],
-    nBins, MPI_UNSIGNED, MPI_SUM, 0, comm);
+  // sum the counts. only rank 0 waits for the result, on the other
+  // ranks the reduction completes in the background
+  std::vector<unsigned int> &gHist = this->GlobalHistogram;
+  gHist.assign(this->Worker->Histogram.begin(),
+    this->Worker->Histogram.begin() + nBins);
+
+  this->Pending->GlobalCounts(gHist);
 
   int rank = 0;
   MPI_Comm_rank(comm, &rank);
 
   if (rank == 0)
     {
+    this->Pending->Wait();
+
     // if there was an error range is initialized to [DOUBLE_MAX, DOUBLE_MIN]
     if (this->Range[0] >= this->Range[1])
       {
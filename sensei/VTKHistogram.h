@@ -10,6 +10,7 @@ class vtkDataArray;
 
 namespace sensei
 {
+namespace MPIUtils { class ReductionBatch; }
 
 class VTKHistogram
 {
@@ -19,14 +20,37 @@ public:
 
     void AddRange(vtkDataArray* da, vtkUnsignedCharArray* ghostArray);
 
-    // compute the global min and max
+    // compute the range of one block's array skipping ghosts. this
+    // is thread safe, the result is passed to AddRange.
+    static void GetRange(vtkDataArray* da, vtkUnsignedCharArray* ghostArray,
+      double range[2]);
+
+    void AddRange(const double range[2]);
+
+    // start the computation of the global min and max. the
+    // reduction completes in the first call to Compute or
+    // PostCompute, local work can be done in between.
     void PreCompute(MPI_Comm comm, int bins);
 
+    // complete the range reduction started by PreCompute and
+    // allocate the bins
+    void FinishPreCompute();
+
     // do the local histgram calculation
     void Compute(vtkDataArray* da, vtkUnsignedCharArray* ghostArray);
 
+    // compute one block's histogram. this is thread safe once
+    // FinishPreCompute has been called. the result is passed to
+    // AddHistogram.
+    void Compute(vtkDataArray* da, vtkUnsignedCharArray* ghostArray,
+      std::vector<unsigned int> &hist);
+
+    void AddHistogram(const std::vector<unsigned int> &hist);
+
     // do the reduction, write the result to a file, or cout.
-    // the result is cached on rank 0.
+    // the result is cached on rank 0. on the other ranks the
+    // reduction completes in the background and is finished by
+    // the destructor.
     void PostCompute(MPI_Comm comm, int nBins, int step, double time,
       const std::string &meshName, const std::string &arrayName,
       const std::string &fileName);
@@ -37,8 +61,11 @@ public:
 
 private:
   double Range[2];
+  int Bins;
   struct Internals;
   Internals *Worker;
+  MPIUtils::ReductionBatch *Pending;
+  std::vector<unsigned int> GlobalHistogram;
 };
 
 }
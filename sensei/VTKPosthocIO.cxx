@@ -25,7 +25,11 @@
 #include <algorithm>
 #include <sstream>
 #include <fstream>
+#include <iomanip>
 #include <cassert>
+#include <limits>
+#include <atomic>
+#include <thread>
 
 #include <sys/stat.h>
 #include <errno.h>
@@ -35,44 +39,94 @@
 #include <vtkCompositeDataPipeline.h>
 #include <vtkXMLDataSetWriter.h>
 #include <vtkDataSetWriter.h>
+#include <vtkDataSetReader.h>
+#ifdef ENABLE_VTK_FILTERS
+#include <vtkAppendFilter.h>
+#include <vtkAppendPolyData.h>
+#endif
 
 #include <mpi.h>
 
 
 //-----------------------------------------------------------------------------
 static
-std::string getBlockExtension(vtkDataObject *dob)
+std::string getBlockExtension(int blockType)
 {
-  if (dynamic_cast<vtkPolyData*>(dob))
-  {
-    return ".vtp";
-  }
-  else if (dynamic_cast<vtkUnstructuredGrid*>(dob))
-  {
-    return ".vtu";
-  }
-  else if (dynamic_cast<vtkImageData*>(dob))
-  {
-    return ".vti";
-  }
-  else if (dynamic_cast<vtkRectilinearGrid*>(dob))
-  {
-    return ".vtr";
-  }
-  else if (dynamic_cast<vtkStructuredGrid*>(dob))
-  {
-    return ".vts";
-  }
-  else if (dynamic_cast<vtkMultiBlockDataSet*>(dob))
-  {
-    return ".vtm";
-  }
-
-  SENSEI_ERROR("Failed to determine file extension for \""
-    << dob->GetClassName() << "\"")
+  switch (blockType)
+    {
+    case VTK_POLY_DATA:
+      return ".vtp";
+    case VTK_UNSTRUCTURED_GRID:
+      return ".vtu";
+    case VTK_IMAGE_DATA:
+    case VTK_UNIFORM_GRID:
+      return ".vti";
+    case VTK_RECTILINEAR_GRID:
+      return ".vtr";
+    case VTK_STRUCTURED_GRID:
+      return ".vts";
+    case VTK_MULTIBLOCK_DATA_SET:
+      return ".vtm";
+    }
   return "";
 }
 
+//-----------------------------------------------------------------------------
+static
+int gatherBytes(const std::vector<char> &sendBuf, std::vector<char> &recvBuf,
+  MPI_Comm comm)
+{
+  // gather a byte buffer of any size to rank 0. the buffers are sent in
+  // chunks that fit in an int, as a node's blocks may exceed 2 GiB.
+  const unsigned long long maxChunk = std::numeric_limits<int>::max();
+  const int tag = 3572;
+
+  int rank = 0;
+  int nRanks = 1;
+  MPI_Comm_rank(comm, &rank);
+  MPI_Comm_size(comm, &nRanks);
+
+  unsigned long long nSend = sendBuf.size();
+  std::vector<unsigned long long> counts(nRanks, 0);
+  MPI_Gather(&nSend, 1, MPI_UNSIGNED_LONG_LONG, counts.data(), 1,
+    MPI_UNSIGNED_LONG_LONG, 0, comm);
+
+  std::vector<MPI_Request> reqs;
+  if (rank == 0)
+    {
+    std::vector<unsigned long long> displ(nRanks, 0);
+    for (int i = 1; i < nRanks; ++i)
+      displ[i] = displ[i-1] + counts[i-1];
+
+    recvBuf.resize(displ[nRanks-1] + counts[nRanks-1]);
+
+    std::copy(sendBuf.begin(), sendBuf.end(), recvBuf.begin());
+
+    for (int i = 1; i < nRanks; ++i)
+      {
+      for (unsigned long long j = 0; j < counts[i]; j += maxChunk)
+        {
+        MPI_Request req;
+        MPI_Irecv(recvBuf.data() + displ[i] + j,
+          int(std::min(maxChunk, counts[i] - j)), MPI_BYTE, i, tag, comm, &req);
+        reqs.push_back(req);
+        }
+      }
+    }
+  else
+    {
+    for (unsigned long long j = 0; j < nSend; j += maxChunk)
+      {
+      MPI_Request req;
+      MPI_Isend(const_cast<char*>(sendBuf.data()) + j,
+        int(std::min(maxChunk, nSend - j)), MPI_BYTE, 0, tag, comm, &req);
+      reqs.push_back(req);
+      }
+    }
+
+  return MPI_Waitall(reqs.size(), reqs.data(), MPI_STATUSES_IGNORE);
+}
+
 //-----------------------------------------------------------------------------
 static
 std::string getBlockFileName(const std::string &outputDir,
@@ -88,6 +142,24 @@ std::string getBlockFileName(const std::string &outputDir,
   return oss.str();
 }
 
+//-----------------------------------------------------------------------------
+static
+void getFileIds(const std::vector<sensei::MeshMetadataPtr> &mmd,
+  std::vector<std::vector<long>> &ids)
+{
+  // a file is written for each block that has cells
+  long nSteps = mmd.size();
+  ids.resize(nSteps);
+  for (long i = 0; i < nSteps; ++i)
+    {
+    for (long j = 0; j < mmd[i]->NumBlocks; ++j)
+      {
+      if (mmd[i]->BlockNumCells[j] > 0)
+        ids[i].push_back(mmd[i]->BlockIds[j]);
+      }
+    }
+}
+
 namespace sensei
 {
 //-----------------------------------------------------------------------------
@@ -95,7 +167,9 @@ senseiNewMacro(VTKPosthocIO);
 
 //-----------------------------------------------------------------------------
 VTKPosthocIO::VTKPosthocIO() :
-  OutputDir("./"), Mode(MODE_PARAVIEW), Writer(WRITER_VTK_XML)
+  OutputDir("./"), Mode(MODE_PARAVIEW), Writer(WRITER_VTK_XML),
+  Compressor(COMPRESSOR_NONE), NumberOfThreads(1), Subfiling(0),
+  NodeComm(MPI_COMM_NULL), LeaderComm(MPI_COMM_NULL)
 {}
 
 //-----------------------------------------------------------------------------
@@ -204,6 +278,73 @@ int VTKPosthocIO::SetWriter(std::string writerStr)
   return 0;
 }
 
+//-----------------------------------------------------------------------------
+int VTKPosthocIO::SetCompressor(int compressor)
+{
+  if ((compressor != VTKPosthocIO::COMPRESSOR_NONE) &&
+    (compressor != VTKPosthocIO::COMPRESSOR_ZLIB) &&
+    (compressor != VTKPosthocIO::COMPRESSOR_LZ4))
+    {
+    SENSEI_ERROR("Invalid compressor " << compressor)
+    return -1;
+    }
+
+  this->Compressor = compressor;
+  return 0;
+}
+
+//-----------------------------------------------------------------------------
+int VTKPosthocIO::SetCompressor(std::string compressorStr)
+{
+  unsigned int n = compressorStr.size();
+  for (unsigned int i = 0; i < n; ++i)
+    compressorStr[i] = tolower(compressorStr[i]);
+
+  int compressor = 0;
+  if (compressorStr == "none")
+    {
+    compressor = VTKPosthocIO::COMPRESSOR_NONE;
+    }
+  else if (compressorStr == "zlib")
+    {
+    compressor = VTKPosthocIO::COMPRESSOR_ZLIB;
+    }
+  else if (compressorStr == "lz4")
+    {
+    compressor = VTKPosthocIO::COMPRESSOR_LZ4;
+    }
+  else
+    {
+    SENSEI_ERROR("invalid compressor \"" << compressorStr << "\"")
+    return -1;
+    }
+
+  this->Compressor = compressor;
+  return 0;
+}
+
+//-----------------------------------------------------------------------------
+void VTKPosthocIO::SetNumberOfThreads(int nThreads)
+{
+  this->NumberOfThreads = nThreads > 0 ? nThreads :
+    std::max(1u, std::thread::hardware_concurrency());
+}
+
+//-----------------------------------------------------------------------------
+int VTKPosthocIO::SetSubfiling(int val)
+{
+#if !defined(ENABLE_VTK_FILTERS)
+  if (val)
+    {
+    SENSEI_ERROR("Subfiling requires VTK filters. Reconfigure with"
+      " ENABLE_VTK_FILTERS=ON")
+    return -1;
+    }
+#endif
+  this->Subfiling = val;
+  return 0;
+}
+
 //-----------------------------------------------------------------------------
 void VTKPosthocIO::SetGhostArrayName(const std::string &name)
 {
@@ -342,13 +483,40 @@ bool VTKPosthocIO::Execute(DataAdaptor* dataAdaptor)
     it->SetSkipEmptyNodes(1);
     it->InitTraversal();
 
-    // figure out block distribution, assume that it does not change, and
-    // that block types are homgeneous
-    if (!it->IsDoneWithTraversal() && !this->HaveBlockInfo[meshName])
+    // figure out the block type, assume that it does not change, and that
+    // block types are homgeneous. this is taken from the global metadata so
+    // that ranks without blocks, which may be rank 0 or a node's writer,
+    // agree with the others. when the metadata does not name a concrete
+    // type the ranks with blocks supply it.
+    if (!this->HaveBlockInfo[meshName])
       {
+      int blockType = mmd->BlockType;
+      if (getBlockExtension(blockType).empty())
+        {
+        blockType = it->IsDoneWithTraversal() ? -1 :
+          it->GetCurrentDataObject()->GetDataObjectType();
+
+        MPI_Allreduce(MPI_IN_PLACE, &blockType, 1, MPI_INT, MPI_MAX,
+          this->GetCommunicator());
+        }
+
+      std::string blockExt = getBlockExtension(blockType);
+      if (blockExt.empty())
+        {
+        SENSEI_ERROR("Failed to determine file extension for blocks of type "
+          << blockType << " in mesh \"" << meshName << "\"")
+        it->Delete();
+        dobj->Delete();
+        return false;
+        }
+
+      // when subfiling the blocks are merged into polydata when all of them
+      // are polydata and into an unstructured grid otherwise
       this->BlockExt[meshName] = this->Writer == VTKPosthocIO::WRITER_VTK_LEGACY ?
-        ".vtk" : getBlockExtension(it->GetCurrentDataObject());
+        ".vtk" : (!this->Subfiling ? blockExt :
+        (blockType == VTK_POLY_DATA ? ".vtp" : ".vtu"));
 
+      this->BlockType[meshName] = blockType;
       this->HaveBlockInfo[meshName] = 1;
       }
 
@@ -357,7 +525,8 @@ bool VTKPosthocIO::Execute(DataAdaptor* dataAdaptor)
     if (dynamic_cast<vtkUniformGridAMR*>(cd.GetPointer()))
       bidShift = 0;
 
-    // write the blocks
+    // gather the blocks
+    BlockList blocks;
     for (it->InitTraversal(); !it->IsDoneWithTraversal(); it->GoToNextItem())
       {
       vtkDataSet *ds = dynamic_cast<vtkDataSet*>(it->GetCurrentDataObject());
@@ -380,10 +549,6 @@ bool VTKPosthocIO::Execute(DataAdaptor* dataAdaptor)
         return false;
         }
 
-      std::string fileName =
-        getBlockFileName(this->OutputDir, meshName, blockId,
-          this->FileId[meshName], this->BlockExt[meshName]);
-
       vtkDataArray *ga = ds->GetCellData()->GetArray("vtkGhostType");
       if (ga)
         {
@@ -391,29 +556,19 @@ bool VTKPosthocIO::Execute(DataAdaptor* dataAdaptor)
         ds->UpdateCellGhostArrayCache();
         }
 
-      if (this->Writer == VTKPosthocIO::WRITER_VTK_LEGACY)
-        {
-        vtkDataSetWriter *writer = vtkDataSetWriter::New();
-        writer->SetInputData(ds);
-        writer->SetFileName(fileName.c_str());
-        writer->SetFileTypeToBinary();
-        writer->Write();
-        writer->Delete();
-        }
-      else
-        {
-        vtkXMLDataSetWriter *writer = vtkXMLDataSetWriter::New();
-        writer->SetInputData(ds);
-        writer->SetDataModeToAppended();
-        writer->EncodeAppendedDataOff();
-        writer->SetCompressorTypeToNone();
-        writer->SetFileName(fileName.c_str());
-        writer->Write();
-        writer->Delete();
-        }
+      blocks.emplace_back(blockId, ds);
       }
     it->Delete();
 
+    // write the blocks
+    if ((this->Subfiling && this->WriteSubfile(meshName, blocks)) ||
+      (!this->Subfiling && this->WriteBlocks(meshName, blocks)))
+      {
+      SENSEI_ERROR("Failed to write mesh \"" << meshName << "\"")
+      dobj->Delete();
+      return false;
+      }
+
     // this is default initialized to 0 by definition of std::map. & we count
     // empty steps
     this->FileId[meshName] += 1;
@@ -443,9 +598,293 @@ bool VTKPosthocIO::Execute(DataAdaptor* dataAdaptor)
   return true;
 }
 
+//-----------------------------------------------------------------------------
+int VTKPosthocIO::WriteDataSet(vtkDataSet *ds, const std::string &fileName)
+{
+  int ok = 0;
+  if (this->Writer == VTKPosthocIO::WRITER_VTK_LEGACY)
+    {
+    vtkDataSetWriter *writer = vtkDataSetWriter::New();
+    writer->SetInputData(ds);
+    writer->SetFileName(fileName.c_str());
+    writer->SetFileTypeToBinary();
+    ok = writer->Write();
+    writer->Delete();
+    }
+  else
+    {
+    vtkXMLDataSetWriter *writer = vtkXMLDataSetWriter::New();
+    writer->SetInputData(ds);
+    writer->SetDataModeToAppended();
+    writer->EncodeAppendedDataOff();
+    if (this->Compressor == VTKPosthocIO::COMPRESSOR_ZLIB)
+      writer->SetCompressorTypeToZLib();
+    else if (this->Compressor == VTKPosthocIO::COMPRESSOR_LZ4)
+      writer->SetCompressorTypeToLZ4();
+    else
+      writer->SetCompressorTypeToNone();
+    writer->SetFileName(fileName.c_str());
+    ok = writer->Write();
+    writer->Delete();
+    }
+
+  if (!ok)
+    {
+    SENSEI_ERROR("Failed to write \"" << fileName << "\"")
+    return -1;
+    }
+
+  return 0;
+}
+
+//-----------------------------------------------------------------------------
+int VTKPosthocIO::WriteBlocks(const std::string &meshName,
+  const BlockList &blocks)
+{
+  unsigned int nBlocks = blocks.size();
+  if (nBlocks == 0)
+    return 0;
+
+  unsigned int nThreads = std::max(1u,
+    std::min(unsigned(this->NumberOfThreads), nBlocks));
+
+  long fileId = this->FileId[meshName];
+  const std::string &blockExt = this->BlockExt[meshName];
+
+  // each thread takes the next block until all have been written. the
+  // writers are independent, so file system latency overlaps
+  std::atomic<unsigned int> next(0);
+  std::vector<int> status(nBlocks, 0);
+
+  auto worker = [&]()
+    {
+    unsigned int i = 0;
+    while ((i = next++) < nBlocks)
+      {
+      std::string fileName = getBlockFileName(this->OutputDir, meshName,
+        blocks[i].first, fileId, blockExt);
+
+      status[i] = this->WriteDataSet(blocks[i].second, fileName);
+      }
+    };
+
+  std::vector<std::thread> threads;
+  for (unsigned int i = 1; i < nThreads; ++i)
+    threads.push_back(std::thread(worker));
+
+  worker();
+
+  for (unsigned int i = 0; i < threads.size(); ++i)
+    threads[i].join();
+
+  for (unsigned int i = 0; i < nBlocks; ++i)
+    {
+    if (status[i])
+      return -1;
+    }
+
+  return 0;
+}
+
+//-----------------------------------------------------------------------------
+int VTKPosthocIO::WriteSubfile(const std::string &meshName,
+  const BlockList &blocks)
+{
+#if !defined(ENABLE_VTK_FILTERS)
+  (void)meshName;
+  (void)blocks;
+  SENSEI_ERROR("Subfiling requires VTK filters")
+  return -1;
+#else
+  MPI_Comm comm = this->GetCommunicator();
+
+  int rank = 0;
+  MPI_Comm_rank(comm, &rank);
+
+  // the ranks sharing a node, and one rank per node to write
+  if (this->NodeComm == MPI_COMM_NULL)
+    {
+    MPI_Comm_split_type(comm, MPI_COMM_TYPE_SHARED, rank,
+      MPI_INFO_NULL, &this->NodeComm);
+
+    int nodeRank = 0;
+    MPI_Comm_rank(this->NodeComm, &nodeRank);
+
+    MPI_Comm_split(comm, nodeRank == 0 ? 0 : MPI_UNDEFINED, rank,
+      &this->LeaderComm);
+    }
+
+  int nodeRank = 0;
+  int nodeSize = 1;
+  MPI_Comm_rank(this->NodeComm, &nodeRank);
+  MPI_Comm_size(this->NodeComm, &nodeSize);
+
+  // serialize the local blocks with the legacy writer, on threads. a
+  // failure is recorded, the collectives below must be made.
+  unsigned int nBlocks = blocks.size();
+  unsigned int nThreads = std::max(1u,
+    std::min(unsigned(this->NumberOfThreads), nBlocks));
+
+  std::vector<std::string> serialized(nBlocks);
+  std::atomic<unsigned int> next(0);
+
+  auto worker = [&]()
+    {
+    unsigned int i = 0;
+    while ((i = next++) < nBlocks)
+      {
+      vtkDataSetWriter *writer = vtkDataSetWriter::New();
+      writer->SetInputData(blocks[i].second);
+      writer->SetFileTypeToBinary();
+      writer->WriteToOutputStringOn();
+      if (writer->Write())
+        serialized[i] = writer->GetOutputStdString();
+      writer->Delete();
+      }
+    };
+
+  std::vector<std::thread> threads;
+  for (unsigned int i = 1; i < nThreads; ++i)
+    threads.push_back(std::thread(worker));
+
+  worker();
+
+  for (unsigned int i = 0; i < threads.size(); ++i)
+    threads[i].join();
+
+  // pack the size of each block followed by the blocks
+  std::vector<char> packed;
+  int failed = 0;
+  for (unsigned int i = 0; i < nBlocks; ++i)
+    {
+    if (serialized[i].empty())
+      {
+      SENSEI_ERROR("Failed to serialize block " << blocks[i].first)
+      failed = 1;
+      }
+
+    unsigned long long n = serialized[i].size();
+    const char *pn = reinterpret_cast<const char*>(&n);
+    packed.insert(packed.end(), pn, pn + sizeof(n));
+    packed.insert(packed.end(), serialized[i].begin(), serialized[i].end());
+    }
+
+  serialized.clear();
+
+  // gather to the node's writer
+  std::vector<char> gathered;
+  if (gatherBytes(packed, gathered, this->NodeComm))
+    {
+    SENSEI_ERROR("Failed to gather the blocks to the node's writer")
+    failed = 1;
+    }
+
+  packed.clear();
+
+  MPI_Allreduce(MPI_IN_PLACE, &failed, 1, MPI_INT, MPI_MAX, comm);
+  if (failed)
+    return -1;
+
+  if (nodeRank != 0)
+    return 0;
+
+  // merge the node's blocks and write them. polydata is kept as polydata
+  // only when every block of the mesh is polydata, otherwise all of the
+  // blocks, polydata included, are merged into an unstructured grid.
+  bool polyData = this->BlockType[meshName] == VTK_POLY_DATA;
+
+  vtkAppendPolyData *appendPd = vtkAppendPolyData::New();
+  vtkAppendFilter *appendUg = vtkAppendFilter::New();
+
+  size_t nGathered = gathered.size();
+  int nMerged = 0;
+  for (size_t pos = 0; pos < nGathered;)
+    {
+    unsigned long long n = 0;
+    memcpy(&n, gathered.data() + pos, sizeof(n));
+    pos += sizeof(n);
+
+    vtkDataSetReader *reader = vtkDataSetReader::New();
+    reader->ReadFromInputStringOn();
+    reader->SetInputString(gathered.data() + pos, n);
+    reader->Update();
+
+    vtkDataSet *ds = reader->GetOutput();
+    vtkPolyData *pd = dynamic_cast<vtkPolyData*>(ds);
+    if (polyData && !pd)
+      {
+      SENSEI_ERROR("Mesh \"" << meshName << "\" is polydata but has a "
+        << ds->GetClassName() << " block")
+      failed = 1;
+      }
+    else if (polyData)
+      appendPd->AddInputData(pd);
+    else
+      appendUg->AddInputData(ds);
+
+    reader->Delete();
+
+    pos += n;
+    ++nMerged;
+    }
+
+  gathered.clear();
+
+  int wrote = 0;
+  if (nMerged && !failed)
+    {
+    vtkAlgorithm *append = polyData ?
+      static_cast<vtkAlgorithm*>(appendPd) : static_cast<vtkAlgorithm*>(appendUg);
+
+    append->Update();
+
+    int nodeId = 0;
+    MPI_Comm_rank(this->LeaderComm, &nodeId);
+
+    std::string fileName = getBlockFileName(this->OutputDir, meshName,
+      nodeId, this->FileId[meshName], this->BlockExt[meshName]);
+
+    failed = this->WriteDataSet(dynamic_cast<vtkDataSet*>(
+      append->GetOutputDataObject(0)), fileName);
+
+    wrote = !failed;
+    }
+
+  appendPd->Delete();
+  appendUg->Delete();
+
+  // rank 0 keeps track of which nodes wrote a file for the meta file
+  int nNodes = 1;
+  MPI_Comm_size(this->LeaderComm, &nNodes);
+
+  std::vector<int> nodeWrote(nNodes, 0);
+  MPI_Gather(&wrote, 1, MPI_INT, nodeWrote.data(), 1, MPI_INT, 0,
+    this->LeaderComm);
+
+  if (rank == 0)
+    {
+    std::vector<long> ids;
+    for (int i = 0; i < nNodes; ++i)
+      {
+      if (nodeWrote[i])
+        ids.push_back(i);
+      }
+    this->SubfileIds[meshName].push_back(ids);
+    }
+
+  return failed ? -1 : 0;
+#endif
+}
+
 //-----------------------------------------------------------------------------
 int VTKPosthocIO::Finalize()
 {
+  if (this->NodeComm != MPI_COMM_NULL)
+    MPI_Comm_free(&this->NodeComm);
+
+  if (this->LeaderComm != MPI_COMM_NULL)
+    MPI_Comm_free(&this->LeaderComm);
+
   int rank = 0;
   MPI_Comm_rank(this->GetCommunicator(), &rank);
 
@@ -470,7 +909,13 @@ int VTKPosthocIO::Finalize()
       return -1;
       }
 
-    const std::vector<MeshMetadataPtr> &mmd = this->Metadata[meshName];
+    // the ids of the files written each step, of the blocks, or of the
+    // nodes when subfiling
+    std::vector<std::vector<long>> fileIds;
+    if (this->Subfiling)
+      fileIds = this->SubfileIds[meshName];
+    else
+      getFileIds(this->Metadata[meshName], fileIds);
 
     std::vector<double> &times = this->Time[meshName];
     long nSteps = times.size();
@@ -495,44 +940,32 @@ int VTKPosthocIO::Finalize()
 
       for (long i = 0; i < nSteps; ++i)
         {
-        for (long j = 0, k = 0; j < mmd[i]->NumBlocks; ++j)
+        long nFiles = fileIds[i].size();
+        for (long k = 0; k < nFiles; ++k)
           {
-          if (mmd[i]->BlockNumCells[j] > 0)
-            {
-            std::string fileName =
-              getBlockFileName("./", meshName, mmd[i]->BlockIds[j], i, blockExt);
+          std::string fileName =
+            getBlockFileName("./", meshName, fileIds[i][k], i, blockExt);
 
-            pvdFile << "<DataSet timestep=\"" << times[i]
-              << "\" group=\"\" part=\"" << k << "\" file=\"" << fileName
-              << "\"/>" << endl;
-
-            ++k;
-            }
+          pvdFile << "<DataSet timestep=\"" << times[i]
+            << "\" group=\"\" part=\"" << k << "\" file=\"" << fileName
+            << "\"/>" << endl;
           }
         }
 
       pvdFile << "</Collection>" << endl
         << "</VTKFile>" << endl;
-
-      return 0;
       }
     else if (this->Mode == VTKPosthocIO::MODE_VISIT)
       {
-      // does the number of blocks change?
+      // does the number of files change?
       // if so dump one visit file per timestep, otherwise one visit file for
       // the series
       int staticMesh = 1;
-      int nBlocks = mmd[0]->NumBlocks;
+      long nFiles = nSteps ? fileIds[0].size() : 0;
       for (long i = 0; staticMesh && (i < nSteps); ++i)
         {
-        if (nBlocks != mmd[i]->NumBlocks)
+        if ((nFiles < 1) || (long(fileIds[i].size()) != nFiles))
           staticMesh = 0;
-
-        for (long j = 0; j < mmd[i]->NumBlocks; ++j)
-          {
-          if (mmd[i]->BlockNumCells[j] < 1)
-            staticMesh = 0;
-          }
         }
 
       if (staticMesh)
@@ -547,17 +980,17 @@ int VTKPosthocIO::Finalize()
           return -1;
           }
 
-        visitFile << "!NBLOCKS " << mmd[0]->NumBlocks << std::endl;
+        visitFile << "!NBLOCKS " << nFiles << std::endl;
 
         for (long i = 0; i < nSteps; ++i)
           visitFile << "!TIME " << times[i] << std::endl;
 
         for (long i = 0; i < nSteps; ++i)
           {
-          for (long j = 0; j < mmd[i]->NumBlocks; ++j)
+          for (long k = 0; k < nFiles; ++k)
             {
             std::string fileName =
-              getBlockFileName("./", meshName, mmd[i]->BlockIds[j], i, blockExt);
+              getBlockFileName("./", meshName, fileIds[i][k], i, blockExt);
 
             visitFile << fileName << std::endl;
             }
@@ -570,14 +1003,7 @@ int VTKPosthocIO::Finalize()
         // write a .visit file per step
         for (long i = 0; i < nSteps; ++i)
           {
-          if (mmd[i]->NumBlocks < 1)
-            continue;
-
-          long numActiveBlocks = 0;
-          for (long j = 0; j < mmd[i]->NumBlocks; ++j)
-            if (mmd[i]->BlockNumCells[j] > 0)
-                ++numActiveBlocks;
-
+          long numActiveBlocks = fileIds[i].size();
           if (numActiveBlocks < 1)
             continue;
 
@@ -597,15 +1023,12 @@ int VTKPosthocIO::Finalize()
           visitFile << "!NBLOCKS " << numActiveBlocks << std::endl;
           visitFile << "!TIME " << times[i] << std::endl;
 
-          for (long j = 0; j < mmd[i]->NumBlocks; ++j)
+          for (long k = 0; k < numActiveBlocks; ++k)
             {
-            if (mmd[i]->BlockNumCells[j] > 0)
-              {
-              std::string fileName =
-                getBlockFileName("./", meshName, mmd[i]->BlockIds[j], i, blockExt);
+            std::string fileName =
+              getBlockFileName("./", meshName, fileIds[i][k], i, blockExt);
 
-              visitFile << fileName << std::endl;
-              }
+            visitFile << fileName << std::endl;
             }
 
           visitFile.close();
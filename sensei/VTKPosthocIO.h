@@ -10,6 +10,9 @@
 #include <mpi.h>
 #include <vector>
 #include <string>
+#include <utility>
+
+class vtkDataSet;
 
 
 namespace sensei
@@ -27,6 +30,12 @@ using VTKPosthocIOPtr = vtkSmartPointer<VTKPosthocIO>;
 /// consisting of a list of meshes and the arrays to write from
 /// each mesh. File names are derived using the output directory,
 /// the mesh name, and the mode.
+///
+/// A rank's blocks may be written concurrently on a pool of threads so
+/// that file system latency overlaps, and the XML writer may compress the
+/// arrays. With subfiling the blocks of all the ranks on a node are merged
+/// and written to a single file per node per step, reducing the load on
+/// the file system's metadata servers.
 class VTKPosthocIO : public AnalysisAdaptor
 {
 public:
@@ -46,6 +55,22 @@ public:
   int SetWriter(int writer);
   int SetWriter(std::string writer);
 
+  // sets the compressor used by the VTK XML writer. options are
+  // none, zlib, or lz4. the legacy writer does not compress.
+  enum {COMPRESSOR_NONE=0, COMPRESSOR_ZLIB=1, COMPRESSOR_LZ4=2};
+  int SetCompressor(int compressor);
+  int SetCompressor(std::string compressor);
+
+  // sets the number of threads used to write a rank's blocks. The
+  // default of 1 writes the blocks one after another, 0 uses a thread per
+  // core.
+  void SetNumberOfThreads(int nThreads);
+
+  // when set the blocks of the ranks on each node are gathered to one rank
+  // and written as a single unstructured grid or polydata file. Structured
+  // blocks are converted to unstructured grids. Requires ENABLE_VTK_FILTERS.
+  int SetSubfiling(int val);
+
   // if set this overrrides the default of vtkGhostType
   // for ParaView and avtGhostZones for VisIt
   void SetGhostArrayName(const std::string &name);
@@ -71,10 +96,26 @@ protected:
 
 private:
 #if !defined(SWIG)
+  using BlockList = std::vector<std::pair<long, vtkDataSet*>>;
+
+  // write each block to its own file
+  int WriteBlocks(const std::string &meshName, const BlockList &blocks);
+
+  // merge the blocks on each node and write a file per node
+  int WriteSubfile(const std::string &meshName, const BlockList &blocks);
+
+  // write a dataset with the configured writer
+  int WriteDataSet(vtkDataSet *ds, const std::string &fileName);
+
   std::string OutputDir;
   DataRequirements Requirements;
   int Mode;
   int Writer;
+  int Compressor;
+  int NumberOfThreads;
+  int Subfiling;
+  MPI_Comm NodeComm;
+  MPI_Comm LeaderComm;
   std::string GhostArrayName;
 
   template<typename T>
@@ -84,8 +125,10 @@ private:
   NameMap<std::vector<long>> TimeStep;
   NameMap<std::vector<MeshMetadataPtr>> Metadata;
   NameMap<std::string> BlockExt;
+  NameMap<int> BlockType;
   NameMap<long> FileId;
   NameMap<int> HaveBlockInfo;
+  NameMap<std::vector<std::vector<long>>> SubfileIds;
 #endif
 };
 
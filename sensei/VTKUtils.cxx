@@ -1,6 +1,7 @@
 #include "senseiConfig.h"
 #include "VTKUtils.h"
 #include "MPIUtils.h"
+#include "ThreadPool.h"
 #include "MeshMetadata.h"
 #include "Error.h"
 
@@ -37,6 +38,7 @@
 #include <vtkOverlappingAMR.h>
 #include <vtkNonOverlappingAMR.h>
 #include <vtkUniformGridAMR.h>
+#include <vtkUniformGridAMRDataIterator.h>
 #include <vtkObjectFactory.h>
 #include <vtkPointData.h>
 #include <vtkSmartPointer.h>
@@ -69,6 +71,9 @@
 
 #include <sstream>
 #include <functional>
+#include <algorithm>
+#include <map>
+#include <cstring>
 #include <mpi.h>
 
 using vtkDataObjectPtr = vtkSmartPointer<vtkDataObject>;
@@ -509,6 +514,55 @@ int Apply(vtkDataObject *dobj, DatasetFunction &func)
   return 0;
 }
 
+//----------------------------------------------------------------------------
+int GetLeaves(vtkDataObject *dobj, std::vector<vtkDataSet*> &leaves)
+{
+  // it is not an error for a rank to have no data
+  if (!dobj)
+    return 0;
+
+  DatasetFunction func = [&leaves](vtkDataSet *ds) -> int
+    {
+    leaves.push_back(ds);
+    return 0;
+    };
+
+  return Apply(dobj, func);
+}
+
+//----------------------------------------------------------------------------
+int ParallelApply(const std::vector<vtkDataSet*> &leaves,
+  const ParallelDatasetFunction &func)
+{
+  return ThreadPool::ParallelFor(leaves.size(),
+    [&leaves, &func](unsigned int i) -> int
+    {
+    return func(i, leaves[i]);
+    });
+}
+
+//----------------------------------------------------------------------------
+int ParallelApply(vtkDataObject *dobj, const ParallelDatasetFunction &func)
+{
+  // the traversal is serial, VTK's iterators are not thread safe
+  std::vector<vtkDataSet*> leaves;
+  if (GetLeaves(dobj, leaves))
+    {
+    SENSEI_ERROR("Failed to get the datasets of a "
+      << (dobj ? dobj->GetClassName() : "nullptr"))
+    return -1;
+    }
+
+  if (ParallelApply(leaves, func))
+    {
+    SENSEI_ERROR("Function failed to apply to " << leaves.size()
+      << " datasets in parallel")
+    return -1;
+    }
+
+  return 0;
+}
+
 //----------------------------------------------------------------------------
 int GetGhostLayerMetadata(vtkDataObject *mesh,
   int &nGhostCellLayers, int &nGhostNodeLayers)
@@ -747,51 +801,200 @@ int GetMetadata(MPI_Comm comm, vtkCompositeDataSet *cd, MeshMetadataPtr metadata
   metadata->NumBlocksLocal = {numBlocksLocal};
   cdit->Delete();
 
-  // get global bounds and extents
+  // get global bounds and extents. the reductions complete while the
+  // AMR hierarchy is described below
+  MPIUtils::ReductionBatch batch(comm);
+
   if (metadata->Flags.BlockBoundsSet())
-    MPIUtils::GlobalBounds(comm, metadata->BlockBounds, metadata->Bounds);
+    batch.GlobalBounds(metadata->BlockBounds, metadata->Bounds);
 
   if (metadata->Flags.BlockExtentsSet())
-    MPIUtils::GlobalBounds(comm, metadata->BlockExtents, metadata->Extent);
+    batch.GlobalBounds(metadata->BlockExtents, metadata->Extent);
 
   if (amrds)
     {
     // global view of block owner is always required
     if (metadata->Flags.BlockDecompSet())
-      MPIUtils::GlobalViewV(comm, metadata->BlockOwner);
+      batch.GlobalViewV(metadata->BlockOwner);
 
     // these are all always global views
-    metadata->NumLevels = amrds->GetNumberOfLevels();
-    metadata->BlockLevel.resize(metadata->NumBlocks);
-    metadata->BlockExtents.resize(metadata->NumBlocks);
-    metadata->RefRatio.resize(metadata->NumLevels);
-    metadata->BlocksPerLevel.resize(metadata->NumLevels);
-
-    int q = 0;
-    for (int i = 0; i < metadata->NumLevels; ++i)
-      {
-      int rr = amrds->GetRefinementRatio(i);
-      metadata->RefRatio[i] = {rr, rr, rr};
+    GetAMRMetadata(amrds, metadata);
+    }
 
-      int nb = amrds->GetNumberOfDataSets(i);
-      metadata->BlocksPerLevel[i] = nb;
+  batch.Wait();
 
-      std::vector<double> bounds;
-      for (int j = 0; j < nb; ++j, ++q)
-        {
-        metadata->BlockLevel[q] = i;
+  return 0;
+}
 
-        int *pbaq = metadata->BlockExtents[q].data();
+// --------------------------------------------------------------------------
+int GetAMRMetadata(vtkOverlappingAMR *amr, MeshMetadataPtr metadata)
+{
+  metadata->NumLevels = amr->GetNumberOfLevels();
+  metadata->NumBlocks = amr->GetTotalNumberOfBlocks();
+  metadata->BlockLevel.resize(metadata->NumBlocks);
+  metadata->BlockExtents.resize(metadata->NumBlocks);
+  metadata->RefRatio.resize(metadata->NumLevels);
+  metadata->BlocksPerLevel.resize(metadata->NumLevels);
+
+  int q = 0;
+  for (int i = 0; i < metadata->NumLevels; ++i)
+    {
+    int rr = amr->GetRefinementRatio(i);
+    metadata->RefRatio[i] = {rr, rr, rr};
 
-        const vtkAMRBox &box = amrds->GetAMRBox(i, j);
-        box.GetDimensions(pbaq, pbaq+3);
-        }
+    int nb = amr->GetNumberOfDataSets(i);
+    metadata->BlocksPerLevel[i] = nb;
+
+    for (int j = 0; j < nb; ++j, ++q)
+      {
+      metadata->BlockLevel[q] = i;
+
+      // the cell extent in the index space of the level, in VTK's
+      // [i0,i1, j0,j1, k0,k1] order
+      int lo[3] = {0};
+      int hi[3] = {0};
+      const vtkAMRBox &box = amr->GetAMRBox(i, j);
+      box.GetDimensions(lo, hi);
+
+      metadata->BlockExtents[q] = {lo[0], hi[0], lo[1], hi[1], lo[2], hi[2]};
       }
     }
 
   return 0;
 }
 
+// --------------------------------------------------------------------------
+int AddAMRBlanking(vtkOverlappingAMR *amr, const MeshMetadataPtr &md,
+  AMRNestingIndex &index)
+{
+  if (index.Update(md))
+    {
+    SENSEI_ERROR("Failed to index the AMR hierarchy of mesh \""
+      << md->MeshName << "\"")
+    return -1;
+    }
+
+  // the metadata identifies blocks by their global id when it has them,
+  // otherwise by position in level order
+  std::map<int, int> idToBlock;
+  bool haveIds = md->BlockIds.size() == unsigned(md->NumBlocks);
+  if (haveIds)
+    {
+    for (int i = 0; i < md->NumBlocks; ++i)
+      idToBlock[md->BlockIds[i]] = i;
+    }
+
+  int nLevels = amr->GetNumberOfLevels();
+  std::vector<int> levelOffset(nLevels + 1, 0);
+  for (int i = 0; i < nLevels; ++i)
+    levelOffset[i+1] = levelOffset[i] + amr->GetNumberOfDataSets(i);
+
+  // gather the local blocks. this is serial, VTK's iterators are not thread
+  // safe
+  std::vector<vtkDataSet*> blocks;
+  std::vector<int> bids;
+
+  vtkUniformGridAMRDataIterator *it =
+    dynamic_cast<vtkUniformGridAMRDataIterator*>(amr->NewIterator());
+  it->SetSkipEmptyNodes(1);
+
+  for (it->InitTraversal(); !it->IsDoneWithTraversal(); it->GoToNextItem())
+    {
+    int level = it->GetCurrentLevel();
+    int idx = it->GetCurrentIndex();
+
+    int bid = levelOffset[level] + idx;
+    if (haveIds)
+      {
+      std::map<int, int>::iterator bit =
+        idToBlock.find(amr->GetAMRBlockSourceIndex(level, idx));
+      bid = bit == idToBlock.end() ? -1 : bit->second;
+      }
+
+    if ((bid < 0) || (bid >= md->NumBlocks) || (md->BlockLevel[bid] != level))
+      {
+      SENSEI_ERROR("Block " << idx << " on level " << level
+        << " is not in the metadata of mesh \"" << md->MeshName << "\"")
+      it->Delete();
+      return -1;
+      }
+
+    blocks.push_back(dynamic_cast<vtkDataSet*>(it->GetCurrentDataObject()));
+    bids.push_back(bid);
+    }
+
+  it->Delete();
+
+  // blank the cells covered by the next finer level
+  return ParallelApply(blocks, [&](unsigned int i, vtkDataSet *ds) -> int
+    {
+    int bid = bids[i];
+    const std::array<int,6> &ext = index.GetExtent(bid);
+
+    long nx = ext[1] - ext[0] + 1;
+    long ny = ext[3] - ext[2] + 1;
+    long nz = ext[5] - ext[4] + 1;
+    long nCells = nx*ny*nz;
+
+    if (!ds || (ds->GetNumberOfCells() != nCells))
+      {
+      SENSEI_ERROR("Block " << bid << " does not match the extent in the"
+        " metadata")
+      return -1;
+      }
+
+    // combine with the ghost cells the block may already have
+    vtkCellData *cd = ds->GetCellData();
+    vtkUnsignedCharArray *ghosts = dynamic_cast<vtkUnsignedCharArray*>(
+      cd->GetArray("vtkGhostType"));
+
+    if (!ghosts)
+      {
+      ghosts = vtkUnsignedCharArray::New();
+      ghosts->SetName("vtkGhostType");
+      ghosts->SetNumberOfTuples(nCells);
+      memset(ghosts->GetVoidPointer(0), 0, nCells);
+      cd->AddArray(ghosts);
+      ghosts->Delete();
+      }
+
+    unsigned char *pg = ghosts->GetPointer(0);
+
+    std::vector<int> children;
+    index.GetChildren(bid, children);
+
+    const std::array<int,3> &rr = index.GetRefRatio(md->BlockLevel[bid]);
+
+    unsigned int nChildren = children.size();
+    for (unsigned int j = 0; j < nChildren; ++j)
+      {
+      // the part of the block the child covers
+      std::array<int,6> cext =
+        AMRNestingIndex::Coarsen(index.GetExtent(children[j]), rr);
+
+      for (int q = 0; q < 3; ++q)
+        {
+        cext[2*q] = std::max(cext[2*q], ext[2*q]) - ext[2*q];
+        cext[2*q+1] = std::min(cext[2*q+1], ext[2*q+1]) - ext[2*q];
+        }
+
+      // a row at a time, the inner loop vectorizes
+      long n = cext[1] - cext[0] + 1;
+      for (long k = cext[4]; k <= cext[5]; ++k)
+        {
+        for (long jj = cext[2]; jj <= cext[3]; ++jj)
+          {
+          unsigned char *row = pg + (k*ny + jj)*nx + cext[0];
+          for (long ii = 0; ii < n; ++ii)
+            row[ii] |= vtkDataSetAttributes::REFINEDCELL;
+          }
+        }
+      }
+
+    return 0;
+    });
+}
+
 // --------------------------------------------------------------------------
 // note: not intended for use on the blocks of a multiblock
 int GetMetadata(MPI_Comm comm, vtkDataSet *ds, MeshMetadataPtr metadata)
@@ -816,12 +1019,16 @@ int GetMetadata(MPI_Comm comm, vtkDataSet *ds, MeshMetadataPtr metadata)
   metadata->NumBlocks = nRanks;
   metadata->NumBlocksLocal = {1};
 
-  // get global bounds and extents
+  // get global bounds and extents, both are in flight at once
+  MPIUtils::ReductionBatch batch(comm);
+
   if (metadata->Flags.BlockBoundsSet())
-    MPIUtils::GlobalBounds(comm, metadata->BlockBounds, metadata->Bounds);
+    batch.GlobalBounds(metadata->BlockBounds, metadata->Bounds);
 
   if (metadata->Flags.BlockExtentsSet())
-    MPIUtils::GlobalBounds(comm, metadata->BlockExtents, metadata->Extent);
+    batch.GlobalBounds(metadata->BlockExtents, metadata->Extent);
+
+  batch.Wait();
 
   return 0;
 }
@@ -1182,6 +1389,224 @@ void HexCell(long cid, unsigned char *pCta, vtkIdType *pClocs, vtkIdType *pCids)
     pCids[jj + 8] = ii + 7;
 }
 
+// --------------------------------------------------------------------------
+std::array<int,6> AMRNestingIndex::Refine(const std::array<int,6> &ext,
+  const std::array<int,3> &rr)
+{
+  return std::array<int,6>{{ext[0]*rr[0], (ext[1] + 1)*rr[0] - 1,
+    ext[2]*rr[1], (ext[3] + 1)*rr[1] - 1, ext[4]*rr[2], (ext[5] + 1)*rr[2] - 1}};
+}
+
+// --------------------------------------------------------------------------
+std::array<int,6> AMRNestingIndex::Coarsen(const std::array<int,6> &ext,
+  const std::array<int,3> &rr)
+{
+  // rounds toward negative infinity
+  auto floorDiv = [](int a, int b) -> int
+    { return a >= 0 ? a/b : -((b - 1 - a)/b); };
+
+  return std::array<int,6>{{floorDiv(ext[0], rr[0]), floorDiv(ext[1], rr[0]),
+    floorDiv(ext[2], rr[1]), floorDiv(ext[3], rr[1]),
+    floorDiv(ext[4], rr[2]), floorDiv(ext[5], rr[2])}};
+}
+
+// --------------------------------------------------------------------------
+void AMRNestingIndex::Clear()
+{
+  this->Levels.clear();
+  this->RefRatio.clear();
+  this->BlockLevel.clear();
+  this->BlockExtents.clear();
+}
+
+// --------------------------------------------------------------------------
+int AMRNestingIndex::Update(const MeshMetadataPtr &md)
+{
+  unsigned int nBlocks = md->NumBlocks;
+  unsigned int nLevels = md->NumLevels;
+
+  if ((md->BlockLevel.size() != nBlocks) ||
+    (md->BlockExtents.size() != nBlocks) || (md->RefRatio.size() < nLevels))
+    {
+    SENSEI_ERROR("The nesting index requires the global view of the"
+      " BlockLevel, BlockExtents, and RefRatio of mesh \""
+      << md->MeshName << "\"")
+    return -1;
+    }
+
+  // the hierarchy has not changed
+  if ((this->Levels.size() == nLevels) && (this->RefRatio == md->RefRatio) &&
+    (this->BlockLevel == md->BlockLevel) &&
+    (this->BlockExtents == md->BlockExtents))
+    return 0;
+
+  this->Clear();
+
+  this->RefRatio = md->RefRatio;
+  this->BlockLevel = md->BlockLevel;
+  this->BlockExtents = md->BlockExtents;
+
+  this->Levels.resize(nLevels);
+
+  for (unsigned int i = 0; i < nBlocks; ++i)
+    {
+    int level = this->BlockLevel[i];
+    if ((level < 0) || (level >= int(nLevels)))
+      {
+      SENSEI_ERROR("Block " << i << " is on level " << level
+        << " of " << nLevels)
+      this->Clear();
+      return -1;
+      }
+
+    this->Levels[level].Ids.push_back(i);
+    }
+
+  for (unsigned int i = 0; i < nLevels; ++i)
+    {
+    Level &level = this->Levels[i];
+
+    int nIds = level.Ids.size();
+    if (nIds)
+      {
+      level.Nodes.reserve(2*nIds);
+      level.Nodes.resize(1);
+      this->Build(level, 0, 0, nIds);
+      }
+    }
+
+  return 0;
+}
+
+// --------------------------------------------------------------------------
+void AMRNestingIndex::Build(Level &level, int node, int start, int end)
+{
+  // the extent of the blocks, and of their centers. centers are doubled to
+  // stay in integers.
+  std::array<int,6> ext = this->BlockExtents[level.Ids[start]];
+  std::array<int,6> cext = {{ext[0] + ext[1], ext[0] + ext[1],
+    ext[2] + ext[3], ext[2] + ext[3], ext[4] + ext[5], ext[4] + ext[5]}};
+
+  for (int i = start + 1; i < end; ++i)
+    {
+    const std::array<int,6> &bext = this->BlockExtents[level.Ids[i]];
+    for (int j = 0; j < 3; ++j)
+      {
+      int c = bext[2*j] + bext[2*j+1];
+      ext[2*j] = std::min(ext[2*j], bext[2*j]);
+      ext[2*j+1] = std::max(ext[2*j+1], bext[2*j+1]);
+      cext[2*j] = std::min(cext[2*j], c);
+      cext[2*j+1] = std::max(cext[2*j+1], c);
+      }
+    }
+
+  level.Nodes[node].Extent = ext;
+
+  // a few blocks are tested directly
+  if (end - start <= 4)
+    {
+    level.Nodes[node].Child = -1;
+    level.Nodes[node].Start = start;
+    level.Nodes[node].Count = end - start;
+    return;
+    }
+
+  // split at the median center along the direction the centers spread
+  // the most. ties are broken by id so that the index is deterministic.
+  int axis = 0;
+  for (int j = 1; j < 3; ++j)
+    {
+    if (cext[2*j+1] - cext[2*j] > cext[2*axis+1] - cext[2*axis])
+      axis = j;
+    }
+
+  const std::vector<std::array<int,6>> &exts = this->BlockExtents;
+  auto center = [&exts, axis](int id) -> int
+    { return exts[id][2*axis] + exts[id][2*axis+1]; };
+
+  int mid = (start + end)/2;
+  std::nth_element(level.Ids.begin() + start, level.Ids.begin() + mid,
+    level.Ids.begin() + end, [&center](int a, int b) -> bool
+    {
+    int ca = center(a);
+    int cb = center(b);
+    return (ca < cb) || ((ca == cb) && (a < b));
+    });
+
+  int child = level.Nodes.size();
+  level.Nodes.resize(child + 2);
+
+  level.Nodes[node].Child = child;
+  level.Nodes[node].Start = 0;
+  level.Nodes[node].Count = 0;
+
+  this->Build(level, child, start, mid);
+  this->Build(level, child + 1, mid, end);
+}
+
+// --------------------------------------------------------------------------
+void AMRNestingIndex::GetOverlapping(int level, const std::array<int,6> &ext,
+  std::vector<int> &bids) const
+{
+  if ((level < 0) || (level >= int(this->Levels.size())))
+    return;
+
+  const Level &lev = this->Levels[level];
+  if (lev.Nodes.empty())
+    return;
+
+  size_t first = bids.size();
+
+  std::vector<int> stack(1, 0);
+  while (!stack.empty())
+    {
+    const Node &node = lev.Nodes[stack.back()];
+    stack.pop_back();
+
+    if (!Overlaps(node.Extent, ext))
+      continue;
+
+    if (node.Child < 0)
+      {
+      for (int i = 0; i < node.Count; ++i)
+        {
+        int bid = lev.Ids[node.Start + i];
+        if (Overlaps(this->BlockExtents[bid], ext))
+          bids.push_back(bid);
+        }
+      }
+    else
+      {
+      stack.push_back(node.Child + 1);
+      stack.push_back(node.Child);
+      }
+    }
+
+  std::sort(bids.begin() + first, bids.end());
+}
+
+// --------------------------------------------------------------------------
+void AMRNestingIndex::GetChildren(int bid, std::vector<int> &children) const
+{
+  int level = this->BlockLevel[bid];
+  if (level + 1 >= int(this->Levels.size()))
+    return;
+
+  this->GetOverlapping(level + 1,
+    Refine(this->BlockExtents[bid], this->RefRatio[level]), children);
+}
+
+// --------------------------------------------------------------------------
+void AMRNestingIndex::GetParents(int bid, std::vector<int> &parents) const
+{
+  int level = this->BlockLevel[bid];
+  if (level < 1)
+    return;
+
+  this->GetOverlapping(level - 1,
+    Coarsen(this->BlockExtents[bid], this->RefRatio[level - 1]), parents);
+}
+
 // --------------------------------------------------------------------------
 int WriteDomainDecomp(MPI_Comm comm, const sensei::MeshMetadataPtr &md,
   const std::string fileName)
@@ -8,10 +8,12 @@ class vtkDataObject;
 class vtkFieldData;
 class vtkDataSetAttributes;
 class vtkCompositeDataSet;
+class vtkOverlappingAMR;
 
 #include <vtkSmartPointer.h>
 #include <functional>
 #include <vector>
+#include <array>
 #include <mpi.h>
 
 using vtkCompositeDataSetPtr = vtkSmartPointer<vtkCompositeDataSet>;
@@ -61,6 +63,22 @@ using DatasetFunction = std::function<int(vtkDataSet*)>;
 /// The function is called once for each leaf dataset
 int Apply(vtkDataObject *dobj, DatasetFunction &func);
 
+/// Get the leaf datasets of the data object in traversal order
+int GetLeaves(vtkDataObject *dobj, std::vector<vtkDataSet*> &leaves);
+
+/// callback that processes the i-th leaf dataset
+/// return 0 for success, non-zero for an error
+using ParallelDatasetFunction = std::function<int(unsigned int, vtkDataSet*)>;
+
+/// Applies the function to the leaves of the data object concurrently on
+/// the threads of the ThreadPool. Leaves are numbered in traversal order.
+/// Results should be stored per leaf and combined by the caller in this
+/// order, so that they do not depend on the number of threads. All leaves
+/// are processed even when a call fails. Returns non-zero if any failed.
+int ParallelApply(vtkDataObject *dobj, const ParallelDatasetFunction &func);
+int ParallelApply(const std::vector<vtkDataSet*> &leaves,
+  const ParallelDatasetFunction &func);
+
 /// Store ghost layer metadata in the mesh
 int SetGhostLayerMetadata(vtkDataObject *mesh,
   int nGhostCellLayers, int nGhostNodeLayers);
@@ -129,6 +147,114 @@ inline bool LogicallyCartesian(const MeshMetadataPtr &md)
   return Structured(md) || UniformCartesian(md) || StretchedCartesian(md);
 }
 
+/// @class AMRNestingIndex
+/// @brief Parent, child, and overlap queries over the blocks of an AMR mesh.
+///
+/// The index is built from the NumLevels, RefRatio, BlockLevel, and
+/// BlockExtents fields of the mesh's metadata. The blocks of each level are
+/// held in a bounding volume hierarchy over their cell extents, a query
+/// costs O(log N + k) for N blocks on the level and k blocks found. Block
+/// ids are indices into the metadata's per block arrays. Extents are cell
+/// extents in the index space of the block's level, RefRatio[i] relates
+/// level i to level i + 1.
+///
+/// Update rebuilds the index only when the hierarchy has changed, so an
+/// index kept from step to step costs nothing for a static hierarchy.
+class AMRNestingIndex
+{
+public:
+  AMRNestingIndex() : Levels(), RefRatio(), BlockLevel(), BlockExtents() {}
+
+  /// Build the index from AMR metadata if its hierarchy differs from the
+  /// one the index was built from. Returns non-zero if the metadata does not
+  /// have the required fields.
+  int Update(const MeshMetadataPtr &md);
+
+  /// Discard the index
+  void Clear();
+
+  /// Get the blocks on the next finer level that overlap block bid.
+  /// Block ids are appended to the vector in ascending order.
+  void GetChildren(int bid, std::vector<int> &children) const;
+
+  /// Get the blocks on the next coarser level that overlap block bid. In a
+  /// properly nested hierarchy these cover the block. Block ids are appended
+  /// to the vector in ascending order.
+  void GetParents(int bid, std::vector<int> &parents) const;
+
+  /// Get the blocks on the level that overlap the extent, given in the
+  /// index space of the level. Block ids are appended to the vector in
+  /// ascending order.
+  void GetOverlapping(int level, const std::array<int,6> &ext,
+    std::vector<int> &bids) const;
+
+  int GetNumberOfLevels() const { return this->Levels.size(); }
+  int GetNumberOfBlocks() const { return this->BlockLevel.size(); }
+
+  int GetLevel(int bid) const { return this->BlockLevel[bid]; }
+
+  const std::array<int,6> &GetExtent(int bid) const
+  { return this->BlockExtents[bid]; }
+
+  const std::array<int,3> &GetRefRatio(int level) const
+  { return this->RefRatio[level]; }
+
+  /// Transform a cell extent to the index space of the next finer level
+  static std::array<int,6> Refine(const std::array<int,6> &ext,
+    const std::array<int,3> &rr);
+
+  /// Transform a cell extent to the index space of the next coarser level
+  static std::array<int,6> Coarsen(const std::array<int,6> &ext,
+    const std::array<int,3> &rr);
+
+  /// Returns true if the cell extents share at least one cell
+  static bool Overlaps(const std::array<int,6> &a, const std::array<int,6> &b)
+  {
+    return (a[0] <= b[1]) && (b[0] <= a[1]) && (a[2] <= b[3]) &&
+      (b[2] <= a[3]) && (a[4] <= b[5]) && (b[4] <= a[5]);
+  }
+
+private:
+  // a node of a level's hierarchy. interior nodes have two children, the
+  // first at Child and the second at Child + 1. leaves reference Count ids
+  // starting at Start.
+  struct Node
+  {
+    std::array<int,6> Extent;
+    int Child;
+    int Start;
+    int Count;
+  };
+
+  struct Level
+  {
+    std::vector<Node> Nodes;
+    std::vector<int> Ids;
+  };
+
+  void Build(Level &level, int node, int start, int end);
+
+  std::vector<Level> Levels;
+  std::vector<std::array<int,3>> RefRatio;
+  std::vector<int> BlockLevel;
+  std::vector<std::array<int,6>> BlockExtents;
+};
+
+/// Get the NumBlocks, NumLevels, RefRatio, BlocksPerLevel, BlockLevel, and
+/// BlockExtents of an AMR mesh from the hierarchy it holds. Blocks are in
+/// level order. No communication is made.
+int GetAMRMetadata(vtkOverlappingAMR *amr, MeshMetadataPtr metadata);
+
+/// Blank the cells of the local blocks of an AMR mesh that are covered by
+/// the next finer level. The vtkDataSetAttributes::REFINEDCELL bit is set in
+/// each block's vtkGhostType cell array, which is created if needed. The
+/// hierarchy is taken from the metadata's BlockLevel, BlockExtents, and
+/// RefRatio, and BlockIds when they are present, indexed by the passed
+/// index. No communication is made. This may be used to implement
+/// DataAdaptor::AddGhostCellsArray.
+int AddAMRBlanking(vtkOverlappingAMR *amr, const MeshMetadataPtr &md,
+  AMRNestingIndex &index);
+
 // rank 0 writes a dataset for visualizing the domain decomp
 int WriteDomainDecomp(MPI_Comm comm, const sensei::MeshMetadataPtr &md,
   const std::string fileName);
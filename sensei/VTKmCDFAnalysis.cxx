@@ -1,12 +1,17 @@
+#include "senseiConfig.h"
 #include "VTKmCDFAnalysis.h"
 
 #include "CDFReducer.h"
 #include "CinemaHelper.h"
 #include "DataAdaptor.h"
+#include "QuantileSketch.h"
+#include "VTKUtils.h"
 #include <Profiler.h>
 #include <Error.h>
 
+#include <vtkDataArray.h>
 #include <vtkDataSet.h>
+#include <vtkFieldData.h>
 #include <vtkCellData.h>
 #include <vtkIntArray.h>
 #include <vtkSortDataArray.h>
@@ -22,8 +27,12 @@
 #include <vtkObjectFactory.h>
 #include <vtkPointData.h>
 #include <vtkSmartPointer.h>
+#ifdef ENABLE_VTK_GENERIC_ARRAYS
+#include <vtkArrayDispatch.h>
+#endif
 
 #include <algorithm>
+#include <functional>
 #include <vector>
 
 // --- vtkm ---
@@ -45,6 +54,134 @@
 namespace sensei
 {
 
+//-----------------------------------------------------------------------------
+// Get the named array from every local block.
+static int GetLocalArrays(vtkDataObject* mesh, int association,
+  const std::string& arrayName, std::vector<vtkDataArray*>& arrays)
+{
+  VTKUtils::DatasetFunction func = [&](vtkDataSet* ds) -> int
+  {
+    vtkFieldData* atts = VTKUtils::GetAttributes(ds, association);
+    vtkDataArray* array = atts ? atts->GetArray(arrayName.c_str()) : nullptr;
+
+    // not every block need have the array
+    if (!array)
+    {
+      return 0;
+    }
+
+    if (array->GetNumberOfComponents() > 1)
+    {
+      SENSEI_ERROR("Cannot compute CDF of multi-component (vector, non-scalar)  array.");
+      return -1;
+    }
+
+    arrays.push_back(array);
+    return 0;
+  };
+
+  return VTKUtils::Apply(mesh, func) < 0 ? -1 : 0;
+}
+
+#ifdef ENABLE_VTK_GENERIC_ARRAYS
+//-----------------------------------------------------------------------------
+// Passes the values of a single component array to a functor. The values are
+// read through the array's own layout thus SOA and implicit arrays are not
+// copied. To be used with vtkArrayDispatch.
+template <typename OpT>
+struct ValueWorker
+{
+  OpT& Op;
+
+  ValueWorker(OpT& op) : Op(op) {}
+
+  template <typename ArrayT>
+  void operator()(ArrayT* array)
+  {
+    vtkIdType numTuples = array->GetNumberOfTuples();
+    for (vtkIdType tIdx = 0; tIdx < numTuples; ++tIdx)
+    {
+      this->Op(static_cast<double>(array->GetTypedComponent(tIdx, 0)));
+    }
+  }
+};
+#endif
+
+//-----------------------------------------------------------------------------
+// Pass each value of the array to the functor, without copying the array.
+template <typename OpT>
+static int ForEachValue(vtkDataArray* array, OpT& op)
+{
+#ifdef ENABLE_VTK_GENERIC_ARRAYS
+  ValueWorker<OpT> worker(op);
+  if (!vtkArrayDispatch::Dispatch::Execute(array, worker))
+  {
+    // array types that are not dispatched are read through the generic API
+    vtkIdType numTuples = array->GetNumberOfTuples();
+    for (vtkIdType tIdx = 0; tIdx < numTuples; ++tIdx)
+    {
+      op(array->GetComponent(tIdx, 0));
+    }
+  }
+#else
+  // without generic arrays every array is contiguous, the pointer is not a
+  // copy
+  switch (array->GetDataType())
+  {
+    vtkTemplateMacro(
+      VTK_TT* ptr = static_cast<VTK_TT*>(array->GetVoidPointer(0));
+      vtkIdType numTuples = array->GetNumberOfTuples();
+      for (vtkIdType tIdx = 0; tIdx < numTuples; ++tIdx)
+      {
+        op(static_cast<double>(ptr[tIdx]));
+      }
+    );
+    default:
+      SENSEI_ERROR("Unsupported array type " << array->GetDataTypeAsString());
+      return -1;
+  }
+#endif
+  return 0;
+}
+
+//-----------------------------------------------------------------------------
+// Add the values of the arrays to the sketch. The values are read in place,
+// no copies are made.
+static int UpdateSketch(const std::vector<vtkDataArray*>& arrays, QuantileSketch& sketch)
+{
+  auto update = [&sketch](double val) { sketch.Update(val); };
+  for (vtkDataArray* array : arrays)
+  {
+    if (ForEachValue(array, update))
+    {
+      return -1;
+    }
+  }
+  return 0;
+}
+
+//-----------------------------------------------------------------------------
+// Append the values of the arrays to a single buffer.
+static int GetValues(const std::vector<vtkDataArray*>& arrays, std::vector<double>& values)
+{
+  size_t nValues = 0;
+  for (vtkDataArray* array : arrays)
+  {
+    nValues += array->GetNumberOfTuples();
+  }
+  values.reserve(nValues);
+
+  auto append = [&values](double val) { values.push_back(val); };
+  for (vtkDataArray* array : arrays)
+  {
+    if (ForEachValue(array, append))
+    {
+      return -1;
+    }
+  }
+  return 0;
+}
+
 //-----------------------------------------------------------------------------
 senseiNewMacro(VTKmCDFAnalysis);
 
@@ -54,6 +191,8 @@ VTKmCDFAnalysis::VTKmCDFAnalysis()
   , Helper(nullptr)
   , NumberOfQuantiles(10)
   , RequestSize(10)
+  , Mode(MODE_EXACT)
+  , ErrorBound(0.01)
 {
 }
 
@@ -102,18 +241,97 @@ bool VTKmCDFAnalysis::Execute(DataAdaptor* data)
   TimeEvent<128> mark("VTKmCDFAnalysis::execute");
   this->Helper->AddTimeEntry();
 
-  // Get the mesh from the simulation:
+  // Get the mesh from the simulation. A rank without blocks has no mesh, it
+  // still takes part in the reductions below with no values.
   vtkDataObject* mesh = nullptr;
-  if (data->GetMesh(this->MeshName, /*structure_only*/true, mesh) || !mesh)
+  if (data->GetMesh(this->MeshName, /*structure_only*/true, mesh))
   {
+    SENSEI_ERROR("Failed to get mesh \"" << this->MeshName << "\"");
     return false;
   }
+  vtkSmartPointer<vtkDataObject> meshPtr;
+  meshPtr.TakeReference(mesh);
+
   // Tell the simulation to add the array we want:
-  data->AddArray(
-    mesh, this->MeshName,
-    this->FieldAssoc == vtkm::cont::Field::Association::POINTS ?
-    vtkDataObject::POINT : vtkDataObject::CELL,
-    this->FieldName);
+  int association = this->FieldAssoc == vtkm::cont::Field::Association::POINTS ?
+    vtkDataObject::POINT : vtkDataObject::CELL;
+
+  if (mesh)
+  {
+    data->AddArray(mesh, this->MeshName, association, this->FieldName);
+  }
+
+  if (this->NumberOfQuantiles <= 0)
+  {
+    SENSEI_ERROR("Invalid CDF request (bad number of quantiles).");
+    return false;
+  }
+
+  if (this->Mode != MODE_SEARCH)
+  {
+    // Use the values on all local blocks
+    if (this->FieldAssoc == vtkm::cont::Field::Association::WHOLE_MESH)
+    {
+      association = vtkDataObject::FIELD;
+    }
+
+    std::vector<vtkDataArray*> arrays;
+    if (mesh && GetLocalArrays(mesh, association, this->FieldName, arrays))
+    {
+      return false;
+    }
+
+    Profiler::StartEvent("VTKm CDF");
+    std::vector<double> cdf(this->NumberOfQuantiles);
+    if (this->Mode == MODE_APPROXIMATE)
+    {
+      // Stream all local blocks through a sketch, and combine the sketches.
+      // The result is only valid, and only written, on the root
+      QuantileSketch sketch(this->ErrorBound);
+      if (UpdateSketch(arrays, sketch) || sketch.Reduce(this->Communicator, 0))
+      {
+        SENSEI_ERROR("Failed to compute the CDF of \"" << this->FieldName << "\"");
+        return false;
+      }
+
+      int rank = 0;
+      MPI_Comm_rank(this->Communicator, &rank);
+      if (rank == 0)
+      {
+        sketch.GetCDF(this->NumberOfQuantiles, cdf.data());
+      }
+    }
+    else
+    {
+      // Exact, with a bounded number of communication rounds
+      std::vector<double> values;
+      CDFReducer reducer(nullptr);
+      double* exact = nullptr;
+      if (GetValues(arrays, values) || !(exact = reducer.ComputeSampleSort(
+        this->Communicator, values.data(), values.size(), this->NumberOfQuantiles)))
+      {
+        SENSEI_ERROR("Failed to compute the CDF of \"" << this->FieldName << "\"");
+        return false;
+      }
+      std::copy(exact, exact + this->NumberOfQuantiles, cdf.begin());
+    }
+    Profiler::EndEvent("VTKm CDF");
+
+    Profiler::StartEvent("Cinema CDF export");
+    this->Helper->WriteCDF(this->NumberOfQuantiles, cdf.data());
+    this->Helper->WriteMetadata();
+    Profiler::EndEvent("Cinema CDF export");
+
+    return true;
+  }
+
+  // The search reads the first and last value of every rank, thus each rank
+  // needs a mesh.
+  if (!mesh)
+  {
+    SENSEI_ERROR("Mode search requires a mesh on every rank, use mode=\"exact\"");
+    return false;
+  }
 
   // Now ask the mesh for the array:
   vtkDataArray* array = nullptr;
@@ -174,12 +392,6 @@ bool VTKmCDFAnalysis::Execute(DataAdaptor* data)
     return false;
   }
 
-  if (this->NumberOfQuantiles <= 0)
-  {
-    SENSEI_ERROR("Invalid CDF request (bad number of quantiles).");
-    return false;
-  }
-
   Profiler::StartEvent("VTKm CDF");
   vtkNew<vtkDoubleArray> sorted;
   sorted->DeepCopy(array);
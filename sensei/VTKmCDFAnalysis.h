@@ -24,6 +24,25 @@ public:
     int requestSize,
     MPI_Comm comm);
 
+  /// How the CDF is computed.
+  /// MODE_EXACT, the default, computes the exact CDF of the values on all
+  /// local blocks with a parallel sample sort.
+  /// MODE_APPROXIMATE approximates the CDF from a mergeable quantile sketch
+  /// built in a single pass over all local blocks and combined with a tree
+  /// reduction.
+  /// In both, ranks without blocks take part with no values.
+  /// MODE_SEARCH sorts the values of the first local block holding the array
+  /// and computes the CDF with CDFReducer's iterative distributed search.
+  /// It requires a block on every rank.
+  enum { MODE_EXACT = 0, MODE_APPROXIMATE = 1, MODE_SEARCH = 2 };
+  void SetMode(int val) { this->Mode = val; }
+  int GetMode() { return this->Mode; }
+
+  /// The rank error bound of the approximation as a fraction of the number
+  /// of values. The default is 0.01.
+  void SetErrorBound(double val) { this->ErrorBound = val; }
+  double GetErrorBound() { return this->ErrorBound; }
+
   bool Execute(DataAdaptor* data) override;
 
   int Finalize() override { return 0; }
@@ -39,6 +58,8 @@ protected:
   CinemaHelper* Helper;
   int NumberOfQuantiles;
   int RequestSize;
+  int Mode;
+  double ErrorBound;
 
 private:
   VTKmCDFAnalysis(const VTKmCDFAnalysis&);
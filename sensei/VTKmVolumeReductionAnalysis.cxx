@@ -2,34 +2,41 @@
 
 #include "CinemaHelper.h"
 #include "DataAdaptor.h"
+#include "VTKUtils.h"
 #include <Profiler.h>
+#include <Error.h>
 
 #include <vtkCellData.h>
+#include <vtkDataArray.h>
+#include <vtkDataSet.h>
+#include <vtkFieldData.h>
 #include <vtkFloatArray.h>
 #include <vtkImageData.h>
+#include <vtkIntArray.h>
 #ifdef ENABLE_VTK_MPI
 #  include <vtkMPICommunicator.h>
 #  include <vtkMPIController.h>
 #endif
-#include <vtkMultiBlockDataSet.h>
 #include <vtkNew.h>
 #include <vtkObjectFactory.h>
 #include <vtkPointData.h>
+#include <vtkShortArray.h>
+#include <vtkSignedCharArray.h>
 #include <vtkSmartPointer.h>
 
 #include <algorithm>
+#include <cmath>
+#include <limits>
+#include <sstream>
 #include <vector>
 
 // --- vtkm ---
 #include <vtkm/Math.h>
 #include <vtkm/cont/ArrayHandle.h>
-#include <vtkm/cont/ArrayHandleCounting.h>
-#include <vtkm/cont/DataSetBuilderUniform.h>
+#include <vtkm/cont/ArrayHandleIndex.h>
 
-#include <vtkm/filter/FilterDataSet.h>
-#include <vtkm/worklet/DispatcherPointNeighborhood.h>
-#include <vtkm/worklet/ScatterPermutation.h>
-#include <vtkm/worklet/WorkletPointNeighborhood.h>
+#include <vtkm/worklet/DispatcherMapField.h>
+#include <vtkm/worklet/WorkletMapField.h>
 
 #include <vtkm/cont/TryExecute.h>
 #include <vtkm/cont/cuda/DeviceAdapterCuda.h>
@@ -50,146 +57,278 @@ struct DevicesToTry : vtkm::ListTagBase<vtkm::cont::DeviceAdapterTagCuda,
 {
 };
 
-struct ImageReductionPolicy : public vtkm::filter::PolicyBase<ImageReductionPolicy>
+// Computes a level of the pyramid from the next finer level. Each voxel is
+// the mean of the 2x2x2 voxels it covers, fewer on the upper boundaries
+// when the finer level has an odd number of voxels.
+struct HaarMean : public vtkm::worklet::WorkletMapField
 {
-  using DeviceAdapterList = DevicesToTry;
-};
+  typedef void ControlSignature(FieldIn<> index,
+                                WholeArrayIn<> fine,
+                                FieldOut<> mean);
 
-struct VoxelMean : public vtkm::worklet::WorkletPointNeighborhood3x3x3
-{
-  using CountingHandle = vtkm::cont::ArrayHandle<vtkm::Id>;
+  typedef void ExecutionSignature(_1, _2, _3);
 
-  VoxelMean(CountingHandle handle): Scatter(handle)
+  VTKM_CONT HaarMean(const vtkm::Id3& fineDims, const vtkm::Id3& coarseDims)
+    : FineDims(fineDims), CoarseDims(coarseDims)
   {
   }
 
-  typedef void ControlSignature(CellSetIn,
-                                FieldInNeighborhood<> in,
-                                FieldOut<> out);
-
-  typedef void ExecutionSignature(_2, _3);
+  template <typename PortalType>
+  VTKM_EXEC void operator()(const vtkm::Id& index,
+                            const PortalType& fine,
+                            vtkm::Float32& mean) const
+  {
+    vtkm::Id i = index % this->CoarseDims[0];
+    vtkm::Id j = (index / this->CoarseDims[0]) % this->CoarseDims[1];
+    vtkm::Id k = index / (this->CoarseDims[0] * this->CoarseDims[1]);
 
-  using ScatterType = vtkm::worklet::ScatterPermutation<typename CountingHandle::StorageTag>;
+    vtkm::Id i1 = vtkm::Min(2 * i + 2, this->FineDims[0]);
+    vtkm::Id j1 = vtkm::Min(2 * j + 2, this->FineDims[1]);
+    vtkm::Id k1 = vtkm::Min(2 * k + 2, this->FineDims[2]);
 
-  template <typename NeighIn>
-  VTKM_EXEC void operator()(const NeighIn& in,
-                            vtkm::Float32& out) const
-  {
-    out = in.Get(0, 0, 0) + in.Get(1, 0, 0)
-        + in.Get(0, 1, 0) + in.Get(1, 1, 0)
-        + in.Get(0, 0, 1) + in.Get(1, 0, 1)
-        + in.Get(0, 1, 1) + in.Get(1, 1, 1);
+    vtkm::Float32 sum = 0.0f;
+    vtkm::Id n = 0;
+    for (vtkm::Id kk = 2 * k; kk < k1; ++kk)
+    {
+      for (vtkm::Id jj = 2 * j; jj < j1; ++jj)
+      {
+        for (vtkm::Id ii = 2 * i; ii < i1; ++ii)
+        {
+          sum += static_cast<vtkm::Float32>(
+            fine.Get(ii + this->FineDims[0] * (jj + this->FineDims[1] * kk)));
+          ++n;
+        }
+      }
+    }
 
-    out *= 0.125;
+    mean = sum / static_cast<vtkm::Float32>(n);
   }
 
-  ScatterType GetScatter() const { return this->Scatter; }
-
-private:
-  ScatterType Scatter;
+  vtkm::Id3 FineDims;
+  vtkm::Id3 CoarseDims;
 };
 
-
-class ImageReduction : public vtkm::filter::FilterDataSet<ImageReduction>
+// Computes the detail that refines a level of the pyramid to the next finer
+// level, the difference between the fine value and the reconstruction of the
+// coarse voxel covering it. Levels are processed from coarse to fine, and
+// the details are computed against the reconstruction rather than the exact
+// coarse values so that quantization errors do not accumulate. When Scale is
+// positive the detail is quantized to an integer multiple of Scale and the
+// reconstruction is within Scale/2 of the fine value.
+struct HaarDetail : public vtkm::worklet::WorkletMapField
 {
-  vtkm::Vec<vtkm::Int32, 3> InputDimensions;
-  vtkm::cont::Field::Association FieldAssoc;
-  std::string FieldName;
+  typedef void ControlSignature(FieldIn<> index,
+                                FieldIn<> fine,
+                                WholeArrayIn<> coarse,
+                                FieldOut<> detail,
+                                FieldOut<> reconstruction);
 
-public:
+  typedef void ExecutionSignature(_1, _2, _3, _4, _5);
 
-  ImageReduction()
-    : InputDimensions(1, 1, 1)
-    , FieldAssoc(vtkm::cont::Field::Association::POINTS)
-  { }
-
-  void SetInputDimensions(vtkm::Int32 i, vtkm::Int32 j, vtkm::Int32 k)
+  VTKM_CONT HaarDetail(const vtkm::Id3& fineDims, const vtkm::Id3& coarseDims,
+                       vtkm::Float32 scale)
+    : FineDims(fineDims), CoarseDims(coarseDims), Scale(scale)
   {
-    this->InputDimensions[0] = i;
-    this->InputDimensions[1] = j;
-    this->InputDimensions[2] = k;
   }
 
-  void SetField(vtkm::cont::Field::Association assoc, const std::string& name)
+  template <typename PortalType>
+  VTKM_EXEC void operator()(const vtkm::Id& index,
+                            const vtkm::Float32& fine,
+                            const PortalType& coarse,
+                            vtkm::Float32& detail,
+                            vtkm::Float32& reconstruction) const
   {
-    this->FieldName = name;
-    this->FieldAssoc = assoc;
+    vtkm::Id i = index % this->FineDims[0];
+    vtkm::Id j = (index / this->FineDims[0]) % this->FineDims[1];
+    vtkm::Id k = index / (this->FineDims[0] * this->FineDims[1]);
+
+    vtkm::Float32 parent = coarse.Get(
+      i / 2 + this->CoarseDims[0] * (j / 2 + this->CoarseDims[1] * (k / 2)));
+
+    if (this->Scale > 0.0f)
+    {
+      detail = vtkm::Round((fine - parent) / this->Scale);
+      reconstruction = parent + detail * this->Scale;
+    }
+    else
+    {
+      detail = fine - parent;
+      reconstruction = fine;
+    }
   }
 
-  template <typename Policy, typename Device>
-  VTKM_CONT vtkm::cont::DataSet DoExecute(const vtkm::cont::DataSet& input,
-                                                  vtkm::filter::PolicyBase<Policy> policy,
-                                                  Device)
+  vtkm::Id3 FineDims;
+  vtkm::Id3 CoarseDims;
+  vtkm::Float32 Scale;
+};
+
+// Builds all levels of the pyramid in a single pass on the device. Only the
+// coarsest level and the details are transferred back to the host.
+struct BuildPyramid
+{
+  using HandleType = vtkm::cont::ArrayHandle<vtkm::Float32>;
+
+  BuildPyramid(const HandleType& input, const std::vector<vtkm::Id3>& dims,
+               vtkm::Float32 scale)
+    : Input(input), Dims(dims), Scale(scale)
+  {
+  }
 
+  template <typename Device>
+  VTKM_CONT bool operator()(Device)
   {
-    using DispatcherType = vtkm::worklet::DispatcherPointNeighborhood<VoxelMean>;
+    size_t nLevels = this->Dims.size();
+
+    // the means, finest to coarsest
+    std::vector<HandleType> means(nLevels);
+    means[0] = this->Input;
+    for (size_t l = 1; l < nLevels; ++l)
+    {
+      const vtkm::Id3& dims = this->Dims[l];
+      vtkm::cont::ArrayHandleIndex index(dims[0] * dims[1] * dims[2]);
 
-    vtkm::cont::ArrayHandle<vtkm::Float32> out;
-    vtkm::cont::ArrayHandle<vtkm::Float32> in;
+      vtkm::worklet::DispatcherMapField<HaarMean, Device> dispatcher(
+        HaarMean(this->Dims[l - 1], dims));
 
-    //get the coordinate system we are using for the 2D area
-    const vtkm::cont::DynamicCellSet& cells = input.GetCellSet(this->GetActiveCellSetIndex());
+      dispatcher.Invoke(index, means[l - 1], means[l]);
+    }
 
-    //get the previous state of the game
-    input.GetField(this->FieldName, this->FieldAssoc).GetData().CopyTo(in);
+    this->Coarsest = means[nLevels - 1];
 
-    // Create scatter array
-    std::vector<vtkm::Id> ids;
-    int kSize = this->InputDimensions[2] - 1;
-    int jSize = this->InputDimensions[1] - 1;
-    int iSize = this->InputDimensions[0] - 1;
-    for (int k = 0; k < kSize; k += 2)
+    // the details, coarsest to finest
+    this->Details.resize(nLevels - 1);
+    HandleType coarse = this->Coarsest;
+    for (size_t l = nLevels - 1; l > 0; --l)
     {
-      for (int j = 0; j < jSize; j += 2)
-      {
-        for (int i = 0; i < iSize; i += 2)
-        {
-          ids.push_back(i + (j * this->InputDimensions[0]) + (k * this->InputDimensions[0] * this->InputDimensions[1]));
-        }
-      }
+      const vtkm::Id3& dims = this->Dims[l - 1];
+      vtkm::cont::ArrayHandleIndex index(dims[0] * dims[1] * dims[2]);
+
+      vtkm::worklet::DispatcherMapField<HaarDetail, Device> dispatcher(
+        HaarDetail(dims, this->Dims[l], this->Scale));
+
+      HandleType fine;
+      dispatcher.Invoke(index, means[l - 1], coarse, this->Details[l - 1], fine);
+
+      coarse = fine;
     }
 
-    auto counting = vtkm::cont::make_ArrayHandle(ids);
+    return true;
+  }
 
-    //Update the game state
-    VoxelMean worklet(counting);
-    DispatcherType(worklet, worklet.GetScatter()).Invoke(vtkm::filter::ApplyPolicy(cells, policy), in, out);
+  HandleType Input;
+  std::vector<vtkm::Id3> Dims;
+  vtkm::Float32 Scale;
 
-    //save the results
-    vtkm::cont::DataSet output;
-    output.AddCellSet(input.GetCellSet(this->GetActiveCellSetIndex()));
-    output.AddCoordinateSystem(input.GetCoordinateSystem(this->GetActiveCoordinateSystemIndex()));
+  HandleType Coarsest;
+  std::vector<HandleType> Details;
+};
 
-    vtkm::cont::Field outputField(this->FieldName, this->FieldAssoc, out);
-    output.AddField(outputField);
+//-----------------------------------------------------------------------------
+// Copy the array to the host.
+static vtkFloatArray* NewFloatArray(const vtkm::cont::ArrayHandle<vtkm::Float32>& handle)
+{
+  auto portal = handle.GetPortalConstControl();
+  vtkm::Id n = portal.GetNumberOfValues();
 
-    // vtkm::cont::printSummary_ArrayHandle(out, std::cout);
+  vtkFloatArray* array = vtkFloatArray::New();
+  array->SetNumberOfTuples(n);
 
-    return output;
+  float* pArray = array->GetPointer(0);
+  for (vtkm::Id i = 0; i < n; ++i)
+  {
+    pArray[i] = portal.Get(i);
   }
 
-  template <typename T, typename StorageType, typename DerivedPolicy, typename DeviceAdapter>
-  VTKM_CONT
-  bool DoMapField(
-    vtkm::cont::DataSet& result,
-    const vtkm::cont::ArrayHandle<T, StorageType>& input,
-    const vtkm::filter::FieldMetadata& fieldMeta,
-    const vtkm::filter::PolicyBase<DerivedPolicy>&,
-    DeviceAdapter)
+  return array;
+}
+
+//-----------------------------------------------------------------------------
+// Convert the quantized details to a narrower integer type.
+template <typename ArrayType, typename ValueType>
+static vtkDataArray* NewQuantizedArray(vtkFloatArray* details)
+{
+  vtkIdType n = details->GetNumberOfTuples();
+  const float* pDetails = details->GetPointer(0);
+
+  ArrayType* array = ArrayType::New();
+  array->SetNumberOfTuples(n);
+
+  ValueType* pArray = array->GetPointer(0);
+  for (vtkIdType i = 0; i < n; ++i)
   {
-    result.AddField(fieldMeta.AsField(input));
-    return true;
+    pArray[i] = static_cast<ValueType>(pDetails[i]);
   }
 
-};
+  return array;
+}
+
+//-----------------------------------------------------------------------------
+// Store the details in the smallest type that can hold them exactly.
+static vtkDataArray* NewDetailArray(const vtkm::cont::ArrayHandle<vtkm::Float32>& handle,
+  bool quantized)
+{
+  vtkFloatArray* details = NewFloatArray(handle);
+  if (!quantized)
+  {
+    return details;
+  }
+
+  float maxAbs = 0.0f;
+  vtkIdType n = details->GetNumberOfTuples();
+  const float* pDetails = details->GetPointer(0);
+  for (vtkIdType i = 0; i < n; ++i)
+  {
+    maxAbs = std::max(maxAbs, std::abs(pDetails[i]));
+  }
 
+  vtkDataArray* array = details;
+  if (maxAbs <= std::numeric_limits<signed char>::max())
+  {
+    array = NewQuantizedArray<vtkSignedCharArray, signed char>(details);
+  }
+  else if (maxAbs <= std::numeric_limits<short>::max())
+  {
+    array = NewQuantizedArray<vtkShortArray, short>(details);
+  }
+  else if (maxAbs < static_cast<float>(std::numeric_limits<int>::max()))
+  {
+    array = NewQuantizedArray<vtkIntArray, int>(details);
+  }
+
+  if (array != details)
+  {
+    details->Delete();
+  }
+
+  return array;
+}
+
+//-----------------------------------------------------------------------------
+// Make an image of the given level of the pyramid. The voxels of a coarse
+// level are centered on the voxels they cover.
+static vtkImageData* NewLevelImage(const vtkm::Id3& dims, const double* origin,
+  const double* spacing, int level, vtkDataArray* scalars)
+{
+  double factor = std::ldexp(1.0, level);
+
+  vtkImageData* image = vtkImageData::New();
+  image->SetDimensions(dims[0], dims[1], dims[2]);
+  image->SetOrigin(origin[0] + 0.5 * (factor - 1.0) * spacing[0],
+    origin[1] + 0.5 * (factor - 1.0) * spacing[1],
+    origin[2] + 0.5 * (factor - 1.0) * spacing[2]);
+  image->SetSpacing(factor * spacing[0], factor * spacing[1], factor * spacing[2]);
+  image->GetPointData()->SetScalars(scalars);
+
+  return image;
+}
 
 //-----------------------------------------------------------------------------
 //-----------------------------------------------------------------------------
 senseiNewMacro(VTKmVolumeReductionAnalysis);
 
 //-----------------------------------------------------------------------------
-VTKmVolumeReductionAnalysis::VTKmVolumeReductionAnalysis() : Communicator(MPI_COMM_WORLD), Helper(NULL)
+VTKmVolumeReductionAnalysis::VTKmVolumeReductionAnalysis() : Communicator(MPI_COMM_WORLD), Helper(NULL),
+  Reduction(0), ErrorBound(0.0)
 {
 }
 
@@ -240,92 +379,163 @@ bool VTKmVolumeReductionAnalysis::Execute(DataAdaptor* data)
   {
     return false;
   }
-  data->AddArray(
-    mesh, this->MeshName,
-    this->FieldAssoc == vtkm::cont::Field::Association::POINTS ?
-    vtkDataObject::POINT : vtkDataObject::CELL,
-    this->FieldName);
-
-  vtkMultiBlockDataSet* blocks = vtkMultiBlockDataSet::SafeDownCast(mesh);
-  vtkImageData* originalImageData = nullptr;
-  for(unsigned int i = 0; i < blocks->GetNumberOfBlocks(); i++)
+  vtkSmartPointer<vtkDataObject> meshPtr;
+  meshPtr.TakeReference(mesh);
+
+  int association = this->FieldAssoc == vtkm::cont::Field::Association::POINTS ?
+    vtkDataObject::POINT : vtkDataObject::CELL;
+
+  data->AddArray(mesh, this->MeshName, association, this->FieldName);
+
+  // every level is written, even when a block is too small to be reduced
+  // further, so that all blocks have the same number of levels
+  int nLevels = std::max(0, this->Reduction) + 1;
+  bool quantized = this->ErrorBound > 0.0;
+  vtkm::Float32 scale = static_cast<vtkm::Float32>(2.0 * this->ErrorBound);
+
+  this->Helper->SetVolumeLevels(nLevels, this->ErrorBound);
+
+  int blockId = 0;
+  VTKUtils::DatasetFunction func = [&](vtkDataSet* ds) -> int
+  {
+    vtkImageData* image = vtkImageData::SafeDownCast(ds);
+    vtkFieldData* atts = image ? VTKUtils::GetAttributes(image, association) : nullptr;
+    vtkDataArray* array = atts ? atts->GetArray(this->FieldName.c_str()) : nullptr;
+
+    // not every block need have the array
+    if (!array)
     {
-    vtkImageData* block = vtkImageData::SafeDownCast(blocks->GetBlock(i));
-    originalImageData = block ? block : originalImageData;
+      return 0;
     }
-  if (originalImageData == nullptr) {
-    return true;
-  }
 
-  vtkNew<vtkImageData> outputDataSet;
-  if (this->Reduction > 0)
+    if (array->GetNumberOfComponents() > 1)
     {
-    Profiler::StartEvent("VTKm reduction");
+      SENSEI_ERROR("Cannot reduce multi-component (vector, non-scalar) array \""
+        << this->FieldName << "\"");
+      return -1;
+    }
+
+    // the dimensions of the data, cell data is written as point data
+    // located at the cell centers
+    int imageDims[3];
+    image->GetDimensions(imageDims);
+
+    double origin[3];
+    image->GetOrigin(origin);
 
-    int dimensions[3];
-    originalImageData->GetDimensions(dimensions);
-    dimensions[0]--; // cell data to point data
-    dimensions[1]--; // cell data to point data
-    dimensions[2]--; // cell data to point data
+    double spacing[3];
+    image->GetSpacing(spacing);
 
-    vtkNew<vtkFloatArray> dataArray;
-    dataArray->ShallowCopy(vtkFloatArray::SafeDownCast(originalImageData->GetCellData()->GetScalars()));
-    vtkm::cont::ArrayHandle<vtkm::Float32> vtkmArray;
-    for (int step = 0 ; step < this->Reduction; step++)
+    std::vector<vtkm::Id3> dims(nLevels);
+    for (int i = 0; i < 3; ++i)
+    {
+      if (association == vtkDataObject::CELL)
       {
-      // Data preparation
-      float* inFloat = dataArray->GetPointer(0);
-      int size = dimensions[0] * dimensions[1] * dimensions[2];
-
-      // --- vtk-m filtering ---
-      // - create vtkm dataset
-      vtkm::cont::ArrayHandle<vtkm::Float32> handle = vtkm::cont::make_ArrayHandle(inFloat, size);
-      vtkm::cont::DataSetBuilderUniform builder;
-      vtkm::cont::DataSet dataset = builder.Create(vtkm::Id3(dimensions[0], dimensions[1], dimensions[2]));
-      vtkm::cont::Field scalarField(this->FieldName, this->FieldAssoc, handle);
-      dataset.AddField(scalarField);
-
-      // - create and execute filter
-      ImageReduction filter;
-      filter.SetInputDimensions(dimensions[0], dimensions[1], dimensions[2]);
-      filter.SetField(this->FieldAssoc, this->FieldName);
-      auto rdata = filter.Execute(dataset, ImageReductionPolicy());
-
-      // - recover data from vtkm
-      rdata.GetField(this->FieldName, this->FieldAssoc).GetData().CopyTo(vtkmArray);
-      float* t = vtkmArray.GetStorage().GetArray();
-
-      // - rebuild regular vtkImageData
-      int newDims[3] = { int(dimensions[0] / 2), int(dimensions[1] / 2), int(dimensions[2] / 2) };
-      int reducedSize = newDims[0] * newDims[1] * newDims[2];
-
-      // Update dimensions and array
-      dimensions[0] = newDims[0];
-      dimensions[1] = newDims[1];
-      dimensions[2] = newDims[2];
-      dataArray->SetArray(t, reducedSize, 1);
+        dims[0][i] = std::max(1, imageDims[i] - 1);
+        origin[i] += 0.5 * spacing[i];
       }
-    outputDataSet->SetDimensions(dimensions[0], dimensions[1], dimensions[2]);
-    outputDataSet->GetPointData()->SetScalars(dataArray);
-    Profiler::EndEvent("VTKm reduction");
+      else
+      {
+        dims[0][i] = imageDims[i];
+      }
+      for (int l = 1; l < nLevels; ++l)
+      {
+        dims[l][i] = (dims[l - 1][i] + 1) / 2;
+      }
+    }
+
+    int id = blockId++;
+
+    Profiler::StartEvent("VTKm reduction");
+
+    // float data is used in place, others are converted
+    vtkIdType n = array->GetNumberOfTuples();
+    std::vector<vtkm::Float32> converted;
+    vtkm::cont::ArrayHandle<vtkm::Float32> input;
+    if (array->GetDataType() == VTK_FLOAT)
+    {
+      input = vtkm::cont::make_ArrayHandle(
+        static_cast<vtkm::Float32*>(array->GetVoidPointer(0)), n);
+    }
+    else
+    {
+      converted.resize(n);
+      switch (array->GetDataType())
+      {
+        vtkTemplateMacro(
+          const VTK_TT* pArray = static_cast<VTK_TT*>(array->GetVoidPointer(0));
+          std::copy(pArray, pArray + n, converted.begin());
+        );
+        default:
+          SENSEI_ERROR("Unsupported array type " << array->GetClassName())
+          Profiler::EndEvent("VTKm reduction");
+          return -1;
+      }
+      input = vtkm::cont::make_ArrayHandle(converted);
+    }
+
+    BuildPyramid pyramid(input, dims, quantized ? scale : 0.0f);
+    if (!vtkm::cont::TryExecute(pyramid, DevicesToTry()))
+    {
+      SENSEI_ERROR("Failed to build the pyramid of \"" << this->FieldName << "\"")
+      Profiler::EndEvent("VTKm reduction");
+      return -1;
+    }
+
+    // the coarsest level, unreduced data is passed through
+    vtkSmartPointer<vtkDataArray> coarsest;
+    if (nLevels > 1)
+    {
+      coarsest.TakeReference(NewFloatArray(pyramid.Coarsest));
+    }
+    else
+    {
+      coarsest = array;
     }
-  else
+
+    // the details, finest to coarsest
+    std::vector<vtkSmartPointer<vtkDataArray>> details(nLevels - 1);
+    for (int l = 1; l < nLevels; ++l)
+    {
+      details[l - 1].TakeReference(NewDetailArray(pyramid.Details[l - 1], quantized));
+    }
+
+    Profiler::EndEvent("VTKm reduction");
+
+    Profiler::StartEvent("Cinema Volume export");
+
+    vtkSmartPointer<vtkImageData> coarseImage;
+    coarseImage.TakeReference(NewLevelImage(dims[nLevels - 1],
+      origin, spacing, nLevels - 1, coarsest));
+
+    this->Helper->WriteVolume(coarseImage, "volume", id);
+
+    for (int l = nLevels - 1; l > 0; --l)
     {
-    int dim[3];
-    originalImageData->GetDimensions(dim);
-    dim[0]--; // cell data to point data
-    dim[1]--; // cell data to point data
-    dim[2]--; // cell data to point data
-    outputDataSet->SetDimensions(dim[0], dim[1], dim[2]);
-    outputDataSet->GetPointData()->SetScalars(originalImageData->GetCellData()->GetScalars());
+      std::ostringstream baseName;
+      baseName << "detail_" << l;
+
+      vtkSmartPointer<vtkImageData> detailImage;
+      detailImage.TakeReference(NewLevelImage(dims[l - 1],
+        origin, spacing, l - 1, details[l - 1]));
+
+      this->Helper->WriteVolume(detailImage, baseName.str(), id,
+        quantized ? scale : 1.0);
     }
 
-  // -----------------------
+    Profiler::EndEvent("Cinema Volume export");
+
+    return 0;
+  };
+
+  if (VTKUtils::Apply(mesh, func) < 0)
+  {
+    SENSEI_ERROR("Failed to reduce \"" << this->FieldName << "\" on mesh \""
+      << this->MeshName << "\"")
+    return false;
+  }
 
-  Profiler::StartEvent("Cinema Volume export");
-  this->Helper->WriteVolume(outputDataSet.GetPointer());
   this->Helper->WriteMetadata();
-  Profiler::EndEvent("Cinema Volume export");
 
   return true;
 }
@@ -9,6 +9,15 @@ namespace sensei
 {
 class CinemaHelper;
 
+/// @class VTKmVolumeReductionAnalysis
+/// @brief Writes a multi-resolution pyramid of the image blocks
+///
+/// Each local image block is reduced "reductionFactor" times by a factor of 2
+/// along each axis, averaging each 2x2x2 group of voxels. All levels are
+/// computed on the device in a single pass. The coarsest level is written as
+/// "volume" and each finer level as "detail_<l>", the residual between level
+/// l-1 and the coarser level l it refines, so that a reader can progressively
+/// refine the volume. Cell and point scalars of any numeric type are handled.
 class VTKmVolumeReductionAnalysis : public AnalysisAdaptor
 {
 public:
@@ -23,6 +32,13 @@ public:
     int reductionFactor,
     MPI_Comm comm);
 
+  /// The largest absolute difference between the original values and the
+  /// values reconstructed from the coarsest level and the details. The
+  /// details are quantized to the smallest integer type that can hold them.
+  /// The default, 0, stores the details losslessly as 32 bit floats.
+  void SetErrorBound(double val) { this->ErrorBound = val; }
+  double GetErrorBound() { return this->ErrorBound; }
+
   bool Execute(DataAdaptor* data) override;
 
   int Finalize() override { return 0; }
@@ -37,6 +53,7 @@ protected:
   MPI_Comm Communicator;
   CinemaHelper* Helper;
   int Reduction;
+  double ErrorBound;
 
 private:
   VTKmVolumeReductionAnalysis(const VTKmVolumeReductionAnalysis&);
@@ -0,0 +1,249 @@
+#include "ErrorBoundedCompressor.h"
+#include "TemporalEncoder.h"
+#include "Error.h"
+
+#include <vtkType.h>
+
+#include <mpi.h>
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <cstdlib>
+#include <cmath>
+
+// Reports the compression ratio, throughput, and largest error of the error
+// bounded compressor on the oscillator miniapp's field, for a range of
+// bounds relative to the range of the values. The lossless shuffle and run
+// length stage of the temporal encoder is shown for comparison. The grid
+// covers the domain of the miniapp's sample input, split along z across the
+// ranks.
+//
+// usage: benchmarkErrorBoundedCompressor [points per side] [time] [repetitions]
+
+// the oscillators of miniapps/oscillators/inputs/sample.osc
+struct Oscillator
+{
+  enum { damped, decaying, periodic } type;
+  float center[3];
+  float radius;
+  float omega0;
+  float zeta;
+};
+
+const Oscillator gOscillators[] = {
+  {Oscillator::damped, {32.f, 32.f, 32.f}, 10.f, 3.14f, 0.3f},
+  {Oscillator::damped, {16.f, 32.f, 16.f}, 10.f, 9.5f, 0.1f},
+  {Oscillator::damped, {48.f, 32.f, 48.f}, 5.f, 3.14f, 0.1f},
+  {Oscillator::decaying, {16.f, 32.f, 48.f}, 15.f, 3.14f, 0.f},
+  {Oscillator::periodic, {48.f, 32.f, 16.f}, 15.f, 3.14f, 0.f}};
+
+// the sum of the oscillators at a point, as in the miniapp
+float evaluate(const float *x, float t)
+{
+  const float pi = 3.14159265358979323846f;
+  t *= 2.f*pi;
+
+  float sum = 0.f;
+  for (const Oscillator &o : gOscillators)
+    {
+    float dx = o.center[0] - x[0];
+    float dy = o.center[1] - x[1];
+    float dz = o.center[2] - x[2];
+    float dist2 = dx*dx + dy*dy + dz*dz;
+    float damp = std::exp(-dist2/(2.f*o.radius*o.radius));
+
+    float val = 0.f;
+    if (o.type == Oscillator::damped)
+      {
+      float phi = std::acos(o.zeta);
+      val = 1.f - std::exp(-o.zeta*o.omega0*t)*
+        (std::sin(std::sqrt(1.f - o.zeta*o.zeta)*o.omega0*t + phi)/std::sin(phi));
+      }
+    else if (o.type == Oscillator::decaying)
+      {
+      float tt = t + 1.f/o.omega0;
+      val = std::sin(tt/o.omega0)/(o.omega0*tt);
+      }
+    else
+      {
+      float tt = t + 1.f/o.omega0;
+      val = std::sin(tt/o.omega0);
+      }
+
+    sum += val*damp;
+    }
+
+  return sum;
+}
+
+// time a function across all ranks
+double timeIt(const std::function<void()> &func)
+{
+  MPI_Barrier(MPI_COMM_WORLD);
+  double t0 = MPI_Wtime();
+  func();
+  double dt = MPI_Wtime() - t0;
+  MPI_Allreduce(MPI_IN_PLACE, &dt, 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+  return dt;
+}
+
+int main(int argc, char **argv)
+{
+  MPI_Init(&argc, &argv);
+
+  int rank = 0;
+  int nRanks = 1;
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &nRanks);
+
+  long n = argc > 1 ? atol(argv[1]) : 128;
+  float t = argc > 2 ? atof(argv[2]) : 0.5f;
+  int nReps = argc > 3 ? atoi(argv[3]) : 5;
+
+  if ((n < 2) || (n < nRanks) || (nReps < 1))
+    {
+    SENSEI_ERROR("At least 2 points per side, one z layer per rank, and 1"
+      " repetition are required")
+    MPI_Abort(MPI_COMM_WORLD, -1);
+    }
+
+  // this rank's slab of the grid over [0, 64]^3
+  long k0 = rank*n/nRanks;
+  long k1 = (rank + 1)*n/nRanks;
+  size_t dims[3] = {size_t(n), size_t(n), size_t(k1 - k0)};
+  size_t nVals = dims[0]*dims[1]*dims[2];
+
+  float dx = 64.f/(n - 1);
+  std::vector<float> vals(nVals);
+  for (long k = k0, q = 0; k < k1; ++k)
+    for (long j = 0; j < n; ++j)
+      for (long i = 0; i < n; ++i, ++q)
+        {
+        float x[3] = {i*dx, j*dx, k*dx};
+        vals[q] = evaluate(x, t);
+        }
+
+  auto range = std::minmax_element(vals.begin(), vals.end());
+  double valRange = double(*range.second) - double(*range.first);
+
+  double rawBytes = nVals*sizeof(float);
+  double totalRaw = rawBytes;
+  MPI_Allreduce(MPI_IN_PLACE, &totalRaw, 1, MPI_DOUBLE, MPI_SUM,
+    MPI_COMM_WORLD);
+
+  double totalMB = 1e-6*totalRaw*nReps;
+
+  if (rank == 0)
+    std::cerr << n << "^3 float32 oscillator values at t=" << t << ", "
+      << nRanks << " MPI ranks, " << nReps << " repetitions" << std::endl
+      << std::setw(14) << "bound" << std::setw(10) << "ratio"
+      << std::setw(14) << "comp(MB/s)" << std::setw(16) << "decomp(MB/s)"
+      << std::setw(14) << "max error" << std::setw(14) << "allowed"
+      << std::endl;
+
+  int retVal = 0;
+  std::vector<unsigned char> frame;
+  std::vector<float> decoded(nVals);
+
+  // the lossless baselines, byte shuffle followed by run length encoding
+  // or zlib
+  const char *losslessComps[] = {"rle", "zlib"};
+  for (const char *comp : losslessComps)
+    {
+    sensei::TemporalEncoder enc;
+    enc.SetShuffle(1);
+    enc.SetCompressor(comp);
+
+    sensei::TemporalEncoder dec;
+
+    int failed = 0;
+    double compTime = timeIt([&]()
+      {
+      for (int r = 0; r < nReps; ++r)
+        failed |= enc.Encode("f", vals.data(), rawBytes, sizeof(float), frame);
+      });
+
+    double decompTime = timeIt([&]()
+      {
+      for (int r = 0; r < nReps; ++r)
+        failed |= dec.Decode("f", frame.data(), frame.size(), decoded.data(),
+          rawBytes);
+      });
+
+    double frameBytes = frame.size();
+    MPI_Allreduce(MPI_IN_PLACE, &frameBytes, 1, MPI_DOUBLE, MPI_SUM,
+      MPI_COMM_WORLD);
+
+    failed |= !std::equal(vals.begin(), vals.end(), decoded.begin());
+    MPI_Allreduce(MPI_IN_PLACE, &failed, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+
+    if (failed)
+      {
+      SENSEI_ERROR("The lossless " << comp << " baseline failed")
+      retVal = -1;
+      }
+
+    if (rank == 0)
+      std::cerr << std::setw(14) << (std::string("lossless ") + comp)
+        << std::setw(10) << totalRaw/frameBytes << std::setw(14)
+        << totalMB/compTime << std::setw(16) << totalMB/decompTime
+        << std::setw(14) << 0.0 << std::setw(14) << 0.0 << std::endl;
+    }
+
+  // the error bounded compressor, the bound is relative to each rank's range
+  double bounds[] = {1e-2, 1e-3, 1e-4, 1e-5, 1e-6};
+  for (double bound : bounds)
+    {
+    int failed = 0;
+    double compTime = timeIt([&]()
+      {
+      for (int r = 0; r < nReps; ++r)
+        failed |= sensei::ErrorBoundedCompressor::Encode(VTK_FLOAT,
+          vals.data(), nVals, 1, dims,
+          sensei::ErrorBoundedCompressor::MODE_RELATIVE, bound, frame);
+      });
+
+    double decompTime = timeIt([&]()
+      {
+      for (int r = 0; r < nReps; ++r)
+        failed |= sensei::ErrorBoundedCompressor::Decode(frame.data(),
+          frame.size(), decoded.data(), rawBytes);
+      });
+
+    double frameBytes = frame.size();
+    MPI_Allreduce(MPI_IN_PLACE, &frameBytes, 1, MPI_DOUBLE, MPI_SUM,
+      MPI_COMM_WORLD);
+
+    // the error as a fraction of the range, the largest over the ranks
+    double maxErr = 0.0;
+    for (size_t i = 0; i < nVals; ++i)
+      maxErr = std::max(maxErr, std::fabs(double(decoded[i]) - double(vals[i])));
+
+    double relErr = valRange > 0.0 ? maxErr/valRange : maxErr;
+
+    MPI_Allreduce(MPI_IN_PLACE, &relErr, 1, MPI_DOUBLE, MPI_MAX,
+      MPI_COMM_WORLD);
+
+    MPI_Allreduce(MPI_IN_PLACE, &failed, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+
+    if (rank == 0)
+      std::cerr << std::setw(14) << bound << std::setw(10)
+        << totalRaw/frameBytes << std::setw(14) << totalMB/compTime
+        << std::setw(16) << totalMB/decompTime << std::setw(14) << relErr
+        << std::setw(14) << bound << std::endl;
+
+    if (failed || (relErr > bound))
+      {
+      SENSEI_ERROR("The relative error " << relErr << " exceeds the bound "
+        << bound)
+      retVal = -1;
+      }
+    }
+
+  MPI_Finalize();
+
+  return retVal;
+}
@@ -0,0 +1,150 @@
+#include <mpi.h>
+#include "MPIUtils.h"
+#include "Error.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+// Compares the MPIUtils collectives made directly over the communicator
+// with the node aware ones that combine values through shared memory
+// before the collective across nodes. The reductions are made on vectors
+// of increasing length, as histograms and metadata are. The results of
+// the two paths must be identical.
+//
+// usage: benchmarkNodeCollectives [max length] [repetitions]
+
+// time a function across all ranks
+double timeIt(const std::function<void()> &func, int nReps)
+{
+  MPI_Barrier(MPI_COMM_WORLD);
+  double t0 = MPI_Wtime();
+  for (int i = 0; i < nReps; ++i)
+    func();
+  double dt = (MPI_Wtime() - t0)/nReps;
+  MPI_Allreduce(MPI_IN_PLACE, &dt, 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+  return dt;
+}
+
+// the values contributed by a rank
+void newData(int rank, int n, std::vector<unsigned long> &counts,
+  std::vector<double> &vals, std::vector<std::array<double,6>> &bounds)
+{
+  counts.resize(n);
+  vals.resize(n);
+  for (int i = 0; i < n; ++i)
+    {
+    counts[i] = (i + rank) % 7;
+    vals[i] = std::sin(0.1*i + rank);
+    }
+
+  // a variable number of blocks per rank
+  bounds.resize(rank % 3 + 1);
+  for (size_t i = 0; i < bounds.size(); ++i)
+    bounds[i] = {-1.0*rank, 1.0*rank + i, 0.0, 1.0, -2.0*i, 2.0*i};
+}
+
+int main(int argc, char **argv)
+{
+  int provided = 0;
+  MPI_Init_thread(&argc, &argv, MPI_THREAD_SERIALIZED, &provided);
+
+  int rank = 0;
+  int nRanks = 1;
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &nRanks);
+
+  int maxLen = argc > 1 ? atoi(argv[1]) : 65536;
+  int nReps = argc > 2 ? atoi(argv[2]) : 20;
+
+  // the analyses use duplicates of the world communicator
+  MPI_Comm comm = MPI_COMM_NULL;
+  MPI_Comm_dup(MPI_COMM_WORLD, &comm);
+
+  // report how the ranks are placed
+  sensei::MPIUtils::SetNodeAwareCollectives(1);
+  sensei::MPIUtils::NodeInfo *node = sensei::MPIUtils::GetNodeInfo(comm);
+  int nNodes = node ? node->NumNodes : 1;
+
+  if (rank == 0)
+    std::cerr << nRanks << " ranks on " << nNodes << " nodes" << std::endl
+      << std::setw(10) << "length" << std::setw(14) << "collective"
+      << std::setw(14) << "direct us" << std::setw(14) << "node us"
+      << std::setw(10) << "speedup" << std::endl;
+
+  int testResult = 0;
+  for (int n = 1; n <= maxLen; n *= 16)
+    {
+    std::vector<unsigned long> counts;
+    std::vector<double> vals;
+    std::vector<std::array<double,6>> bounds;
+    newData(rank, n, counts, vals, bounds);
+
+    std::vector<unsigned long> counts0, counts1;
+    std::vector<double> vals0, vals1;
+    std::array<double,6> bounds0{}, bounds1{};
+
+    struct Case
+      {
+      const char *Name;
+      std::function<void(int)> Run;
+      };
+
+    Case cases[] = {
+      {"counts", [&](int aware)
+        {
+        std::vector<unsigned long> &res = aware ? counts1 : counts0;
+        res = counts;
+        sensei::MPIUtils::GlobalCounts(comm, res);
+        }},
+      {"view", [&](int aware)
+        {
+        std::vector<double> &res = aware ? vals1 : vals0;
+        std::vector<double> lvals(vals.begin(), vals.begin() + (rank % 2 ? n : n/2));
+        sensei::MPIUtils::GlobalViewV(comm, lvals, res);
+        }},
+      {"bounds", [&](int aware)
+        {
+        std::array<double,6> &res = aware ? bounds1 : bounds0;
+        sensei::MPIUtils::GlobalBounds(comm, bounds, res);
+        }}};
+
+    for (const Case &c : cases)
+      {
+      // the view gathers the values of all ranks, keep it to a size that
+      // fits easily
+      if ((c.Name[0] == 'v') && ((long)n*nRanks > (1l << 24)))
+        continue;
+
+      sensei::MPIUtils::SetNodeAwareCollectives(0);
+      double t0 = timeIt([&]() { c.Run(0); }, nReps);
+
+      sensei::MPIUtils::SetNodeAwareCollectives(1);
+      double t1 = timeIt([&]() { c.Run(1); }, nReps);
+
+      int same = (counts0 == counts1) && (vals0 == vals1) && (bounds0 == bounds1);
+      MPI_Allreduce(MPI_IN_PLACE, &same, 1, MPI_INT, MPI_MIN, comm);
+      if (!same)
+        {
+        if (rank == 0)
+          SENSEI_ERROR("The node aware " << c.Name << " of length " << n
+            << " differs from the direct one")
+        testResult = -1;
+        }
+
+      if (rank == 0)
+        std::cerr << std::setw(10) << n << std::setw(14) << c.Name
+          << std::setw(14) << std::setprecision(4) << 1e6*t0
+          << std::setw(14) << 1e6*t1 << std::setw(10) << t0/t1 << std::endl;
+      }
+    }
+
+  MPI_Comm_free(&comm);
+
+  MPI_Finalize();
+
+  return testResult;
+}
@@ -0,0 +1,191 @@
+#include "QuantileSketch.h"
+#include "Error.h"
+
+#include <vtkType.h>
+#include <vtkMPIController.h>
+#include <vtkNew.h>
+
+#include "CDFReducer.h"
+
+#include <mpi.h>
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <functional>
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <cstdlib>
+#include <cmath>
+
+// Compares the wall time and accuracy of the CDF computations available in
+// VTKmCDFAnalysis. A full local sort followed by CDFReducer's iterative
+// distributed search, the exact parallel sample sort, and the approximation
+// from a mergeable quantile sketch.
+//
+// usage: benchmarkQuantiles [values per rank] [quantiles] [error bound]
+//   [distinct values]
+//
+// When the number of distinct values is given the values are folded onto
+// that many integers, the ties that result exercise the sample sort's
+// splitting of equal values across ranks.
+
+// returns the largest error in the ranks of the computed
+// quantiles as a fraction of the number of values
+double rankError(const std::vector<double> &sorted,
+  const double *cdf, unsigned int nQuantiles)
+{
+  double maxErr = 0.0;
+  double n = sorted.size();
+  unsigned int splitSize = nQuantiles - 1;
+  for (unsigned int i = 1; i < splitSize; ++i)
+    {
+    double target = double((long long)(i*sorted.size()/splitSize));
+
+    double lo = std::lower_bound(sorted.begin(), sorted.end(), cdf[i]) - sorted.begin();
+    double hi = std::upper_bound(sorted.begin(), sorted.end(), cdf[i]) - sorted.begin();
+
+    double err = target < lo ? lo - target : (target >= hi ? target - hi + 1 : 0.0);
+    maxErr = std::max(maxErr, err/n);
+    }
+  return maxErr;
+}
+
+// time a function across all ranks
+double timeIt(const std::function<void()> &func)
+{
+  MPI_Barrier(MPI_COMM_WORLD);
+  double t0 = MPI_Wtime();
+  func();
+  double dt = MPI_Wtime() - t0;
+  MPI_Allreduce(MPI_IN_PLACE, &dt, 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+  return dt;
+}
+
+int main(int argc, char **argv)
+{
+  MPI_Init(&argc, &argv);
+
+  int rank = 0;
+  int nRanks = 1;
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &nRanks);
+
+  long nVals = argc > 1 ? atol(argv[1]) : 1000000;
+  unsigned int nQuantiles = argc > 2 ? atoi(argv[2]) : 100;
+  double errorBound = argc > 3 ? atof(argv[3]) : 0.01;
+  long nDistinct = argc > 4 ? atol(argv[4]) : 0;
+
+  if ((nVals < 1) || (nQuantiles < 3))
+    {
+    SENSEI_ERROR("At least 1 value per rank and 3 quantiles are required")
+    MPI_Abort(MPI_COMM_WORLD, -1);
+    }
+
+  // a skewed distribution that differs per rank
+  std::mt19937_64 gen(rank + 1);
+  std::lognormal_distribution<double> dist(0.1*rank, 1.0);
+
+  std::vector<double> vals(nVals);
+  for (long i = 0; i < nVals; ++i)
+    vals[i] = nDistinct > 0 ? double(long(10.0*dist(gen)) % nDistinct) : dist(gen);
+
+  // iterative search
+  vtkNew<vtkMPIController> controller;
+  controller->Initialize(0, 0, 1);
+
+  std::vector<double> search(nQuantiles);
+  double searchTime = timeIt([&]()
+    {
+    std::vector<double> sorted(vals);
+    std::sort(sorted.begin(), sorted.end());
+
+    CDFReducer reducer(controller);
+    reducer.SetBufferSize(nQuantiles);
+
+    double *cdf = reducer.Compute(sorted.data(), nVals, nQuantiles);
+    std::copy(cdf, cdf + nQuantiles, search.begin());
+    });
+
+  // sample sort
+  std::vector<double> exact(nQuantiles);
+  int exactFailed = 0;
+  double exactTime = timeIt([&]()
+    {
+    std::vector<double> unsorted(vals);
+
+    CDFReducer reducer(nullptr);
+
+    double *cdf = reducer.ComputeSampleSort(MPI_COMM_WORLD,
+      unsorted.data(), nVals, nQuantiles);
+
+    if (cdf)
+      std::copy(cdf, cdf + nQuantiles, exact.begin());
+    else
+      exactFailed = 1;
+    });
+
+  // approximate
+  std::vector<double> approx(nQuantiles);
+  size_t sketchSize = 0;
+  double approxTime = timeIt([&]()
+    {
+    sensei::QuantileSketch sketch(errorBound);
+    sketch.Update(vals.data(), nVals);
+    sketch.Reduce(MPI_COMM_WORLD, 0);
+    if (rank == 0)
+      {
+      sketch.GetCDF(nQuantiles, approx.data());
+      sketchSize = sketch.GetSize();
+      }
+    });
+
+  // the reference
+  std::vector<double> all(rank == 0 ? nVals*nRanks : 0);
+  MPI_Gather(vals.data(), nVals, MPI_DOUBLE, all.data(), nVals,
+    MPI_DOUBLE, 0, MPI_COMM_WORLD);
+
+  int retVal = 0;
+  if (rank == 0)
+    {
+    std::sort(all.begin(), all.end());
+
+    double searchErr = rankError(all, search.data(), nQuantiles);
+    double exactErr = rankError(all, exact.data(), nQuantiles);
+    double approxErr = rankError(all, approx.data(), nQuantiles);
+
+    std::cerr << nVals << " values per rank, " << nRanks << " MPI ranks, "
+      << nQuantiles << " quantiles, bound " << errorBound << ", "
+      << (nDistinct > 0 ? std::to_string(nDistinct) : std::string("all"))
+      << " distinct values"
+      << ", sketch size " << sketchSize << std::endl
+      << std::setw(12) << "mode" << std::setw(14) << "time(s)"
+      << std::setw(16) << "max rank diff" << std::endl
+      << std::setw(12) << "search" << std::setw(14) << searchTime
+      << std::setw(16) << searchErr << std::endl
+      << std::setw(12) << "exact" << std::setw(14) << exactTime
+      << std::setw(16) << exactErr << std::endl
+      << std::setw(12) << "approximate" << std::setw(14) << approxTime
+      << std::setw(16) << approxErr << std::endl;
+
+    if (exactFailed || (exactErr > 0.0))
+      {
+      SENSEI_ERROR("The sample sort is not exact, rank error " << exactErr)
+      retVal = -1;
+      }
+
+    // the bound holds with high probability, allow some slack
+    if (approxErr > 2.0*errorBound)
+      {
+      SENSEI_ERROR("The approximation's rank error " << approxErr
+        << " exceeds the bound " << errorBound)
+      retVal = -1;
+      }
+    }
+
+  controller->Finalize(1);
+
+  MPI_Finalize();
+
+  return retVal;
+}
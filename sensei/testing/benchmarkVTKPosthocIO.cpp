@@ -0,0 +1,222 @@
+#include "VTKPosthocIO.h"
+#include "VTKDataAdaptor.h"
+#include "DataRequirements.h"
+#include "senseiConfig.h"
+#include "Error.h"
+
+#include <vtkDataObject.h>
+#include <vtkFloatArray.h>
+#include <vtkImageData.h>
+#include <vtkMultiBlockDataSet.h>
+#include <vtkPointData.h>
+
+#include <mpi.h>
+#include <cmath>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <dirent.h>
+#include <sys/stat.h>
+
+// Measures the rate at which VTKPosthocIO writes blocks, comparing
+// sequential writes with writes on a thread pool, the XML writer's
+// compressors, and subfiling. Rates are reported in blocks and in bytes
+// of array data per second, along with the size of the files written.
+//
+// usage: benchmarkVTKPosthocIO [cells per side] [blocks per rank] [steps] [threads]
+
+// make the rank's blocks, each holds a smooth float field
+vtkMultiBlockDataSet *newMesh(int rank, int nRanks, int nCells,
+  int nBlocks, int step)
+{
+  vtkMultiBlockDataSet *mb = vtkMultiBlockDataSet::New();
+  mb->SetNumberOfBlocks(nRanks*nBlocks);
+
+  for (int b = 0; b < nBlocks; ++b)
+    {
+    int bid = rank*nBlocks + b;
+
+    vtkImageData *im = vtkImageData::New();
+    im->SetDimensions(nCells + 1, nCells + 1, nCells + 1);
+    im->SetOrigin(0.0, 0.0, nCells*bid);
+
+    long nPts = im->GetNumberOfPoints();
+
+    vtkFloatArray *f = vtkFloatArray::New();
+    f->SetName("f");
+    f->SetNumberOfTuples(nPts);
+
+    float *pf = f->GetPointer(0);
+    for (long i = 0; i < nPts; ++i)
+      pf[i] = std::sin(0.01f*i + 0.1f*step + bid);
+
+    im->GetPointData()->AddArray(f);
+    f->Delete();
+
+    mb->SetBlock(bid, im);
+    im->Delete();
+    }
+
+  return mb;
+}
+
+// sums the size of the files in a directory
+long long directorySize(const std::string &dirName)
+{
+  long long nBytes = 0;
+  DIR *dir = opendir(dirName.c_str());
+  if (!dir)
+    return 0;
+
+  while (struct dirent *ent = readdir(dir))
+    {
+    std::string fileName = dirName + "/" + ent->d_name;
+    struct stat st;
+    if (!stat(fileName.c_str(), &st) && S_ISREG(st.st_mode))
+      nBytes += st.st_size;
+    }
+
+  closedir(dir);
+  return nBytes;
+}
+
+// time a function across all ranks
+double timeIt(const std::function<int()> &func, int &status)
+{
+  MPI_Barrier(MPI_COMM_WORLD);
+  double t0 = MPI_Wtime();
+  status = func();
+  double dt = MPI_Wtime() - t0;
+  MPI_Allreduce(MPI_IN_PLACE, &dt, 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+  MPI_Allreduce(MPI_IN_PLACE, &status, 1, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
+  return dt;
+}
+
+int main(int argc, char **argv)
+{
+  MPI_Init(&argc, &argv);
+
+  int rank = 0;
+  int nRanks = 1;
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &nRanks);
+
+  int nCells = argc > 1 ? atoi(argv[1]) : 32;
+  int nBlocks = argc > 2 ? atoi(argv[2]) : 8;
+  int nSteps = argc > 3 ? atoi(argv[3]) : 2;
+  int nThreads = argc > 4 ? atoi(argv[4]) : 4;
+
+  long long nBlocksTotal = (long long)nRanks*nBlocks*nSteps;
+  long long nBytesTotal = nBlocksTotal*(nCells + 1)*(nCells + 1)*(nCells + 1)*sizeof(float);
+
+  struct Config
+    {
+    int Threads;
+    const char *Compressor;
+    int Subfiling;
+    };
+
+  std::vector<Config> configs;
+  for (int sub = 0; sub < 2; ++sub)
+    {
+#if !defined(ENABLE_VTK_FILTERS)
+    if (sub)
+      continue;
+#endif
+    for (const char *comp : {"none", "zlib", "lz4"})
+      {
+      configs.push_back({1, comp, sub});
+      configs.push_back({nThreads, comp, sub});
+      }
+    }
+
+  if (rank == 0)
+    std::cerr << nRanks << " ranks, " << nBlocks << " blocks per rank of "
+      << nCells << "^3 cells, " << nSteps << " steps" << std::endl
+      << std::setw(8) << "threads" << std::setw(12) << "compressor"
+      << std::setw(10) << "subfiling" << std::setw(12) << "seconds"
+      << std::setw(12) << "blocks/s" << std::setw(12) << "MB/s"
+      << std::setw(12) << "disk MB" << std::endl;
+
+  int testResult = 0;
+  for (const Config &cfg : configs)
+    {
+    std::ostringstream dirName;
+    dirName << "benchmarkVTKPosthocIO_" << cfg.Threads << "_"
+      << cfg.Compressor << "_" << cfg.Subfiling;
+
+    sensei::DataRequirements reqs;
+    reqs.AddRequirement("mesh", vtkDataObject::POINT,
+      std::vector<std::string>({"f"}));
+
+    sensei::VTKPosthocIO *writer = sensei::VTKPosthocIO::New();
+    writer->SetCommunicator(MPI_COMM_WORLD);
+    writer->SetNumberOfThreads(cfg.Threads);
+
+    if (writer->SetOutputDir(dirName.str()) || writer->SetMode("paraview") ||
+      writer->SetCompressor(cfg.Compressor) || writer->SetSubfiling(cfg.Subfiling) ||
+      writer->SetDataRequirements(reqs))
+      {
+      SENSEI_ERROR("Failed to configure the writer")
+      writer->Delete();
+      testResult = -1;
+      continue;
+      }
+
+    // the meshes are made outside of the timed region
+    std::vector<sensei::VTKDataAdaptor*> adaptors(nSteps);
+    for (int i = 0; i < nSteps; ++i)
+      {
+      vtkMultiBlockDataSet *mb = newMesh(rank, nRanks, nCells, nBlocks, i);
+      adaptors[i] = sensei::VTKDataAdaptor::New();
+      adaptors[i]->SetCommunicator(MPI_COMM_WORLD);
+      adaptors[i]->SetDataObject("mesh", mb);
+      adaptors[i]->SetDataTimeStep(i);
+      adaptors[i]->SetDataTime(i);
+      mb->Delete();
+      }
+
+    int status = 0;
+    double dt = timeIt([&]() -> int
+      {
+      for (int i = 0; i < nSteps; ++i)
+        {
+        if (!writer->Execute(adaptors[i]))
+          return -1;
+        }
+      return writer->Finalize();
+      }, status);
+
+    for (int i = 0; i < nSteps; ++i)
+      adaptors[i]->Delete();
+
+    writer->Delete();
+
+    if (status)
+      {
+      SENSEI_ERROR("Failed to write with " << cfg.Threads << " threads, compressor "
+        << cfg.Compressor << ", subfiling " << cfg.Subfiling)
+      testResult = -1;
+      continue;
+      }
+
+    // the directory is shared when ranks are on the same node
+    long long diskBytes = rank == 0 ? directorySize(dirName.str()) : 0;
+
+    if (rank == 0)
+      std::cerr << std::setw(8) << cfg.Threads << std::setw(12) << cfg.Compressor
+        << std::setw(10) << cfg.Subfiling << std::setw(12) << std::setprecision(4)
+        << dt << std::setw(12) << nBlocksTotal/dt << std::setw(12)
+        << nBytesTotal/dt/1048576.0 << std::setw(12) << diskBytes/1048576.0
+        << std::endl;
+    }
+
+  MPI_Finalize();
+
+  return testResult;
+}
@@ -0,0 +1,224 @@
+#include "VTKUtils.h"
+#include "VTKDataAdaptor.h"
+#include "MeshMetadata.h"
+#include "Error.h"
+
+#include <mpi.h>
+#include <vtkAMRBox.h>
+#include <vtkCellData.h>
+#include <vtkDataSetAttributes.h>
+#include <vtkOverlappingAMR.h>
+#include <vtkUniformGrid.h>
+#include <vtkUnsignedCharArray.h>
+#include <array>
+#include <cstring>
+#include <vector>
+#include <iostream>
+
+// Builds a two level AMR mesh and checks the REFINEDCELL bits set by
+// VTKUtils::AddAMRBlanking and by the default
+// DataAdaptor::AddGhostCellsArray against the cells known to be covered.
+//
+// level 0 has two 8 x 8 blocks side by side. level 1, refined by 2, has a
+// block that straddles them, covering coarse cells [6,9] x [1,2], and a
+// block covering coarse cells [0,1] x [6,7] of the first.
+
+// the cell extents of the blocks in level order
+const int nBlocks = 4;
+const int blockLevel[nBlocks] = {0, 0, 1, 1};
+const std::array<int,6> blockExt[nBlocks] = {
+  {{0, 7, 0, 7, 0, 0}}, {{8, 15, 0, 7, 0, 0}},
+  {{12, 19, 2, 5, 0, 0}}, {{0, 3, 12, 15, 0, 0}}};
+
+// the coarse cells covered by the fine blocks, in the coarse index space
+const std::array<int,6> covered[2] = {
+  {{6, 9, 1, 2, 0, 0}}, {{0, 1, 6, 7, 0, 0}}};
+
+vtkOverlappingAMR *newAMR(int ids)
+{
+  int blocksPerLevel[2] = {2, 2};
+
+  vtkOverlappingAMR *amr = vtkOverlappingAMR::New();
+  amr->Initialize(2, blocksPerLevel);
+
+  double x0[3] = {0.0, 0.0, 0.0};
+  amr->SetOrigin(x0);
+
+  for (int i = 0, lbid = 0; i < nBlocks; ++i, ++lbid)
+    {
+    int level = blockLevel[i];
+    if (i && (level != blockLevel[i-1]))
+      lbid = 0;
+
+    double dx[3] = {1.0/(level + 1), 1.0/(level + 1), 1.0};
+    amr->SetSpacing(level, dx);
+    amr->SetRefinementRatio(level, 2);
+
+    const std::array<int,6> &ext = blockExt[i];
+    int lo[3] = {ext[0], ext[2], ext[4]};
+    int hi[3] = {ext[1], ext[3], ext[5]};
+
+    vtkAMRBox box(lo, hi);
+    amr->SetAMRBox(level, lbid, box);
+
+    // ids that don't follow the level order
+    if (ids)
+      amr->SetAMRBlockSourceIndex(level, lbid, 10*(nBlocks - i));
+
+    int ptExt[6] = {ext[0], ext[1] + 1, ext[2], ext[3] + 1, 0, 1};
+
+    vtkUniformGrid *ug = vtkUniformGrid::New();
+    ug->SetOrigin(x0);
+    ug->SetSpacing(dx);
+    ug->SetExtent(ptExt);
+
+    amr->SetDataSet(level, lbid, ug);
+    ug->Delete();
+    }
+
+  return amr;
+}
+
+// compare the ghost array of each block with the covered cells. the bits
+// in preset are expected in addition to REFINEDCELL.
+int checkBlanking(vtkOverlappingAMR *amr, const char *method,
+  int presetBlock, int presetCell, unsigned char preset)
+{
+  int nErrors = 0;
+  for (int i = 0, lbid = 0; i < nBlocks; ++i, ++lbid)
+    {
+    int level = blockLevel[i];
+    if (i && (level != blockLevel[i-1]))
+      lbid = 0;
+
+    vtkUniformGrid *ug = amr->GetDataSet(level, lbid);
+
+    vtkUnsignedCharArray *ghosts = dynamic_cast<vtkUnsignedCharArray*>(
+      ug->GetCellData()->GetArray("vtkGhostType"));
+
+    if (!ghosts)
+      {
+      SENSEI_ERROR(<< method << " block " << i << " has no ghost array")
+      ++nErrors;
+      continue;
+      }
+
+    const std::array<int,6> &ext = blockExt[i];
+    int nx = ext[1] - ext[0] + 1;
+    int ny = ext[3] - ext[2] + 1;
+
+    for (int jj = 0; jj < ny; ++jj)
+      {
+      for (int ii = 0; ii < nx; ++ii)
+        {
+        int ci = ext[0] + ii;
+        int cj = ext[2] + jj;
+
+        // only the coarse level is covered
+        bool refined = false;
+        for (int q = 0; (level == 0) && (q < 2); ++q)
+          {
+          refined = refined || ((ci >= covered[q][0]) &&
+            (ci <= covered[q][1]) && (cj >= covered[q][2]) &&
+            (cj <= covered[q][3]));
+          }
+
+        int cid = jj*nx + ii;
+
+        unsigned char expected =
+          refined ? vtkDataSetAttributes::REFINEDCELL : 0;
+
+        if ((i == presetBlock) && (cid == presetCell))
+          expected |= preset;
+
+        unsigned char val = ghosts->GetValue(cid);
+        if (val != expected)
+          {
+          SENSEI_ERROR(<< method << " block " << i << " cell (" << ci << ", "
+            << cj << ") is " << int(val) << " expected " << int(expected))
+          ++nErrors;
+          }
+        }
+      }
+    }
+
+  return nErrors;
+}
+
+int main(int argc, char **argv)
+{
+  MPI_Init(&argc, &argv);
+
+  int testResult = 0;
+
+  // blank through VTKUtils using metadata with block ids
+  vtkOverlappingAMR *amr = newAMR(1);
+
+  sensei::MeshMetadataPtr md = sensei::MeshMetadata::New();
+  md->MeshName = "amr";
+  sensei::VTKUtils::GetAMRMetadata(amr, md);
+
+  md->BlockIds.resize(nBlocks);
+  for (int i = 0; i < nBlocks; ++i)
+    md->BlockIds[i] = 10*(nBlocks - i);
+
+  sensei::VTKUtils::AMRNestingIndex index;
+  if (sensei::VTKUtils::AddAMRBlanking(amr, md, index))
+    {
+    SENSEI_ERROR("AddAMRBlanking failed")
+    testResult = -1;
+    }
+  else if (checkBlanking(amr, "AddAMRBlanking", -1, -1, 0))
+    {
+    testResult = -1;
+    }
+
+  amr->Delete();
+
+  // blank through the default DataAdaptor::AddGhostCellsArray. a ghost
+  // array with a duplicate cell in a covered cell of the second block is
+  // present and must be kept
+  amr = newAMR(0);
+
+  vtkUniformGrid *ug = amr->GetDataSet(0, 1);
+  vtkUnsignedCharArray *ghosts = vtkUnsignedCharArray::New();
+  ghosts->SetName("vtkGhostType");
+  ghosts->SetNumberOfTuples(ug->GetNumberOfCells());
+  memset(ghosts->GetVoidPointer(0), 0, ug->GetNumberOfCells());
+  ghosts->SetValue(8 + 1, vtkDataSetAttributes::DUPLICATECELL);
+  ug->GetCellData()->AddArray(ghosts);
+  ghosts->Delete();
+
+  sensei::VTKDataAdaptor *da = sensei::VTKDataAdaptor::New();
+  da->SetDataObject("amr", amr);
+
+  if (da->AddGhostCellsArray(amr, "amr"))
+    {
+    SENSEI_ERROR("AddGhostCellsArray failed")
+    testResult = -1;
+    }
+  else if (checkBlanking(amr, "AddGhostCellsArray", 1, 8 + 1,
+    vtkDataSetAttributes::DUPLICATECELL))
+    {
+    testResult = -1;
+    }
+
+  // a second call must not change the bits
+  if (!testResult && (da->AddGhostCellsArray(amr, "amr") ||
+    checkBlanking(amr, "AddGhostCellsArray again", 1, 8 + 1,
+    vtkDataSetAttributes::DUPLICATECELL)))
+    {
+    testResult = -1;
+    }
+
+  da->ReleaseData();
+  da->Delete();
+  amr->Delete();
+
+  std::cerr << "AMR blanking " << (testResult ? "failed" : "passed")
+    << std::endl;
+
+  MPI_Finalize();
+
+  return testResult;
+}
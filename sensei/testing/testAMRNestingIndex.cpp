@@ -0,0 +1,143 @@
+#include "VTKUtils.h"
+#include "MeshMetadata.h"
+#include "Error.h"
+
+#include <mpi.h>
+#include <array>
+#include <vector>
+#include <iostream>
+#include <cstdlib>
+
+// Builds a random AMR hierarchy and checks the parent, child, and overlap
+// queries of VTKUtils::AMRNestingIndex against a search over all blocks.
+//
+// usage: testAMRNestingIndex [blocks per side] [levels] [refinement ratio]
+
+// generate the blocks of the next level by refining a random subset of the
+// blocks of the current level into rr x rr x 1 patches
+void refineLevel(const sensei::MeshMetadataPtr &md, int level, int rr,
+  unsigned int &seed)
+{
+  std::array<int,3> ratio{{rr, rr, 1}};
+  int nBlocks = md->NumBlocks;
+  for (int i = 0; i < nBlocks; ++i)
+    {
+    if ((md->BlockLevel[i] != level) || (rand_r(&seed) % 3))
+      continue;
+
+    std::array<int,6> ext =
+      sensei::VTKUtils::AMRNestingIndex::Refine(md->BlockExtents[i], ratio);
+
+    int nx = (ext[1] - ext[0] + 1)/rr;
+    int ny = (ext[3] - ext[2] + 1)/rr;
+    for (int q = 0; q < rr; ++q)
+      {
+      for (int p = 0; p < rr; ++p)
+        {
+        md->BlockExtents.push_back({{ext[0] + p*nx, ext[0] + (p + 1)*nx - 1,
+          ext[2] + q*ny, ext[2] + (q + 1)*ny - 1, ext[4], ext[5]}});
+        md->BlockLevel.push_back(level + 1);
+        md->NumBlocks += 1;
+        }
+      }
+    }
+}
+
+// the blocks on a level that overlap the extent, by testing each block
+void searchAll(const sensei::MeshMetadataPtr &md, int level,
+  const std::array<int,6> &ext, std::vector<int> &bids)
+{
+  for (int i = 0; i < md->NumBlocks; ++i)
+    {
+    if ((md->BlockLevel[i] == level) &&
+      sensei::VTKUtils::AMRNestingIndex::Overlaps(md->BlockExtents[i], ext))
+      bids.push_back(i);
+    }
+}
+
+int main(int argc, char **argv)
+{
+  MPI_Init(&argc, &argv);
+
+  int nSide = argc > 1 ? atoi(argv[1]) : 16;
+  int nLevels = argc > 2 ? atoi(argv[2]) : 4;
+  int rr = argc > 3 ? atoi(argv[3]) : 2;
+
+  // a 2D hierarchy, the coarse level covers the domain with nSide x nSide
+  // blocks of 8 x 8 cells
+  sensei::MeshMetadataPtr md = sensei::MeshMetadata::New();
+  md->MeshName = "amr";
+  md->NumLevels = nLevels;
+  md->NumBlocks = 0;
+  md->RefRatio.resize(nLevels, {{rr, rr, 1}});
+
+  for (int j = 0; j < nSide; ++j)
+    {
+    for (int i = 0; i < nSide; ++i)
+      {
+      md->BlockExtents.push_back({{8*i, 8*i + 7, 8*j, 8*j + 7, 0, 0}});
+      md->BlockLevel.push_back(0);
+      md->NumBlocks += 1;
+      }
+    }
+
+  unsigned int seed = 1;
+  for (int i = 0; i < nLevels - 1; ++i)
+    refineLevel(md, i, rr, seed);
+
+  sensei::VTKUtils::AMRNestingIndex index;
+  if (index.Update(md))
+    {
+    SENSEI_ERROR("Failed to build the index")
+    return -1;
+    }
+
+  int testResult = 0;
+  for (int i = 0; (i < md->NumBlocks) && !testResult; ++i)
+    {
+    int level = md->BlockLevel[i];
+    std::array<int,3> ratio{{rr, rr, 1}};
+
+    std::vector<int> children, children0;
+    index.GetChildren(i, children);
+    if (level + 1 < nLevels)
+      searchAll(md, level + 1, sensei::VTKUtils::AMRNestingIndex::Refine(
+        md->BlockExtents[i], ratio), children0);
+
+    std::vector<int> parents, parents0;
+    index.GetParents(i, parents);
+    if (level > 0)
+      searchAll(md, level - 1, sensei::VTKUtils::AMRNestingIndex::Coarsen(
+        md->BlockExtents[i], ratio), parents0);
+
+    // the patches are properly nested
+    if ((children != children0) || (parents != parents0) ||
+      ((level > 0) && (parents.size() != 1)))
+      {
+      SENSEI_ERROR("Block " << i << " on level " << level << " has "
+        << children.size() << " children and " << parents.size()
+        << " parents, expected " << children0.size() << " and "
+        << parents0.size())
+      testResult = -1;
+      }
+    }
+
+  // a query that spans many blocks of the coarse level
+  std::array<int,6> ext{{3, 8*nSide/2, 5, 8*nSide/3, 0, 0}};
+  std::vector<int> bids, bids0;
+  index.GetOverlapping(0, ext, bids);
+  searchAll(md, 0, ext, bids0);
+  if (bids != bids0)
+    {
+    SENSEI_ERROR("Found " << bids.size() << " overlapping blocks, expected "
+      << bids0.size())
+    testResult = -1;
+    }
+
+  std::cerr << md->NumBlocks << " blocks on " << nLevels << " levels "
+    << (testResult ? "failed" : "passed") << std::endl;
+
+  MPI_Finalize();
+
+  return testResult;
+}
@@ -0,0 +1,322 @@
+#include "ConfigurableAnalysis.h"
+#include "ConfigurableInTransitDataAdaptor.h"
+#include "VTKDataAdaptor.h"
+#include "Error.h"
+
+#include <mpi.h>
+#include <vtkImageData.h>
+#include <vtkMultiBlockDataSet.h>
+#include <vtkCompositeDataIterator.h>
+#include <vtkDoubleArray.h>
+#include <vtkFloatArray.h>
+#include <vtkDataArray.h>
+#include <vtkPointData.h>
+#include <vtkCellData.h>
+#include <vtkDataObject.h>
+#include <vtkSmartPointer.h>
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <string>
+
+// Writes a mesh through a transport configured by an XML file whose
+// <compress> elements compress two of its arrays, then reads it back through
+// the transport's data adaptor and checks the values against the error
+// bounds. The bounds must match the XML:
+//
+//   pdata, point, double, absolute bound 1e-3
+//   cdata, cell, float, bound 1e-4 relative to the range of each block
+//   xdata, point, double, not compressed, read back exactly
+
+const double pointBound = 1e-3;
+const double cellBound = 1e-4;
+const int nSteps = 2;
+
+// a smooth function of the global index and time
+double field(int i, int j, int k, double t)
+{
+  return std::sin(0.3*i + t)*std::cos(0.2*j) + 0.1*k;
+}
+
+// a multiblock with one n x n x n image per rank, neighbors share a layer of
+// points
+vtkMultiBlockDataSet *newMultiBlock(int rank, int nRanks, int n, double t)
+{
+  vtkImageData *im = vtkImageData::New();
+  im->SetExtent(rank*(n - 1), (rank + 1)*(n - 1), 0, n - 1, 0, n - 1);
+
+  int ext[6] = {0};
+  im->GetExtent(ext);
+
+  vtkDoubleArray *pd = vtkDoubleArray::New();
+  pd->SetName("pdata");
+  pd->SetNumberOfTuples(n*n*n);
+
+  vtkDoubleArray *xd = vtkDoubleArray::New();
+  xd->SetName("xdata");
+  xd->SetNumberOfTuples(n*n*n);
+
+  for (int k = ext[4], q = 0; k <= ext[5]; ++k)
+    for (int j = ext[2]; j <= ext[3]; ++j)
+      for (int i = ext[0]; i <= ext[1]; ++i, ++q)
+        {
+        pd->SetValue(q, field(i, j, k, t));
+        xd->SetValue(q, field(i, j, k, t) + 1.0);
+        }
+
+  im->GetPointData()->AddArray(pd);
+  im->GetPointData()->AddArray(xd);
+  pd->Delete();
+  xd->Delete();
+
+  vtkFloatArray *cd = vtkFloatArray::New();
+  cd->SetName("cdata");
+  cd->SetNumberOfTuples((n - 1)*(n - 1)*(n - 1));
+  for (int k = ext[4], q = 0; k < ext[5]; ++k)
+    for (int j = ext[2]; j < ext[3]; ++j)
+      for (int i = ext[0]; i < ext[1]; ++i, ++q)
+        cd->SetValue(q, field(i, j, k, t));
+  im->GetCellData()->AddArray(cd);
+  cd->Delete();
+
+  vtkMultiBlockDataSet *mb = vtkMultiBlockDataSet::New();
+  mb->SetNumberOfBlocks(nRanks);
+  mb->SetBlock(rank, im);
+  im->Delete();
+
+  return mb;
+}
+
+int writeSteps(const std::string &xml, int rank, int nRanks, int n)
+{
+  vtkSmartPointer<sensei::ConfigurableAnalysis> ca =
+    vtkSmartPointer<sensei::ConfigurableAnalysis>::New();
+
+  if (ca->Initialize(xml))
+    {
+    SENSEI_ERROR("Failed to initialize the writer from \"" << xml << "\"")
+    return -1;
+    }
+
+  int ierr = 0;
+  for (int step = 0; (step < nSteps) && !ierr; ++step)
+    {
+    double t = 0.5*step;
+
+    vtkMultiBlockDataSet *mb = newMultiBlock(rank, nRanks, n, t);
+
+    sensei::VTKDataAdaptor *vda = sensei::VTKDataAdaptor::New();
+    vda->SetDataTime(t);
+    vda->SetDataTimeStep(step);
+    vda->SetDataObject("mesh", mb);
+    mb->Delete();
+
+    if (!ca->Execute(vda))
+      {
+      SENSEI_ERROR("Failed to write step " << step)
+      ierr = -1;
+      }
+
+    vda->ReleaseData();
+    vda->Delete();
+    }
+
+  ca->Finalize();
+
+  return ierr;
+}
+
+// checks the arrays of a block read back, and updates the largest
+// difference of each compressed array in units of its bound
+int checkBlock(vtkImageData *im, double t, double &pDiff, double &cDiff)
+{
+  vtkDataArray *pd = im->GetPointData()->GetArray("pdata");
+  vtkDataArray *xd = im->GetPointData()->GetArray("xdata");
+  vtkDataArray *cd = im->GetCellData()->GetArray("cdata");
+  if (!pd || !xd || !cd)
+    {
+    SENSEI_ERROR("A block is missing data")
+    return -1;
+    }
+
+  int ext[6] = {0};
+  im->GetExtent(ext);
+
+  long q = 0;
+  for (int k = ext[4]; k <= ext[5]; ++k)
+    for (int j = ext[2]; j <= ext[3]; ++j)
+      for (int i = ext[0]; i <= ext[1]; ++i, ++q)
+        {
+        double f = field(i, j, k, t);
+        double d = std::fabs(pd->GetTuple1(q) - f);
+        if (d > pointBound)
+          {
+          SENSEI_ERROR("pdata at " << i << ", " << j << ", " << k << " is "
+            << pd->GetTuple1(q) << " expected " << f << " within "
+            << pointBound)
+          return -1;
+          }
+        pDiff = std::max(pDiff, d/pointBound);
+
+        if (xd->GetTuple1(q) != f + 1.0)
+          {
+          SENSEI_ERROR("xdata at " << i << ", " << j << ", " << k << " is "
+            << xd->GetTuple1(q) << " expected " << f + 1.0)
+          return -1;
+          }
+        }
+
+  // the bound is relative to the range of the block's values as written
+  float lo = field(ext[0], ext[2], ext[4], t);
+  float hi = lo;
+  for (int k = ext[4]; k < ext[5]; ++k)
+    for (int j = ext[2]; j < ext[3]; ++j)
+      for (int i = ext[0]; i < ext[1]; ++i)
+        {
+        float f = field(i, j, k, t);
+        lo = std::min(lo, f);
+        hi = std::max(hi, f);
+        }
+
+  double eb = cellBound*(double(hi) - double(lo));
+
+  q = 0;
+  for (int k = ext[4]; k < ext[5]; ++k)
+    for (int j = ext[2]; j < ext[3]; ++j)
+      for (int i = ext[0]; i < ext[1]; ++i, ++q)
+        {
+        float f = field(i, j, k, t);
+        double d = std::fabs(cd->GetTuple1(q) - double(f));
+        if (d > eb)
+          {
+          SENSEI_ERROR("cdata at " << i << ", " << j << ", " << k << " is "
+            << cd->GetTuple1(q) << " expected " << f << " within " << eb)
+          return -1;
+          }
+        cDiff = std::max(cDiff, d/eb);
+        }
+
+  return 0;
+}
+
+int readSteps(const std::string &xml, int rank)
+{
+  vtkSmartPointer<sensei::ConfigurableInTransitDataAdaptor> da =
+    vtkSmartPointer<sensei::ConfigurableInTransitDataAdaptor>::New();
+
+  if (da->Initialize(xml) || da->OpenStream())
+    {
+    SENSEI_ERROR("Failed to open the stream configured by \"" << xml << "\"")
+    return -1;
+    }
+
+  int ierr = 0;
+  int nRead = 0;
+  double pDiff = 0.0;
+  double cDiff = 0.0;
+  do
+    {
+    double t = da->GetDataTime();
+
+    vtkDataObject *mesh = nullptr;
+    if (da->GetMesh("mesh", false, mesh) ||
+      da->AddArray(mesh, "mesh", vtkDataObject::POINT, "pdata") ||
+      da->AddArray(mesh, "mesh", vtkDataObject::POINT, "xdata") ||
+      da->AddArray(mesh, "mesh", vtkDataObject::CELL, "cdata"))
+      {
+      SENSEI_ERROR("Failed to read step " << nRead)
+      ierr = -1;
+      }
+
+    vtkMultiBlockDataSet *mb = dynamic_cast<vtkMultiBlockDataSet*>(mesh);
+    if (!ierr && mb)
+      {
+      vtkCompositeDataIterator *it = mb->NewIterator();
+      it->InitTraversal();
+      for (; !it->IsDoneWithTraversal() && !ierr; it->GoToNextItem())
+        {
+        vtkImageData *im =
+          dynamic_cast<vtkImageData*>(it->GetCurrentDataObject());
+        if (!im || checkBlock(im, t, pDiff, cDiff))
+          ierr = -1;
+        }
+      it->Delete();
+      }
+    else if (!ierr)
+      {
+      SENSEI_ERROR("The mesh read back is not a multiblock")
+      ierr = -1;
+      }
+
+    if (mesh)
+      mesh->Delete();
+
+    da->ReleaseData();
+    ++nRead;
+    }
+  while (!ierr && !da->AdvanceStream());
+
+  da->CloseStream();
+  da->Finalize();
+
+  if (!ierr && (nRead != nSteps))
+    {
+    SENSEI_ERROR("Read " << nRead << " steps, expected " << nSteps)
+    ierr = -1;
+    }
+
+  // the compressed arrays are lossy, a difference of zero everywhere
+  // means that they were not compressed
+  MPI_Allreduce(MPI_IN_PLACE, &pDiff, 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+  MPI_Allreduce(MPI_IN_PLACE, &cDiff, 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+
+  if (!ierr && ((pDiff == 0.0) || (cDiff == 0.0)))
+    {
+    SENSEI_ERROR("The arrays were not compressed")
+    ierr = -1;
+    }
+
+  if (rank == 0)
+    std::cerr << "largest difference in units of the bound pdata "
+      << pDiff << " cdata " << cDiff << std::endl;
+
+  return ierr;
+}
+
+int main(int argc, char **argv)
+{
+  MPI_Init(&argc, &argv);
+
+  int rank = 0;
+  int nRanks = 1;
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &nRanks);
+
+  if (argc != 3)
+    {
+    if (rank == 0)
+      std::cerr << "usage: testCompressedIO [writer xml] [reader xml]"
+        << std::endl;
+    MPI_Finalize();
+    return -1;
+    }
+
+  int n = 17;
+
+  int testResult = writeSteps(argv[1], rank, nRanks, n);
+
+  MPI_Allreduce(MPI_IN_PLACE, &testResult, 1, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
+
+  if (!testResult)
+    testResult = readSteps(argv[2], rank);
+
+  MPI_Allreduce(MPI_IN_PLACE, &testResult, 1, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
+
+  if (rank == 0)
+    std::cerr << "compressed IO " << (testResult ? "failed" : "passed")
+      << std::endl;
+
+  MPI_Finalize();
+
+  return testResult;
+}
@@ -0,0 +1,278 @@
+#include "ProgrammableDataAdaptor.h"
+#include "ConfigurableAnalysis.h"
+#include "CachingDataAdaptor.h"
+#include "MeshMetadata.h"
+#include "Error.h"
+
+#include <vtkMultiBlockDataSet.h>
+#include <vtkImageData.h>
+#include <vtkCellData.h>
+#include <vtkDoubleArray.h>
+#include <vtkFloatArray.h>
+#include <vtkDataObject.h>
+
+#include <iostream>
+
+using std::cerr;
+using std::endl;
+
+// x - y mesh size, the mesh gets one
+// layer in z for each rank
+int gnx = 16;
+int gny = 16;
+
+// the number of times the simulation was asked for metadata,
+// meshes and arrays
+int gNumMetadataCalls = 0;
+int gNumMeshCalls = 0;
+int gNumGeometryCalls = 0;
+int gNumArrayCalls = 0;
+int gNumFloatArrayCalls = 0;
+
+// the number of times the array read by the analysis
+// that is scheduled every other step was requested
+int gNumScheduledArrayCalls = 0;
+
+// data adaptor
+int getNumMeshes(unsigned int &n)
+{
+    n = 1;
+    return 0;
+}
+
+int getMeshMetadata(unsigned int i, sensei::MeshMetadataPtr &mdp)
+{
+  if (i != 0)
+    return -1;
+
+  gNumMetadataCalls += 1;
+
+  int rank = 0;
+  int nRanks = 1;
+
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &nRanks);
+
+  mdp->MeshName = "mesh";
+  mdp->MeshType = VTK_MULTIBLOCK_DATA_SET;
+  mdp->BlockType = VTK_IMAGE_DATA;
+  mdp->NumBlocks = nRanks;
+  mdp->NumBlocksLocal = {1};
+  mdp->NumArrays = 3;
+
+  mdp->ArrayName = {"values", "scheduled", "floats"};
+  mdp->ArrayCentering = {vtkDataObject::CELL, vtkDataObject::CELL,
+    vtkDataObject::CELL};
+  mdp->ArrayComponents = {1, 1, 1};
+  mdp->ArrayType = {VTK_DOUBLE, VTK_DOUBLE, VTK_FLOAT};
+
+  return 0;
+}
+
+int getMesh(const std::string &meshName, bool structureOnly,
+  vtkDataObject *&mesh)
+{
+  if (meshName == "mesh")
+    {
+    gNumMeshCalls += 1;
+    gNumGeometryCalls += structureOnly ? 0 : 1;
+
+    int rank = 0;
+    int nRanks = 1;
+
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &nRanks);
+
+    int ext[] = {0, gnx, 0, gny, rank, rank+1};
+
+    vtkImageData *im = vtkImageData::New();
+    im->SetExtent(ext);
+
+    vtkMultiBlockDataSet *mb = vtkMultiBlockDataSet::New();
+    mb->SetNumberOfBlocks(nRanks);
+    mb->SetBlock(rank, im);
+    im->Delete();
+
+    mesh = mb;
+
+    return 0;
+    }
+  return -1;
+}
+
+int addArray(vtkDataObject *mesh, const std::string &meshName,
+  int assoc, const std::string &name)
+{
+  if ((meshName == "mesh") && (assoc == vtkDataObject::CELL) &&
+    ((name == "values") || (name == "scheduled") || (name == "floats")))
+    {
+    if (name == "values")
+      gNumArrayCalls += 1;
+    else if (name == "scheduled")
+      gNumScheduledArrayCalls += 1;
+    else
+      gNumFloatArrayCalls += 1;
+
+    int rank = 0;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+    vtkMultiBlockDataSet *mb = dynamic_cast<vtkMultiBlockDataSet*>(mesh);
+    if (!mb)
+      return -1;
+
+    vtkImageData *ds = dynamic_cast<vtkImageData*>(mb->GetBlock(rank));
+    if (!ds)
+      return -1;
+
+    long nVals = gnx*gny;
+
+    // the autocorrelation reads float arrays
+    vtkDataArray *da = nullptr;
+    if (name == "floats")
+      da = vtkFloatArray::New();
+    else
+      da = vtkDoubleArray::New();
+
+    da->SetName(name.c_str());
+    da->SetNumberOfTuples(nVals);
+
+    for (long i = 0; i < nVals; ++i)
+      da->SetTuple1(i, i % gnx);
+
+    ds->GetCellData()->AddArray(da);
+    da->Delete();
+
+    return 0;
+    }
+  return -1;
+}
+
+int releaseData()
+{
+  return 0;
+}
+
+
+
+int main(int argc, char **argv)
+{
+  // concurrent startup makes use of MPI_THREAD_MULTIPLE when
+  // it is available and falls back to serial otherwise
+  int provided = 0;
+  MPI_Init_thread(&argc, &argv, MPI_THREAD_MULTIPLE, &provided);
+
+  if (argc != 2)
+    {
+    SENSEI_ERROR("need an xml config on the command line")
+    MPI_Abort(MPI_COMM_WORLD, -1);
+    return -1;
+    }
+
+  sensei::ProgrammableDataAdaptor *da = sensei::ProgrammableDataAdaptor::New();
+  da->SetGetNumberOfMeshesCallback(getNumMeshes);
+  da->SetGetMeshMetadataCallback(getMeshMetadata);
+  da->SetGetMeshCallback(getMesh);
+  da->SetAddArrayCallback(addArray);
+  da->SetReleaseDataCallback(releaseData);
+
+  sensei::ConfigurableAnalysis *aa = sensei::ConfigurableAnalysis::New();
+  if (aa->Initialize(argv[1]))
+    {
+    SENSEI_ERROR("Failed to intialize the analysis")
+    MPI_Abort(MPI_COMM_WORLD, -1);
+    return -1;
+    }
+
+  int nSteps = 3;
+  for (int i = 0; i < nSteps; ++i)
+    {
+    da->SetDataTimeStep(i);
+    da->SetDataTime(i);
+    aa->Execute(da);
+    da->ReleaseData();
+    }
+
+  aa->Finalize();
+
+  aa->Delete();
+
+  // with the plan cached all of the analyses share a
+  // single metadata query per time step
+  int retVal = 0;
+  if (gNumMetadataCalls != nSteps)
+    {
+    SENSEI_ERROR("Metadata was requested " << gNumMetadataCalls
+      << " times in " << nSteps << " steps, expected " << nSteps)
+    retVal = -1;
+    }
+
+  // with data shared the mesh and array are fetched once per time
+  // step. the autocorrelation reads the geometry, it is fetched up
+  // front with the mesh rather than in a second request
+  if ((gNumMeshCalls != nSteps) || (gNumGeometryCalls != nSteps) ||
+    (gNumArrayCalls != nSteps) || (gNumFloatArrayCalls != nSteps))
+    {
+    SENSEI_ERROR("The mesh was requested " << gNumMeshCalls
+      << " times, " << gNumGeometryCalls << " with geometry, and the arrays "
+      << gNumArrayCalls << " and " << gNumFloatArrayCalls << " times in "
+      << nSteps << " steps, expected " << nSteps)
+    retVal = -1;
+    }
+
+  // the scheduled analysis runs in steps 0 and 2
+  if (gNumScheduledArrayCalls != 2)
+    {
+    SENSEI_ERROR("The scheduled array was requested "
+      << gNumScheduledArrayCalls << " times, expected 2")
+    retVal = -1;
+    }
+
+  // a consumer that asks for the structure only is given the same
+  // structure whether or not another consumer asked for the geometry first
+  int rank = 0;
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+  sensei::CachingDataAdaptor *cda = sensei::CachingDataAdaptor::New();
+  cda->SetShareData(1);
+
+  int nCells[4] = {0};
+  for (int i = 0; i < 2; ++i)
+    {
+    cda->SetDataAdaptor(da);
+
+    vtkDataObject *m[2] = {nullptr, nullptr};
+    cda->GetMesh("mesh", i == 0, m[0]);
+    cda->GetMesh("mesh", i != 0, m[1]);
+
+    for (int j = 0; j < 2; ++j)
+      {
+      vtkMultiBlockDataSet *mb = dynamic_cast<vtkMultiBlockDataSet*>(m[j]);
+      vtkImageData *im = mb ?
+        dynamic_cast<vtkImageData*>(mb->GetBlock(rank)) : nullptr;
+      nCells[2*i + j] = im ? im->GetNumberOfCells() : -1;
+      if (m[j])
+        m[j]->Delete();
+      }
+
+    cda->ReleaseData();
+    da->ReleaseData();
+    }
+
+  cda->Delete();
+
+  for (int i = 0; i < 4; ++i)
+    {
+    if (nCells[i] != gnx*gny)
+      {
+      SENSEI_ERROR("Shared mesh " << i << " has " << nCells[i]
+        << " cells, expected " << gnx*gny)
+      retVal = -1;
+      }
+    }
+
+  da->Delete();
+
+  MPI_Finalize();
+
+  return retVal;
+}
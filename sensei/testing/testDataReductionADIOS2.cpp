@@ -0,0 +1,257 @@
+#include "DataReduction.h"
+#include "ADIOS2AnalysisAdaptor.h"
+#include "ADIOS2DataAdaptor.h"
+#include "VTKDataAdaptor.h"
+#include "MeshMetadata.h"
+#include "Error.h"
+
+#include <mpi.h>
+#include <vtkImageData.h>
+#include <vtkMultiBlockDataSet.h>
+#include <vtkCompositeDataIterator.h>
+#include <vtkDoubleArray.h>
+#include <vtkDataArray.h>
+#include <vtkPointData.h>
+#include <vtkCellData.h>
+#include <vtkDataObject.h>
+#include <vtkSmartPointer.h>
+#include <iostream>
+#include <string>
+
+// Writes a mesh through the ADIOS2 transport behind a DataReduction whose
+// region of interest lies inside the first rank's block, then reads it back.
+// The blocks of the other ranks are written empty and must read back with
+// no points and no tuples. The values inside the region must be unchanged.
+
+// a multiblock with one n x n x n image per rank, neighbors share a layer of
+// points. the arrays hold a function of the global index
+vtkMultiBlockDataSet *newMultiBlock(int rank, int nRanks, int n)
+{
+  vtkImageData *im = vtkImageData::New();
+  im->SetExtent(rank*(n - 1), (rank + 1)*(n - 1), 0, n - 1, 0, n - 1);
+
+  vtkDoubleArray *pd = vtkDoubleArray::New();
+  pd->SetName("pdata");
+  pd->SetNumberOfTuples(n*n*n);
+  for (int k = 0, q = 0; k < n; ++k)
+    for (int j = 0; j < n; ++j)
+      for (int i = 0; i < n; ++i, ++q)
+        pd->SetValue(q, rank*(n - 1) + i + 100*j + 10000*k);
+  im->GetPointData()->AddArray(pd);
+  pd->Delete();
+
+  vtkDoubleArray *cd = vtkDoubleArray::New();
+  cd->SetName("cdata");
+  cd->SetNumberOfTuples((n - 1)*(n - 1)*(n - 1));
+  for (int k = 0, q = 0; k < n - 1; ++k)
+    for (int j = 0; j < n - 1; ++j)
+      for (int i = 0; i < n - 1; ++i, ++q)
+        cd->SetValue(q, rank*(n - 1) + i + 100*j + 10000*k);
+  im->GetCellData()->AddArray(cd);
+  cd->Delete();
+
+  vtkMultiBlockDataSet *mb = vtkMultiBlockDataSet::New();
+  mb->SetNumberOfBlocks(nRanks);
+  mb->SetBlock(rank, im);
+  im->Delete();
+
+  return mb;
+}
+
+// compares the values of an array read back with the function of the
+// global index over the given extent
+int checkValues(vtkDataArray *da, const int *ext, const char *name)
+{
+  long q = 0;
+  for (int k = ext[4]; k <= ext[5]; ++k)
+    for (int j = ext[2]; j <= ext[3]; ++j)
+      for (int i = ext[0]; i <= ext[1]; ++i, ++q)
+        if (da->GetTuple1(q) != i + 100*j + 10000*k)
+          {
+          SENSEI_ERROR(<< name << " at " << i << ", " << j << ", " << k
+            << " is " << da->GetTuple1(q))
+          return -1;
+          }
+  return 0;
+}
+
+int writeReduced(const std::string &fileName, int rank, int nRanks, int n)
+{
+  sensei::VTKDataAdaptor *vda = sensei::VTKDataAdaptor::New();
+  vtkMultiBlockDataSet *src = newMultiBlock(rank, nRanks, n);
+  vda->SetDataObject("mesh", src);
+  src->Delete();
+
+  vtkSmartPointer<sensei::ADIOS2AnalysisAdaptor> aw =
+    vtkSmartPointer<sensei::ADIOS2AnalysisAdaptor>::New();
+  aw->SetFileName(fileName);
+  aw->SetEngineName("BP4");
+
+  // a region inside the first block, the others are written empty
+  sensei::DataReduction *dr = sensei::DataReduction::New();
+  dr->SetAnalysis(aw);
+  dr->SetRegion({{1, 4, 0, n - 1, 0, n - 1}});
+
+  int ierr = 0;
+  if (!dr->Execute(vda))
+    {
+    SENSEI_ERROR("Failed to write the reduced mesh")
+    ierr = -1;
+    }
+
+  dr->Finalize();
+  dr->Delete();
+
+  vda->ReleaseData();
+  vda->Delete();
+
+  return ierr;
+}
+
+int readReduced(const std::string &fileName, int nRanks, int n)
+{
+  sensei::ADIOS2DataAdaptor *da = sensei::ADIOS2DataAdaptor::New();
+  da->SetFileName(fileName);
+  da->SetReadEngine("BP4");
+
+  if (da->OpenStream())
+    {
+    SENSEI_ERROR("Failed to open \"" << fileName << "\"")
+    da->Delete();
+    return -1;
+    }
+
+  int ierr = 0;
+
+  // every block keeps its place in the metadata, those outside of the
+  // region have no points
+  sensei::MeshMetadataPtr md = sensei::MeshMetadata::New();
+  md->Flags.SetBlockDecomp();
+  md->Flags.SetBlockSize();
+  if (da->GetMeshMetadata(0, md) || (md->NumBlocks != nRanks) ||
+    (md->BlockNumPoints.size() != (unsigned int)nRanks))
+    {
+    SENSEI_ERROR("The metadata read back is incorrect")
+    ierr = -1;
+    }
+  else
+    {
+    for (int j = 0; j < nRanks; ++j)
+      {
+      long nPts = j ? 0 : 4*n*n;
+      if (md->BlockNumPoints[j] != nPts)
+        {
+        SENSEI_ERROR("Block " << j << " has " << md->BlockNumPoints[j]
+          << " points, expected " << nPts)
+        ierr = -1;
+        }
+      }
+    }
+
+  vtkDataObject *mesh = nullptr;
+  if (!ierr && (da->GetMesh("mesh", false, mesh) ||
+    da->AddArray(mesh, "mesh", vtkDataObject::POINT, "pdata") ||
+    da->AddArray(mesh, "mesh", vtkDataObject::CELL, "cdata")))
+    {
+    SENSEI_ERROR("Failed to read the reduced mesh")
+    ierr = -1;
+    }
+
+  vtkMultiBlockDataSet *mb = dynamic_cast<vtkMultiBlockDataSet*>(mesh);
+  if (!ierr && !mb)
+    {
+    SENSEI_ERROR("The mesh read back is not a multiblock")
+    ierr = -1;
+    }
+
+  if (!ierr)
+    {
+    vtkCompositeDataIterator *it = mb->NewIterator();
+    it->InitTraversal();
+    for (; !it->IsDoneWithTraversal() && !ierr; it->GoToNextItem())
+      {
+      vtkImageData *im = dynamic_cast<vtkImageData*>(it->GetCurrentDataObject());
+      vtkDataArray *pd = im ? im->GetPointData()->GetArray("pdata") : nullptr;
+      vtkDataArray *cd = im ? im->GetCellData()->GetArray("cdata") : nullptr;
+      if (!pd || !cd)
+        {
+        SENSEI_ERROR("Block " << it->GetCurrentFlatIndex() - 1
+          << " is missing data")
+        ierr = -1;
+        break;
+        }
+
+      if (!im->GetNumberOfPoints())
+        {
+        if (pd->GetNumberOfTuples() || cd->GetNumberOfTuples())
+          {
+          SENSEI_ERROR("An empty block has " << pd->GetNumberOfTuples()
+            << " point and " << cd->GetNumberOfTuples() << " cell values")
+          ierr = -1;
+          }
+        continue;
+        }
+
+      int ext[6] = {0};
+      im->GetExtent(ext);
+
+      int cext[6] = {ext[0], ext[1] - 1, ext[2], ext[3] - 1,
+        ext[4], ext[5] - 1};
+
+      if ((ext[0] != 1) || (ext[1] != 4) || (ext[3] != n - 1) ||
+        (ext[5] != n - 1))
+        {
+        SENSEI_ERROR("The reduced block's extent is [" << ext[0] << ", "
+          << ext[1] << ", " << ext[2] << ", " << ext[3] << ", " << ext[4]
+          << ", " << ext[5] << "]")
+        ierr = -1;
+        }
+      else if (checkValues(pd, ext, "pdata") ||
+        checkValues(cd, cext, "cdata"))
+        {
+        ierr = -1;
+        }
+      }
+    it->Delete();
+    }
+
+  if (mesh)
+    mesh->Delete();
+
+  da->ReleaseData();
+  da->CloseStream();
+  da->Delete();
+
+  return ierr;
+}
+
+int main(int argc, char **argv)
+{
+  MPI_Init(&argc, &argv);
+
+  int rank = 0;
+  int nRanks = 1;
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &nRanks);
+
+  std::string fileName = argc > 1 ? argv[1] : "testDataReductionADIOS2.bp";
+
+  int n = 9;
+
+  int testResult = writeReduced(fileName, rank, nRanks, n);
+
+  MPI_Allreduce(MPI_IN_PLACE, &testResult, 1, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
+
+  if (!testResult)
+    testResult = readReduced(fileName, nRanks, n);
+
+  MPI_Allreduce(MPI_IN_PLACE, &testResult, 1, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
+
+  if (rank == 0)
+    std::cerr << "DataReduction ADIOS2 " << (testResult ? "failed" : "passed")
+      << std::endl;
+
+  MPI_Finalize();
+
+  return testResult;
+}
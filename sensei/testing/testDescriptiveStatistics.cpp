@@ -0,0 +1,314 @@
+#include "DescriptiveStatistics.h"
+#include "DataRequirements.h"
+#include "VTKDataAdaptor.h"
+#include "Error.h"
+
+#include <vtkCellData.h>
+#include <vtkDataObject.h>
+#include <vtkDoubleArray.h>
+#include <vtkFloatArray.h>
+#include <vtkImageData.h>
+#include <vtkIntArray.h>
+#include <vtkMultiBlockDataSet.h>
+#include <vtkPointData.h>
+#include <vtkUnsignedCharArray.h>
+
+#include <mpi.h>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+// each rank has 2 blocks of nx by ny cells. the first row of cells in each
+// block are ghost cells and hold values that would change the result if
+// they were not skipped.
+int gNx = 23;
+int gNy = 17;
+
+// make the block and its arrays, the values that are not ghosts are
+// appended to the lists. f is a float scalar, v is a double vector, both
+// cell centered, and p is an int point scalar.
+vtkImageData *newBlock(int rank, int block, std::vector<double> &f,
+  std::vector<double> *v, std::vector<double> &p)
+{
+  std::mt19937 gen(3*rank + block + 1);
+  std::lognormal_distribution<float> dist(0.5f*rank, 0.75f);
+
+  vtkImageData *im = vtkImageData::New();
+  im->SetDimensions(gNx + 1, gNy + 1, 2);
+  im->SetOrigin(0.0, 0.0, 2*rank + block);
+
+  long nCells = gNx*gNy;
+
+  vtkUnsignedCharArray *ghosts = vtkUnsignedCharArray::New();
+  ghosts->SetName("vtkGhostType");
+  ghosts->SetNumberOfTuples(nCells);
+
+  vtkFloatArray *fa = vtkFloatArray::New();
+  fa->SetName("f");
+  fa->SetNumberOfTuples(nCells);
+
+  vtkDoubleArray *va = vtkDoubleArray::New();
+  va->SetName("v");
+  va->SetNumberOfComponents(3);
+  va->SetNumberOfTuples(nCells);
+
+  for (long i = 0; i < nCells; ++i)
+    {
+    bool ghost = i < gNx;
+    ghosts->SetValue(i, ghost ? 1 : 0);
+
+    float fv = ghost ? 1.0e6f : dist(gen);
+    fa->SetValue(i, fv);
+
+    double vv[3] = {ghost ? -1.0e6 : double(i % 7), 0.5*rank - block,
+      ghost ? 1.0e6 : std::sin(0.1*i)};
+    va->SetTuple(i, vv);
+
+    if (!ghost)
+      {
+      f.push_back(fv);
+      for (int j = 0; j < 3; ++j)
+        v[j].push_back(vv[j]);
+      }
+    }
+
+  long nPoints = (gNx + 1)*(gNy + 1)*2;
+
+  vtkIntArray *pa = vtkIntArray::New();
+  pa->SetName("p");
+  pa->SetNumberOfTuples(nPoints);
+
+  for (long i = 0; i < nPoints; ++i)
+    {
+    int pv = (i + rank) % 13;
+    pa->SetValue(i, pv);
+    p.push_back(pv);
+    }
+
+  im->GetCellData()->AddArray(ghosts);
+  im->GetCellData()->AddArray(fa);
+  im->GetCellData()->AddArray(va);
+  im->GetPointData()->AddArray(pa);
+
+  ghosts->Delete();
+  fa->Delete();
+  va->Delete();
+  pa->Delete();
+
+  return im;
+}
+
+// compute the reference statistics of the values on all ranks, valid on
+// rank 0
+int validate(const std::string &name, const std::vector<double> &local,
+  const sensei::DescriptiveStatistics::Statistics &stats)
+{
+  int rank = 0;
+  int nRanks = 1;
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &nRanks);
+
+  int nLocal = local.size();
+  std::vector<int> counts(nRanks);
+  MPI_Gather(&nLocal, 1, MPI_INT, counts.data(), 1, MPI_INT, 0, MPI_COMM_WORLD);
+
+  std::vector<int> displ(nRanks, 0);
+  for (int i = 1; i < nRanks; ++i)
+    displ[i] = displ[i-1] + counts[i-1];
+
+  std::vector<double> all(rank == 0 ? displ[nRanks-1] + counts[nRanks-1] : 0);
+  MPI_Gatherv(local.data(), nLocal, MPI_DOUBLE, all.data(), counts.data(),
+    displ.data(), MPI_DOUBLE, 0, MPI_COMM_WORLD);
+
+  if (rank != 0)
+    return 0;
+
+  long double n = all.size();
+  long double sum = 0.0;
+  double vmin = all[0];
+  double vmax = all[0];
+  for (double val : all)
+    {
+    sum += val;
+    vmin = std::min(vmin, val);
+    vmax = std::max(vmax, val);
+    }
+
+  long double mean = sum/n;
+  long double m2 = 0.0;
+  long double m3 = 0.0;
+  long double m4 = 0.0;
+  for (double val : all)
+    {
+    long double d = val - mean;
+    m2 += d*d;
+    m3 += d*d*d;
+    m4 += d*d*d*d;
+    }
+
+  double var = m2/n;
+  double skew = m2 > 0.0 ? std::sqrt(n)*m3/std::pow(m2, 1.5L) : 0.0;
+  double kurt = m2 > 0.0 ? n*m4/(m2*m2) - 3.0 : 0.0;
+
+  auto differ = [](double a, double b)
+    {
+    return std::abs(a - b) > 1.0e-9*std::max(1.0, std::abs(b));
+    };
+
+  if ((stats.Count != all.size()) || differ(stats.Mean, mean) ||
+    differ(stats.Variance, var) || differ(stats.Skewness, skew) ||
+    differ(stats.Kurtosis, kurt) || (stats.Min != vmin) || (stats.Max != vmax))
+    {
+    SENSEI_ERROR(<< name << " count " << stats.Count << " mean " << stats.Mean
+      << " variance " << stats.Variance << " skewness " << stats.Skewness
+      << " kurtosis " << stats.Kurtosis << " min " << stats.Min
+      << " max " << stats.Max << ", expected count " << all.size()
+      << " mean " << double(mean) << " variance " << var << " skewness "
+      << skew << " kurtosis " << kurt << " min " << vmin << " max " << vmax)
+    return -1;
+    }
+
+  std::cerr << name << " count " << stats.Count << " mean " << stats.Mean
+    << " variance " << stats.Variance << " skewness " << stats.Skewness
+    << " kurtosis " << stats.Kurtosis << " min " << stats.Min << " max "
+    << stats.Max << std::endl;
+
+  return 0;
+}
+
+// check that the reported location of an extremum holds its value
+int validateLocation(const std::string &name, vtkMultiBlockDataSet *mb,
+  int rank, int association, int comp, double val, int valRank,
+  long block, long long index)
+{
+  if (valRank != rank)
+    return 0;
+
+  vtkImageData *im = dynamic_cast<vtkImageData*>(mb->GetBlock(2*rank + block));
+  vtkFieldData *atts = association == vtkDataObject::CELL ?
+    static_cast<vtkFieldData*>(im->GetCellData()) :
+    static_cast<vtkFieldData*>(im->GetPointData());
+
+  double locVal = atts->GetArray(name.c_str())->GetComponent(index, comp);
+  if (locVal != val)
+    {
+    SENSEI_ERROR("The extremum of " << name << " " << val
+      << " is not at block " << block << " index " << index
+      << " of rank " << rank << " where the value is " << locVal)
+    return -1;
+    }
+
+  return 0;
+}
+
+int main(int argc, char **argv)
+{
+  MPI_Init(&argc, &argv);
+
+  int rank = 0;
+  int nRanks = 1;
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &nRanks);
+
+  // the local values that are not ghosts
+  std::vector<double> f;
+  std::vector<double> v[3];
+  std::vector<double> p;
+
+  vtkMultiBlockDataSet *mb = vtkMultiBlockDataSet::New();
+  mb->SetNumberOfBlocks(2*nRanks);
+  for (int i = 0; i < 2; ++i)
+    {
+    vtkImageData *im = newBlock(rank, i, f, v, p);
+    mb->SetBlock(2*rank + i, im);
+    im->Delete();
+    }
+
+  sensei::VTKDataAdaptor *dataAdaptor = sensei::VTKDataAdaptor::New();
+  dataAdaptor->SetDataObject("mesh", mb);
+
+  sensei::DataRequirements reqs;
+  reqs.AddRequirement("mesh", vtkDataObject::CELL,
+    std::vector<std::string>({"f", "v"}));
+  reqs.AddRequirement("mesh", vtkDataObject::POINT, "p");
+
+  std::string logName = "testDescriptiveStatistics.csv";
+
+  sensei::DescriptiveStatistics *analysisAdaptor =
+    sensei::DescriptiveStatistics::New();
+
+  analysisAdaptor->SetDataRequirements(reqs);
+  analysisAdaptor->SetFileName(logName);
+
+  int nSteps = 2;
+  int testResult = 0;
+  for (int i = 0; i < nSteps; ++i)
+    {
+    dataAdaptor->SetDataTimeStep(i);
+    dataAdaptor->SetDataTime(0.5*i);
+
+    if (!analysisAdaptor->Execute(dataAdaptor))
+      {
+      SENSEI_ERROR("Failed to execute step " << i)
+      testResult = -1;
+      }
+    }
+
+  sensei::DescriptiveStatistics::Statistics stats;
+
+  const char *names[] = {"f", "v", "v", "v", "p"};
+  const int assocs[] = {vtkDataObject::CELL, vtkDataObject::CELL,
+    vtkDataObject::CELL, vtkDataObject::CELL, vtkDataObject::POINT};
+  const int comps[] = {0, 0, 1, 2, 0};
+  const std::vector<double> *vals[] = {&f, &v[0], &v[1], &v[2], &p};
+
+  for (int i = 0; i < 5; ++i)
+    {
+    if (analysisAdaptor->GetStatistics("mesh", assocs[i], names[i],
+      comps[i], stats))
+      {
+      testResult = -1;
+      continue;
+      }
+
+    std::string name = std::string(names[i]) + "[" + std::to_string(comps[i]) + "]";
+
+    if (validate(name, *vals[i], stats) ||
+      validateLocation(names[i], mb, rank, assocs[i], comps[i], stats.Min,
+        stats.MinRank, stats.MinBlock, stats.MinIndex) ||
+      validateLocation(names[i], mb, rank, assocs[i], comps[i], stats.Max,
+        stats.MaxRank, stats.MaxBlock, stats.MaxIndex))
+      testResult = -1;
+    }
+
+  analysisAdaptor->Finalize();
+  analysisAdaptor->Delete();
+  dataAdaptor->Delete();
+  mb->Delete();
+
+  // the log has a header and a row per component per step
+  if (rank == 0)
+    {
+    std::ifstream log(logName.c_str());
+    int nLines = 0;
+    std::string line;
+    while (std::getline(log, line))
+      ++nLines;
+
+    if (nLines != 1 + 5*nSteps)
+      {
+      SENSEI_ERROR("The log has " << nLines << " lines, expected "
+        << 1 + 5*nSteps)
+      testResult = -1;
+      }
+    }
+
+  MPI_Allreduce(MPI_IN_PLACE, &testResult, 1, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
+
+  MPI_Finalize();
+
+  return testResult;
+}
@@ -0,0 +1,205 @@
+#include "ErrorBoundedCompressor.h"
+#include "Error.h"
+
+#include <mpi.h>
+#include <vtkDataObject.h>
+#include <vtkType.h>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+
+using sensei::ErrorBoundedCompressor;
+
+// a smooth field on an n x n x n grid, the sum of two Gaussian bumps
+void newField(int n, std::vector<float> &f)
+{
+  f.resize(n*n*n);
+  for (int k = 0, q = 0; k < n; ++k)
+    for (int j = 0; j < n; ++j)
+      for (int i = 0; i < n; ++i, ++q)
+        {
+        double r0 = (i - 0.3*n)*(i - 0.3*n) + (j - 0.5*n)*(j - 0.5*n) +
+          (k - 0.4*n)*(k - 0.4*n);
+        double r1 = (i - 0.7*n)*(i - 0.7*n) + (j - 0.4*n)*(j - 0.4*n) +
+          (k - 0.6*n)*(k - 0.6*n);
+        f[q] = 10.0*std::exp(-r0/(0.02*n*n)) -
+          4.0*std::exp(-r1/(0.05*n*n)) + 1.0;
+        }
+}
+
+// compress and decompress, returning the largest error of the finite values.
+// values that are not finite must be reproduced exactly
+template <typename T>
+int roundTrip(int type, const std::vector<T> &vals, size_t nTuples,
+  unsigned int nComps, const size_t *dims, int mode, double bound,
+  double &maxErr, double &ratio)
+{
+  std::vector<unsigned char> frame;
+  if (ErrorBoundedCompressor::Encode(type, vals.data(), nTuples, nComps,
+    dims, mode, bound, frame))
+    return -1;
+
+  if (!ErrorBoundedCompressor::IsEncoded(frame.data(), frame.size()))
+    {
+    SENSEI_ERROR("The frame was not recognized")
+    return -1;
+    }
+
+  size_t nBytes = vals.size()*sizeof(T);
+  ratio = double(nBytes)/frame.size();
+
+  std::vector<T> decoded(vals.size());
+  if (ErrorBoundedCompressor::Decode(frame.data(), frame.size(),
+    decoded.data(), nBytes))
+    return -1;
+
+  maxErr = 0.0;
+  for (size_t i = 0; i < vals.size(); ++i)
+    {
+    if (std::isfinite(double(vals[i])))
+      {
+      maxErr = std::max(maxErr, std::fabs(double(decoded[i]) - double(vals[i])));
+      }
+    else if (memcmp(&decoded[i], &vals[i], sizeof(T)))
+      {
+      SENSEI_ERROR("Value " << i << " was not reproduced")
+      return -1;
+      }
+    }
+
+  return 0;
+}
+
+int main(int argc, char **argv)
+{
+  MPI_Init(&argc, &argv);
+
+  int rank = 0;
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+  int testResult = 0;
+
+  int n = 32;
+  std::vector<float> f;
+  newField(n, f);
+
+  float lo = f[0];
+  float hi = f[0];
+  for (float v : f)
+    {
+    lo = std::min(lo, v);
+    hi = std::max(hi, v);
+    }
+
+  // relative bounds, with and without the structure of the grid
+  size_t dims[3] = {size_t(n), size_t(n), size_t(n)};
+  double bounds[] = {1e-2, 1e-3, 1e-4, 1e-5};
+  for (int b = 0; b < 4; ++b)
+    {
+    for (int s = 0; s < 2; ++s)
+      {
+      double maxErr = 0.0;
+      double ratio = 0.0;
+      double eb = bounds[b]*(double(hi) - double(lo));
+      if (roundTrip(VTK_FLOAT, f, f.size(), 1, s ? dims : nullptr,
+        ErrorBoundedCompressor::MODE_RELATIVE, bounds[b], maxErr, ratio) ||
+        (maxErr > eb))
+        {
+        SENSEI_ERROR("Relative bound " << bounds[b] << " failed, the error "
+          << maxErr << " exceeds " << eb)
+        testResult = -1;
+        }
+
+      if (rank == 0)
+        std::cerr << "relative bound " << bounds[b] << (s ? " 3d" : " 1d")
+          << " ratio " << ratio << " max error " << maxErr << std::endl;
+
+      // a smooth field should compress well at the bounds of interest
+      if (s && (bounds[b] >= 1e-4) && (ratio < 3.0))
+        {
+        SENSEI_ERROR("The compression ratio " << ratio << " is too low")
+        testResult = -1;
+        }
+      }
+    }
+
+  // absolute bound on a double array with 3 interleaved components
+  std::vector<double> v(3*f.size());
+  for (size_t i = 0; i < f.size(); ++i)
+    {
+    v[3*i] = f[i];
+    v[3*i + 1] = -2.0*f[i];
+    v[3*i + 2] = 1e6 + f[i];
+    }
+
+  double maxErr = 0.0;
+  double ratio = 0.0;
+  if (roundTrip(VTK_DOUBLE, v, f.size(), 3, dims,
+    ErrorBoundedCompressor::MODE_ABSOLUTE, 1e-3, maxErr, ratio) ||
+    (maxErr > 1e-3))
+    {
+    SENSEI_ERROR("Absolute bound failed, the error " << maxErr
+      << " exceeds 1e-3")
+    testResult = -1;
+    }
+
+  // values that can't be quantized are stored as is
+  float inf = std::numeric_limits<float>::infinity();
+  std::vector<float> special = {1.0f, 2.0f,
+    std::numeric_limits<float>::quiet_NaN(), inf, -inf, 3.0e38f, -3.0e38f,
+    1.0e-40f, 0.0f, 5.0f};
+
+  if (roundTrip(VTK_FLOAT, special, special.size(), 1, nullptr,
+    ErrorBoundedCompressor::MODE_ABSOLUTE, 1e-3, maxErr, ratio) ||
+    (maxErr > 1e-3) ||
+    roundTrip(VTK_FLOAT, special, special.size(), 1, nullptr,
+    ErrorBoundedCompressor::MODE_RELATIVE, 1e-3, maxErr, ratio) ||
+    roundTrip(VTK_FLOAT, special, special.size(), 1, nullptr,
+    ErrorBoundedCompressor::MODE_ABSOLUTE, 0.0, maxErr, ratio) ||
+    (maxErr != 0.0))
+    {
+    SENSEI_ERROR("Special values were not handled")
+    testResult = -1;
+    }
+
+  // integers are not compressed
+  std::vector<int> ints = {1, -2, 3, 1 << 30, 5};
+  if (roundTrip(VTK_INT, ints, ints.size(), 1, nullptr,
+    ErrorBoundedCompressor::MODE_ABSOLUTE, 10.0, maxErr, ratio) ||
+    (maxErr != 0.0))
+    {
+    SENSEI_ERROR("Integers were not stored as is")
+    testResult = -1;
+    }
+
+  // per array settings, the first match wins
+  ErrorBoundedCompressor comp;
+  comp.SetErrorBound("mesh", vtkDataObject::POINT, "data",
+    ErrorBoundedCompressor::MODE_ABSOLUTE, 0.5);
+  comp.SetErrorBound("", -1, "data", ErrorBoundedCompressor::MODE_RELATIVE,
+    1e-4);
+
+  int mode = -1;
+  double bound = 0.0;
+  if (!comp.Enabled() ||
+    !comp.GetErrorBound("mesh", vtkDataObject::POINT, "data", mode, bound) ||
+    (mode != ErrorBoundedCompressor::MODE_ABSOLUTE) || (bound != 0.5) ||
+    !comp.GetErrorBound("other", vtkDataObject::CELL, "data", mode, bound) ||
+    (mode != ErrorBoundedCompressor::MODE_RELATIVE) || (bound != 1e-4) ||
+    comp.GetErrorBound("mesh", vtkDataObject::POINT, "pressure", mode, bound))
+    {
+    SENSEI_ERROR("The per array settings are incorrect")
+    testResult = -1;
+    }
+
+  if (rank == 0)
+    std::cerr << "ErrorBoundedCompressor " << (testResult ? "failed" : "passed")
+      << std::endl;
+
+  MPI_Finalize();
+
+  return testResult;
+}
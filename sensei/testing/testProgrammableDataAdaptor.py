@@ -52,8 +52,8 @@ def addArray(mesh, meshName, assoc, arrayName):
   sys.stderr.write('===addArray\n')
   if ((meshName == 'image') and (assoc == vtk.vtkDataObject.POINT) \
     and (arrayName == 'data')):
-    da = vtknp.numpy_to_vtk(data)
-    da.SetName('data')
+    # zero-copy, the VTK array keeps data alive
+    da = sensei.NumpyToVTK(data, 'data')
     mesh.GetPointData().AddArray(da)
     return
   raise RuntimeError('failed to add array')
@@ -87,6 +87,16 @@ result = -1
 if hist == baselineHist:
   result = 0
 
+# verify the round trip NumPy -> VTK -> NumPy shares memory
+# and that the view can't be used to modify VTK's memory
+vda = sensei.NumpyToVTK(data, 'data')
+view = sensei.VTKToNumpy(vda)
+del vda
+if not (np.shares_memory(view, data) and np.array_equal(view, data) \
+  and not view.flags.writeable):
+  sys.stderr.write('zero-copy round trip failed\n')
+  result = -1
+
 ha.Delete()
 
 pda.ReleaseData()
@@ -150,7 +150,10 @@ int addArray(vtkDataObject *mesh, const std::string &meshName,
 
 int main(int argc, char **argv)
 {
-  MPI_Init(&argc, &argv);
+  // asynchronous execution makes use of MPI_THREAD_MULTIPLE when
+  // it is available and falls back to synchronous otherwise
+  int provided = 0;
+  MPI_Init_thread(&argc, &argv, MPI_THREAD_MULTIPLE, &provided);
 
   if (argc != 2)
     {
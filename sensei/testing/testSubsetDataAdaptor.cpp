@@ -0,0 +1,216 @@
+#include "SubsetDataAdaptor.h"
+#include "VTKDataAdaptor.h"
+#include "MeshMetadata.h"
+#include "Error.h"
+
+#include <mpi.h>
+#include <vtkImageData.h>
+#include <vtkMultiBlockDataSet.h>
+#include <vtkDoubleArray.h>
+#include <vtkFloatArray.h>
+#include <vtkDataArray.h>
+#include <vtkPointData.h>
+#include <vtkCellData.h>
+#include <vtkDataObject.h>
+#include <array>
+#include <iostream>
+#include <string>
+
+// Checks the blocks, arrays, and metadata served by SubsetDataAdaptor for
+// strided subsampling, a region of interest, and reduced precision, and that
+// nothing is copied when the data is unchanged.
+
+// a multiblock with one n x n x n image per rank, neighbors share a layer of
+// points. the arrays hold a function of the global index
+vtkMultiBlockDataSet *newMultiBlock(int rank, int nRanks, int n)
+{
+  vtkImageData *im = vtkImageData::New();
+  im->SetExtent(rank*(n - 1), (rank + 1)*(n - 1), 0, n - 1, 0, n - 1);
+
+  vtkDoubleArray *pd = vtkDoubleArray::New();
+  pd->SetName("pdata");
+  pd->SetNumberOfTuples(n*n*n);
+  for (int k = 0, q = 0; k < n; ++k)
+    for (int j = 0; j < n; ++j)
+      for (int i = 0; i < n; ++i, ++q)
+        pd->SetValue(q, rank*(n - 1) + i + 100*j + 10000*k);
+  im->GetPointData()->AddArray(pd);
+  pd->Delete();
+
+  vtkDoubleArray *cd = vtkDoubleArray::New();
+  cd->SetName("cdata");
+  cd->SetNumberOfTuples((n - 1)*(n - 1)*(n - 1));
+  for (int k = 0, q = 0; k < n - 1; ++k)
+    for (int j = 0; j < n - 1; ++j)
+      for (int i = 0; i < n - 1; ++i, ++q)
+        cd->SetValue(q, rank*(n - 1) + i + 100*j + 10000*k);
+  im->GetCellData()->AddArray(cd);
+  cd->Delete();
+
+  vtkMultiBlockDataSet *mb = vtkMultiBlockDataSet::New();
+  mb->SetNumberOfBlocks(nRanks);
+  mb->SetBlock(rank, im);
+  im->Delete();
+
+  return mb;
+}
+
+// gets this rank's block of the reduced mesh with both arrays
+vtkImageData *getBlock(sensei::SubsetDataAdaptor *sda, int rank,
+  vtkDataObject *&mesh)
+{
+  mesh = nullptr;
+  if (sda->GetMesh("mesh", false, mesh) ||
+    sda->AddArray(mesh, "mesh", vtkDataObject::POINT, "pdata") ||
+    sda->AddArray(mesh, "mesh", vtkDataObject::CELL, "cdata"))
+    return nullptr;
+
+  vtkMultiBlockDataSet *mb = dynamic_cast<vtkMultiBlockDataSet*>(mesh);
+  return mb ? dynamic_cast<vtkImageData*>(mb->GetBlock(rank)) : nullptr;
+}
+
+int main(int argc, char **argv)
+{
+  MPI_Init(&argc, &argv);
+
+  int rank = 0;
+  int nRanks = 1;
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &nRanks);
+
+  int n = 9;
+
+  sensei::VTKDataAdaptor *vda = sensei::VTKDataAdaptor::New();
+  vtkMultiBlockDataSet *src = newMultiBlock(rank, nRanks, n);
+  vda->SetDataObject("mesh", src);
+
+  sensei::SubsetDataAdaptor *sda = sensei::SubsetDataAdaptor::New();
+  sda->SetDataAdaptor(vda);
+
+  int testResult = 0;
+
+  // unchanged data is shared
+  vtkDataObject *mesh = nullptr;
+  vtkImageData *im = getBlock(sda, rank, mesh);
+  vtkImageData *srcIm = static_cast<vtkImageData*>(src->GetBlock(rank));
+  if (!im || (im->GetPointData()->GetArray("pdata") !=
+    srcIm->GetPointData()->GetArray("pdata")))
+    {
+    SENSEI_ERROR("The source arrays were not shared")
+    testResult = -1;
+    }
+  if (mesh)
+    mesh->Delete();
+
+  // every other point in single precision
+  sda->SetStride({{2, 2, 2}});
+  sda->SetPrecision("float32");
+
+  im = getBlock(sda, rank, mesh);
+
+  int m = (n - 1)/2;
+  vtkFloatArray *pd = im ? dynamic_cast<vtkFloatArray*>(
+    im->GetPointData()->GetArray("pdata")) : nullptr;
+  vtkFloatArray *cd = im ? dynamic_cast<vtkFloatArray*>(
+    im->GetCellData()->GetArray("cdata")) : nullptr;
+
+  int ext[6] = {0};
+  if (im)
+    im->GetExtent(ext);
+
+  if (!pd || !cd || (ext[0] != rank*m) || (ext[1] != (rank + 1)*m) ||
+    (ext[3] != m) || (ext[5] != m) || (im->GetSpacing()[0] != 2.0) ||
+    (pd->GetNumberOfTuples() != (m + 1)*(m + 1)*(m + 1)) ||
+    (cd->GetNumberOfTuples() != m*m*m))
+    {
+    SENSEI_ERROR("The subsampled block is incorrect")
+    testResult = -1;
+    }
+  else
+    {
+    for (int k = 0, q = 0; k <= m; ++k)
+      for (int j = 0; j <= m; ++j)
+        for (int i = 0; i <= m; ++i, ++q)
+          if (pd->GetValue(q) != 2*(rank*m + i) + 200*j + 20000*k)
+            testResult = -1;
+
+    // the cell at the lower corner of each reduced cell
+    for (int k = 0, q = 0; k < m; ++k)
+      for (int j = 0; j < m; ++j)
+        for (int i = 0; i < m; ++i, ++q)
+          if (cd->GetValue(q) != 2*(rank*m + i) + 200*j + 20000*k)
+            testResult = -1;
+
+    if (testResult)
+      SENSEI_ERROR("The subsampled values are incorrect")
+    }
+  if (mesh)
+    mesh->Delete();
+
+  sensei::MeshMetadataPtr md = sensei::MeshMetadata::New();
+  md->Flags.SetBlockSize();
+  md->Flags.SetBlockExtents();
+  sda->GetMeshMetadata(0, md);
+
+  if ((md->BlockExtents.size() != 1) || (md->BlockExtents[0][0] != rank*m) ||
+    (md->Extent[1] != nRanks*m) || (md->BlockNumPoints[0] != (m + 1)*(m + 1)*(m + 1)) ||
+    (md->BlockNumCells[0] != m*m*m) || (md->ArrayType[0] != VTK_FLOAT))
+    {
+    SENSEI_ERROR("The subsampled metadata is incorrect")
+    testResult = -1;
+    }
+
+  // a region inside the first block, the others are served empty with
+  // arrays that have no tuples
+  sda->SetStride({{1, 1, 1}});
+  sda->SetPrecision("native");
+  sda->SetRegion({{1, 4, 0, n - 1, 2, 2}});
+
+  im = getBlock(sda, rank, mesh);
+  vtkDataArray *pda = im ? im->GetPointData()->GetArray("pdata") : nullptr;
+  vtkDataArray *cda = im ? im->GetCellData()->GetArray("cdata") : nullptr;
+  if (!pda || !cda || (rank ? (im->GetNumberOfPoints() ||
+    pda->GetNumberOfTuples() || cda->GetNumberOfTuples()) :
+    ((im->GetNumberOfPoints() != 4*n) || (pda->GetTuple1(0) != 1 + 20000))))
+    {
+    SENSEI_ERROR("The region is incorrect")
+    testResult = -1;
+    }
+  if (mesh)
+    mesh->Delete();
+
+  // the metadata keeps the empty blocks and their owners
+  md = sensei::MeshMetadata::New();
+  md->Flags.SetBlockDecomp();
+  md->Flags.SetBlockSize();
+  sda->GetMeshMetadata(0, md);
+
+  if ((md->NumBlocks != nRanks) || (md->BlockOwner.size() != 1) ||
+    (md->BlockOwner[0] != rank) ||
+    (md->BlockNumPoints[0] != (rank ? 0 : 4*n)))
+    {
+    SENSEI_ERROR("The region's metadata is incorrect")
+    testResult = -1;
+    }
+
+  // half precision values
+  if ((sensei::SubsetDataAdaptor::RoundToHalf(1.0f/3.0f) != 0.333251953125f) ||
+    (sensei::SubsetDataAdaptor::RoundToHalf(65519.0f) != 65504.0f) ||
+    (sensei::SubsetDataAdaptor::RoundToHalf(1.0e-8f) != 0.0f))
+    {
+    SENSEI_ERROR("Half precision rounding is incorrect")
+    testResult = -1;
+    }
+
+  sda->Delete();
+  vda->Delete();
+  src->Delete();
+
+  if (rank == 0)
+    std::cerr << "SubsetDataAdaptor " << (testResult ? "failed" : "passed")
+      << std::endl;
+
+  MPI_Finalize();
+
+  return testResult;
+}
@@ -0,0 +1,133 @@
+#include "TemporalEncoder.h"
+#include "Error.h"
+
+#include <mpi.h>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// the fields change slowly in time, as simulation fields do between
+// in situ invocations. f is a float wave, d is a double that is constant
+// over most of the domain, i is an int counter and g is a ghost array
+// that never changes.
+int gN = 20000;
+int gSteps = 12;
+
+void newStep(int step, std::vector<float> &f, std::vector<double> &d,
+  std::vector<int> &i, std::vector<unsigned char> &g)
+{
+  f.resize(gN);
+  d.resize(gN);
+  i.resize(gN);
+  g.resize(gN);
+
+  for (int j = 0; j < gN; ++j)
+    {
+    f[j] = std::sin(0.001f*j + 0.01f*step);
+    d[j] = j < gN/10 ? std::exp(-0.001*j*step) : 1.0;
+    i[j] = j/16 + step;
+    g[j] = j < 64 ? 1 : 0;
+    }
+}
+
+// encode the step with one encoder and decode it with another, checking
+// that the result is bit for bit identical. the encoded size is accumulated.
+template <typename T>
+int roundTrip(sensei::TemporalEncoder &enc, sensei::TemporalEncoder &dec,
+  const std::string &key, const std::vector<T> &vals, size_t &nEncoded)
+{
+  size_t nBytes = vals.size()*sizeof(T);
+
+  std::vector<unsigned char> frame;
+  if (enc.Encode(key, vals.data(), nBytes, sizeof(T), frame))
+    return -1;
+
+  nEncoded += frame.size();
+
+  std::vector<T> decoded(vals.size());
+  if (dec.Decode(key, frame.data(), frame.size(), decoded.data(), nBytes))
+    return -1;
+
+  if (memcmp(decoded.data(), vals.data(), nBytes))
+    {
+    SENSEI_ERROR("The decoded values of " << key << " differ")
+    return -1;
+    }
+
+  return 0;
+}
+
+int main(int argc, char **argv)
+{
+  MPI_Init(&argc, &argv);
+
+  int rank = 0;
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+  const char *deltaModes[] = {"none", "xor", "arithmetic"};
+  const char *compressors[] = {"none", "rle", "zlib"};
+
+  size_t nRaw = gSteps*gN*(sizeof(float) + sizeof(double) + sizeof(int) + 1);
+
+  int testResult = 0;
+  for (int m = 0; m < 3; ++m)
+    {
+    for (int s = 0; s < 2; ++s)
+      {
+      for (int c = 0; c < 3; ++c)
+        {
+        sensei::TemporalEncoder enc;
+        enc.SetDeltaMode(deltaModes[m]);
+        enc.SetShuffle(s);
+        enc.SetCompressor(compressors[c]);
+        enc.SetKeyFrameInterval(5);
+
+        // the decoder needs no configuration
+        sensei::TemporalEncoder dec;
+
+        std::vector<float> f;
+        std::vector<double> d;
+        std::vector<int> i;
+        std::vector<unsigned char> g;
+
+        size_t nEncoded = 0;
+        for (int step = 0; step < gSteps; ++step)
+          {
+          newStep(step, f, d, i, g);
+
+          if (roundTrip(enc, dec, "f", f, nEncoded) ||
+            roundTrip(enc, dec, "d", d, nEncoded) ||
+            roundTrip(enc, dec, "i", i, nEncoded) ||
+            roundTrip(enc, dec, "g", g, nEncoded))
+            {
+            SENSEI_ERROR("Step " << step << " failed with delta "
+              << deltaModes[m] << " shuffle " << s << " compressor "
+              << compressors[c])
+            testResult = -1;
+            }
+          }
+
+        double ratio = double(nRaw)/nEncoded;
+
+        if (rank == 0)
+          std::cerr << "delta " << deltaModes[m] << " shuffle " << s
+            << " compressor " << compressors[c] << " ratio " << ratio
+            << std::endl;
+
+        // with all of the stages the volume should be reduced substantially
+        if ((m > 0) && s && c && (ratio < 3.0))
+          {
+          SENSEI_ERROR("The compression ratio " << ratio << " is too low")
+          testResult = -1;
+          }
+        }
+      }
+    }
+
+  MPI_Finalize();
+
+  return testResult;
+}
@@ -0,0 +1,118 @@
+#include "ThreadPool.h"
+#include "Error.h"
+
+#include <atomic>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+// Checks that ThreadPool::ParallelFor visits every item exactly once,
+// reports failures, runs nested calls and calls from concurrent threads,
+// and that per item results combined in item order do not depend on the
+// number of threads.
+//
+// usage: testThreadPool [number of threads]
+
+// a sum whose value depends on the order of the additions
+double orderedSum(unsigned int n)
+{
+  std::vector<double> vals(n, 0.0);
+  sensei::ThreadPool::ParallelFor(n, [&vals](unsigned int i) -> int
+    {
+    vals[i] = 1.0/(1.0 + i*i);
+    return 0;
+    });
+
+  double sum = 0.0;
+  for (unsigned int i = 0; i < n; ++i)
+    sum += vals[i];
+
+  return sum;
+}
+
+int main(int argc, char **argv)
+{
+  int nThreads = argc > 1 ? atoi(argv[1]) : 4;
+
+  sensei::ThreadPool::SetNumberOfThreads(1);
+  double sum1 = orderedSum(100000);
+
+  sensei::ThreadPool::SetNumberOfThreads(nThreads);
+
+  int testResult = 0;
+  unsigned int n = 1000;
+  for (int rep = 0; rep < 20; ++rep)
+    {
+    // every item once, a nested call runs serially on the worker
+    std::vector<std::atomic<int>> visits(n);
+    for (unsigned int i = 0; i < n; ++i)
+      visits[i] = 0;
+
+    int ret = sensei::ThreadPool::ParallelFor(n, [&](unsigned int i) -> int
+      {
+      int nested = 0;
+      sensei::ThreadPool::ParallelFor(10, [&nested](unsigned int) -> int
+        {
+        ++nested;
+        return 0;
+        });
+
+      visits[i] += nested == 10 ? 1 : 100;
+
+      // one item fails in odd repetitions
+      return (rep % 2) && (i == n/2) ? -1 : 0;
+      });
+
+    for (unsigned int i = 0; i < n; ++i)
+      {
+      if (visits[i] != 1)
+        {
+        SENSEI_ERROR("Item " << i << " was visited " << visits[i] << " times")
+        testResult = -1;
+        break;
+        }
+      }
+
+    if ((ret != 0) != (rep % 2 == 1))
+      {
+      SENSEI_ERROR("Repetition " << rep << " returned " << ret)
+      testResult = -1;
+      }
+    }
+
+  // calls from two threads at once, one of them runs serially
+  std::atomic<long> total(0);
+  auto work = [&total]()
+    {
+    for (int rep = 0; rep < 50; ++rep)
+      sensei::ThreadPool::ParallelFor(100, [&total](unsigned int i) -> int
+        {
+        total += i;
+        return 0;
+        });
+    };
+
+  std::thread other(work);
+  work();
+  other.join();
+
+  if (total != 2*50*4950)
+    {
+    SENSEI_ERROR("Concurrent calls summed to " << total)
+    testResult = -1;
+    }
+
+  // the combined result does not depend on the number of threads
+  double sumN = orderedSum(100000);
+  if (sumN != sum1)
+    {
+    SENSEI_ERROR("The sum on " << nThreads << " threads " << sumN
+      << " differs from the sum on 1 thread " << sum1)
+    testResult = -1;
+    }
+
+  std::cerr << "ThreadPool with " << sensei::ThreadPool::GetNumberOfThreads()
+    << " threads " << (testResult ? "failed" : "passed") << std::endl;
+
+  return testResult;
+}
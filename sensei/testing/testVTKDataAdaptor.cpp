@@ -0,0 +1,170 @@
+#include "VTKDataAdaptor.h"
+#include "MeshMetadata.h"
+#include "Error.h"
+
+#include <mpi.h>
+#include <vtkImageData.h>
+#include <vtkMultiBlockDataSet.h>
+#include <vtkDoubleArray.h>
+#include <vtkPointData.h>
+#include <vtkDataObject.h>
+#include <iostream>
+#include <string>
+
+// Checks that VTKDataAdaptor numbers the meshes by name, reuses the metadata
+// it makes, gives each caller its own mesh, and makes them again when the
+// data object is set again.
+
+// a multiblock with one image per rank
+vtkMultiBlockDataSet *newMultiBlock(int rank, int nRanks, int n)
+{
+  vtkImageData *im = vtkImageData::New();
+  im->SetDimensions(n, n, n);
+  im->SetOrigin(rank*(n - 1), 0, 0);
+
+  vtkDoubleArray *da = vtkDoubleArray::New();
+  da->SetName("data");
+  da->SetNumberOfTuples(n*n*n);
+  for (int i = 0; i < n*n*n; ++i)
+    da->SetValue(i, rank + i);
+  im->GetPointData()->AddArray(da);
+  da->Delete();
+
+  vtkMultiBlockDataSet *mb = vtkMultiBlockDataSet::New();
+  mb->SetNumberOfBlocks(nRanks);
+  mb->SetBlock(rank, im);
+  im->Delete();
+
+  return mb;
+}
+
+int main(int argc, char **argv)
+{
+  MPI_Init(&argc, &argv);
+
+  int rank = 0;
+  int nRanks = 1;
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &nRanks);
+
+  sensei::VTKDataAdaptor *da = sensei::VTKDataAdaptor::New();
+
+  // the ids follow the names not the order the meshes were set in
+  const char *names[] = {"c", "a", "b"};
+  for (int i = 0; i < 3; ++i)
+    {
+    vtkMultiBlockDataSet *mb = newMultiBlock(rank, nRanks, 4 + i);
+    da->SetDataObject(names[i], mb);
+    mb->Delete();
+    }
+
+  int testResult = 0;
+  unsigned int nMeshes = 0;
+  da->GetNumberOfMeshes(nMeshes);
+  for (unsigned int i = 0; (i < nMeshes) && !testResult; ++i)
+    {
+    sensei::MeshMetadataPtr md = sensei::MeshMetadata::New();
+    md->Flags.SetBlockDecomp();
+    if (da->GetMeshMetadata(i, md) || (md->MeshName != std::string(1, 'a' + i)))
+      {
+      SENSEI_ERROR("Mesh " << i << " is \"" << md->MeshName << "\"")
+      testResult = -1;
+      }
+    }
+
+  // the metadata for the same flags is reused, other flags are honored.
+  // the block arrays describe the local block
+  sensei::MeshMetadataPtr md0 = sensei::MeshMetadata::New();
+  md0->Flags.SetBlockDecomp();
+  da->GetMeshMetadata(0, md0);
+
+  sensei::MeshMetadataPtr md1 = sensei::MeshMetadata::New();
+  md1->Flags.SetBlockDecomp();
+  da->GetMeshMetadata(0, md1);
+
+  sensei::MeshMetadataPtr md2 = sensei::MeshMetadata::New();
+  md2->Flags.SetBlockBounds();
+  da->GetMeshMetadata(0, md2);
+
+  if ((md0->NumBlocks != nRanks) || (md1->NumBlocks != nRanks) ||
+    (md1->BlockOwner != md0->BlockOwner) || (md0->BlockOwner.size() != 1) ||
+    !md2->BlockOwner.empty() || (md2->BlockBounds.size() != 1))
+    {
+    SENSEI_ERROR("The metadata has " << md0->NumBlocks << ", "
+      << md1->NumBlocks << " and " << md2->NumBlocks << " blocks")
+    testResult = -1;
+    }
+
+  // each caller gets its own mesh, arrays added to one are not seen
+  // through the others. the structure is made from the data object once
+  // and kept until the data object is set again, so a change to the data
+  // object made in between is not seen by later callers
+  vtkDataObject *m0 = nullptr;
+  vtkDataObject *m1 = nullptr;
+  vtkDataObject *m2 = nullptr;
+  vtkDataObject *m3 = nullptr;
+  da->GetMesh("a", false, m0);
+  da->AddArray(m0, "a", vtkDataObject::POINT, "data");
+
+  vtkDataObject *src = nullptr;
+  da->GetDataObject("a", src);
+  vtkImageData *srcIm = dynamic_cast<vtkImageData*>(
+    static_cast<vtkMultiBlockDataSet*>(src)->GetBlock(rank));
+  srcIm->SetOrigin(-1000.0, 0.0, 0.0);
+
+  da->GetMesh("a", false, m1);
+  da->GetMesh("a", true, m2);
+
+  vtkMultiBlockDataSet *mb = newMultiBlock(rank, nRanks, 8);
+  da->SetDataObject("a", mb);
+  mb->Delete();
+
+  da->GetMesh("a", false, m3);
+
+  vtkMultiBlockDataSet *mb0 = dynamic_cast<vtkMultiBlockDataSet*>(m0);
+  vtkImageData *im0 = mb0 ?
+    dynamic_cast<vtkImageData*>(mb0->GetBlock(rank)) : nullptr;
+
+  vtkMultiBlockDataSet *mb1 = dynamic_cast<vtkMultiBlockDataSet*>(m1);
+  vtkImageData *im1 = mb1 ?
+    dynamic_cast<vtkImageData*>(mb1->GetBlock(rank)) : nullptr;
+
+  vtkMultiBlockDataSet *mb3 = dynamic_cast<vtkMultiBlockDataSet*>(m3);
+  vtkImageData *im3 = mb3 ?
+    dynamic_cast<vtkImageData*>(mb3->GetBlock(rank)) : nullptr;
+
+  if ((m0 == m1) || (m0 == m2) || (m0 == m3) || !im0 || !im1 || !im3 ||
+    (im0 == im1) || !im0->GetPointData()->GetArray("data") ||
+    im1->GetPointData()->GetArray("data") ||
+    (im1->GetNumberOfPoints() != 5*5*5) ||
+    (im1->GetOrigin()[0] != rank*(5 - 1)) ||
+    (im3->GetNumberOfPoints() != 8*8*8) ||
+    (im3->GetOrigin()[0] != rank*(8 - 1)))
+    {
+    SENSEI_ERROR("The meshes were not made as expected")
+    testResult = -1;
+    }
+
+  m0->Delete();
+  m1->Delete();
+  m2->Delete();
+  m3->Delete();
+
+  da->ReleaseData();
+  da->GetNumberOfMeshes(nMeshes);
+  if (nMeshes)
+    {
+    SENSEI_ERROR(nMeshes << " meshes remain after ReleaseData")
+    testResult = -1;
+    }
+
+  da->Delete();
+
+  if (rank == 0)
+    std::cerr << "VTKDataAdaptor " << (testResult ? "failed" : "passed")
+      << std::endl;
+
+  MPI_Finalize();
+
+  return testResult;
+}